@@ -0,0 +1,362 @@
+#ifndef INDEXED_N_TREE_HPP
+#define INDEXED_N_TREE_HPP
+
+#include "fixedBranchTreeInterface.hpp"
+
+#include <array>
+#include <vector>
+#include <deque>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#define ITREE IndexedFixedBranchTree< T, NC >
+
+namespace tree
+{
+    /*!
+      \brief n-ary tree stored in contiguous arrays, linking nodes by indices instead of pointers
+      the children of a node occupy one block of NC consecutive slots, so iterating children touches contiguous memory
+      and blocks of deleted children are reused by later expansions
+      \param T type to store in nodes, default constructible, slots of deleted nodes are reset to T()
+      \param NC number of children per interior node
+      \note nodes are indices, they stay valid until their slot is deleted or the tree is laid out anew
+    */
+    template< typename T, size_t NC >
+    class IndexedFixedBranchTree : public FixedBranchTreeInterface< T, NC >
+    {
+      public:
+	typedef uint32_t IndexT;
+
+	static constexpr IndexT NO_INDEX = std::numeric_limits< IndexT >::max();
+
+	static const size_t N = NC;
+
+	//! \class copyable handle of a node
+	class Node
+	{
+	    friend class IndexedFixedBranchTree< T, NC >;
+	  public:
+	    Node() : mIndex( NO_INDEX ) {}
+
+	    bool operator ==( const Node& other ) const { return mIndex == other.mIndex; }
+
+	    bool operator !=( const Node& other ) const { return mIndex != other.mIndex; }
+
+	  private:
+	    explicit Node( const IndexT& index ) : mIndex( index ) {}
+
+	    IndexT mIndex;
+	};
+
+	//! \class random access iterator over the block of children of a node
+	class ChildrenIterator
+	{
+	  public:
+	    typedef std::random_access_iterator_tag iterator_category;
+	    typedef Node value_type;
+	    typedef std::ptrdiff_t difference_type;
+	    typedef const Node* pointer;
+	    typedef Node reference;
+
+	    ChildrenIterator() : mIndex( NO_INDEX ) {}
+
+	    explicit ChildrenIterator( const IndexT& index ) : mIndex( index ) {}
+
+	    Node operator *() const { return Node( mIndex ); }
+
+	    ChildrenIterator& operator ++() { ++mIndex; return *this; }
+
+	    ChildrenIterator operator ++( int ) { ChildrenIterator old( *this ); ++mIndex; return old; }
+
+	    ChildrenIterator& operator --() { --mIndex; return *this; }
+
+	    ChildrenIterator operator --( int ) { ChildrenIterator old( *this ); --mIndex; return old; }
+
+	    ChildrenIterator& operator +=( const difference_type& add ) { mIndex += add; return *this; }
+
+	    ChildrenIterator& operator -=( const difference_type& sub ) { mIndex -= sub; return *this; }
+
+	    ChildrenIterator operator +( const difference_type& add ) const { return ChildrenIterator( mIndex + add ); }
+
+	    ChildrenIterator operator -( const difference_type& sub ) const { return ChildrenIterator( mIndex - sub ); }
+
+	    difference_type operator -( const ChildrenIterator& other ) const { return difference_type( mIndex ) - difference_type( other.mIndex ); }
+
+	    Node operator []( const difference_type& offset ) const { return Node( mIndex + offset ); }
+
+	    bool operator ==( const ChildrenIterator& other ) const { return mIndex == other.mIndex; }
+
+	    bool operator !=( const ChildrenIterator& other ) const { return mIndex != other.mIndex; }
+
+	    bool operator <( const ChildrenIterator& other ) const { return mIndex < other.mIndex; }
+
+	    bool operator <=( const ChildrenIterator& other ) const { return mIndex <= other.mIndex; }
+
+	    bool operator >( const ChildrenIterator& other ) const { return mIndex > other.mIndex; }
+
+	    bool operator >=( const ChildrenIterator& other ) const { return mIndex >= other.mIndex; }
+
+	  private:
+	    IndexT mIndex;
+	};
+
+	// trait defs
+	typedef T ValueT;
+	typedef Node NodeT;
+	typedef std::array< NodeT, NC > CListT;
+	typedef ChildrenIterator CIterT;
+
+	IndexedFixedBranchTree( const T& rootValue )
+	    : mValues( { rootValue } )
+	    , mParents( { NO_INDEX } )
+	    , mFirstChildren( { NO_INDEX } )
+	    , mDepths( { 0 } )
+	    , mNodesAtDepth( { 1 } )
+	    , mSize( 1 )
+	{}
+
+	NodeT root() const { return Node( ROOT ); }
+
+	/*! \return number of nodes in tree */
+	size_t size() const { return mSize; }
+
+	/*! \return length of longest path - 1 */
+	size_t height() const { return mNodesAtDepth.size(); }
+
+	ValueT& value( const NodeT& n ) { return mValues[ n.mIndex ]; }
+
+	const ValueT& value( const NodeT& n ) const { return mValues[ n.mIndex ]; }
+
+	NodeT parent( const NodeT& n ) const { return Node( mParents[ n.mIndex ] ); }
+
+	std::pair< CIterT, CIterT > children( const NodeT& n ) const
+	{
+	    const IndexT first = mFirstChildren[ n.mIndex ];
+	    if( first == NO_INDEX )
+		return std::make_pair( CIterT( 0 ), CIterT( 0 ) );
+	    return std::make_pair( CIterT( first ), CIterT( first + NC ) );
+	}
+
+	bool isRoot( const NodeT& n ) const { return n.mIndex == ROOT; }
+
+	bool isLeaf( const NodeT& n ) const
+	{
+	    if( n.mIndex >= mValues.size() )
+		throw std::runtime_error( "bad node" );
+	    return mFirstChildren[ n.mIndex ] == NO_INDEX;
+	}
+
+	//! \return length of the path from the root to n
+	size_t depth( const NodeT& n ) const { return mDepths[ n.mIndex ]; }
+
+	void expand( const NodeT& n, const std::array< T, NC >& vals )
+	{
+	    if( !isLeaf( n ) )
+		throw std::logic_error( "is interior node, cannot expand" );
+	    IndexT first;
+	    if( !mFreeBlocks.empty() )
+	    {
+		first = mFreeBlocks.back();
+		mFreeBlocks.pop_back();
+	    }
+	    else
+	    {
+		first = mValues.size();
+		mValues.resize( first + NC );
+		mParents.resize( first + NC );
+		mFirstChildren.resize( first + NC );
+		mDepths.resize( first + NC );
+	    }
+	    const IndexT childDepth = mDepths[ n.mIndex ] + 1;
+	    for( IndexT c = 0; c < NC; ++c )
+	    {
+		mValues[ first + c ] = vals[ c ];
+		mParents[ first + c ] = n.mIndex;
+		mFirstChildren[ first + c ] = NO_INDEX;
+		mDepths[ first + c ] = childDepth;
+	    }
+	    mFirstChildren[ n.mIndex ] = first;
+	    if( childDepth >= mNodesAtDepth.size() )
+		mNodesAtDepth.resize( childDepth + 1, 0 );
+	    mNodesAtDepth[ childDepth ] += NC;
+	    mSize += NC;
+	}
+
+	//! \brief deletes all descendants of n, handing their blocks back for reuse
+	void delChildren( const NodeT& n )
+	{
+	    std::vector< IndexT > stack;
+	    if( mFirstChildren[ n.mIndex ] != NO_INDEX )
+		stack.push_back( n.mIndex );
+	    while( !stack.empty() )
+	    {
+		const IndexT p = stack.back();
+		stack.pop_back();
+		const IndexT first = mFirstChildren[ p ];
+		for( IndexT c = first; c < first + NC; ++c )
+		{
+		    if( mFirstChildren[ c ] != NO_INDEX )
+			stack.push_back( c );
+		    mValues[ c ] = T();
+		    mParents[ c ] = NO_INDEX;
+		}
+		mNodesAtDepth[ mDepths[ first ] ] -= NC;
+		mSize -= NC;
+		mFirstChildren[ p ] = NO_INDEX;
+		mFreeBlocks.push_back( first );
+	    }
+	    while( mNodesAtDepth.back() == 0 )
+		mNodesAtDepth.pop_back();
+	}
+
+	/*!
+	  \brief stores nodes in breadth first order, so descents from the root read the tree front to back and no slots are free
+	  \note invalidates all nodes obtained before
+	*/
+	void layoutBreadthFirst()
+	{
+	    std::vector< T > values;
+	    std::vector< IndexT > parents, firstChildren, depths;
+	    values.reserve( mSize );
+	    parents.reserve( mSize );
+	    firstChildren.reserve( mSize );
+	    depths.reserve( mSize );
+
+	    // old index of each node in new order, children of a node are appended as one block
+	    std::vector< IndexT > order = { ROOT };
+	    order.reserve( mSize );
+	    parents.push_back( NO_INDEX );
+	    for( IndexT i = 0; i < order.size(); ++i )
+	    {
+		const IndexT old = order[ i ];
+		values.push_back( std::move( mValues[ old ] ) );
+		depths.push_back( mDepths[ old ] );
+		const IndexT first = mFirstChildren[ old ];
+		if( first == NO_INDEX )
+		    firstChildren.push_back( NO_INDEX );
+		else
+		{
+		    firstChildren.push_back( order.size() );
+		    for( IndexT c = first; c < first + NC; ++c )
+		    {
+			order.push_back( c );
+			parents.push_back( i );
+		    }
+		}
+	    }
+	    mValues.swap( values );
+	    mParents.swap( parents );
+	    mFirstChildren.swap( firstChildren );
+	    mDepths.swap( depths );
+	    mFreeBlocks.clear();
+	}
+
+	//! \return bytes allocated on the heap by the tree, excluding storage the values allocate
+	size_t heapBytes() const
+	{
+	    return mValues.capacity() * sizeof( T )
+		+ ( mParents.capacity() + mFirstChildren.capacity() + mDepths.capacity() + mFreeBlocks.capacity() ) * sizeof( IndexT )
+		+ mNodesAtDepth.capacity() * sizeof( size_t );
+	}
+
+      private:
+	static constexpr IndexT ROOT = 0;
+
+	std::vector< T > mValues;
+	std::vector< IndexT > mParents;
+	// first slot of the block of children, NO_INDEX for leaves
+	std::vector< IndexT > mFirstChildren;
+	std::vector< IndexT > mDepths;
+	// first slots of blocks of deleted children
+	std::vector< IndexT > mFreeBlocks;
+	// number of nodes at each depth, the height is the number of depths occupied
+	std::vector< size_t > mNodesAtDepth;
+	size_t mSize;
+    };
+
+    template< typename T, size_t NC >
+    typename ITREE::ValueT& value( ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.value( n );
+    }
+
+    template< typename T, size_t NC >
+    typename ITREE::NodeT root( const ITREE& t )
+    {
+	return t.root();
+    }
+
+    template< typename T, size_t NC >
+    typename ITREE::NodeT parent( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.parent( n );
+    }
+
+    template< typename T, size_t NC >
+    std::pair< typename ITREE::CIterT, typename ITREE::CIterT > children( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.children( n );
+    }
+
+    //! \return the depth of the node i.e. length of path until root - 1
+    template< typename T, size_t NC >
+    size_t depth( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.depth( n );
+    }
+
+    //! \return the height of the subtree in t at n
+    template< typename T, size_t NC >
+    size_t subtreeHeight( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	size_t h = 1;
+	for( auto crange = t.children( n ); crange.first != crange.second; ++crange.first )
+	    h = std::max( h, 1 + subtreeHeight( t, *crange.first ) );
+	return h;
+    }
+
+    template< typename T, size_t NC >
+    size_t subtreeSize( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	size_t size = 0;
+	std::vector< typename ITREE::NodeT > stack = { n };
+	while( !stack.empty() )
+	{
+	    auto crange = t.children( stack.back() );
+	    stack.pop_back();
+	    ++size;
+	    stack.insert( stack.end(), crange.first, crange.second );
+	}
+	return size;
+    }
+
+    template< typename T, size_t NC >
+    bool isRoot( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.isRoot( n );
+    }
+
+    template< typename T, size_t NC >
+    bool isLeaf( const ITREE& t, const typename ITREE::NodeT& n )
+    {
+	return t.isLeaf( n );
+    }
+
+    template< typename T, size_t NC >
+    void delChildren( ITREE& t, const typename ITREE::NodeT& n )
+    {
+	t.delChildren( n );
+    }
+
+    template< typename T, size_t NC >
+    void expand( ITREE& t, const typename ITREE::NodeT& n, const std::array< T, NC >& vals = std::array< T, NC >() )
+    {
+	t.expand( n, vals );
+    }
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define LINKED_FIXED_BRANCH_TREE_TEST_HPP
 
 #include "linkedFixedBranchTree.hpp"
+#include "indexedFixedBranchTree.hpp"
 #include "testInterface.hpp"
 #include "testGroupInterface.hpp"
 
@@ -10,14 +11,22 @@
 #include <random>
 #include <memory>
 #include <utility>
+#include <vector>
+#include <type_traits>
 
 using namespace tree;
 
-class LinkedFixedBranchTreeTest : public ITestGroup
+/*!
+  \class tests of a fixed branch tree, run for every implementation
+  \param TreeTT template of the tree taking the type of values and the number of children
+*/
+template< template< typename, size_t > class TreeTT >
+class FixedBranchTreeTest : public ITestGroup
 {
   public:
     static const uint mNoChildren = 10;
-    typedef LinkedFixedBranchTree< int, 10 > TestTreeT;
+    typedef TreeTT< int, 10 > TestTreeT;
+    static const std::string mDescription;
     static std::default_random_engine mRandom;
     static std::uniform_int_distribution<> mIntDist, mChildDist;
     static std::uniform_real_distribution<> mProbDist;
@@ -113,6 +122,34 @@ class LinkedFixedBranchTreeTest : public ITestGroup
 	uint mHeightBefore;
     };
 
+    // laying out the tree anew keeps its structure and values, only run for trees supporting layouts
+    class LayoutTest : public ITest
+    {
+	STATEFUL_TEST( LayoutTest );
+      private:
+	std::unique_ptr< TestTreeT > mpTree;
+	const double mTraverseThresh = 1.0 / std::log2( mTestSize );
+    };
+
+    //! \return values of the subtree of t at n in preorder, followed by -1 at every leaf
+    template< typename TreeT >
+    static std::vector< int > preorder( const TreeT& t, const typename TreeT::NodeT& n )
+    {
+	std::vector< int > values;
+	std::vector< typename TreeT::NodeT > stack = { n };
+	while( !stack.empty() )
+	{
+	    const typename TreeT::NodeT x = stack.back();
+	    stack.pop_back();
+	    values.push_back( value( t, x ) );
+	    if( isLeaf( t, x ) )
+		values.push_back( -1 );
+	    for( auto crange = children( t, x ); crange.first != crange.second; ++crange.first )
+		stack.push_back( *crange.first );
+	}
+	return values;
+    }
+
     class MemoryFreed : public ITest
     {
       public:
@@ -137,7 +174,7 @@ class LinkedFixedBranchTreeTest : public ITestGroup
 	void iterate();
 	bool check() const;
       private:
-	std::unique_ptr< LinkedFixedBranchTree< Dummy, mNoChildren > > mpTree;
+	std::unique_ptr< TreeTT< Dummy, mNoChildren > > mpTree;
 	uint mObjectCounter, mCreationCounter;
 	std::uniform_int_distribution< uint > mSizeDist;
     };
@@ -145,10 +182,13 @@ class LinkedFixedBranchTreeTest : public ITestGroup
     // test delete height
     // generate tree of b=m with n expansions, then delete root
     
-    GROUP_CTOR_DECL( LinkedFixedBranchTreeTest );
+    GROUP_CTOR_DECL( FixedBranchTreeTest );
 
     void init();
     
 }; // test group
 
+typedef FixedBranchTreeTest< LinkedFixedBranchTree > LinkedFixedBranchTreeTest;
+typedef FixedBranchTreeTest< IndexedFixedBranchTree > IndexedFixedBranchTreeTest;
+
 #endif
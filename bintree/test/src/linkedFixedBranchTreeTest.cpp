@@ -8,28 +8,36 @@
 
 using namespace tree;
 
-std::default_random_engine LinkedFixedBranchTreeTest::mRandom = std::default_random_engine( std::random_device()() );
-std::uniform_int_distribution<> LinkedFixedBranchTreeTest::mIntDist = std::uniform_int_distribution<>();
-std::uniform_int_distribution<> LinkedFixedBranchTreeTest::mChildDist = std::uniform_int_distribution<>( 0, LinkedFixedBranchTreeTest::mNoChildren - 1 );
-std::uniform_real_distribution<> LinkedFixedBranchTreeTest::mProbDist = std::uniform_real_distribution<>( 0, 1 );
-
-LinkedFixedBranchTreeTest::TEST_CTOR( LeafTest, "test isLeaf" )
-
-void LinkedFixedBranchTreeTest::LeafTest::init()
+template< template< typename, size_t > class TreeTT >
+std::default_random_engine FixedBranchTreeTest< TreeTT >::mRandom = std::default_random_engine( std::random_device()() );
+template< template< typename, size_t > class TreeTT >
+std::uniform_int_distribution<> FixedBranchTreeTest< TreeTT >::mIntDist = std::uniform_int_distribution<>();
+template< template< typename, size_t > class TreeTT >
+std::uniform_int_distribution<> FixedBranchTreeTest< TreeTT >::mChildDist = std::uniform_int_distribution<>( 0, FixedBranchTreeTest< TreeTT >::mNoChildren - 1 );
+template< template< typename, size_t > class TreeTT >
+std::uniform_real_distribution<> FixedBranchTreeTest< TreeTT >::mProbDist = std::uniform_real_distribution<>( 0, 1 );
+
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( LeafTest, "test isLeaf" )
+
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::LeafTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
 }
 
-void LinkedFixedBranchTreeTest::LeafTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::LeafTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
     D( std::cout << "expanded: size = " << mpTree->size() << ", height = " << mpTree->height() << std::endl; );
 }
 
 // look for some leaf and test that it does not have any children
-bool LinkedFixedBranchTreeTest::LeafTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::LeafTest::check() const
 {
-    TestTreeT::NodeT n = root( *mpTree );
+    typename TestTreeT::NodeT n = root( *mpTree );
     while( !isLeaf( *mpTree, n ) )
     {
     	auto crange = children( *mpTree, n );
@@ -45,42 +53,50 @@ bool LinkedFixedBranchTreeTest::LeafTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( ExpandSizeTest, "size of tree" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( ExpandSizeTest, "size of tree" )
 
-void LinkedFixedBranchTreeTest::ExpandSizeTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::ExpandSizeTest::init()
 {
     mNoExpansions = 0;
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
 }
 
-void LinkedFixedBranchTreeTest::ExpandSizeTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::ExpandSizeTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
     ++mNoExpansions;
 }
     
-bool LinkedFixedBranchTreeTest::ExpandSizeTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::ExpandSizeTest::check() const
 {
     if( mpTree->size() != mNoChildren * mNoExpansions + 1 )
 	return false;
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( ExpandHeightTest, "height of tree" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( ExpandHeightTest, "height of tree" )
 
-void LinkedFixedBranchTreeTest::ExpandHeightTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::ExpandHeightTest::init()
 {
     mNoExpansions = 0;
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
 }
 
-void LinkedFixedBranchTreeTest::ExpandHeightTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::ExpandHeightTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
     ++mNoExpansions;
 }
 
-bool LinkedFixedBranchTreeTest::ExpandHeightTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::ExpandHeightTest::check() const
 {
     /* min: perfect n-ary tree => size( t ) = b^height( t ) + 1
        max: number of expansions */
@@ -91,20 +107,24 @@ bool LinkedFixedBranchTreeTest::ExpandHeightTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( RootTest,  "test isRoot on deep tree" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( RootTest,  "test isRoot on deep tree" )
 
-void LinkedFixedBranchTreeTest::RootTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::RootTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
     mRoot = root( *mpTree );
 }
 
-void LinkedFixedBranchTreeTest::RootTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::RootTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
 }
 
-bool LinkedFixedBranchTreeTest::RootTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::RootTest::check() const
 {
     if( !isRoot( *mpTree, mRoot ) )
     {
@@ -114,19 +134,23 @@ bool LinkedFixedBranchTreeTest::RootTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( NotRootTest, "test complement of isRoot on deep tree" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( NotRootTest, "test complement of isRoot on deep tree" )
 
-void LinkedFixedBranchTreeTest::NotRootTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::NotRootTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
 }
 
-void LinkedFixedBranchTreeTest::NotRootTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::NotRootTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
 }
 
-bool LinkedFixedBranchTreeTest::NotRootTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::NotRootTest::check() const
 {
     typename TestTreeT::NodeT n = root( *mpTree );
     while( !isLeaf( *mpTree, n ) )
@@ -143,9 +167,11 @@ bool LinkedFixedBranchTreeTest::NotRootTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( DeleteTest, "deletion of children" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( DeleteTest, "deletion of children" )
 
-void LinkedFixedBranchTreeTest::DeleteTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
     mDeletedAt.reset();
@@ -153,10 +179,11 @@ void LinkedFixedBranchTreeTest::DeleteTest::init()
 	randomExpandTree( *mpTree, mIntDist );
 }
 
-void LinkedFixedBranchTreeTest::DeleteTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
-    TestTreeT::NodeT n = root( *mpTree );
+    typename TestTreeT::NodeT n = root( *mpTree );
     while( !isLeaf( *mpTree, n ) && mProbDist( mRandom ) > mTraverseThresh )
     {
 	auto crange = children( *mpTree, n );
@@ -167,7 +194,8 @@ void LinkedFixedBranchTreeTest::DeleteTest::iterate()
     delChildren( *mpTree, n );
 }
 
-bool LinkedFixedBranchTreeTest::DeleteTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::DeleteTest::check() const
 {
     if( !isLeaf( *mpTree, mDeletedAt.value_or( root( *mpTree ) ) ) )
     {
@@ -177,19 +205,22 @@ bool LinkedFixedBranchTreeTest::DeleteTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( DeleteSizeTest, "effect of deletion on size" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( DeleteSizeTest, "effect of deletion on size" )
 
-void LinkedFixedBranchTreeTest::DeleteSizeTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteSizeTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
     for( uint cExpand = 0; cExpand < mTestSize; ++cExpand )
 	randomExpandTree( *mpTree, mIntDist );
 }
 
-void LinkedFixedBranchTreeTest::DeleteSizeTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteSizeTest::iterate()
 {
     randomExpandTree( *mpTree, mIntDist );
-    TestTreeT::NodeT n = root( *mpTree );
+    typename TestTreeT::NodeT n = root( *mpTree );
     while( !isLeaf( *mpTree, n ) && mProbDist( mRandom ) > mTraverseThresh )
     {
 	auto crange = children( *mpTree, n );
@@ -199,7 +230,8 @@ void LinkedFixedBranchTreeTest::DeleteSizeTest::iterate()
     delChildren( *mpTree, n );
 }
 
-bool LinkedFixedBranchTreeTest::DeleteSizeTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::DeleteSizeTest::check() const
 {
     size_t subSize = subtreeSize( *mpTree, root( *mpTree ) );
     if( subSize != mpTree->size() )
@@ -210,9 +242,11 @@ bool LinkedFixedBranchTreeTest::DeleteSizeTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::TEST_CTOR( DeleteHeightTest, "effect of deletion on height" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( DeleteHeightTest, "effect of deletion on height" )
 
-void LinkedFixedBranchTreeTest::DeleteHeightTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteHeightTest::init()
 {
     mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
     for( uint cExpand = 0; cExpand < mTestSize; ++cExpand )
@@ -221,10 +255,11 @@ void LinkedFixedBranchTreeTest::DeleteHeightTest::init()
     D( std::cout << "init delete height test: tree height " << mHeightBefore << std::endl; );
 }
 
-void LinkedFixedBranchTreeTest::DeleteHeightTest::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::DeleteHeightTest::iterate()
 {
     mHeightBefore = mpTree->height();
-    TestTreeT::NodeT n = root( *mpTree );
+    typename TestTreeT::NodeT n = root( *mpTree );
     while( !isLeaf( *mpTree, n ) && mProbDist( mRandom ) > mTraverseThresh )
     {
 	auto crange = children( *mpTree, n );
@@ -235,7 +270,8 @@ void LinkedFixedBranchTreeTest::DeleteHeightTest::iterate()
     D( std::cout << "iterate delete height test: tree height was " << mHeightBefore << std::endl; );
 }
 
-bool LinkedFixedBranchTreeTest::DeleteHeightTest::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::DeleteHeightTest::check() const
 {
     size_t heightNow = mpTree->height();
     if( heightNow > mHeightBefore )
@@ -246,43 +282,94 @@ bool LinkedFixedBranchTreeTest::DeleteHeightTest::check() const
     return true;
 }
 
-LinkedFixedBranchTreeTest::MemoryFreed::Dummy::Dummy()
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::TEST_CTOR( LayoutTest, "breadth first layout keeps structure" )
+
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::LayoutTest::init()
+{
+    mpTree.reset( new TestTreeT( mIntDist( mRandom ) ) );
+}
+
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::LayoutTest::iterate()
+{
+    randomExpandTree( *mpTree, mIntDist );
+    randomExpandTree( *mpTree, mIntDist );
+    typename TestTreeT::NodeT n = root( *mpTree );
+    while( !isLeaf( *mpTree, n ) && mProbDist( mRandom ) > mTraverseThresh )
+    {
+	auto crange = children( *mpTree, n );
+	std::advance( crange.first, mChildDist( mRandom ) );
+	n = *crange.first;
+    }
+    if( !isRoot( *mpTree, n ) )
+	delChildren( *mpTree, n );
+}
+
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::LayoutTest::check() const
+{
+    if constexpr( std::is_same_v< TestTreeT, IndexedFixedBranchTree< int, 10 > > )
+    {
+	const std::vector< int > before = preorder( *mpTree, root( *mpTree ) );
+	const size_t sizeBefore = mpTree->size(), heightBefore = mpTree->height();
+	mpTree->layoutBreadthFirst();
+	if( preorder( *mpTree, root( *mpTree ) ) != before || mpTree->size() != sizeBefore || mpTree->height() != heightBefore
+	    || subtreeSize( *mpTree, root( *mpTree ) ) != sizeBefore )
+	{
+	    std::cout << "structure of tree of size " << sizeBefore << " changed by layout" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::Dummy()
     : mDefaultConstructed( true ) {}
 
-LinkedFixedBranchTreeTest::MemoryFreed::Dummy::Dummy( uint *counterRef, const uint& id )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::Dummy( uint *counterRef, const uint& id )
     : mCounterRef( counterRef ), mId( id ), mDefaultConstructed( false ) { ++(*mCounterRef); }
 
-LinkedFixedBranchTreeTest::MemoryFreed::Dummy::Dummy( const Dummy& orig )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::Dummy( const Dummy& orig )
     : mCounterRef( orig.mCounterRef ), mId( orig.mId ), mDefaultConstructed( orig.mDefaultConstructed )
 {
     if( !mDefaultConstructed )
 	++(*mCounterRef);
 }
 
-LinkedFixedBranchTreeTest::MemoryFreed::Dummy& LinkedFixedBranchTreeTest::MemoryFreed::Dummy::operator =( const Dummy& orig )
+template< template< typename, size_t > class TreeTT >
+typename FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy& FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::operator =( const Dummy& orig )
 {
     mId = orig.mId; // no reference rebinding, so leave counter as is
     return *this;
 }
 
-LinkedFixedBranchTreeTest::MemoryFreed::Dummy::~Dummy()
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::~Dummy()
 {
     if( !mDefaultConstructed )
 	--(*mCounterRef);
 }
 
-bool LinkedFixedBranchTreeTest::MemoryFreed::Dummy::operator ==( const Dummy& other ) { return this->mId == other.mId; }
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::MemoryFreed::Dummy::operator ==( const Dummy& other ) { return this->mId == other.mId; }
 
-LinkedFixedBranchTreeTest::MemoryFreed::MemoryFreed( const uint& testSize, const uint& repetitions )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::MemoryFreed::MemoryFreed( const uint& testSize, const uint& repetitions )
     : ITest( "test tree nodes are freed on destruction of tree", testSize, repetitions )
     , mSizeDist( 0, testSize )
 {}
 
-void LinkedFixedBranchTreeTest::MemoryFreed::MemoryFreed::iterate()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::MemoryFreed::MemoryFreed::iterate()
 {
     mObjectCounter = 0;
     mCreationCounter = 0;
-    mpTree.reset( new LinkedFixedBranchTree< Dummy, mNoChildren >( Dummy( &mObjectCounter, ++mCreationCounter ) ) );
+    mpTree.reset( new TreeTT< Dummy, mNoChildren >( Dummy( &mObjectCounter, ++mCreationCounter ) ) );
 
     for( uint i = 0; i < mSizeDist( mRandom ); ++i )
     {
@@ -302,7 +389,8 @@ void LinkedFixedBranchTreeTest::MemoryFreed::MemoryFreed::iterate()
     mpTree.reset();
 }
     
-bool LinkedFixedBranchTreeTest::MemoryFreed::MemoryFreed::check() const
+template< template< typename, size_t > class TreeTT >
+bool FixedBranchTreeTest< TreeTT >::MemoryFreed::MemoryFreed::check() const
 {
     if( mObjectCounter != 0 )
     {
@@ -313,9 +401,13 @@ bool LinkedFixedBranchTreeTest::MemoryFreed::MemoryFreed::check() const
     return true;
 }
 
-GROUP_CTOR( LinkedFixedBranchTreeTest, "linked fixed branch tree" )
+template< template< typename, size_t > class TreeTT >
+FixedBranchTreeTest< TreeTT >::FixedBranchTreeTest( uint size, uint repetitions, uint level, std::ostream& out )
+    : ITestGroup( mDescription, size, repetitions, level, out )
+{}
 
-void LinkedFixedBranchTreeTest::init()
+template< template< typename, size_t > class TreeTT >
+void FixedBranchTreeTest< TreeTT >::init()
 {
     std::shared_ptr< InterleaveRandomRunner > printerleave( new InterleaveRandomRunner() );
     std::shared_ptr< StatelessRunner > pStateless( new StatelessRunner() );
@@ -329,4 +421,14 @@ void LinkedFixedBranchTreeTest::init()
     addTest( new DeleteSizeTest( 0.5 * mTestSize, mRepetitions ), printerleave );
     addTest( new DeleteHeightTest( 0.25 * mTestSize, mRepetitions ), printerleave );
     addTest( new MemoryFreed( 8 * mTestSize, mRepetitions ), pStateless );
+    if constexpr( std::is_same_v< TestTreeT, IndexedFixedBranchTree< int, 10 > > )
+	addTest( new LayoutTest( 0.5 * mTestSize, mRepetitions ), printerleave );
 }
+
+template<>
+const std::string LinkedFixedBranchTreeTest::mDescription = "linked fixed branch tree";
+template<>
+const std::string IndexedFixedBranchTreeTest::mDescription = "indexed fixed branch tree";
+
+template class FixedBranchTreeTest< LinkedFixedBranchTree >;
+template class FixedBranchTreeTest< IndexedFixedBranchTree >;
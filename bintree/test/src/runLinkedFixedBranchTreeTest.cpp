@@ -5,5 +5,7 @@ int main()
     OnlyOnceRunner oor;
     LinkedFixedBranchTreeTest tst( 100, 1000 );
     oor.run( &tst );
+    IndexedFixedBranchTreeTest indexedTst( 100, 1000 );
+    oor.run( &indexedTst );
     return 0;
 }
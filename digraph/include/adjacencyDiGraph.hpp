@@ -10,6 +10,9 @@
 #include <memory>
 #include <functional>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
 
 #include <assert.h>
 
@@ -46,6 +49,128 @@ namespace graph
 	{
 	    return std::find( BaseT::begin(), BaseT::end(), val );
 	}
+
+	//! \return bytes allocated on the heap
+	size_t heapBytes() const { return BaseT::capacity() * sizeof( T ); }
+    };
+
+    /*!
+      \class element hash: hash used by HashVec
+      \note defaults to calling hash() on the element, std::hash is used for arithmetic types
+    */
+    template< typename T, typename EnableT = void >
+    struct ElementHash
+    {
+	size_t operator ()( const T& val ) const { return val.hash(); }
+    };
+
+    template< typename T >
+    struct ElementHash< T, typename std::enable_if< std::is_arithmetic< T >::value >::type >
+    {
+	size_t operator ()( const T& val ) const { return std::hash< T >()( val ); }
+    };
+
+    /*!
+      \class hash vector: insert vector that indexes its elements by ElementHash once it grows beyond INDEX_THRESHOLD
+      below the threshold find is a linear search, above it takes constant time on average
+      \note erase moves the last element into the position of the erased one
+    */
+    template< typename T >
+    class HashVec : public std::vector< T >
+    {
+      public:
+	typedef std::vector< T > BaseT;
+
+	static constexpr size_t INDEX_THRESHOLD = 16;
+
+	HashVec() {}
+
+	HashVec( typename BaseT::const_iterator istart
+		 , typename BaseT::const_iterator iend )
+	{
+	    for( ; istart != iend; ++istart )
+		insert( *istart );
+	}
+
+	typename BaseT::const_iterator insert( const T& val )
+	{
+	    BaseT::push_back( val );
+	    if( mIndexed )
+		mIndex.emplace( mHash( val ), BaseT::size() - 1 );
+	    else if( BaseT::size() > INDEX_THRESHOLD )
+		buildIndex();
+	    return BaseT::end() - 1;
+	}
+
+	typename BaseT::const_iterator find( const T& val ) const
+	{
+	    if( !mIndexed )
+		return std::find( BaseT::begin(), BaseT::end(), val );
+
+	    auto range = mIndex.equal_range( mHash( val ) );
+	    for( ; range.first != range.second; ++range.first )
+		if( BaseT::operator []( range.first->second ) == val )
+		    return BaseT::begin() + range.first->second;
+	    return BaseT::end();
+	}
+
+	//! \return iterator to the element moved into the position of ierase, end if ierase was last
+	typename BaseT::const_iterator erase( typename BaseT::const_iterator ierase )
+	{
+	    const size_t pos = ierase - BaseT::cbegin()
+		, last = BaseT::size() - 1;
+	    if( mIndexed )
+	    {
+		unindex( pos );
+		if( pos != last )
+		{
+		    unindex( last );
+		    mIndex.emplace( mHash( BaseT::back() ), pos );
+		}
+	    }
+	    if( pos != last )
+		BaseT::operator []( pos ) = BaseT::back();
+	    BaseT::pop_back();
+	    return BaseT::cbegin() + pos;
+	}
+
+	void clear()
+	{
+	    BaseT::clear();
+	    mIndex.clear();
+	    mIndexed = false;
+	}
+
+	//! \return bytes allocated on the heap, nodes of the index are estimated as an entry and a link
+	size_t heapBytes() const
+	{
+	    return BaseT::capacity() * sizeof( T ) + mIndex.bucket_count() * sizeof( void* )
+		+ mIndex.size() * ( sizeof( std::pair< size_t, size_t > ) + sizeof( void* ) );
+	}
+
+      private:
+	void buildIndex()
+	{
+	    mIndex.reserve( 2 * BaseT::size() );
+	    for( size_t i = 0; i < BaseT::size(); ++i )
+		mIndex.emplace( mHash( BaseT::operator []( i ) ), i );
+	    mIndexed = true;
+	}
+
+	void unindex( const size_t& pos )
+	{
+	    auto range = mIndex.equal_range( mHash( BaseT::operator []( pos ) ) );
+	    for( ; range.first != range.second; ++range.first )
+		if( range.first->second == pos )
+		{
+		    mIndex.erase( range.first );
+		    return;
+		}
+	}
+
+	ElementHash< T > mHash;
+	std::unordered_multimap< size_t, size_t > mIndex;
+	bool mIndexed = false;
     };
 
     //! \class vector map: simpler replacement for vertex map
@@ -101,10 +226,122 @@ namespace graph
 	{
 	    return ValueIterator( BaseT::erase( this->find( key ) ) );
 	}
+
+	//! \return bytes allocated on the heap
+	size_t heapBytes() const { return BaseT::capacity() * sizeof( std::pair< K, V > ); }
       private:
 	ComparatorT mComp;
     };
 
+    /*!
+      \class key index: maps keys of an IndexMap to dense, unique indices
+      \note defaults to calling index() on the key; pointers are dereferenced and integral keys are used as is
+    */
+    template< typename K, typename EnableT = void >
+    struct KeyIndex
+    {
+	size_t operator ()( const K& key ) const { return key.index(); }
+    };
+
+    template< typename K >
+    struct KeyIndex< K*, void >
+    {
+	size_t operator ()( K* const& key ) const { return key->index(); }
+    };
+
+    template< typename K >
+    struct KeyIndex< K, typename std::enable_if< std::is_integral< K >::value >::type >
+    {
+	size_t operator ()( const K& key ) const { return static_cast< size_t >( key ); }
+    };
+
+    /*!
+      \class index map: vertex map with constant time find, insert and erase
+      values are stored densely, slots indexed by KeyIndex< K > locate their position
+      \note indices should be small and unique among the keys stored, as the slot table grows up to the largest index
+      \note erase moves the last value into the position of the erased one
+    */
+    template< typename K, typename V, typename ComparatorT >
+    class IndexMap : public std::vector< std::pair< K, V > >
+    {
+      public:
+	typedef std::vector< std::pair< K, V > > BaseT;
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef const mapped_type& reference;
+	typedef const mapped_type* pointer;
+
+	struct ValueIterator : public BaseT::const_iterator
+	{
+	    ValueIterator() = default;
+
+	    ValueIterator( const typename BaseT::const_iterator& i ) : BaseT::const_iterator( i ) {}
+
+	    ValueIterator( const ValueIterator& ci ) : BaseT::const_iterator( ci ) {}
+
+	    ValueIterator& operator =( const ValueIterator& ci ) {  BaseT::const_iterator::operator =( ci ); return *this; }
+
+	    const mapped_type& operator *() const { return (BaseT::const_iterator::operator *()).second; }
+
+	    const mapped_type* operator ->() const { return &(BaseT::const_iterator::operator *()).second; }
+	};
+
+	IndexMap( const ComparatorT& comp )
+	    : mComp( comp )
+	{}
+
+	ValueIterator find( const K& key ) const
+	{
+	    const size_t pos = position( key );
+	    if( pos == NO_POSITION || !mComp( BaseT::operator []( pos ).first, key ) )
+		return ValueIterator( BaseT::end() );
+	    return ValueIterator( BaseT::begin() + pos );
+	}
+
+	ValueIterator insert( const K& key, const V& val )
+	{
+	    const size_t index = mIndex( key );
+	    if( index >= mSlots.size() )
+		mSlots.resize( std::max( index + 1, 2 * mSlots.size() ), NO_POSITION );
+	    mSlots[ index ] = BaseT::size();
+	    BaseT::push_back( std::make_pair( key, val ) );
+	    return ValueIterator( BaseT::end() - 1 );
+	}
+
+	//! \return iterator to the value moved into the position of key, end if key was stored last
+	ValueIterator erase( const K& key )
+	{
+	    const size_t pos = position( key );
+	    if( pos == NO_POSITION )
+		return ValueIterator( BaseT::end() );
+
+	    mSlots[ mIndex( key ) ] = NO_POSITION;
+	    if( pos != BaseT::size() - 1 )
+	    {
+		BaseT::operator []( pos ) = BaseT::back();
+		mSlots[ mIndex( BaseT::operator []( pos ).first ) ] = pos;
+	    }
+	    BaseT::pop_back();
+	    return ValueIterator( BaseT::begin() + pos );
+	}
+
+	//! \return bytes allocated on the heap
+	size_t heapBytes() const { return BaseT::capacity() * sizeof( std::pair< K, V > ) + mSlots.capacity() * sizeof( size_t ); }
+
+      private:
+	static constexpr size_t NO_POSITION = std::numeric_limits< size_t >::max();
+
+	size_t position( const K& key ) const
+	{
+	    const size_t index = mIndex( key );
+	    return index < mSlots.size() ? mSlots[ index ] : NO_POSITION;
+	}
+
+	KeyIndex< K > mIndex;
+	std::vector< size_t > mSlots;
+	ComparatorT mComp;
+    };
+
     /*!
       directed graph implemented by means of adjacency containers for incoming and outgoing edges
       values stored are used as a basis for comparison and therefore are immutable
@@ -210,6 +447,14 @@ namespace graph
 		return this->mSource == other.mSource &&
 		    this->mTarget == other.mTarget;
 	    }
+
+	    //! \return hash of the nodes linked, consistent with equality as values are unique within a graph
+	    size_t hash() const
+	    {
+		const size_t hsrc = std::hash< InternalNode* >()( mSource.mPtr.get() )
+		    , htrg = std::hash< InternalNode* >()( mTarget.mPtr.get() );
+		return hsrc ^ ( htrg + 0x9e3779b9 + ( hsrc << 6 ) + ( hsrc >> 2 ) );
+	    }
 	  private:
 	    VertexT mSource, mTarget;
 	};
@@ -361,6 +606,18 @@ namespace graph
 	    return std::make_pair( ieSrc, ieTrg );
 	}
 
+	//! \return bytes allocated on the heap for vertices, the container and the shared nodes, estimating a control block as two words
+	size_t vertexBytes() const { return mVertices.heapBytes() + size() * ( sizeof( InternalNode ) + 2 * sizeof( long ) ); }
+
+	//! \return bytes allocated on the heap for the in and out edge containers of all vertices
+	size_t edgeBytes() const
+	{
+	    size_t bytes = 0;
+	    for( const std::pair< T, Node >& n : mVertices )
+		bytes += n.second.mPtr->mIns.heapBytes() + n.second.mPtr->mOuts.heapBytes();
+	    return bytes;
+	}
+
 	~AdjacencyDiGraph()
 	{
 	    for( std::pair< T, Node >& n : mVertices )
@@ -496,20 +753,19 @@ namespace graph
     ADJ_GRAPH_TEMPLATE
     std::pair< typename AGRAPH::OutIterT, typename AGRAPH::InIterT > removeEdge( AGRAPH& ag, const typename AGRAPH::VertexT& src, const typename AGRAPH::VertexT& trg ) { return ag.removeEdge( src, trg ); }
 
-    template< typename T
-	      , template< typename K, typename V, typename CmpT > typename VCT
-	      , template< typename S > typename OECT
-	      , template< typename S > typename IECT
-	      , typename ComparatorT
-	      , typename CharT, typename Traits
-	      , typename P>
-    std::basic_ostream< CharT, Traits >& print( std::basic_ostream< CharT, Traits >& os, const AGRAPH& ag, const typename AGRAPH::VertexT& v
-						, const std::function< P( const typename AGRAPH::ValueT& ) >& converter = [] (const typename AGRAPH::ValueT& v) { return v; } )
+    /*!
+      \brief prints v between the sources of its in-edges and the targets of its out-edges, one edge of each per line
+      \param converter maps values of G to printable objects
+      \note graph functions are found by argument dependent lookup, so graph types declared later can be printed
+    */
+    template< typename G, typename CharT, typename Traits, typename ConverterT >
+    std::basic_ostream< CharT, Traits >& printAdjacencies( std::basic_ostream< CharT, Traits >& os, const G& ag, const typename G::VertexT& v
+							   , const ConverterT& converter )
     {
 	const int segmentSize = 40;
 	    
-	typename DiGraphTraits< AGRAPH >::InRangeT ins = graph::inEdges( ag, v );
-	typename DiGraphTraits< AGRAPH >::OutRangeT outs = graph::outEdges( ag, v );
+	typename DiGraphTraits< G >::InRangeT ins = inEdges( ag, v );
+	typename DiGraphTraits< G >::OutRangeT outs = outEdges( ag, v );
 	uint maxInOut = std::max( std::distance( ins.first, ins.second )
 				  , std::distance( outs.first, outs.second ) );
 	
@@ -517,13 +773,13 @@ namespace graph
 	for( uint cEdge = 0; cEdge < maxInOut || cEdge == 0; ++cEdge )
 	{
 	    if( ins.first != ins.second )
-		line << converter( graph::value( ag, graph::source( ag, *ins.first ) ) ) << " ->";
+		line << converter( value( ag, source( ag, *ins.first ) ) ) << " ->";
 	    line << std::setw( std::max( 0, segmentSize - static_cast< const int&& >( line.str().size() ) ) );
 	    if( cEdge == std::floor( maxInOut / 2.0 ) )
-		line << converter( graph::value( ag, v ) );
+		line << converter( value( ag, v ) );
 	    line << std::setw( std::max( 0, 2 * segmentSize - static_cast< const int&& >( line.str().size() ) ) ) << " ";
 	    if( outs.first != outs.second )
-	    	line << "-> " << converter( graph::value( ag, graph::target( ag, *outs.first ) ) );
+	    	line << "-> " << converter( value( ag, target( ag, *outs.first ) ) );
 	    os << line.str() << std::endl;
 	    line.str( std::string() );
 	    
@@ -535,6 +791,19 @@ namespace graph
 	return os;
     }
 
+    template< typename T
+	      , template< typename K, typename V, typename CmpT > typename VCT
+	      , template< typename S > typename OECT
+	      , template< typename S > typename IECT
+	      , typename ComparatorT
+	      , typename CharT, typename Traits
+	      , typename P>
+    std::basic_ostream< CharT, Traits >& print( std::basic_ostream< CharT, Traits >& os, const AGRAPH& ag, const typename AGRAPH::VertexT& v
+						, const std::function< P( const typename AGRAPH::ValueT& ) >& converter = [] (const typename AGRAPH::ValueT& v) { return v; } )
+    {
+	return printAdjacencies( os, ag, v, converter );
+    }
+
     template< typename T
 	      , template< typename K, typename V, typename CmpT > typename VCT
 	      , template< typename S > typename OECT
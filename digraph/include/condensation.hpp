@@ -0,0 +1,153 @@
+#ifndef CONDENSATION_HPP
+#define CONDENSATION_HPP
+
+#include "diGraphInterface.hpp"
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+namespace graph
+{
+    /*!
+      \class strongly connected components of a compressed snapshot and the acyclic graph condensing them
+      components are numbered in the order tarjan's algorithm completes them, which is a reverse topological order: edges between components
+      lead from higher to lower numbers, so a pass over components in increasing order sees all successors of a component before the component
+      \param CsrT graph with dense vertex indices, such as CsrDiGraph
+      \note iterative, so long paths do not exhaust the call stack
+    */
+    template< typename CsrT >
+    class Condensation
+    {
+      public:
+	typedef typename CsrT::VertexT VertexT;
+	typedef uint32_t ComponentT;
+
+	static constexpr ComponentT NO_COMPONENT = std::numeric_limits< ComponentT >::max();
+
+	Condensation() : mMemberOffsets( 1, 0 ), mSuccessorOffsets( 1, 0 ) {}
+
+	explicit Condensation( const CsrT& g ) { assign( g ); }
+
+	//! \brief recomputes the components of g and the edges between them
+	void assign( const CsrT& g )
+	{
+	    const size_t n = g.size();
+	    mComponents.assign( n, NO_COMPONENT );
+	    mMembers.clear();
+	    mMemberOffsets.assign( 1, 0 );
+	    mCyclic.clear();
+
+	    // tarjan with an explicit stack of vertices and the position in their out edges
+	    std::vector< VertexT > order( n, NO_INDEX ), low( n ), stack;
+	    std::vector< std::pair< VertexT, typename CsrT::OutIterT > > calls;
+	    VertexT counter = 0;
+	    for( VertexT root = 0; root < n; ++root )
+	    {
+		if( order[ root ] != NO_INDEX )
+		    continue;
+		order[ root ] = low[ root ] = counter++;
+		stack.push_back( root );
+		calls.push_back( std::make_pair( root, g.outEdges( root ).first ) );
+		while( !calls.empty() )
+		{
+		    const VertexT v = calls.back().first;
+		    typename CsrT::OutIterT& iout = calls.back().second;
+		    if( iout != g.outEdges( v ).second )
+		    {
+			const VertexT w = g.target( *iout );
+			++iout;
+			if( order[ w ] == NO_INDEX )
+			{
+			    order[ w ] = low[ w ] = counter++;
+			    stack.push_back( w );
+			    calls.push_back( std::make_pair( w, g.outEdges( w ).first ) );
+			}
+			else if( mComponents[ w ] == NO_COMPONENT )
+			    low[ v ] = std::min( low[ v ], order[ w ] );
+			continue;
+		    }
+
+		    calls.pop_back();
+		    if( !calls.empty() )
+			low[ calls.back().first ] = std::min( low[ calls.back().first ], low[ v ] );
+		    if( low[ v ] != order[ v ] )
+			continue;
+		    const ComponentT c = mCyclic.size();
+		    VertexT w;
+		    do
+		    {
+			w = stack.back();
+			stack.pop_back();
+			mComponents[ w ] = c;
+			mMembers.push_back( w );
+		    } while( w != v );
+		    mMemberOffsets.push_back( mMembers.size() );
+		    mCyclic.push_back( mMemberOffsets[ c + 1 ] - mMemberOffsets[ c ] > 1 || g.findEdgeTo( v, v ) != g.outEdges( v ).second );
+		}
+	    }
+
+	    // distinct successors of each component, marked by the component last adding them
+	    mSuccessors.clear();
+	    mSuccessorOffsets.assign( 1, 0 );
+	    std::vector< ComponentT > addedBy( size(), NO_COMPONENT );
+	    for( ComponentT c = 0; c < size(); ++c )
+	    {
+		for( auto m = members( c ); m.first != m.second; ++m.first )
+		{
+		    for( auto outs = g.outEdges( *m.first ); outs.first != outs.second; ++outs.first )
+		    {
+			const ComponentT d = mComponents[ g.target( *outs.first ) ];
+			if( d != c && addedBy[ d ] != c )
+			{
+			    addedBy[ d ] = c;
+			    mSuccessors.push_back( d );
+			}
+		    }
+		}
+		mSuccessorOffsets.push_back( mSuccessors.size() );
+	    }
+	}
+
+	//! \return number of components
+	size_t size() const { return mCyclic.size(); }
+
+	//! \return component of v
+	ComponentT component( const VertexT& v ) const { return mComponents[ v ]; }
+
+	//! \return range of the vertices of c
+	std::pair< const VertexT*, const VertexT* > members( const ComponentT& c ) const
+	{
+	    return std::make_pair( mMembers.data() + mMemberOffsets[ c ], mMembers.data() + mMemberOffsets[ c + 1 ] );
+	}
+
+	//! \return range of the distinct components other than c reached by an edge from c, all numbered lower than c
+	std::pair< const ComponentT*, const ComponentT* > successors( const ComponentT& c ) const
+	{
+	    return std::make_pair( mSuccessors.data() + mSuccessorOffsets[ c ], mSuccessors.data() + mSuccessorOffsets[ c + 1 ] );
+	}
+
+	//! \return true if c contains a cycle, i.e. it has more than one vertex or a loop
+	bool isCyclic( const ComponentT& c ) const { return mCyclic[ c ]; }
+
+	//! \return bytes allocated on the heap
+	size_t heapBytes() const
+	{
+	    return ( mComponents.capacity() + mSuccessors.capacity() ) * sizeof( ComponentT )
+		+ ( mMembers.capacity() + mMemberOffsets.capacity() + mSuccessorOffsets.capacity() ) * sizeof( VertexT ) + mCyclic.capacity() / 8;
+	}
+
+      private:
+	static constexpr VertexT NO_INDEX = std::numeric_limits< VertexT >::max();
+
+	std::vector< ComponentT > mComponents;
+	std::vector< VertexT > mMembers, mMemberOffsets;
+	std::vector< ComponentT > mSuccessors;
+	std::vector< VertexT > mSuccessorOffsets;
+	std::vector< bool > mCyclic;
+    };
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef CSR_DI_GRAPH_HPP
+#define CSR_DI_GRAPH_HPP
+
+#include "diGraphInterface.hpp"
+#include "adjacencyDiGraph.hpp"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+namespace graph
+{
+    /*!
+      \class read-only compressed sparse row snapshot of a directed graph
+      vertices are dense 32 bit indices assigned in the order of vertices( g ), out and in adjacencies are stored contiguously
+      \param G graph type to take snapshots of, has to comply with the interface of diGraphInterface.hpp
+      \param KeyIndexT maps each value of G to a unique index, used to translate vertices of G into dense indices
+      \note the snapshot does not observe modifications of the graph it was taken from, call assign to rebuild it
+    */
+    template< typename G, typename KeyIndexT = KeyIndex< typename G::ValueT > >
+    class CsrDiGraph
+    {
+      public:
+	typedef typename G::ValueT ValueT;
+	typedef uint32_t VertexT;
+	typedef typename G::VertexT OriginalVertexT;
+
+	static constexpr VertexT NO_VERTEX = std::numeric_limits< VertexT >::max();
+
+	struct Edge
+	{
+	    VertexT mSource, mTarget;
+
+	    bool operator ==( const Edge& other ) const { return mSource == other.mSource && mTarget == other.mTarget; }
+	};
+	typedef Edge EdgeT;
+
+	//! \class random access iterator over vertex indices
+	class VertexIterator
+	{
+	  public:
+	    typedef std::random_access_iterator_tag iterator_category;
+	    typedef VertexT value_type;
+	    typedef std::ptrdiff_t difference_type;
+	    typedef const VertexT* pointer;
+	    typedef VertexT reference;
+
+	    VertexIterator() : mV( 0 ) {}
+
+	    explicit VertexIterator( const VertexT& v ) : mV( v ) {}
+
+	    VertexT operator *() const { return mV; }
+	    VertexT operator []( const difference_type& n ) const { return mV + n; }
+
+	    VertexIterator& operator ++() { ++mV; return *this; }
+	    VertexIterator operator ++( int ) { VertexIterator old( *this ); ++mV; return old; }
+	    VertexIterator& operator --() { --mV; return *this; }
+	    VertexIterator operator --( int ) { VertexIterator old( *this ); --mV; return old; }
+	    VertexIterator& operator +=( const difference_type& n ) { mV += n; return *this; }
+	    VertexIterator& operator -=( const difference_type& n ) { mV -= n; return *this; }
+	    VertexIterator operator +( const difference_type& n ) const { return VertexIterator( mV + n ); }
+	    VertexIterator operator -( const difference_type& n ) const { return VertexIterator( mV - n ); }
+	    difference_type operator -( const VertexIterator& other ) const { return difference_type( mV ) - difference_type( other.mV ); }
+
+	    bool operator ==( const VertexIterator& other ) const { return mV == other.mV; }
+	    bool operator !=( const VertexIterator& other ) const { return mV != other.mV; }
+	    bool operator <( const VertexIterator& other ) const { return mV < other.mV; }
+	    bool operator >( const VertexIterator& other ) const { return mV > other.mV; }
+	    bool operator <=( const VertexIterator& other ) const { return mV <= other.mV; }
+	    bool operator >=( const VertexIterator& other ) const { return mV >= other.mV; }
+	  private:
+	    VertexT mV;
+	};
+
+	/*!
+	  \class random access iterator over one adjacency row, dereferences to edges by value
+	  \param OUT true if the row stores targets of out-edges, false if it stores sources of in-edges
+	*/
+	template< bool OUT >
+	class EdgeIterator
+	{
+	  public:
+	    typedef std::random_access_iterator_tag iterator_category;
+	    typedef Edge value_type;
+	    typedef std::ptrdiff_t difference_type;
+	    typedef const Edge* pointer;
+	    typedef Edge reference;
+
+	    EdgeIterator() : mpAdj( nullptr ), mV( NO_VERTEX ) {}
+
+	    EdgeIterator( const VertexT* pAdj, const VertexT& v ) : mpAdj( pAdj ), mV( v ) {}
+
+	    Edge operator *() const { return OUT ? Edge{ mV, *mpAdj } : Edge{ *mpAdj, mV }; }
+	    Edge operator []( const difference_type& n ) const { return *(*this + n); }
+
+	    EdgeIterator& operator ++() { ++mpAdj; return *this; }
+	    EdgeIterator operator ++( int ) { EdgeIterator old( *this ); ++mpAdj; return old; }
+	    EdgeIterator& operator --() { --mpAdj; return *this; }
+	    EdgeIterator operator --( int ) { EdgeIterator old( *this ); --mpAdj; return old; }
+	    EdgeIterator& operator +=( const difference_type& n ) { mpAdj += n; return *this; }
+	    EdgeIterator& operator -=( const difference_type& n ) { mpAdj -= n; return *this; }
+	    EdgeIterator operator +( const difference_type& n ) const { return EdgeIterator( mpAdj + n, mV ); }
+	    EdgeIterator operator -( const difference_type& n ) const { return EdgeIterator( mpAdj - n, mV ); }
+	    difference_type operator -( const EdgeIterator& other ) const { return mpAdj - other.mpAdj; }
+
+	    bool operator ==( const EdgeIterator& other ) const { return mpAdj == other.mpAdj; }
+	    bool operator !=( const EdgeIterator& other ) const { return mpAdj != other.mpAdj; }
+	    bool operator <( const EdgeIterator& other ) const { return mpAdj < other.mpAdj; }
+	    bool operator >( const EdgeIterator& other ) const { return mpAdj > other.mpAdj; }
+	    bool operator <=( const EdgeIterator& other ) const { return mpAdj <= other.mpAdj; }
+	    bool operator >=( const EdgeIterator& other ) const { return mpAdj >= other.mpAdj; }
+	  private:
+	    const VertexT* mpAdj;
+	    VertexT mV;
+	};
+
+	typedef VertexIterator VIterT;
+	typedef EdgeIterator< true > OutIterT;
+	typedef EdgeIterator< false > InIterT;
+
+	CsrDiGraph( const KeyIndexT& keyIndex = KeyIndexT() )
+	    : mKeyIndex( keyIndex )
+	    , mOutOffsets( 1, 0 )
+	    , mInOffsets( 1, 0 )
+	{}
+
+	CsrDiGraph( const G& g, const KeyIndexT& keyIndex = KeyIndexT() )
+	    : mKeyIndex( keyIndex )
+	{
+	    assign( g );
+	}
+
+	//! \brief rebuilds the snapshot from g, rows are sorted by index
+	void assign( const G& g )
+	{
+	    mValues.clear();
+	    mOriginals.clear();
+	    mSlots.clear();
+	    mOutOffsets.assign( 1, 0 );
+	    mOutTargets.clear();
+	    mInOffsets.assign( 1, 0 );
+	    mInSources.clear();
+
+	    const size_t nv = graph::size( g );
+	    mValues.reserve( nv );
+	    mOriginals.reserve( nv );
+	    for( auto vs = graph::vertices( g ); vs.first != vs.second; ++vs.first )
+	    {
+		const ValueT& val = graph::value( g, *vs.first );
+		const size_t slot = mKeyIndex( val );
+		if( slot >= mSlots.size() )
+		    mSlots.resize( std::max( slot + 1, 2 * mSlots.size() ), NO_VERTEX );
+		mSlots[ slot ] = mValues.size();
+		mValues.push_back( val );
+		mOriginals.push_back( *vs.first );
+	    }
+
+	    mOutOffsets.reserve( nv + 1 );
+	    mInOffsets.reserve( nv + 1 );
+	    for( const OriginalVertexT& ov : mOriginals )
+	    {
+		const size_t outBegin = mOutTargets.size();
+		for( auto outs = graph::outEdges( g, ov ); outs.first != outs.second; ++outs.first )
+		    mOutTargets.push_back( index( graph::value( g, graph::target( g, *outs.first ) ) ) );
+		std::sort( mOutTargets.begin() + outBegin, mOutTargets.end() );
+		mOutOffsets.push_back( mOutTargets.size() );
+
+		const size_t inBegin = mInSources.size();
+		for( auto ins = graph::inEdges( g, ov ); ins.first != ins.second; ++ins.first )
+		    mInSources.push_back( index( graph::value( g, graph::source( g, *ins.first ) ) ) );
+		std::sort( mInSources.begin() + inBegin, mInSources.end() );
+		mInOffsets.push_back( mInSources.size() );
+	    }
+	}
+
+	size_t size() const { return mValues.size(); }
+
+	//! \return number of edges stored
+	size_t edgeCount() const { return mOutTargets.size(); }
+
+	//! \return bytes allocated on the heap
+	size_t heapBytes() const
+	{
+	    return mValues.capacity() * sizeof( ValueT ) + mOriginals.capacity() * sizeof( OriginalVertexT )
+		+ ( mSlots.capacity() + mOutOffsets.capacity() + mOutTargets.capacity() + mInOffsets.capacity() + mInSources.capacity() ) * sizeof( VertexT );
+	}
+
+	const ValueT& value( const VertexT& v ) const { return mValues[ v ]; }
+
+	//! \return vertex of the graph the snapshot was taken from corresponding to v
+	const OriginalVertexT& original( const VertexT& v ) const { return mOriginals[ v ]; }
+
+	//! \return index of the vertex storing val, NO_VERTEX if none exists
+	VertexT index( const ValueT& val ) const
+	{
+	    const size_t slot = mKeyIndex( val );
+	    return slot < mSlots.size() ? mSlots[ slot ] : NO_VERTEX;
+	}
+
+	std::pair< VIterT, VIterT > vertices() const
+	{
+	    return std::make_pair( VIterT( 0 ), VIterT( mValues.size() ) );
+	}
+
+	VIterT findVertex( const ValueT& val ) const
+	{
+	    const VertexT v = index( val );
+	    return v == NO_VERTEX ? VIterT( mValues.size() ) : VIterT( v );
+	}
+
+	std::pair< OutIterT, OutIterT > outEdges( const VertexT& v ) const
+	{
+	    const VertexT* pRow = mOutTargets.data();
+	    return std::make_pair( OutIterT( pRow + mOutOffsets[ v ], v ), OutIterT( pRow + mOutOffsets[ v + 1 ], v ) );
+	}
+
+	std::pair< InIterT, InIterT > inEdges( const VertexT& v ) const
+	{
+	    const VertexT* pRow = mInSources.data();
+	    return std::make_pair( InIterT( pRow + mInOffsets[ v ], v ), InIterT( pRow + mInOffsets[ v + 1 ], v ) );
+	}
+
+	//! \return edge in src to trg, found by binary search
+	OutIterT findEdgeTo( const VertexT& src, const VertexT& trg ) const
+	{
+	    const VertexT* pBegin = mOutTargets.data() + mOutOffsets[ src ]
+		, *pEnd = mOutTargets.data() + mOutOffsets[ src + 1 ]
+		, *pFound = std::lower_bound( pBegin, pEnd, trg );
+	    return OutIterT( pFound != pEnd && *pFound == trg ? pFound : pEnd, src );
+	}
+
+	//! \return edge in trg from src, found by binary search
+	InIterT findEdgeFrom( const VertexT& src, const VertexT& trg ) const
+	{
+	    const VertexT* pBegin = mInSources.data() + mInOffsets[ trg ]
+		, *pEnd = mInSources.data() + mInOffsets[ trg + 1 ]
+		, *pFound = std::lower_bound( pBegin, pEnd, src );
+	    return InIterT( pFound != pEnd && *pFound == src ? pFound : pEnd, trg );
+	}
+
+	VertexT source( const EdgeT& e ) const { return e.mSource; }
+
+	VertexT target( const EdgeT& e ) const { return e.mTarget; }
+
+      private:
+	KeyIndexT mKeyIndex;
+	std::vector< ValueT > mValues;
+	std::vector< OriginalVertexT > mOriginals;
+	std::vector< VertexT > mSlots;
+	std::vector< VertexT > mOutOffsets, mOutTargets;
+	std::vector< VertexT > mInOffsets, mInSources;
+    };
+
+    template< typename G, typename K >
+    const typename CsrDiGraph< G, K >::ValueT& value( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::VertexT& v ) { return csr.value( v ); }
+
+    template< typename G, typename K >
+    typename CsrDiGraph< G, K >::VertexT source( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::EdgeT& e ) { return csr.source( e ); }
+
+    template< typename G, typename K >
+    typename CsrDiGraph< G, K >::VertexT target( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::EdgeT& e ) { return csr.target( e ); }
+
+    template< typename G, typename K >
+    typename DiGraphTraits< CsrDiGraph< G, K > >::VRangeT vertices( const CsrDiGraph< G, K >& csr ) { return csr.vertices(); }
+
+    template< typename G, typename K >
+    typename DiGraphTraits< CsrDiGraph< G, K > >::OutRangeT outEdges( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::VertexT& v ) { return csr.outEdges( v ); }
+
+    template< typename G, typename K >
+    typename DiGraphTraits< CsrDiGraph< G, K > >::InRangeT inEdges( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::VertexT& v ) { return csr.inEdges( v ); }
+
+    template< typename G, typename K >
+    typename CsrDiGraph< G, K >::VIterT findVertex( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::ValueT& val ) { return csr.findVertex( val ); }
+
+    template< typename G, typename K >
+    typename CsrDiGraph< G, K >::OutIterT findEdgeTo( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::VertexT& src, const typename CsrDiGraph< G, K >::VertexT& trg ) { return csr.findEdgeTo( src, trg ); }
+
+    template< typename G, typename K >
+    typename CsrDiGraph< G, K >::InIterT findEdgeFrom( const CsrDiGraph< G, K >& csr, const typename CsrDiGraph< G, K >::VertexT& src, const typename CsrDiGraph< G, K >::VertexT& trg ) { return csr.findEdgeFrom( src, trg ); }
+}
+
+#endif
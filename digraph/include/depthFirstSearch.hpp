@@ -3,6 +3,7 @@
 
 #include <unordered_set>
 #include <functional>
+#include <vector>
 
 namespace graph
 {
@@ -62,72 +63,109 @@ namespace graph
 	c.visit( g, v, visited );
     }
 
-    //! \brief helper to perform edge exploration
-    //! \param e edge to explore
-    //! \param v endpoint of e from which to explore
-    //! \param u endpoint of e to which to explore
-    template< typename DiGraphT, typename ControlT, typename UnorderedSetT >
-    void dftExplore( DiGraphT& g, const typename DiGraphT::VertexT& v, const typename DiGraphT::VertexT& u, const typename DiGraphT::EdgeT& e
-		     , ControlT& c, UnorderedSetT& visited
-		     , const std::function< ControlT&( DiGraphT&, const typename DiGraphT::VertexT&, ControlT&, UnorderedSetT& ) >& recCall )
+    //! \brief edges traversed by forward (FORWARD = true) or backward traversals
+    template< bool FORWARD >
+    struct DFTDirection
     {
-	c.explore( g, e );
-	if( c.isBacktrack( g, u, visited ) || visited.find( u ) != visited.end() )
-	    c.backtrack( g, u, visited );
-	else
-	{
-	    recCall( g, u, c, visited );
-	    c.returned( g, e );
-	}
-    }
+	template< typename DiGraphT >
+	static auto edges( DiGraphT& g, const typename DiGraphT::VertexT& v ) { return outEdges( g, v ); }
+
+	//! \return endpoint of e to which to explore
+	template< typename DiGraphT >
+	static typename DiGraphT::VertexT next( DiGraphT& g, const typename DiGraphT::EdgeT& e ) { return target( g, e ); }
+    };
+
+    template<>
+    struct DFTDirection< false >
+    {
+	template< typename DiGraphT >
+	static auto edges( DiGraphT& g, const typename DiGraphT::VertexT& v ) { return inEdges( g, v ); }
+
+	template< typename DiGraphT >
+	static typename DiGraphT::VertexT next( DiGraphT& g, const typename DiGraphT::EdgeT& e ) { return source( g, e ); }
+    };
 
     /*!
-      \brief performs dfs traversal forward
+      \brief performs dfs traversal on an explicit stack, notifying c of the same events in the same order as a recursive traversal
       \param g graph to traverse
       \param v node at which to start traversal
       \param c is notified of events in search and controls termination
-      \param visited set of nodes visited
+      \param visited set of nodes visited, supporting insert( v ) and count( v ), e.g. std::unordered_set or VisitSet
+      \note g must not be modified structurally during the traversal
     */
-    template< typename DiGraphT, typename ControlT, typename UnorderedSetT >
-    ControlT& forwardDFTRecursive( DiGraphT& g, const typename DiGraphT::VertexT& v, ControlT& c, UnorderedSetT& visited )
+    template< bool FORWARD, typename DiGraphT, typename ControlT, typename UnorderedSetT >
+    ControlT& dftIterative( DiGraphT& g, const typename DiGraphT::VertexT& v, ControlT& c, UnorderedSetT& visited )
     {
-	std::function< ControlT&( DiGraphT&, const typename DiGraphT::VertexT&, ControlT&, UnorderedSetT& ) >
-	    selfCall( forwardDFTRecursive< DiGraphT, ControlT, UnorderedSetT > );
+	typedef DFTDirection< FORWARD > DirT;
+	typedef decltype( DirT::edges( g, v ) ) RangeT;
+	struct Frame
+	{
+	    typename DiGraphT::VertexT mVertex;
+	    RangeT mEdges;
+	};
 
+	std::vector< Frame > stack;
+	std::vector< typename DiGraphT::EdgeT > entered; // edge leading to each frame but the first
 	dftVisit( g, v, c, visited );
+	stack.push_back( Frame{ v, DirT::edges( g, v ) } );
 
-	for( auto iouts = outEdges( g, v ); iouts.first != iouts.second && !c.terminate( g, v, visited ); ++iouts.first )
+	while( !stack.empty() )
 	{
-	    const typename DiGraphT::VertexT& t = target( g, *iouts.first );
-	    dftExplore( g, v, t, *iouts.first, c, visited, selfCall );
+	    Frame& f = stack.back();
+	    if( f.mEdges.first != f.mEdges.second && !c.terminate( g, f.mVertex, visited ) )
+	    {
+		const typename DiGraphT::EdgeT e = *f.mEdges.first;
+		++f.mEdges.first;
+		const typename DiGraphT::VertexT u = DirT::next( g, e );
+
+		c.explore( g, e );
+		if( c.isBacktrack( g, u, visited ) || visited.count( u ) != 0 )
+		    c.backtrack( g, u, visited );
+		else
+		{
+		    dftVisit( g, u, c, visited );
+		    entered.push_back( e );
+		    stack.push_back( Frame{ u, DirT::edges( g, u ) } ); // invalidates f
+		}
+	    }
+	    else
+	    {
+		c.leave( g, f.mVertex, visited );
+		stack.pop_back();
+		if( !entered.empty() )
+		{
+		    c.returned( g, entered.back() );
+		    entered.pop_back();
+		}
+	    }
 	}
-
-	c.leave( g, v, visited );
 	return c;
     }
 
     /*!
-      \brief performs dfs traversal backward
+      \brief performs dfs traversal forward
       \param g graph to traverse
       \param v node at which to start traversal
       \param c is notified of events in search and controls termination
       \param visited set of nodes visited
     */
     template< typename DiGraphT, typename ControlT, typename UnorderedSetT >
-    ControlT& backwardDFTRecursive( DiGraphT& g, const typename DiGraphT::VertexT& v, ControlT& c, UnorderedSetT& visited )
+    ControlT& forwardDFTIterative( DiGraphT& g, const typename DiGraphT::VertexT& v, ControlT& c, UnorderedSetT& visited )
     {
-	std::function< ControlT&( DiGraphT&, const typename DiGraphT::VertexT&, ControlT&, UnorderedSetT& ) >
-	    selfCall( backwardDFTRecursive< DiGraphT, ControlT, UnorderedSetT > );
-	dftVisit( g, v, c, visited );
-
-	for( auto iIn = inEdges( g, v ); iIn.first != iIn.second && !c.terminate( g, v, visited ); ++iIn.first )
-	{
-	    const typename DiGraphT::VertexT& s = source( g, *iIn.first );
-	    dftExplore( g, v, s, *iIn.first, c, visited, selfCall );
-	}
+	return dftIterative< true >( g, v, c, visited );
+    }
 
-	c.leave( g, v, visited );
-	return c;
+    /*!
+      \brief performs dfs traversal backward
+      \param g graph to traverse
+      \param v node at which to start traversal
+      \param c is notified of events in search and controls termination
+      \param visited set of nodes visited
+    */
+    template< typename DiGraphT, typename ControlT, typename UnorderedSetT >
+    ControlT& backwardDFTIterative( DiGraphT& g, const typename DiGraphT::VertexT& v, ControlT& c, UnorderedSetT& visited )
+    {
+	return dftIterative< false >( g, v, c, visited );
     }
 
     template< typename DiGraphT, typename ControlT
@@ -140,7 +178,7 @@ namespace graph
 	std::unordered_set< typename DiGraphT::VertexT, HashT, CompareT > visitSet( graph::size( g ), hsh, cmp );
 
 	c.init( g, v );
-	forwardDFTRecursive( g, v, c, visitSet );
+	forwardDFTIterative( g, v, c, visitSet );
 	c.finish( g, v );
 	return c;
     }
@@ -155,7 +193,7 @@ namespace graph
 	std::unordered_set< typename DiGraphT::VertexT, HashT, CompareT > visitSet( graph::size( g ), hsh, cmp );
 
 	c.init( g, v );
-	backwardDFTRecursive( g, v, c, visitSet );
+	backwardDFTIterative( g, v, c, visitSet );
 	c.finish( g, v );
 	return c;
     }
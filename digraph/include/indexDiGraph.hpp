@@ -0,0 +1,373 @@
+#ifndef INDEX_DI_GRAPH_HPP
+#define INDEX_DI_GRAPH_HPP
+
+#include "diGraphInterface.hpp"
+#include "adjacencyDiGraph.hpp"
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <limits>
+#include <cstdint>
+#include <stdexcept>
+
+#include <assert.h>
+
+#define INDEX_GRAPH_TEMPLATE template< typename T,    template< typename K, typename V, typename CompT > class VCT,    template< typename S > class OECT,    template< typename S > class IECT,     typename ComparatorT >
+
+#define INDEX_GRAPH_TEMPLATE_PARAMS typename T,    template< typename K, typename V, typename CompT > class VCT,    template< typename S > class OECT,    template< typename S > class IECT,     typename ComparatorT
+
+#define IGRAPH IndexDiGraph< T, VCT, OECT, IECT, ComparatorT >
+
+namespace graph
+{
+    /*!
+      directed graph with the interface of AdjacencyDiGraph whose vertices are handles into a slot table
+      handles are a 32 bit slot index and the generation of the slot, edges are pairs of slot indices,
+      so copying vertices, edges and paths of them does not touch reference counts
+      \param T type to be stored as value, has to be copy constructible, assignable and comparable w.r.t. equality
+      \param VCT container type for storing the vertices, as for AdjacencyDiGraph
+      \param OECT container template type for storing out-edges, as for AdjacencyDiGraph
+      \param IECT container template type for storing in-edges, as for AdjacencyDiGraph
+      \note slots of removed vertices are reused, handles to removed vertices are stale and refer to the vertex reusing their slot, use contains to check
+    */
+    template< typename T
+	      , template< typename K, typename V, typename CompT > class VCT
+	      , template< typename S > class OECT
+	      , template< typename S > class IECT
+	      , typename ComparatorT = std::equal_to< T > >
+    class IndexDiGraph
+    {
+      public:
+	struct Edge;
+	class Node;
+
+	typedef IndexDiGraph< T, VCT, OECT, IECT, ComparatorT > Igraph;
+	typedef T ValueT;
+	typedef Node VertexT;
+	typedef Edge EdgeT;
+	typedef uint32_t IndexT;
+
+	static constexpr IndexT NO_INDEX = std::numeric_limits< IndexT >::max();
+
+	// containers
+	typedef VCT< T, Node, ComparatorT > VertexContainerT;
+	typedef OECT< EdgeT > OutEdgeContainerT;
+	typedef IECT< EdgeT > InEdgeContainerT;
+
+	// iterators
+	typedef typename VertexContainerT::ValueIterator VIterT;
+	typedef typename OutEdgeContainerT::const_iterator OutIterT;
+	typedef typename InEdgeContainerT::const_iterator InIterT;
+
+	//! \class handle of a vertex, trivially copyable
+	class Node
+	{
+	    friend class IndexDiGraph< T, VCT, OECT, IECT, ComparatorT >;
+	  public:
+	    Node() = default;
+
+	    bool operator ==( const Node& other ) const { return mIndex == other.mIndex && mGeneration == other.mGeneration; }
+
+	    bool operator !=( const Node& other ) const { return !( *this == other ); }
+
+	    //! \return slot of the vertex, dense among the vertices of the graph
+	    IndexT index() const { return mIndex; }
+
+	    size_t hash() const { return std::hash< uint64_t >()( ( uint64_t( mGeneration ) << 32 ) | mIndex ); }
+	  private:
+	    Node( const IndexT& index, const uint32_t& generation ) : mIndex( index ), mGeneration( generation ) {}
+
+	    IndexT mIndex = NO_INDEX;
+	    uint32_t mGeneration = 0;
+	};
+
+	//! \class edge between the vertices of two slots, only stored while both vertices exist
+	struct Edge
+	{
+	    IndexT mSource = NO_INDEX, mTarget = NO_INDEX;
+
+	    bool operator ==( const Edge& other ) const { return mSource == other.mSource && mTarget == other.mTarget; }
+
+	    size_t hash() const
+	    {
+		const size_t hsrc = std::hash< IndexT >()( mSource ), htrg = std::hash< IndexT >()( mTarget );
+		return hsrc ^ ( htrg + 0x9e3779b9 + ( hsrc << 6 ) + ( hsrc >> 2 ) );
+	    }
+	};
+
+	IndexDiGraph( const ComparatorT& cmp = ComparatorT() )
+	    : mVertices( cmp )
+	{}
+
+	//! \note debug builds assert that v is not stale, as the value of its slot would belong to the vertex reusing it
+	const ValueT& value( const VertexT& v ) const
+	{
+	    assert( contains( v ) && "value of a handle to a removed vertex" );
+	    return mSlots[ v.mIndex ].mValue;
+	}
+
+	//! \return true if v is a handle to a vertex of the graph, false if the vertex was removed
+	bool contains( const VertexT& v ) const { return v.mIndex < mSlots.size() && mSlots[ v.mIndex ].mGeneration == v.mGeneration; }
+
+	typename DiGraphTraits< Igraph >::VRangeT vertices() const { return std::make_pair( mVertices.begin(), mVertices.end() ); }
+
+	VIterT findVertex( const ValueT& v ) const { return mVertices.find( v ); }
+
+	typename DiGraphTraits< Igraph >::OutRangeT outEdges( const VertexT& v ) const
+	{
+	    const Slot& s = mSlots[ v.mIndex ];
+	    return std::make_pair( s.mOuts.begin(), s.mOuts.end() );
+	}
+
+	typename DiGraphTraits< Igraph >::InRangeT inEdges( const VertexT& v ) const
+	{
+	    const Slot& s = mSlots[ v.mIndex ];
+	    return std::make_pair( s.mIns.begin(), s.mIns.end() );
+	}
+
+	//! \return edge in src to trg
+	OutIterT findEdgeTo( const VertexT& src, const VertexT& trg ) const
+	{
+	    return mSlots[ src.mIndex ].mOuts.find( EdgeT{ src.mIndex, trg.mIndex } );
+	}
+
+	//! \return edge in trg from src
+	InIterT findEdgeFrom( const VertexT& src, const VertexT& trg ) const
+	{
+	    return mSlots[ trg.mIndex ].mIns.find( EdgeT{ src.mIndex, trg.mIndex } );
+	}
+
+	VertexT source( const EdgeT& e ) const { return vertex( e.mSource ); }
+
+	VertexT target( const EdgeT& e ) const { return vertex( e.mTarget ); }
+
+	size_t size() const { return mVertices.size(); }
+
+	//! \return number of edges, counted as they are added and removed
+	size_t edgeCount() const { return mEdgeCount; }
+
+	//! \return bytes allocated on the heap for vertices, the vertex container, slots and free list, excluding adjacencies
+	size_t vertexBytes() const
+	{
+	    return mVertices.heapBytes() + mSlots.size() * ( sizeof( Slot ) - sizeof( InEdgeContainerT ) - sizeof( OutEdgeContainerT ) )
+		+ mFree.capacity() * sizeof( IndexT );
+	}
+
+	//! \return bytes allocated on the heap for the in and out edge containers of all slots
+	size_t edgeBytes() const
+	{
+	    size_t bytes = mSlots.size() * ( sizeof( InEdgeContainerT ) + sizeof( OutEdgeContainerT ) );
+	    for( const Slot& s : mSlots )
+		bytes += s.mIns.heapBytes() + s.mOuts.heapBytes();
+	    return bytes;
+	}
+
+	//! \return iterator to vertex added
+	VIterT addVertex( const ValueT& v )
+	{
+	    VIterT ivAdd = mVertices.find( v );
+	    if( ivAdd != mVertices.cend() )
+		return ivAdd;
+
+	    IndexT i;
+	    if( mFree.empty() )
+	    {
+		if( mSlots.size() == NO_INDEX )
+		    throw std::logic_error( "cannot add vertex, all slot indices in use" );
+		i = mSlots.size();
+		mSlots.emplace_back( v );
+	    }
+	    else
+	    {
+		i = mFree.back();
+		mFree.pop_back();
+		mSlots[ i ].mValue = v;
+	    }
+	    return mVertices.insert( v, vertex( i ) );
+	}
+
+	//! \return iterator to vertex following v
+	VIterT removeVertex( const VertexT& v )
+	{
+	    Slot& s = mSlots[ v.mIndex ];
+	    for( const EdgeT& in : s.mIns )
+	    {
+		auto& outs = mSlots[ in.mSource ].mOuts;
+		auto iout = outs.find( in );
+		if( iout != outs.end() )
+		{
+		    outs.erase( iout );
+		    --mEdgeCount;
+		}
+	    }
+	    for( const EdgeT& out : s.mOuts )
+	    {
+		auto& ins = mSlots[ out.mTarget ].mIns;
+		auto iin = ins.find( out );
+		if( iin != ins.end() )
+		    ins.erase( iin );
+	    }
+	    mEdgeCount -= s.mOuts.size();
+	    s.mIns.clear();
+	    s.mOuts.clear();
+
+	    // stale handles are told apart by the generation, the value stays until the slot is reused
+	    ++s.mGeneration;
+	    mFree.push_back( v.mIndex );
+	    return mVertices.erase( s.mValue );
+	}
+
+	template< typename CallT >
+	VIterT updateVertex( const VertexT& v, CallT& call )
+	{
+	    Slot& s = mSlots[ v.mIndex ];
+	    VIterT iv = findVertex( s.mValue );
+	    if( iv == mVertices.end() || *iv != v )
+		throw std::logic_error( "cannot update vertex, does not reference value stored in graph" );
+
+	    mVertices.erase( s.mValue );
+	    call( s.mValue );
+	    return mVertices.insert( s.mValue, v );
+	}
+
+	std::pair< OutIterT, InIterT > addEdge( const VertexT& src, const VertexT& trg )
+	{
+	    const EdgeT newEdge{ src.mIndex, trg.mIndex };
+	    auto& outs = mSlots[ src.mIndex ].mOuts;
+	    auto& ins = mSlots[ trg.mIndex ].mIns;
+	    OutIterT iout = outs.find( newEdge );
+	    InIterT iin = ins.find( newEdge );
+	    if( iout == outs.end() )
+	    {
+		iout = outs.insert( newEdge );
+		++mEdgeCount;
+	    }
+	    if( iin == ins.end() )
+		iin = ins.insert( newEdge );
+	    return std::make_pair( iout, iin );
+	}
+
+	std::pair< OutIterT, InIterT > removeEdge( const VertexT& src, const VertexT& trg )
+	{
+	    const EdgeT e{ src.mIndex, trg.mIndex };
+	    auto& outs = mSlots[ src.mIndex ].mOuts;
+	    auto& ins = mSlots[ trg.mIndex ].mIns;
+	    OutIterT ieSrc = outs.find( e );
+	    InIterT ieTrg = ins.find( e );
+	    if( ieSrc != outs.end() )
+	    {
+		ieSrc = outs.erase( ieSrc );
+		--mEdgeCount;
+	    }
+	    if( ieTrg != ins.end() )
+		ieTrg = ins.erase( ieTrg );
+	    return std::make_pair( ieSrc, ieTrg );
+	}
+
+      private:
+	// slots are kept in a deque, so adding vertices does not move the adjacencies of others
+	struct Slot
+	{
+	    explicit Slot( const ValueT& v ) : mValue( v ) {}
+
+	    ValueT mValue;
+	    uint32_t mGeneration = 0;
+	    InEdgeContainerT mIns;
+	    OutEdgeContainerT mOuts;
+	};
+
+	//! \return handle of the vertex currently stored in slot i
+	VertexT vertex( const IndexT& i ) const { return VertexT( i, mSlots[ i ].mGeneration ); }
+
+	VertexContainerT mVertices;
+	std::deque< Slot > mSlots;
+	std::vector< IndexT > mFree;
+	size_t mEdgeCount = 0;
+    };
+
+    INDEX_GRAPH_TEMPLATE
+    const typename IGRAPH::ValueT& value( const IGRAPH& ig, const typename IGRAPH::VertexT& v ) { return ig.value( v ); }
+
+    template< INDEX_GRAPH_TEMPLATE_PARAMS, typename CallT >
+    typename IGRAPH::VIterT updateVertex( IGRAPH& ig, const typename IGRAPH::VertexT& v, CallT& call ) { return ig.updateVertex( v, call ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::VertexT source( const IGRAPH& ig, const typename IGRAPH::EdgeT& e ) { return ig.source( e ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::VertexT target( const IGRAPH& ig, const typename IGRAPH::EdgeT& e ) { return ig.target( e ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename DiGraphTraits< IGRAPH >::VRangeT vertices( const IGRAPH& ig ) { return ig.vertices(); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename DiGraphTraits< IGRAPH >::OutRangeT outEdges( const IGRAPH& ig, const typename IGRAPH::VertexT& v ) { return ig.outEdges( v ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename DiGraphTraits< IGRAPH >::InRangeT inEdges( const IGRAPH& ig, const typename IGRAPH::VertexT& v ) { return ig.inEdges( v ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::VIterT findVertex( const IGRAPH& ig, const typename IGRAPH::ValueT& val ) { return ig.findVertex( val ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::OutIterT findEdgeTo( const IGRAPH& ig, const typename IGRAPH::VertexT& src, const typename IGRAPH::VertexT& trg ) { return ig.findEdgeTo( src, trg ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::InIterT findEdgeFrom( const IGRAPH& ig, const typename IGRAPH::VertexT& src, const typename IGRAPH::VertexT& trg ) { return ig.findEdgeFrom( src, trg ); }
+
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::VIterT addVertex( IGRAPH& ig, const typename IGRAPH::ValueT& v ) { return ig.addVertex( v ); }
+
+    INDEX_GRAPH_TEMPLATE
+    std::pair< typename IGRAPH::OutIterT, typename IGRAPH::InIterT > addEdge( IGRAPH& ig, const typename IGRAPH::VertexT& src, const typename IGRAPH::VertexT& trg ) { return ig.addEdge( src, trg ); }
+
+    /*! \note makes all handles of v stale and invalidates VIterT, VRangeT */
+    INDEX_GRAPH_TEMPLATE
+    typename IGRAPH::VIterT removeVertex( IGRAPH& ig, const typename IGRAPH::VertexT& v ) { return ig.removeVertex( v ); }
+
+    /*! \note invalidates all OutEdgeT of src and InEdgeT of trg as well as corresponding iterators */
+    INDEX_GRAPH_TEMPLATE
+    std::pair< typename IGRAPH::OutIterT, typename IGRAPH::InIterT > removeEdge( IGRAPH& ig, const typename IGRAPH::EdgeT& e ) { return ig.removeEdge( ig.source( e ), ig.target( e ) ); }
+
+    /*! \note invalidates all OutEdgeT of src and InEdgeT of trg as well as corresponding iterators */
+    INDEX_GRAPH_TEMPLATE
+    std::pair< typename IGRAPH::OutIterT, typename IGRAPH::InIterT > removeEdge( IGRAPH& ig, const typename IGRAPH::VertexT& src, const typename IGRAPH::VertexT& trg ) { return ig.removeEdge( src, trg ); }
+
+    template< typename T
+	      , template< typename K, typename V, typename CmpT > typename VCT
+	      , template< typename S > typename OECT
+	      , template< typename S > typename IECT
+	      , typename ComparatorT
+	      , typename CharT, typename Traits
+	      , typename P>
+    std::basic_ostream< CharT, Traits >& print( std::basic_ostream< CharT, Traits >& os, const IGRAPH& ig, const typename IGRAPH::VertexT& v
+						, const std::function< P( const typename IGRAPH::ValueT& ) >& converter = [] (const typename IGRAPH::ValueT& v) { return v; } )
+    {
+	return printAdjacencies( os, ig, v, converter );
+    }
+
+    template< typename T
+	      , template< typename K, typename V, typename CmpT > typename VCT
+	      , template< typename S > typename OECT
+	      , template< typename S > typename IECT
+	      , typename ComparatorT
+	      , typename CharT, typename Traits
+	      , typename P>
+    std::basic_ostream< CharT, Traits >& print( std::basic_ostream< CharT, Traits >& os, const IGRAPH& ig
+						, const std::function< P( const typename IGRAPH::ValueT& ) >& converter = [] (const typename IGRAPH::ValueT& v) {return v;} )
+    {
+	for( auto vs = graph::vertices( ig ); vs.first != vs.second; ++vs.first )
+	{
+	    printAdjacencies( os, ig, *vs.first, converter );
+	    os << std::endl;
+	}
+	return os;
+    }
+}
+
+#undef IGRAPH
+#undef INDEX_GRAPH_TEMPLATE
+#undef INDEX_GRAPH_TEMPLATE_PARAMS
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef VISIT_SET_HPP
+#define VISIT_SET_HPP
+
+#include "adjacencyDiGraph.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+namespace graph
+{
+    /*!
+      \class set of visited vertices of a graph, indexed by KeyIndex of their values
+      stores the epoch in which each vertex was inserted, so membership is a single load and clearing is constant time
+      \param G graph type whose vertex values have small, unique indices, e.g. ids of graph values
+      \param KeyIndexT maps vertex values to their index
+      \note supports insert and count as used by depth first traversals
+    */
+    template< typename G, typename KeyIndexT = KeyIndex< typename G::ValueT > >
+    class VisitSet
+    {
+      public:
+	//! \param capacity bound on indices to expect, the set grows beyond if needed
+	VisitSet( const G& g, const size_t& capacity = 0 )
+	    : mGraph( g )
+	    , mStamps( capacity, 0 )
+	    , mEpoch( 1 )
+	{}
+
+	//! \brief empties the set in constant time
+	void clear()
+	{
+	    if( mEpoch == std::numeric_limits< uint32_t >::max() )
+	    {
+		std::fill( mStamps.begin(), mStamps.end(), 0 );
+		mEpoch = 0;
+	    }
+	    ++mEpoch;
+	}
+
+	//! \return true if v was not contained before
+	bool insert( const typename G::VertexT& v ) { return insertIndex( index( v ) ); }
+
+	size_t count( const typename G::VertexT& v ) const { return containsIndex( index( v ) ) ? 1 : 0; }
+
+	bool contains( const typename G::VertexT& v ) const { return containsIndex( index( v ) ); }
+
+	bool insertIndex( const size_t& i )
+	{
+	    if( i >= mStamps.size() )
+		mStamps.resize( std::max( i + 1, 2 * mStamps.size() ), 0 );
+	    if( mStamps[ i ] == mEpoch )
+		return false;
+	    mStamps[ i ] = mEpoch;
+	    return true;
+	}
+
+	bool containsIndex( const size_t& i ) const { return i < mStamps.size() && mStamps[ i ] == mEpoch; }
+
+      private:
+	size_t index( const typename G::VertexT& v ) const { return KeyIndexT()( value( mGraph, v ) ); }
+
+	const G& mGraph;
+	std::vector< uint32_t > mStamps;
+	uint32_t mEpoch;
+    };
+
+} // namespace
+
+#endif
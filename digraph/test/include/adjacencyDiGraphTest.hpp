@@ -3,8 +3,14 @@
 
 #include "testGroupInterface.hpp"
 #include "adjacencyDiGraph.hpp"
+#include "csrDiGraph.hpp"
+#include "condensation.hpp"
+#include "depthFirstSearch.hpp"
+#include "visitSet.hpp"
+#include "indexDiGraph.hpp"
 
 #include <random>
+#include <string>
 #include <set>
 #include <vector>
 
@@ -60,10 +66,23 @@ struct AdjacencyDiGraphTest : public ITestGroup
     using Gt = AdjacencyDiGraph< T, VecMap, InVec, InVec >;
     
     typedef AdjacencyDiGraph< int, VecMap, InVec, InVec > G;
+
+    // the tests of G instantiated a second time with hashed edges
+    typedef AdjacencyDiGraph< int, VecMap, HashVec, HashVec > Gh;
+
+    //! \return suffix of the descriptions of tests instantiated with GraphT, telling instantiations of the same test apart
+    template< typename GraphT >
+    static std::string edgesOf();
+
+    typedef AdjacencyDiGraph< int, IndexMap, InVec, InVec > Gi;
+
+    typedef IndexDiGraph< int, IndexMap, HashVec, HashVec > Gx;
     
     // test whether a value can be found in the graph after adding it
+    template< typename GraphT >
     class AddValueTest : public ITest
     {
+	typedef GraphT G;
 	STATEFUL_TEST( AddValueTest );
       private:
 	G mGraph;
@@ -72,8 +91,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
 
     // test whether an edge with matching source and target can be found after adding it
+    template< typename GraphT >
     class AddEdgeTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( AddEdgeTest );
       private:
     	G mGraph;
@@ -82,8 +103,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
 
     // test whether removing vertex renders it absent from the graph
+    template< typename GraphT >
     class RemoveVertexTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( RemoveVertexTest );
       private:
     	G mGraph;
@@ -92,8 +115,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
     
     // test whether removing vertex does not leave invalid vertices
+    template< typename GraphT >
     class RemoveVertexNonCorruptionTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( RemoveVertexNonCorruptionTest );
       private:
     	G mGraph;
@@ -102,8 +127,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
 
     // test whether removing vertex removes incoming connections of formerly adjacent vertices
+    template< typename GraphT >
     class RemoveVertexIncomingTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( RemoveVertexIncomingTest );
       private:
     	G mGraph;
@@ -113,8 +140,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
 
     // test whether removing vertex removes incoming connections of formerly adjacent vertices
+    template< typename GraphT >
     class RemoveVertexOutgoingTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( RemoveVertexOutgoingTest );
       private:
     	G mGraph;
@@ -124,8 +153,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     };
 
     // test whether removing vertex removes outgoing connectinos of formerly adjacent vertices
+    template< typename GraphT >
     class RemoveEdgeTest : public ITest
     {
+	typedef GraphT G;
     	STATEFUL_TEST( RemoveEdgeTest );
       private:
     	G mGraph;
@@ -133,6 +164,81 @@ struct AdjacencyDiGraphTest : public ITestGroup
     	int mSrcVal, mTrgVal;
     };
 
+    // test whether index map locates all remaining vertices after removal moved them
+    class IndexMapRemovalTest : public ITest
+    {
+    	STATEFUL_TEST( IndexMapRemovalTest );
+      private:
+    	Gi mGraph;
+    	std::vector< int > mRemain;
+    	int mRemVal;
+    };
+
+    // test whether index handle graph keeps the same edges as the adjacency graph under the same modifications and detects stale handles
+    class IndexHandleTest : public ITest
+    {
+    	STATEFUL_TEST( IndexHandleTest );
+      private:
+    	Gi mGraph;
+    	Gx mIndexGraph;
+    	Gx::VertexT mRemoved;
+    	int mNextVal;
+    };
+
+    // test whether compressed snapshot holds exactly the edges of the graph it was taken from
+    class CsrSnapshotTest : public ITest
+    {
+    	STATELESS_TEST( CsrSnapshotTest );
+      private:
+    	Gi mGraph;
+    	CsrDiGraph< Gi > mCsr;
+    };
+
+    // test whether vertices share a component exactly if they reach each other and components are numbered in reverse topological order
+    class CondensationTest : public ITest
+    {
+    	STATELESS_TEST( CondensationTest );
+      private:
+    	Gi mGraph;
+    	CsrDiGraph< Gi > mCsr;
+    };
+
+    // test whether depth first traversals visit exactly the vertices reachable from the start, reporting events properly nested
+    // with hashed as well as index visited sets
+    class DFTTest : public ITest
+    {
+      public:
+	//! \class records events of a traversal and whether they were nested properly
+	struct RecordingControl : public BidirectionalDFTControl
+	{
+	    std::vector< int > mVisited, mOpen;
+	    int mLeft = 0;
+	    bool mNested = true;
+
+	    template< typename VisitSetT >
+	    void visit( const G& g, const G::VertexT& v, const VisitSetT& visited ) { mVisited.push_back( value( g, v ) ); mOpen.push_back( value( g, v ) ); }
+
+	    template< typename VisitSetT >
+	    void leave( const G& g, const G::VertexT& v, const VisitSetT& visited )
+	    {
+		mNested = mNested && !mOpen.empty() && mOpen.back() == value( g, v );
+		if( !mOpen.empty() )
+		    mOpen.pop_back();
+		mLeft = value( g, v );
+	    }
+	};
+
+	struct ValueHash { const G& mGraph; size_t operator ()( const G::VertexT& v ) const { return std::hash< int >()( value( mGraph, v ) ); } };
+	struct ValueEqual { const G& mGraph; bool operator ()( const G::VertexT& v, const G::VertexT& u ) const { return value( mGraph, v ) == value( mGraph, u ); } };
+
+	//! \return values reachable from v, forwards or backwards
+	std::set< int > reachable( const G::VertexT& v, bool forward ) const;
+
+    	STATELESS_TEST( DFTTest );
+      private:
+    	G mGraph;
+    };
+
     // test whether objects stored in graph are deleted as often as they are created
     class MemoryFreed : public ITest
     {
@@ -163,4 +269,10 @@ struct AdjacencyDiGraphTest : public ITestGroup
     void init();
 };
 
+template<>
+inline std::string AdjacencyDiGraphTest::edgesOf< AdjacencyDiGraphTest::G >() { return ""; }
+
+template<>
+inline std::string AdjacencyDiGraphTest::edgesOf< AdjacencyDiGraphTest::Gh >() { return " with hashed edges"; }
+
 #endif
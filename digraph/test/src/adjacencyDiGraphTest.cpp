@@ -11,22 +11,29 @@
 
 std::default_random_engine AdjacencyDiGraphTest::mRandom = std::default_random_engine( std::random_device()() );
 
-AdjacencyDiGraphTest::TEST_CTOR( AddValueTest, "add values and find them again" );
+// constructor of tests instantiated for several graph types, descriptions tell the instantiations apart
+#define GRAPH_TEST_CTOR(name,description) template< typename GraphT > AdjacencyDiGraphTest::name< GraphT >::name( uint size, uint repetitions ) \
+    : ITest( description + edgesOf< GraphT >(), size, repetitions ) {}
 
-void AdjacencyDiGraphTest::AddValueTest::init()
+GRAPH_TEST_CTOR( AddValueTest, "add values and find them again" )
+
+template< typename GraphT >
+void AdjacencyDiGraphTest::AddValueTest< GraphT >::init()
 {
     mGraph = G();
     addVertex( mGraph, 0 );
     mVal = 0;
 }
 
-void AdjacencyDiGraphTest::AddValueTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::AddValueTest< GraphT >::iterate()
 {
     mVal = mVdist( mRandom );
     addVertex( mGraph, mVal );
 }
 
-bool AdjacencyDiGraphTest::AddValueTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::AddValueTest< GraphT >::check() const
 {
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
     typename DiGraphTraits< G >::VIterT iv = findVertex( mGraph, mVal );
@@ -36,9 +43,10 @@ bool AdjacencyDiGraphTest::AddValueTest::check() const
     return true;
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( AddEdgeTest, "add edges and find source and target" );
+GRAPH_TEST_CTOR( AddEdgeTest, "add edges and find source and target" )
 
-void AdjacencyDiGraphTest::AddEdgeTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::AddEdgeTest< GraphT >::init()
 {
     D( std::cout << "init add edge test" << std::endl; );
     mGraph = G();
@@ -47,7 +55,8 @@ void AdjacencyDiGraphTest::AddEdgeTest::init()
     D( std::cout << "finished init add edge test" << std::endl; );
 }
 
-void AdjacencyDiGraphTest::AddEdgeTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::AddEdgeTest< GraphT >::iterate()
 {
     D( std::cout << "iterate add edge test" << std::endl; );
     addVertex( mGraph, mVdist( mRandom ) );
@@ -77,7 +86,8 @@ void AdjacencyDiGraphTest::AddEdgeTest::iterate()
     D( std::cout << "finished iteration in add edge test" << std::endl; );
 }
 
-bool AdjacencyDiGraphTest::AddEdgeTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::AddEdgeTest< GraphT >::check() const
 {
     D( std::cout << "check add edge test" << std::endl; );
     typename DiGraphTraits< G >::VIterT src = findVertex( mGraph, mSrcVal )
@@ -121,9 +131,10 @@ bool AdjacencyDiGraphTest::AddEdgeTest::check() const
     }
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( RemoveVertexTest, "verify removed vertices vanish" );
+GRAPH_TEST_CTOR( RemoveVertexTest, "verify removed vertices vanish" )
 
-void AdjacencyDiGraphTest::RemoveVertexTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexTest< GraphT >::init()
 {
     D( std::cout << "init remove vertex test" << std::endl; );
     mGraph = G();
@@ -139,7 +150,8 @@ void AdjacencyDiGraphTest::RemoveVertexTest::init()
     D( std::cout << "finished init remove vertex test" << std::endl; );
 }
 
-void AdjacencyDiGraphTest::RemoveVertexTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexTest< GraphT >::iterate()
 {
     D( std::cout << "iterate remove vertex test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -158,7 +170,8 @@ void AdjacencyDiGraphTest::RemoveVertexTest::iterate()
     D( std::cout << "done iterate remove vertex test" << std::endl; );
 }
 
-bool AdjacencyDiGraphTest::RemoveVertexTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::RemoveVertexTest< GraphT >::check() const
 {
     D( std::cout << "check remove vertex test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -172,9 +185,10 @@ bool AdjacencyDiGraphTest::RemoveVertexTest::check() const
     return true;
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( RemoveVertexNonCorruptionTest, "verify removal keeps all other vertices" );
+GRAPH_TEST_CTOR( RemoveVertexNonCorruptionTest, "verify removal keeps all other vertices" )
 
-void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest< GraphT >::init()
 {
     D( std::cout << "init remove vertex test" << std::endl; );
     mGraph = G();
@@ -190,7 +204,8 @@ void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::init()
     D( std::cout << "finished init remove vertex test" << std::endl; );
 }
 
-void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest< GraphT >::iterate()
 {
     D( std::cout << "iterate remove vertex test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -215,7 +230,8 @@ void AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::iterate()
 	D( std::cout << "nothing to remove, graph is empty" << std::endl; );
 }
 
-bool AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest< GraphT >::check() const
 {
     D( std::cout << "check remove vertex test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -232,9 +248,10 @@ bool AdjacencyDiGraphTest::RemoveVertexNonCorruptionTest::check() const
     return true;
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( RemoveVertexIncomingTest, "removed vertices are not found as sources" );
+GRAPH_TEST_CTOR( RemoveVertexIncomingTest, "removed vertices are not found as sources" )
 
-void AdjacencyDiGraphTest::RemoveVertexIncomingTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexIncomingTest< GraphT >::init()
 {
     D( std::cout << "init remove vertex incoming test" << std::endl; );
     mGraph = G();
@@ -250,7 +267,7 @@ void AdjacencyDiGraphTest::RemoveVertexIncomingTest::init()
 	D( std::cout << "add value " << valAdd << std::endl; );
 	// add edges to preexisting vertices randomly in both directions
 	typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
-	for( DiGraphTraits< G >::VIterT iv = vs.first; iv != vs.second; ++iv )
+	for( typename DiGraphTraits< G >::VIterT iv = vs.first; iv != vs.second; ++iv )
 	{
 	    int event = eventDist( mRandom );
 	    if( event == 0 )
@@ -270,7 +287,8 @@ void AdjacencyDiGraphTest::RemoveVertexIncomingTest::init()
     iterate();
 }
 
-void AdjacencyDiGraphTest::RemoveVertexIncomingTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexIncomingTest< GraphT >::iterate()
 {
     D( std::cout << "iterate remove vertex incoming test" << std::endl; );
 
@@ -293,7 +311,8 @@ void AdjacencyDiGraphTest::RemoveVertexIncomingTest::iterate()
     // D( std::cout << "changed graph " << std::endl << mGraph << std::endl; );
 }
 
-bool AdjacencyDiGraphTest::RemoveVertexIncomingTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::RemoveVertexIncomingTest< GraphT >::check() const
 {
     D( std::cout << "check remove vertex incoming test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -313,9 +332,10 @@ bool AdjacencyDiGraphTest::RemoveVertexIncomingTest::check() const
     return true;
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( RemoveVertexOutgoingTest, "removed vertices are not found as targets" );
+GRAPH_TEST_CTOR( RemoveVertexOutgoingTest, "removed vertices are not found as targets" )
 
-void AdjacencyDiGraphTest::RemoveVertexOutgoingTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexOutgoingTest< GraphT >::init()
 {
     D( std::cout << "init remove vertex incoming test" << std::endl; );
     mGraph = G();
@@ -331,7 +351,7 @@ void AdjacencyDiGraphTest::RemoveVertexOutgoingTest::init()
 	D( std::cout << "add value " << valAdd << std::endl; );
 	// add edges to preexisting vertices randomly in both directions
 	typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
-	for( DiGraphTraits< G >::VIterT iv = vs.first; iv != vs.second; ++iv )
+	for( typename DiGraphTraits< G >::VIterT iv = vs.first; iv != vs.second; ++iv )
 	{
 	    if( boolDist( mRandom ) == 1 )
 		addEdge( mGraph, *ivadd, *iv );
@@ -342,7 +362,8 @@ void AdjacencyDiGraphTest::RemoveVertexOutgoingTest::init()
     iterate();
 }
 
-void AdjacencyDiGraphTest::RemoveVertexOutgoingTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveVertexOutgoingTest< GraphT >::iterate()
 {
     D( std::cout << "iterate remove vertex incoming test" << std::endl; );
 
@@ -361,7 +382,8 @@ void AdjacencyDiGraphTest::RemoveVertexOutgoingTest::iterate()
     }
 }
 
-bool AdjacencyDiGraphTest::RemoveVertexOutgoingTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::RemoveVertexOutgoingTest< GraphT >::check() const
 {
     D( std::cout << "check remove vertex incoming test" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -381,19 +403,23 @@ bool AdjacencyDiGraphTest::RemoveVertexOutgoingTest::check() const
     return true;
 }
 
-AdjacencyDiGraphTest::TEST_CTOR( RemoveEdgeTest, "verify removed edges vanish" );
+GRAPH_TEST_CTOR( RemoveEdgeTest, "verify removed edges vanish" )
 
-void AdjacencyDiGraphTest::RemoveEdgeTest::init()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveEdgeTest< GraphT >::init()
 {
     D( std::cout << "init: remove edges " << std::endl; );
     std::uniform_int_distribution<> vdist;
-    mGraph = randomVertices< int, VecMap, InVec, InVec, std::uniform_int_distribution >( mTestSize, vdist );
+    mGraph = G();
+    for( uint i = 0; i < mTestSize; ++i )
+	addVertex( mGraph, vdist( mRandom ) );
     randomEdges( mGraph, mTestSize + 1 );
     mJumpDist = std::uniform_int_distribution<>( 0, mTestSize - 1 );
     iterate();
 }
 
-void AdjacencyDiGraphTest::RemoveEdgeTest::iterate()
+template< typename GraphT >
+void AdjacencyDiGraphTest::RemoveEdgeTest< GraphT >::iterate()
 {
     D( std::cout << "iterate: remove edges" << std::endl; );
     typename DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
@@ -405,7 +431,8 @@ void AdjacencyDiGraphTest::RemoveEdgeTest::iterate()
     removeEdge( mGraph, *isrc, *itrg );
 }
 
-bool AdjacencyDiGraphTest::RemoveEdgeTest::check() const
+template< typename GraphT >
+bool AdjacencyDiGraphTest::RemoveEdgeTest< GraphT >::check() const
 {
     D( std::cout << "check: remove edges" << std::endl; );
     typename DiGraphTraits< G >::VIterT isrc = findVertex( mGraph, mSrcVal )
@@ -418,6 +445,352 @@ bool AdjacencyDiGraphTest::RemoveEdgeTest::check() const
     return true;
 }
 
+AdjacencyDiGraphTest::TEST_CTOR( IndexMapRemovalTest, "index map finds vertices after removal" );
+
+void AdjacencyDiGraphTest::IndexMapRemovalTest::init()
+{
+    mGraph = Gi();
+    std::uniform_int_distribution<> vdist( 0, 4 * mTestSize );
+    for( uint cInitVs = 0; cInitVs < mTestSize + 1; ++cInitVs )
+	addVertex( mGraph, vdist( mRandom ) );
+    randomEdges( mGraph, 2 * mTestSize );
+
+    iterate();
+}
+
+void AdjacencyDiGraphTest::IndexMapRemovalTest::iterate()
+{
+    typename DiGraphTraits< Gi >::VRangeT vs = vertices( mGraph );
+    uint noVertices = std::distance( vs.first, vs.second );
+    mRemain.clear();
+    mRemVal = -1;
+    if( noVertices > 0 )
+    {
+	typename DiGraphTraits< Gi >::VIterT irem = vs.first + (std::uniform_int_distribution<>( 0, noVertices - 1 ) )( mRandom );
+	mRemVal = value( mGraph, *irem );
+	for( typename DiGraphTraits< Gi >::VIterT iv = vs.first; iv != vs.second; ++iv )
+	    if( value( mGraph, *iv ) != mRemVal )
+		mRemain.push_back( value( mGraph, *iv ) );
+	removeVertex( mGraph, *irem );
+    }
+}
+
+bool AdjacencyDiGraphTest::IndexMapRemovalTest::check() const
+{
+    typename DiGraphTraits< Gi >::VRangeT vs = vertices( mGraph );
+    if( static_cast< size_t >( std::distance( vs.first, vs.second ) ) != mRemain.size() )
+	return false;
+    if( mRemVal >= 0 && findVertex( mGraph, mRemVal ) != vs.second )
+	return false;
+    for( int remainVal : mRemain )
+    {
+	typename DiGraphTraits< Gi >::VIterT iv = findVertex( mGraph, remainVal );
+	if( iv == vs.second || value( mGraph, *iv ) != remainVal )
+	{
+	    D( std::cout << "check failed, could not find " << remainVal << std::endl; );
+	    return false;
+	}
+    }
+    return true;
+}
+
+AdjacencyDiGraphTest::TEST_CTOR( IndexHandleTest, "index handle graph matches adjacency graph" );
+
+void AdjacencyDiGraphTest::IndexHandleTest::init()
+{
+    mGraph = Gi();
+    mIndexGraph = Gx();
+    for( mNextVal = 0; mNextVal < static_cast< int >( mTestSize ) + 1; ++mNextVal )
+    {
+	addVertex( mGraph, mNextVal );
+	addVertex( mIndexGraph, mNextVal );
+    }
+    std::uniform_int_distribution<> vdist( 0, mNextVal - 1 );
+    for( uint cEdge = 0; cEdge < 3 * mTestSize; ++cEdge )
+    {
+	const int src = vdist( mRandom ), trg = vdist( mRandom );
+	addEdge( mGraph, *findVertex( mGraph, src ), *findVertex( mGraph, trg ) );
+	addEdge( mIndexGraph, *findVertex( mIndexGraph, src ), *findVertex( mIndexGraph, trg ) );
+    }
+    mRemoved = Gx::VertexT();
+}
+
+void AdjacencyDiGraphTest::IndexHandleTest::iterate()
+{
+    // remove a vertex and add a new one reusing its slot, connected to random vertices
+    auto vs = vertices( mIndexGraph );
+    const int remVal = value( mIndexGraph, *std::next( vs.first, std::uniform_int_distribution<>( 0, std::distance( vs.first, vs.second ) - 1 )( mRandom ) ) );
+    mRemoved = *findVertex( mIndexGraph, remVal );
+    removeVertex( mIndexGraph, mRemoved );
+    removeVertex( mGraph, *findVertex( mGraph, remVal ) );
+
+    const int newVal = mNextVal++;
+    addVertex( mGraph, newVal );
+    addVertex( mIndexGraph, newVal );
+    vs = vertices( mIndexGraph );
+    std::uniform_int_distribution<> jumpDist( 0, std::distance( vs.first, vs.second ) - 1 );
+    for( uint cEdge = 0; cEdge < 3; ++cEdge )
+    {
+	const int other = value( mIndexGraph, *std::next( vertices( mIndexGraph ).first, jumpDist( mRandom ) ) );
+	addEdge( mGraph, *findVertex( mGraph, newVal ), *findVertex( mGraph, other ) );
+	addEdge( mIndexGraph, *findVertex( mIndexGraph, newVal ), *findVertex( mIndexGraph, other ) );
+	addEdge( mGraph, *findVertex( mGraph, other ), *findVertex( mGraph, newVal ) );
+	addEdge( mIndexGraph, *findVertex( mIndexGraph, other ), *findVertex( mIndexGraph, newVal ) );
+    }
+}
+
+bool AdjacencyDiGraphTest::IndexHandleTest::check() const
+{
+    if( mRemoved != Gx::VertexT() && mIndexGraph.contains( mRemoved ) )
+    {
+	D( std::cout << "check failed, handle of removed vertex still contained" << std::endl; );
+	return false;
+    }
+    if( graph::size( mGraph ) != graph::size( mIndexGraph ) )
+	return false;
+
+    size_t noEdges = 0;
+    for( auto vs = vertices( mIndexGraph ); vs.first != vs.second; ++vs.first )
+    {
+	const Gx::VertexT v = *vs.first;
+	auto iv = findVertex( mGraph, value( mIndexGraph, v ) );
+	if( !mIndexGraph.contains( v ) || iv == vertices( mGraph ).second )
+	    return false;
+
+	std::set< int > outs, ins, indexOuts, indexIns;
+	for( auto es = outEdges( mGraph, *iv ); es.first != es.second; ++es.first )
+	    outs.insert( value( mGraph, target( mGraph, *es.first ) ) );
+	for( auto es = inEdges( mGraph, *iv ); es.first != es.second; ++es.first )
+	    ins.insert( value( mGraph, source( mGraph, *es.first ) ) );
+	for( auto es = outEdges( mIndexGraph, v ); es.first != es.second; ++es.first )
+	{
+	    if( source( mIndexGraph, *es.first ) != v || !mIndexGraph.contains( target( mIndexGraph, *es.first ) ) )
+		return false;
+	    indexOuts.insert( value( mIndexGraph, target( mIndexGraph, *es.first ) ) );
+	    ++noEdges;
+	}
+	for( auto es = inEdges( mIndexGraph, v ); es.first != es.second; ++es.first )
+	    indexIns.insert( value( mIndexGraph, source( mIndexGraph, *es.first ) ) );
+	if( outs != indexOuts || ins != indexIns )
+	{
+	    D( std::cout << "check failed, edges of " << value( mIndexGraph, v ) << " differ between graphs" << std::endl; );
+	    return false;
+	}
+    }
+    if( noEdges != mIndexGraph.edgeCount() )
+    {
+	D( std::cout << "check failed, counted " << mIndexGraph.edgeCount() << " of " << noEdges << " edges" << std::endl; );
+	return false;
+    }
+    return true;
+}
+
+AdjacencyDiGraphTest::TEST_CTOR( CsrSnapshotTest, "compressed snapshot matches graph" );
+
+void AdjacencyDiGraphTest::CsrSnapshotTest::iterate()
+{
+    mGraph = Gi();
+    std::uniform_int_distribution<> vdist( 0, 4 * mTestSize );
+    for( uint cInitVs = 0; cInitVs < mTestSize + 1; ++cInitVs )
+	addVertex( mGraph, vdist( mRandom ) );
+    randomEdges( mGraph, 4 * mTestSize );
+    mCsr.assign( mGraph );
+}
+
+bool AdjacencyDiGraphTest::CsrSnapshotTest::check() const
+{
+    if( graph::size( mCsr ) != graph::size( mGraph ) )
+	return false;
+
+    size_t noEdges = 0;
+    for( auto vs = vertices( mGraph ); vs.first != vs.second; ++vs.first )
+    {
+	auto outs = outEdges( mGraph, *vs.first );
+	auto ins = inEdges( mGraph, *vs.first );
+	uint32_t v = mCsr.index( value( mGraph, *vs.first ) );
+	if( v == CsrDiGraph< Gi >::NO_VERTEX || value( mCsr, v ) != value( mGraph, *vs.first ) ||
+	    std::distance( outs.first, outs.second ) != std::distance( outEdges( mCsr, v ).first, outEdges( mCsr, v ).second ) ||
+	    std::distance( ins.first, ins.second ) != std::distance( inEdges( mCsr, v ).first, inEdges( mCsr, v ).second ) )
+	    return false;
+
+	for( ; outs.first != outs.second; ++outs.first )
+	{
+	    uint32_t t = mCsr.index( value( mGraph, target( mGraph, *outs.first ) ) );
+	    if( findEdgeTo( mCsr, v, t ) == outEdges( mCsr, v ).second ||
+		findEdgeFrom( mCsr, v, t ) == inEdges( mCsr, t ).second )
+	    {
+		D( std::cout << "check failed, edge " << v << " -> " << t << " missing in snapshot" << std::endl; );
+		return false;
+	    }
+	    ++noEdges;
+	}
+    }
+    return noEdges == mCsr.edgeCount();
+}
+
+AdjacencyDiGraphTest::TEST_CTOR( CondensationTest, "strongly connected components condense graph to dag" );
+
+void AdjacencyDiGraphTest::CondensationTest::iterate()
+{
+    mGraph = Gi();
+    std::uniform_int_distribution<> vdist( 0, 4 * mTestSize );
+    for( uint cInitVs = 0; cInitVs < mTestSize + 1; ++cInitVs )
+	addVertex( mGraph, vdist( mRandom ) );
+    // sparse, so there are components of all sizes
+    randomEdges( mGraph, 1.2 * mTestSize );
+    mCsr.assign( mGraph );
+}
+
+bool AdjacencyDiGraphTest::CondensationTest::check() const
+{
+    typedef CsrDiGraph< Gi >::VertexT VertexT;
+    Condensation< CsrDiGraph< Gi > > cond( mCsr );
+    const size_t n = mCsr.size();
+
+    std::vector< std::vector< bool > > reaches( n, std::vector< bool >( n, false ) );
+    for( VertexT v = 0; v < n; ++v )
+    {
+	std::vector< VertexT > stack = { v };
+	reaches[ v ][ v ] = true;
+	while( !stack.empty() )
+	{
+	    VertexT u = stack.back();
+	    stack.pop_back();
+	    for( auto outs = outEdges( mCsr, u ); outs.first != outs.second; ++outs.first )
+	    {
+		VertexT t = target( mCsr, *outs.first );
+		if( !reaches[ v ][ t ] )
+		{
+		    reaches[ v ][ t ] = true;
+		    stack.push_back( t );
+		}
+	    }
+	}
+    }
+
+    size_t noMembers = 0;
+    for( uint c = 0; c < cond.size(); ++c )
+    {
+	for( auto m = cond.members( c ); m.first != m.second; ++m.first, ++noMembers )
+	{
+	    if( cond.component( *m.first ) != c )
+		return false;
+	}
+	for( auto ss = cond.successors( c ); ss.first != ss.second; ++ss.first )
+	{
+	    if( *ss.first >= c )
+	    {
+		D( std::cout << "check failed, component " << c << " has successor " << *ss.first << std::endl; );
+		return false;
+	    }
+	}
+    }
+    if( noMembers != n )
+	return false;
+
+    for( VertexT u = 0; u < n; ++u )
+    {
+	const uint cu = cond.component( u );
+	bool loop = findEdgeTo( mCsr, u, u ) != outEdges( mCsr, u ).second;
+	for( VertexT v = 0; v < n; ++v )
+	{
+	    const bool mutual = reaches[ u ][ v ] && reaches[ v ][ u ];
+	    if( mutual != ( cond.component( v ) == cu ) )
+	    {
+		D( std::cout << "check failed, " << u << " and " << v << " mutually reachable " << mutual << std::endl; );
+		return false;
+	    }
+	    loop = loop || ( u != v && mutual );
+	}
+	if( loop != cond.isCyclic( cu ) )
+	    return false;
+	for( auto outs = outEdges( mCsr, u ); outs.first != outs.second; ++outs.first )
+	{
+	    const uint ct = cond.component( target( mCsr, *outs.first ) );
+	    auto ss = cond.successors( cu );
+	    if( ct != cu && std::find( ss.first, ss.second, ct ) == ss.second )
+		return false;
+	}
+    }
+    return true;
+}
+
+AdjacencyDiGraphTest::TEST_CTOR( DFTTest, "depth first traversals visit reachable vertices once" );
+
+void AdjacencyDiGraphTest::DFTTest::iterate()
+{
+    mGraph = G();
+    // distinct values, a long chain and random edges
+    for( uint cInitVs = 0; cInitVs < 10 * mTestSize; ++cInitVs )
+	addVertex( mGraph, cInitVs );
+    DiGraphTraits< G >::VRangeT vs = vertices( mGraph );
+    for( uint cChain = 0; cChain + 1 < mTestSize; ++cChain )
+    {
+	G::VIterT isrc = vs.first + cChain, itrg = vs.first + cChain + 1;
+	addEdge( mGraph, *isrc, *itrg );
+    }
+    randomEdges( mGraph, 10 * mTestSize );
+}
+
+std::set< int > AdjacencyDiGraphTest::DFTTest::reachable( const G::VertexT& v, bool forward ) const
+{
+    std::set< int > reached = { value( mGraph, v ) };
+    std::vector< G::VertexT > stack = { v };
+    while( !stack.empty() )
+    {
+	G::VertexT u = stack.back();
+	stack.pop_back();
+	std::vector< G::VertexT > nexts;
+	if( forward )
+	    for( auto outs = outEdges( mGraph, u ); outs.first != outs.second; ++outs.first )
+		nexts.push_back( target( mGraph, *outs.first ) );
+	else
+	    for( auto ins = inEdges( mGraph, u ); ins.first != ins.second; ++ins.first )
+		nexts.push_back( source( mGraph, *ins.first ) );
+	for( auto& n : nexts )
+	    if( reached.insert( value( mGraph, n ) ).second )
+		stack.push_back( n );
+    }
+    return reached;
+}
+
+bool AdjacencyDiGraphTest::DFTTest::check() const
+{
+    const G::VertexT start = *vertices( mGraph ).first;
+    // shared between traversals, clearing has to forget earlier ones
+    VisitSet< G > visitSet( mGraph );
+    for( bool forward : { true, false } )
+	for( bool indexed : { false, true } )
+	{
+	    RecordingControl c;
+	    if( indexed )
+	    {
+		visitSet.clear();
+		c.init( mGraph, start );
+		if( forward )
+		    forwardDFTIterative( mGraph, start, c, visitSet );
+		else
+		    backwardDFTIterative( mGraph, start, c, visitSet );
+		c.finish( mGraph, start );
+	    }
+	    else if( forward )
+		forwardDFT( mGraph, start, c, ValueHash{ mGraph }, ValueEqual{ mGraph } );
+	    else
+		backwardDFT( mGraph, start, c, ValueHash{ mGraph }, ValueEqual{ mGraph } );
+
+	    std::set< int > visited( c.mVisited.begin(), c.mVisited.end() );
+	    if( visited.size() != c.mVisited.size() || visited != reachable( start, forward ) )
+	    {
+		D( std::cout << ( forward ? "forward" : "backward" ) << ( indexed ? " indexed" : " hashed" ) << " traversal visited "
+		   << c.mVisited.size() << " vertices, " << visited.size() << " distinct" << std::endl; );
+		return false;
+	    }
+	    if( !c.mNested || !c.mOpen.empty() || c.mLeft != value( mGraph, start ) )
+		return false;
+	}
+    return true;
+}
+
 AdjacencyDiGraphTest::MemoryFreed::MemoryFreed( const uint& testSize, const uint& reps )
     : ITest( "verify allocted nodes are freed upon graph destruction", testSize, reps )
     , mSizeDist( 0, testSize )
@@ -476,12 +849,24 @@ void AdjacencyDiGraphTest::init()
     uint simpleTestSize = 5 * mTestSize
 	, advancedSize = 0.5 * mTestSize;
     
-    addTest( new AddValueTest( simpleTestSize, mRepetitions ), interleave );
-    addTest( new AddEdgeTest( simpleTestSize, mRepetitions ), interleave );
-    addTest( new RemoveVertexTest( simpleTestSize, mRepetitions ), rinterleave );
-    addTest( new RemoveVertexNonCorruptionTest( advancedSize, mRepetitions ), rinterleave );
-    addTest( new RemoveVertexIncomingTest( advancedSize, mRepetitions ), rinterleave );
-    addTest( new RemoveVertexOutgoingTest( advancedSize, mRepetitions ), rinterleave );
-    addTest( new RemoveEdgeTest( advancedSize, mRepetitions ), rinterleave );
+    addTest( new AddValueTest< G >( simpleTestSize, mRepetitions ), interleave );
+    addTest( new AddValueTest< Gh >( simpleTestSize, mRepetitions ), interleave );
+    addTest( new AddEdgeTest< G >( simpleTestSize, mRepetitions ), interleave );
+    addTest( new AddEdgeTest< Gh >( simpleTestSize, mRepetitions ), interleave );
+    addTest( new RemoveVertexTest< G >( simpleTestSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexTest< Gh >( simpleTestSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexNonCorruptionTest< G >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexNonCorruptionTest< Gh >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexIncomingTest< G >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexIncomingTest< Gh >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexOutgoingTest< G >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveVertexOutgoingTest< Gh >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveEdgeTest< G >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new RemoveEdgeTest< Gh >( advancedSize, mRepetitions ), rinterleave );
+    addTest( new IndexMapRemovalTest( advancedSize, mRepetitions ), rinterleave );
+    addTest( new IndexHandleTest( advancedSize, mRepetitions ), rinterleave );
+    addTest( new CsrSnapshotTest( advancedSize, mRepetitions ), pStateless );
+    addTest( new CondensationTest( advancedSize, mRepetitions ), pStateless );
+    addTest( new DFTTest( advancedSize, 0.1 * mRepetitions ), pStateless );
     addTest( new MemoryFreed( simpleTestSize, 0.01 * mRepetitions ), pStateless );
 }
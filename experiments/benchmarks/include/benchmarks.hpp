@@ -0,0 +1,186 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include "adjacencyDiGraph.hpp"
+#include "indexDiGraph.hpp"
+#include "objectPool.hpp"
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <set>
+#include <ostream>
+#include <cstdint>
+
+//! \class accumulates the time spent between start and stop, setup outside of these is not measured
+class Stopwatch
+{
+  public:
+    typedef std::chrono::steady_clock ClockT;
+
+    void start() { mStart = ClockT::now(); }
+
+    void stop() { mNanoseconds += std::chrono::duration_cast< std::chrono::nanoseconds >( ClockT::now() - mStart ).count(); }
+
+    //! \brief adds ns measured elsewhere, e.g. by the phase profiler
+    void add( const uint64_t& ns ) { mNanoseconds += ns; }
+
+    uint64_t nanoseconds() const { return mNanoseconds; }
+
+  private:
+    ClockT::time_point mStart;
+    uint64_t mNanoseconds = 0;
+};
+
+//! \class nanoseconds of all repetitions of a benchmark at one size
+struct Measurement
+{
+    std::string mName;
+    size_t mSize;
+    // operations timed in each repetition
+    size_t mOperations;
+    std::vector< uint64_t > mNanoseconds;
+
+    uint64_t minimum() const { return *std::min_element( mNanoseconds.begin(), mNanoseconds.end() ); }
+
+    uint64_t median() const
+    {
+	std::vector< uint64_t > sorted( mNanoseconds );
+	std::nth_element( sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end() );
+	return sorted[ sorted.size() / 2 ];
+    }
+};
+
+/*!
+  \return measurement of repetitions calls of bench
+  \param bench callable taking a Stopwatch, starting and stopping it around the operations to time
+*/
+template< typename BenchT >
+Measurement measure( const std::string& name, const size_t& size, const size_t& operations, const uint& repetitions, BenchT&& bench )
+{
+    Measurement m{ name, size, operations, {} };
+    for( uint r = 0; r < repetitions; ++r )
+    {
+	Stopwatch sw;
+	bench( sw );
+	m.mNanoseconds.push_back( sw.nanoseconds() );
+    }
+    return m;
+}
+
+//! \brief writes names of the columns written by operator << of Measurement
+inline std::ostream& writeHeader( std::ostream& os )
+{
+    return os << "benchmark,size,operations,repetitions,minNs,medianNs,minNsPerOperation,medianNsPerOperation" << std::endl;
+}
+
+//! \brief writes m as one csv line
+inline std::ostream& operator <<( std::ostream& os, const Measurement& m )
+{
+    const double ops = std::max< size_t >( m.mOperations, 1 );
+    return os << m.mName << "," << m.mSize << "," << m.mOperations << "," << m.mNanoseconds.size()
+	      << "," << m.minimum() << "," << m.median()
+	      << "," << m.minimum() / ops << "," << m.median() / ops << std::endl;
+}
+
+//! \return graph of vertices 0, ..., size - 1 without edges
+template< typename G >
+G vertexGraph( const size_t& size )
+{
+    G g;
+    for( size_t v = 0; v < size; ++v )
+	graph::addVertex( g, int( v ) );
+    return g;
+}
+
+//! \return vertices of g
+template< typename G >
+std::vector< typename G::VertexT > verticesOf( const G& g )
+{
+    std::vector< typename G::VertexT > vertices;
+    for( auto vs = graph::vertices( g ); vs.first != vs.second; ++vs.first )
+	vertices.push_back( *vs.first );
+    return vertices;
+}
+
+//! \return distinct pairs of positions into vertices, about edgesPerVertex for each vertex, drawn from a generator seeded by seed
+inline std::vector< std::pair< size_t, size_t > > randomEdges( const size_t& size, const size_t& edgesPerVertex, const uint64_t& seed )
+{
+    std::mt19937_64 random( seed );
+    std::uniform_int_distribution< size_t > dist( 0, size - 1 );
+    std::set< std::pair< size_t, size_t > > unique;
+    for( size_t e = 0; e < size * edgesPerVertex; ++e )
+	unique.insert( std::make_pair( dist( random ), dist( random ) ) );
+    std::vector< std::pair< size_t, size_t > > edges( unique.begin(), unique.end() );
+    std::shuffle( edges.begin(), edges.end(), random );
+    return edges;
+}
+
+template< typename G >
+void benchAddVertices( const size_t& size, Stopwatch& sw )
+{
+    G g;
+    sw.start();
+    for( size_t v = 0; v < size; ++v )
+	graph::addVertex( g, int( v ) );
+    sw.stop();
+}
+
+template< typename G >
+void benchRemoveVertices( const size_t& size, Stopwatch& sw )
+{
+    G g = vertexGraph< G >( size );
+    const std::vector< typename G::VertexT > vertices = verticesOf( g );
+    sw.start();
+    for( const typename G::VertexT& v : vertices )
+	graph::removeVertex( g, v );
+    sw.stop();
+}
+
+template< typename G >
+void benchAddEdges( const size_t& size, const std::vector< std::pair< size_t, size_t > >& edges, Stopwatch& sw )
+{
+    G g = vertexGraph< G >( size );
+    const std::vector< typename G::VertexT > vertices = verticesOf( g );
+    sw.start();
+    for( const std::pair< size_t, size_t >& e : edges )
+	graph::addEdge( g, vertices[ e.first ], vertices[ e.second ] );
+    sw.stop();
+}
+
+template< typename G >
+void benchRemoveEdges( const size_t& size, const std::vector< std::pair< size_t, size_t > >& edges, Stopwatch& sw )
+{
+    G g = vertexGraph< G >( size );
+    const std::vector< typename G::VertexT > vertices = verticesOf( g );
+    for( const std::pair< size_t, size_t >& e : edges )
+	graph::addEdge( g, vertices[ e.first ], vertices[ e.second ] );
+    sw.start();
+    for( const std::pair< size_t, size_t >& e : edges )
+	graph::removeEdge( g, vertices[ e.first ], vertices[ e.second ] );
+    sw.stop();
+}
+
+/*!
+  \brief hands out size fresh objects and back, then hands them out and back again, recycled
+  \param PoolT ObjectPoolRaw or ConcurrentObjectPoolRaw
+*/
+template< typename PoolT, typename T >
+void benchPool( const size_t& size, const size_t& chunkSize, Stopwatch& sw )
+{
+    PoolT pool( chunkSize );
+    std::vector< T* > objects( size );
+    sw.start();
+    for( uint round = 0; round < 2; ++round )
+    {
+	for( T*& pObj : objects )
+	    pObj = pool.handOut();
+	for( T* pObj : objects )
+	    pool.handBack( pObj );
+    }
+    sw.stop();
+}
+
+#endif
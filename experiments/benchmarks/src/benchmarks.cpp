@@ -0,0 +1,139 @@
+#include "benchmarks.hpp"
+
+#include "cegar.hpp"
+#include "guide.hpp"
+#include "phaseProfiler.hpp"
+
+#include "expression/space.hpp"
+#include "expression/expression.hpp"
+#include "function/function.hpp"
+
+#include <iostream>
+#include <array>
+#include <memory>
+#include <string>
+
+typedef Ariadne::ExactBoxType EncT;
+typedef RefinementTree< EncT > RtreeT;
+
+// graph types compared: vertices as before the refinement tree used index handles, and as used now
+typedef graph::AdjacencyDiGraph< int, graph::IndexMap, graph::HashVec, graph::HashVec > AdjacencyGraphT;
+typedef graph::IndexDiGraph< int, graph::IndexMap, graph::HashVec, graph::HashVec > IndexGraphT;
+
+// object of the size of a small tree value
+typedef std::array< double, 8 > PooledT;
+
+const size_t EDGES_PER_VERTEX = 4;
+const size_t POOL_CHUNK_SIZE = 64;
+
+//! \return refinement tree of the henon map with safe set [-2, 2]^2
+std::unique_ptr< RtreeT > henonTree( const Ariadne::Effort& effort )
+{
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::RealConstant a( "a", Ariadne::Real( 1.4 ) ), b( "b", Ariadne::Real( 0.3 ) );
+    Ariadne::EffectiveVectorFunction henon = Ariadne::make_function( {x, y}, {1 - a*x*x + y, b*x} );
+    Ariadne::BoundedConstraintSet safe( Ariadne::RealBox( { {-2, 2}, {-2, 2} } ) );
+    return std::unique_ptr< RtreeT >( new RtreeT( safe, henon, effort ) );
+}
+
+/*!
+  \brief refines noRefinements leaves of rtree, drawn uniformly from a generator seeded by seed
+  \param sw if not null, timing the refinements only
+*/
+void refineRandomLeaves( RtreeT& rtree, const size_t& noRefinements, const uint64_t& seed, Stopwatch* sw = nullptr )
+{
+    LargestSideRefiner refiner;
+    std::mt19937_64 random( seed );
+    for( size_t r = 0; r < noRefinements; ++r )
+    {
+	auto vs = graph::vertices( rtree.graph() );
+	typename RtreeT::NodeT n;
+	do
+	    n = *std::next( vs.first, std::uniform_int_distribution< size_t >( 0, std::distance( vs.first, vs.second ) - 1 )( random ) );
+	while( rtree.equal( rtree.outside(), n ) );
+	if( sw )
+	    sw->start();
+	rtree.refine( n, refiner );
+	if( sw )
+	    sw->stop();
+    }
+}
+
+void graphBenchmarks( const size_t& size, const uint& repetitions, const uint64_t& seed )
+{
+    const std::vector< std::pair< size_t, size_t > > edges = randomEdges( size, EDGES_PER_VERTEX, seed );
+
+    std::cout << measure( "adjacencyGraph.addVertex", size, size, repetitions, [&size] (Stopwatch& sw) { benchAddVertices< AdjacencyGraphT >( size, sw ); } )
+	      << measure( "adjacencyGraph.removeVertex", size, size, repetitions, [&size] (Stopwatch& sw) { benchRemoveVertices< AdjacencyGraphT >( size, sw ); } )
+	      << measure( "adjacencyGraph.addEdge", size, edges.size(), repetitions, [&] (Stopwatch& sw) { benchAddEdges< AdjacencyGraphT >( size, edges, sw ); } )
+	      << measure( "adjacencyGraph.removeEdge", size, edges.size(), repetitions, [&] (Stopwatch& sw) { benchRemoveEdges< AdjacencyGraphT >( size, edges, sw ); } )
+	      << measure( "indexGraph.addVertex", size, size, repetitions, [&size] (Stopwatch& sw) { benchAddVertices< IndexGraphT >( size, sw ); } )
+	      << measure( "indexGraph.removeVertex", size, size, repetitions, [&size] (Stopwatch& sw) { benchRemoveVertices< IndexGraphT >( size, sw ); } )
+	      << measure( "indexGraph.addEdge", size, edges.size(), repetitions, [&] (Stopwatch& sw) { benchAddEdges< IndexGraphT >( size, edges, sw ); } )
+	      << measure( "indexGraph.removeEdge", size, edges.size(), repetitions, [&] (Stopwatch& sw) { benchRemoveEdges< IndexGraphT >( size, edges, sw ); } );
+}
+
+void poolBenchmarks( const size_t& size, const uint& repetitions )
+{
+    std::cout << measure( "objectPoolRaw.handOutBack", size, 4 * size, repetitions
+			  , [&size] (Stopwatch& sw) { benchPool< ObjectPoolRaw< PooledT >, PooledT >( size, POOL_CHUNK_SIZE, sw ); } )
+	      << measure( "concurrentObjectPoolRaw.handOutBack", size, 4 * size, repetitions
+			  , [&size] (Stopwatch& sw) { benchPool< ConcurrentObjectPoolRaw< PooledT >, PooledT >( size, POOL_CHUNK_SIZE, sw ); } );
+}
+
+void refinementBenchmarks( const size_t& size, const uint& repetitions, const uint64_t& seed )
+{
+    const Ariadne::Effort effort( 10 );
+
+    // transitive safety is updated within refine only, its share is taken from the phase profiler
+    Measurement transSafety{ "refinementTree.transitiveSafety", size, 0, {} };
+    Measurement refine = measure( "refinementTree.refine", size, size, repetitions, [&] (Stopwatch& sw) {
+	    std::unique_ptr< RtreeT > pRtree = henonTree( effort );
+	    const PhaseStats before = PhaseProfiler::instance().collect()[ static_cast< size_t >( Phase::TRANS_SAFETY ) ];
+	    refineRandomLeaves( *pRtree, size, seed, &sw );
+	    PhaseStats during = PhaseProfiler::instance().collect()[ static_cast< size_t >( Phase::TRANS_SAFETY ) ];
+	    during -= before;
+	    transSafety.mOperations = during.mCalls;
+	    transSafety.mNanoseconds.push_back( during.mNanoseconds );
+	} );
+    std::cout << refine;
+#ifdef CEGAR_PROFILE
+    std::cout << transSafety;
+#endif
+
+    std::unique_ptr< RtreeT > pRtree = henonTree( effort );
+    refineRandomLeaves( *pRtree, size, seed );
+    Ariadne::BoundedConstraintSet initialSet( Ariadne::RealBox( { {0, 0.5}, {0, 0.5} } ) );
+    auto intersects = [&effort] (const EncT& enc, const Ariadne::BoundedConstraintSet& cs) { return !cs.separated( enc ).check( effort ); };
+    const std::vector< typename RtreeT::NodeT > initialNodes = pRtree->intersection( initialSet, intersects );
+    std::cout << measure( "findCounterexample", size, 1, repetitions, [&] (Stopwatch& sw) {
+	    StateVolume stateH; GreatestState cexH;
+	    CounterexampleStore< EncT, StateVolume, GreatestState > store( stateH, cexH );
+	    sw.start();
+	    findCounterexample( *pRtree, initialNodes.begin(), initialNodes.end(), store );
+	    sw.stop();
+	} );
+}
+
+/*!
+  writes csv timings of graph, pool and refinement operations at growing sizes to stdout
+  usage: benchmarks [repetitions = 5] [log2 of largest graph size = 14] [seed = 0]
+  refinement benchmarks run at sizes smaller by a factor of 16, as each refinement computes images
+  \note sizes, seeds and effort are fixed, so outputs of different builds can be compared line by line
+*/
+int main( int argc, char** argv )
+{
+    const uint repetitions = argc > 1 ? std::stoul( argv[ 1 ] ) : 5;
+    const uint maxExponent = argc > 2 ? std::stoul( argv[ 2 ] ) : 14;
+    const uint64_t seed = argc > 3 ? std::stoull( argv[ 3 ] ) : 0;
+    const uint MIN_EXPONENT = 8, REFINEMENT_SHIFT = 4;
+
+    writeHeader( std::cout );
+    for( uint e = MIN_EXPONENT; e <= maxExponent; ++e )
+    {
+	graphBenchmarks( size_t( 1 ) << e, repetitions, seed );
+	poolBenchmarks( size_t( 1 ) << e, repetitions );
+    }
+    for( uint e = MIN_EXPONENT - REFINEMENT_SHIFT; e + REFINEMENT_SHIFT <= maxExponent; ++e )
+	refinementBenchmarks( size_t( 1 ) << e, repetitions, seed );
+}
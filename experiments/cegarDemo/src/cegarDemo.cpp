@@ -77,10 +77,11 @@ int main()
     GreatestState counterexH;
     TreeSizePrinter sizePrinter;
     DebugOutput dbgout;
+    KeepReached< ExactRefinementTree::EnclosureT > reached( initialSet, effort );
 
     LimitedIterations termination( maxNodes );
     
-    auto safety = cegar( rtree, initialSet, effort, refiner, stateH, counterexH, termination, dbgout );
+    auto safety = cegar( rtree, initialSet, effort, refiner, stateH, counterexH, termination, dbgout, reached );
     std::cout << "safety " << safety.first << std::endl;
     std::cout << "counterexample " << std::endl;
     for( auto& n : safety.second )
@@ -101,7 +102,7 @@ int main()
     }
     
     // trying graphical output
-    auto fig = visualize( rtree, initialSet, effort );
+    auto fig = visualize( rtree, initialSet, reached.reached() );
     fig.write( "test.png" );
     
     return 0;
@@ -7,6 +7,14 @@
 #include "expression/constant.hpp"
 
 #include <tuple>
+#include <vector>
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include <omp.h>
 
 template< typename E > class System;
 
@@ -65,6 +73,12 @@ class System
 	return RefinementTree< E >( mSafe, mDynamics, mEffort );
     }
 
+    //! \return refinement tree warm started from the partition of snapshot, e.g. saved for the system with other parameters
+    RefinementTree< E > refinementTree( std::istream& snapshot ) const
+    {
+	return RefinementTree< E >( mSafe, mDynamics, mEffort, snapshot );
+    }
+
     const Ariadne::BoundedConstraintSet& initialSet() const
     {
 	return mInitial;
@@ -154,46 +168,143 @@ void printHead( std::ostream& o, const H& heuristic, const uint padding )
 	o << ",";
 }
 
-template< typename E, typename R, typename L, typename G, typename TermT, typename ... Ms >
-void performWithConfig( const System< E >& system, const uint& repetitions
-			, const R& refinement, const L& locator, const G& guide, const TermT& term, Metrics& mets )
+//! \class metrics of one repetition of a configuration on a system
+struct RunMetrics
 {
-    ExperimentConfiguration< R, L, G, TermT > config( repetitions, refinement, locator, guide, term );
+    unsigned long mTotal = 0, mSearch = 0, mCheck = 0, mRefine = 0, mMisc = 0;
+    uint mIterations = 0, mCounterexamples = 0;
+    double mAverage = 0.0;
+    Ariadne::ValidatedKleenean mResult;
+    // reason the repetition failed, empty if it did not
+    std::string mError;
+};
+
+//! \return metrics of a single run of refinement, locator, guide and term on system
+template< typename E, typename R, typename L, typename G, typename TermT >
+RunMetrics runWithConfig( const System< E >& system, const R& refinement, const L& locator, const G& guide, const TermT& term )
+{
+    ExperimentConfiguration< R, L, G, TermT > config( 1, refinement, locator, guide, term );
 
     CegarTimer< std::chrono::milliseconds > timer;
     IterationCounter iterations;
     CounterexampleLengthAverage cexLength;
-    // DebugOutput debugOut;
 
+    RunMetrics run;
     try
     {
-	auto safety = config.run( system, timer, iterations, cexLength );
-
-	mets.mTotal.push_back( timer.total() );
-	mets.mSearch.push_back( timer.search() );
-	mets.mCheck.push_back( timer.check() );
-	mets.mRefine.push_back( timer.refine() );
-	mets.mMisc.push_back( timer.other() );
-	mets.mIterations.push_back( iterations.iterations() );
-	mets.mAverage.push_back( cexLength.average() );
-	mets.mResult.push_back( safety );
-
-	// std::cout << system.name() << " + " << refinement.name() << " + " << locator.name() << " + " << guide.name() << std::endl
-	// 	  << "total " << timer.total()
-	// 	  << ", searching " << timer.search()
-	// 	  << ", checking " << timer.check()
-	// 	  << ", refining " << timer.refine()
-	// 	  << ", misc " << timer.other()
-	// 	  << ", iterations " << iterations.iterations()
-	// 	  << std::endl;
-	
-	// maybe do a visualization as well?
+	run.mResult = config.run( system, timer, iterations, cexLength );
+	run.mTotal = timer.total();
+	run.mSearch = timer.search();
+	run.mCheck = timer.check();
+	run.mRefine = timer.refine();
+	run.mMisc = timer.other();
+	run.mIterations = iterations.iterations();
+	run.mCounterexamples = cexLength.counterexamples();
+	run.mAverage = cexLength.average();
     }
     catch( const std::exception& e )
     {
-	std::cout << "failed because " << e.what() << std::endl;
+	run.mError = e.what();
+    }
+    return run;
+}
+
+/*!
+  \brief appends the repetitions of one configuration to mets as a single column
+  times and iterations are summed, averages are weighted by the counterexamples they are taken over and the result is the one of the last repetition
+  \note if any repetition failed, nothing is appended and the failure is reported
+*/
+inline void mergeInto( Metrics& mets, const std::vector< RunMetrics >& runs )
+{
+    RunMetrics sum;
+    for( const RunMetrics& run : runs )
+    {
+	if( !run.mError.empty() )
+	{
+	    std::cout << "failed because " << run.mError << std::endl;
+	    return;
+	}
+	sum.mTotal += run.mTotal;
+	sum.mSearch += run.mSearch;
+	sum.mCheck += run.mCheck;
+	sum.mRefine += run.mRefine;
+	sum.mMisc += run.mMisc;
+	sum.mIterations += run.mIterations;
+	sum.mCounterexamples += run.mCounterexamples;
+	sum.mAverage += run.mAverage * run.mCounterexamples;
+	sum.mResult = run.mResult;
+    }
+    mets.mTotal.push_back( sum.mTotal );
+    mets.mSearch.push_back( sum.mSearch );
+    mets.mCheck.push_back( sum.mCheck );
+    mets.mRefine.push_back( sum.mRefine );
+    mets.mMisc.push_back( sum.mMisc );
+    mets.mIterations.push_back( sum.mIterations );
+    mets.mAverage.push_back( sum.mCounterexamples > 0 ? sum.mAverage / sum.mCounterexamples : 0.0 );
+    mets.mResult.push_back( sum.mResult );
+}
+
+template< typename E, typename R, typename L, typename G, typename TermT, typename ... Ms >
+void performWithConfig( const System< E >& system, const uint& repetitions
+			, const R& refinement, const L& locator, const G& guide, const TermT& term, Metrics& mets )
+{
+    std::vector< RunMetrics > runs;
+    for( uint r = 0; r < repetitions; ++r )
+	runs.push_back( runWithConfig( system, refinement, locator, guide, term ) );
+    mergeInto( mets, runs );
+}
+
+/*!
+  \class runs independent jobs on a fixed number of threads, each job taking the next one not started yet
+  parallel regions opened by a job use at most threadsPerJob threads, so jobs times threads per job bounds the threads busy
+*/
+class JobRunner
+{
+  public:
+    //! \param noJobs number of jobs run at once, 0 to fill the hardware threads with jobs of threadsPerJob threads
+    JobRunner( const uint& noJobs, const uint& threadsPerJob )
+	: mNoJobs( noJobs > 0 ? noJobs : std::max( 1u, std::thread::hardware_concurrency() / std::max( 1u, threadsPerJob ) ) )
+	, mThreadsPerJob( std::max( 1u, threadsPerJob ) )
+    {}
+
+    void add( const std::function< void() >& job ) { mJobs.push_back( job ); }
+
+    //! \brief runs all jobs added, returns once all finished
+    void run()
+    {
+	std::atomic< size_t > next( 0 );
+	std::vector< std::thread > workers;
+	for( uint w = 0; w < std::min< size_t >( mNoJobs, mJobs.size() ); ++w )
+	    workers.emplace_back( [this, &next] () {
+		    // the number of threads is a per thread setting, applying to regions opened by this worker only
+		    omp_set_num_threads( mThreadsPerJob );
+		    for( size_t j = next++; j < mJobs.size(); j = next++ )
+			mJobs[ j ]();
+		} );
+	for( std::thread& w : workers )
+	    w.join();
+	mJobs.clear();
+    }
+
+  private:
+    uint mNoJobs, mThreadsPerJob;
+    std::vector< std::function< void() > > mJobs;
+};
+
+/*!
+  \brief adds a job for each repetition of a configuration on system to runner
+  \param runs receives the metrics of the repetitions, sized to repetitions, has to outlive running the jobs
+*/
+template< typename E, typename R, typename L, typename G, typename TermT >
+void scheduleWithConfig( JobRunner& runner, const System< E >& system, const uint& repetitions
+			 , const R& refinement, const L& locator, const G& guide, const TermT& term, std::vector< RunMetrics >& runs )
+{
+    runs.resize( repetitions );
+    for( uint r = 0; r < repetitions; ++r )
+    {
+	RunMetrics* pRun = &runs[ r ];
+	runner.add( [&system, refinement, locator, guide, term, pRun] () { *pRun = runWithConfig( system, refinement, locator, guide, term ); } );
     }
-    // std::cout << std::endl;
 }
 
 #endif
@@ -0,0 +1,162 @@
+#ifndef REGRESSION_HPP
+#define REGRESSION_HPP
+
+#include "heuristics.hpp"
+#include "termination.hpp"
+#include "guide.hpp"
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <omp.h>
+
+//! \class system of the benchmark catalogue and the name it is selected by
+struct CatalogueEntry
+{
+    std::string mName;
+    System< Ariadne::ExactBoxType > mSystem;
+};
+
+//! \return the named presets of the systems used in experiments: logistic and henon map at the difficulties false, easy, hard and crazy, bogdanov map, two tinkerbell maps and duffing map
+std::vector< CatalogueEntry > systemCatalogue( const Ariadne::Effort& effort );
+
+/*!
+  \return entries of catalogue named by names, in the order of names
+  \note throws if a name is not in catalogue
+*/
+inline std::vector< CatalogueEntry > selectSystems( const std::vector< CatalogueEntry >& catalogue, const std::vector< std::string >& names )
+{
+    std::vector< CatalogueEntry > selected;
+    for( const std::string& name : names )
+    {
+	auto ientry = std::find_if( catalogue.begin(), catalogue.end(), [&name] (const CatalogueEntry& e) { return e.mName == name; } );
+	if( ientry == catalogue.end() )
+	    throw std::logic_error( "system " + name + " is not in the catalogue" );
+	selected.push_back( *ientry );
+    }
+    return selected;
+}
+
+//! \class measurements of a run of a catalogue system under a fixed iteration budget and fixed seeds
+struct RegressionRecord
+{
+    std::string mSystem;
+    uint mIterations = 0;
+    uint64_t mSeed = 0;
+    std::string mResult;
+    unsigned long mMilliseconds = 0;
+    size_t mPeakBytes = 0, mNodes = 0;
+
+    static const char* header() { return "system,iterations,seed,result,milliseconds,peakBytes,nodes"; }
+};
+
+inline std::ostream& operator <<( std::ostream& os, const RegressionRecord& r )
+{
+    return os << r.mSystem << "," << r.mIterations << "," << r.mSeed << "," << r.mResult << "," << r.mMilliseconds << "," << r.mPeakBytes << "," << r.mNodes;
+}
+
+/*!
+  \brief runs cegar on the system of entry for at most iterations iterations
+  the random refiner and random state heuristic are seeded from seed, so runs with equal seeds refine the same nodes
+  runs on a single thread, so times are comparable between machines and the order counterexamples are found in does not vary
+  \return time of the loop, peak memory of the refinement tree sampled at the start of each iteration and nodes of the final tree
+  \note the number of threads of later parallel regions is restored
+*/
+inline RegressionRecord runRegression( const CatalogueEntry& entry, const uint& iterations, const uint64_t& seed )
+{
+    typedef Ariadne::ExactBoxType EncT;
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads( 1 );
+    RefinementTree< EncT > rtree = entry.mSystem.refinementTree();
+    RandomRefiner refinement( 0.25, 0.75, seed );
+    RandomStateValue stateH( seed + 1 );
+    GreatestState counterexampleH;
+
+    CegarTimer< std::chrono::milliseconds > timer;
+    MemoryObserver memory;
+    auto result = cegar( rtree, entry.mSystem.initialSet(), rtree.effort(), refinement, stateH, counterexampleH, LimitedIterations( iterations ), timer, memory );
+    omp_set_num_threads( threads );
+
+    RegressionRecord record;
+    record.mSystem = entry.mName;
+    record.mIterations = iterations;
+    record.mSeed = seed;
+    std::stringstream ss;
+    ss << result.first;
+    record.mResult = ss.str();
+    record.mMilliseconds = timer.total();
+    for( const MemoryObserver::Sample& s : memory.samples() )
+	record.mPeakBytes = std::max( record.mPeakBytes, s.mUsage.total() );
+    record.mNodes = graph::size( rtree.graph() );
+    return record;
+}
+
+//! \return records in the format written by operator <<, preceded by the header line
+inline std::vector< RegressionRecord > readBaseline( std::istream& is )
+{
+    std::vector< RegressionRecord > records;
+    std::string line;
+    std::getline( is, line );
+    if( line != RegressionRecord::header() )
+	throw std::logic_error( "baseline does not start with the header of regression records" );
+    while( std::getline( is, line ) )
+    {
+	if( line.empty() )
+	    continue;
+	std::stringstream ls( line );
+	std::vector< std::string > fields;
+	std::string field;
+	while( std::getline( ls, field, ',' ) )
+	    fields.push_back( field );
+	if( fields.size() != 7 )
+	    throw std::logic_error( "baseline record " + line + " does not have 7 fields" );
+	RegressionRecord r;
+	r.mSystem = fields[ 0 ];
+	r.mIterations = std::stoul( fields[ 1 ] );
+	r.mSeed = std::stoull( fields[ 2 ] );
+	r.mResult = fields[ 3 ];
+	r.mMilliseconds = std::stoul( fields[ 4 ] );
+	r.mPeakBytes = std::stoull( fields[ 5 ] );
+	r.mNodes = std::stoull( fields[ 6 ] );
+	records.push_back( r );
+    }
+    return records;
+}
+
+//! milliseconds a run may exceed the baseline by regardless of the tolerance, short runs are timed too coarsely for relative bounds
+constexpr unsigned long REGRESSION_TIME_SLACK = 10;
+
+/*!
+  \return regressions of run against the record of baseline with equal system, iterations and seed, empty if there are none
+  results and node counts have to match exactly as runs are seeded, time and peak memory may exceed the baseline by a fraction of tolerance
+  \note a run without a matching baseline record is not reported, e.g. when a system was added to the catalogue
+*/
+inline std::vector< std::string > compareToBaseline( const RegressionRecord& run, const std::vector< RegressionRecord >& baseline
+						     , const double& timeTolerance, const double& memoryTolerance )
+{
+    std::vector< std::string > regressions;
+    auto ibase = std::find_if( baseline.begin(), baseline.end(), [&run] (const RegressionRecord& r) {
+	    return r.mSystem == run.mSystem && r.mIterations == run.mIterations && r.mSeed == run.mSeed; } );
+    if( ibase == baseline.end() )
+	return regressions;
+    auto describe = [&regressions, &run] (const std::string& what, const auto& base, const auto& now) {
+	std::stringstream ss;
+	ss << run.mSystem << ": " << what << " " << now << " instead of " << base;
+	regressions.push_back( ss.str() ); };
+    if( run.mResult != ibase->mResult )
+	describe( "result", ibase->mResult, run.mResult );
+    if( run.mNodes != ibase->mNodes )
+	describe( "nodes", ibase->mNodes, run.mNodes );
+    if( run.mMilliseconds > ( 1 + timeTolerance ) * ibase->mMilliseconds + REGRESSION_TIME_SLACK )
+	describe( "milliseconds", ibase->mMilliseconds, run.mMilliseconds );
+    if( run.mPeakBytes > ( 1 + memoryTolerance ) * ibase->mPeakBytes )
+	describe( "peak bytes", ibase->mPeakBytes, run.mPeakBytes );
+    return regressions;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "heuristics.hpp"
+#include "regression.hpp"
 
 #include "guide.hpp" // others should also be removed from refinementTree, cegar and heuristics.hpp for cleanliness
 
@@ -8,6 +9,7 @@
 
 #include <array>
 #include <sstream>
+#include <fstream>
 
 std::ostream& operator <<( std::ostream& os, const Metrics& mets )
 {
@@ -140,59 +142,103 @@ System< Ariadne::ExactBoxType > duffing( const double& a, const double& b
 
 
 
-int main()
+std::vector< CatalogueEntry > systemCatalogue( const Ariadne::Effort& effort )
+{
+    return {
+	    { "logisticFalse", logisticMap( 0.98, 0.98, 0.35, 0.4, 0.1, effort ) }
+	    , { "logisticEasy", logisticMap( 0.98, 0.98, 1.1, 0.4, 0.1, effort ) }
+	    , { "logisticHard", logisticMap( 1.00, 0.99, 3, 0.4, 0.1, effort ) }
+	    , { "logisticCrazy", logisticMap( 1.1, 0.99, 3, 0.4, 0.1, effort ) }
+	    , { "henonFalse", henonMap( 1.4, 0.3
+					, -2, 2, -2, 2
+					, 0, 0.4, 0, 0.34, effort ) }
+	    , { "henonEasy", henonMap( 1.375, 0.3
+				       , -2, 2, -2, 1
+				       , 0, 0.6, 0, 0.3, effort ) }
+	    , { "henonHard", henonMap( 1.4, 0.3
+				       , -3, 3, -3, 3
+				       , 0, 0.25, 0, 0.25, effort ) }
+	    , { "henonCrazy", henonMap( 1.425, 0.3
+					, -3, 3, -3, 3
+					, 0, 0.25, 0, 0.25, effort ) }
+	    , { "bogdanov", bogdanovMap( 0.2, 1, 1, 1.25, 0.25, effort ) }
+	    , { "tinkerbell1", tinkerbell( 0.9, -0.6013, 2, 0.5
+					   , -2, 2, -2, 2
+					   , -0.8, -0.6, -0.7, -0.5
+					   , effort ) }
+	    , { "tinkerbell2", tinkerbell( 0.3, 0.6, 2, 0.27
+					   , -0.5, 0.5, -0.5, 1.5
+					   , 0, 0.15, 0, 0.7, effort ) }
+	    , { "duffing", duffing( 2.75, 0.2
+				    , -2, 2, -2, 2
+				    , -0.25, 1, -0.5, 0.8, effort ) }
+    };
+}
+
+//! relative amounts by which time and peak memory of a regression run may exceed the baseline
+const double REGRESSION_TIME_TOLERANCE = 0.25;
+const double REGRESSION_MEMORY_TOLERANCE = 0.05;
+
+/*!
+  \brief runs systems of the catalogue with fixed iterations and seeds, writes their records and compares them to the baseline
+  \param args baseline file, - to record only, followed by iterations, seed and names of systems, all of the catalogue if none are named
+  \return 0 if no regression was found
+*/
+int regression( const std::vector< std::string >& args, const Ariadne::Effort& effort )
+{
+    if( args.empty() )
+	throw std::logic_error( "regression needs a baseline file or - to record only" );
+    const uint iterations = args.size() > 1 ? std::stoul( args[ 1 ] ) : 50;
+    const uint64_t seed = args.size() > 2 ? std::stoull( args[ 2 ] ) : 0;
+    const std::vector< CatalogueEntry > catalogue = systemCatalogue( effort );
+    std::vector< CatalogueEntry > systems = catalogue;
+    if( args.size() > 3 )
+	systems = selectSystems( catalogue, std::vector< std::string >( args.begin() + 3, args.end() ) );
+
+    std::vector< RegressionRecord > baseline;
+    if( args[ 0 ] != "-" )
+    {
+	std::ifstream is( args[ 0 ] );
+	if( !is )
+	    throw std::logic_error( "baseline " + args[ 0 ] + " cannot be read" );
+	baseline = readBaseline( is );
+    }
+
+    std::vector< std::string > regressions;
+    std::cout << RegressionRecord::header() << std::endl;
+    for( const CatalogueEntry& entry : systems )
+    {
+	const RegressionRecord record = runRegression( entry, iterations, seed );
+	std::cout << record << std::endl;
+	const std::vector< std::string > found = compareToBaseline( record, baseline, REGRESSION_TIME_TOLERANCE, REGRESSION_MEMORY_TOLERANCE );
+	regressions.insert( regressions.end(), found.begin(), found.end() );
+    }
+    for( const std::string& r : regressions )
+	std::cerr << "regression of " << r << std::endl;
+    return regressions.empty() ? 0 : 1;
+}
+
+/*!
+  usage: heuristics [jobs = 0] [threads per job = 1]
+  each repetition of a configuration on a system is an independent job, 0 jobs fill the hardware threads
+  usage: heuristics regression <baseline | -> [iterations = 50] [seed = 0] [system ...]
+  runs the named systems of the catalogue, or all, and exits with 1 if a run regressed against the baseline
+*/
+int main( int argc, char** argv )
 {
     typedef Ariadne::ExactBoxType EncT;
     Ariadne::Effort effort( 25 );
+    if( argc > 1 && std::string( argv[ 1 ] ) == "regression" )
+	return regression( std::vector< std::string >( argv + 2, argv + argc ), effort );
+
+    const uint noJobs = argc > 1 ? std::stoul( argv[ 1 ] ) : 0;
+    const uint threadsPerJob = argc > 2 ? std::stoul( argv[ 2 ] ) : 1;
     std::vector< System< EncT > > systems;
 
-    // std::vector< System< EncT > > systems = { logistic( 0.5, 1, 1, 0.4, 0.1, 10 ) };
-    // std::vector< ExperimentConfiguration > configs = { ExperimentConfiguration
-    System< EncT > logisticFalse = logisticMap( 0.98, 0.98, 0.35, 0.4, 0.1, effort );
-    System< EncT > logisticEasy = logisticMap( 0.98, 0.98, 1.1, 0.4, 0.1, effort );
-    System< EncT > logisticHard = logisticMap( 1.00, 0.99, 3, 0.4, 0.1, effort );
-    System< EncT > logisticCrazy = logisticMap( 1.1, 0.99, 3, 0.4, 0.1, effort );
-
-    System< EncT > henonFalse = henonMap( 1.4, 0.3
-					  , -2, 2, -2, 2
-					  , 0, 0.4, 0, 0.34, effort );
-
-    System< EncT > henonEasy = henonMap( 1.375, 0.3
-					 , -2, 2, -2, 1
-					 , 0, 0.6, 0, 0.3, effort );
-    System< EncT > henonHard = henonMap( 1.4, 0.3
-					 , -3, 3, -3, 3
-					 , 0, 0.25, 0, 0.25, effort );
-    System< EncT > henonCrazy = henonMap( 1.425, 0.3
-					  , -3, 3, -3, 3
-					  , 0, 0.25, 0, 0.25, effort );
-    
-    System< EncT > tinkerbell1 = tinkerbell( 0.9, -0.6013, 2, 0.5
-    					     , -2, 2, -2, 2
-					     , -0.8, -0.6, -0.7, -0.5
-    					     , effort );
-    System< EncT > tinkerbell2 = tinkerbell( 0.3, 0.6, 2, 0.27
-    					     , -0.5, 0.5, -0.5, 1.5
-    					     , 0, 0.15, 0, 0.7, effort );
-
-    System< EncT > duffing0 = duffing( 2.75, 0.2
-    				       , -2, 2, -2, 2
-    				       , -0.25, 1, -0.5, 0.8, effort );
-
-    systems = {
-	       // logisticFalse
-	       // , logisticEasy
-	       // , logisticHard
-	       //, logisticCrazy
-	        henonFalse
-	       // , henonEasy
-	       // , henonHard
-	       //, henonCrazy
-	       // , tinkerbell1
-	       //, tinkerbell2
-	       // , duffing0
-    };
-    
+    const std::vector< CatalogueEntry > catalogue = systemCatalogue( effort );
+    for( const CatalogueEntry& entry : selectSystems( catalogue, { "henonFalse" } ) )
+	systems.push_back( entry.mSystem );
+
     const uint noSysConfigs = 4;
 
     // for( uint i = 0; i <= noSysConfigs; ++i )
@@ -250,22 +296,31 @@ int main()
 	applyTuple( [&] (auto ch) { printHead( std::cout, ch, 1 ); }, cexHs );
     std::cout << std::endl;
     
-    for( auto& system : systems )
+    // runs of each configuration of each system, in the order of the columns
+    JobRunner runner( noJobs, threadsPerJob );
+    std::vector< std::vector< std::vector< RunMetrics > > > runs( systems.size(), std::vector< std::vector< RunMetrics > >( noRefiners * noStateHs * noCexHs ) );
+    for( uint s = 0; s < systems.size(); ++s )
     {
-	std::cout << system.name();
-	Metrics mets;
-
+	uint c = 0;
 	applyTuple( [&] (auto ref) {
 		applyTuple( [&] (auto sh) {
 			applyTuple( [&] (auto ch) {
-					performWithConfig( system, reps, ref, sh, ch, limitTime, mets );
+				scheduleWithConfig( runner, systems[ s ], reps, ref, sh, ch, limitTime, runs[ s ][ c++ ] );
 			    }
 			    , cexHs );
 		    }
 		    , stateHs );
 	    }
 	    , refiners );
-	std::cout << mets;
     }
+    runner.run();
 
+    for( uint s = 0; s < systems.size(); ++s )
+    {
+	std::cout << systems[ s ].name();
+	Metrics mets;
+	for( const std::vector< RunMetrics >& configRuns : runs[ s ] )
+	    mergeInto( mets, configRuns );
+	std::cout << mets;
+    }
 }
@@ -0,0 +1,192 @@
+#ifndef AFFINE_IMAGE_HPP
+#define AFFINE_IMAGE_HPP
+
+#include "geometry/box.hpp"
+#include "numeric/logical.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+//! enclosures of images cached by a refinement tree: boxes only, or mean value forms in addition to boxes
+enum class ImageEnclosure : uint8_t { BOX, AFFINE };
+
+/*!
+  \class mean value form of the image of a box, f( x ) in f( c ) + J ( x - c ) for the centre c of the box and an enclosure J of the jacobian over it
+  for maps rotating or shearing boxes the form is a parallelotope far smaller than the box enclosing it, it is intersected with boxes by projecting both
+  onto the normals of the faces of the parallelotope in addition to intersecting the enclosing box
+  \note normals are computed in floating point, only the projections onto them are enclosed, so any normal keeps the intersection test sound
+*/
+class AffineImage
+{
+  public:
+    typedef Ariadne::Bounds< Ariadne::FloatDP > NumberT;
+
+    //! placeholder of nodes not caching a form
+    AffineImage() = default;
+
+    //! form without normals, consisting of the box image only
+    explicit AffineImage( const Ariadne::UpperBoxType& image ) : mBox( image ) {}
+
+    /*!
+      \param centreImage f( c ) by coordinates of the image
+      \param jacobian enclosure of the jacobian over the box by rows, one row for each coordinate of the image
+      \param offsets x - c over the box by coordinates of the box
+      \param image box enclosing the image, intersected with the bounding box of the form
+    */
+    AffineImage( const std::vector< NumberT >& centreImage, const std::vector< NumberT >& jacobian, const std::vector< NumberT >& offsets
+		 , const Ariadne::UpperBoxType& image )
+	: mBox( image )
+    {
+	const size_t n = offsets.size(), m = centreImage.size();
+	std::vector< double > unit( m, 0 );
+	for( size_t i = 0; i < m; ++i )
+	{
+	    unit[ i ] = 1;
+	    const NumberT p = project( unit, centreImage, jacobian, offsets );
+	    unit[ i ] = 0;
+	    mBox[ i ] = Ariadne::UpperIntervalType( p.lower().get_d() > mBox[ i ].lower().get_d() ? p.lower() : mBox[ i ].lower()
+						    , p.upper().get_d() < mBox[ i ].upper().get_d() ? p.upper() : mBox[ i ].upper() );
+	}
+	if( n != m )
+	    return;
+
+	// face normals of the parallelotope are the rows of the inverse of the midpoint jacobian
+	std::vector< double > normals;
+	if( !midpointInverse( jacobian, n, normals ) )
+	    return;
+	mNormals = normals;
+	mProjections.reserve( n );
+	for( size_t k = 0; k < n; ++k )
+	{
+	    const std::vector< double > normal( mNormals.begin() + k * n, mNormals.begin() + ( k + 1 ) * n );
+	    mProjections.push_back( project( normal, centreImage, jacobian, offsets ) );
+	}
+    }
+
+    size_t dimension() const { return mBox.dimension(); }
+
+    //! \return box enclosing the image, tightened by the form
+    const Ariadne::UpperBoxType& boundingBox() const { return mBox; }
+
+    //! \return number of face normals the form is projected onto, 0 if the jacobian is not square or close to singular
+    size_t normalCount() const { return mProjections.size(); }
+
+    //! \return false if the form is proven not to intersect bx, possibly true otherwise
+    template< typename BoxT >
+    Ariadne::ValidatedUpperKleenean intersects( const BoxT& bx ) const
+    {
+	Ariadne::ValidatedUpperKleenean boxesIntersect = !Ariadne::intersection( mBox, Ariadne::UpperBoxType( bx ) ).is_empty();
+	if( !possibly( boxesIntersect ) )
+	    return boxesIntersect;
+	const size_t n = bx.dimension();
+	for( size_t k = 0; k < mProjections.size(); ++k )
+	{
+	    NumberT p( 0 );
+	    for( size_t i = 0; i < n; ++i )
+		p = p + NumberT( mNormals[ k * n + i ] ) * NumberT( bx[ i ].lower(), bx[ i ].upper() );
+	    if( definitely( p.upper() < mProjections[ k ].lower() ) || definitely( mProjections[ k ].upper() < p.lower() ) )
+		return Ariadne::ValidatedUpperKleenean( false );
+	}
+	return boxesIntersect;
+    }
+
+    //! \return bytes allocated on the heap by the form
+    size_t heapBytes() const
+    {
+	return mBox.dimension() * sizeof( Ariadne::UpperIntervalType ) + mNormals.capacity() * sizeof( double )
+	    + mProjections.capacity() * sizeof( NumberT );
+    }
+
+  private:
+    //! \return enclosure of the projection of the form onto direction
+    static NumberT project( const std::vector< double >& direction, const std::vector< NumberT >& centreImage
+			    , const std::vector< NumberT >& jacobian, const std::vector< NumberT >& offsets )
+    {
+	const size_t n = offsets.size();
+	NumberT p( 0 );
+	for( size_t i = 0; i < centreImage.size(); ++i )
+	{
+	    if( direction[ i ] != 0 )
+		p = p + NumberT( direction[ i ] ) * centreImage[ i ];
+	}
+	// the dependency on each coordinate is kept by summing its column before multiplying by its offset
+	for( size_t j = 0; j < n; ++j )
+	{
+	    NumberT column( 0 );
+	    for( size_t i = 0; i < centreImage.size(); ++i )
+	    {
+		if( direction[ i ] != 0 )
+		    column = column + NumberT( direction[ i ] ) * jacobian[ i * n + j ];
+	    }
+	    p = p + column * offsets[ j ];
+	}
+	return p;
+    }
+
+    /*!
+      \brief inverts the midpoints of the square jacobian by gauss jordan elimination with partial pivoting
+      \return false if jacobian is close to singular or not finite, in which case inverse is left unspecified
+    */
+    static bool midpointInverse( const std::vector< NumberT >& jacobian, const size_t& n, std::vector< double >& inverse )
+    {
+	std::vector< double > a( n * n );
+	double scale = 0;
+	for( size_t e = 0; e < n * n; ++e )
+	{
+	    a[ e ] = jacobian[ e ].get_d();
+	    if( !std::isfinite( a[ e ] ) )
+		return false;
+	    scale = std::max( scale, std::abs( a[ e ] ) );
+	}
+	inverse.assign( n * n, 0 );
+	for( size_t i = 0; i < n; ++i )
+	    inverse[ i * n + i ] = 1;
+	for( size_t c = 0; c < n; ++c )
+	{
+	    size_t pivot = c;
+	    for( size_t r = c + 1; r < n; ++r )
+	    {
+		if( std::abs( a[ r * n + c ] ) > std::abs( a[ pivot * n + c ] ) )
+		    pivot = r;
+	    }
+	    if( !( std::abs( a[ pivot * n + c ] ) > SINGULAR_TOLERANCE * scale ) )
+		return false;
+	    for( size_t k = 0; k < n; ++k )
+	    {
+		std::swap( a[ c * n + k ], a[ pivot * n + k ] );
+		std::swap( inverse[ c * n + k ], inverse[ pivot * n + k ] );
+	    }
+	    const double p = a[ c * n + c ];
+	    for( size_t k = 0; k < n; ++k )
+	    {
+		a[ c * n + k ] /= p;
+		inverse[ c * n + k ] /= p;
+	    }
+	    for( size_t r = 0; r < n; ++r )
+	    {
+		const double factor = a[ r * n + c ];
+		if( r == c || factor == 0 )
+		    continue;
+		for( size_t k = 0; k < n; ++k )
+		{
+		    a[ r * n + k ] -= factor * a[ c * n + k ];
+		    inverse[ r * n + k ] -= factor * inverse[ c * n + k ];
+		}
+	    }
+	}
+	return true;
+    }
+
+    //! pivots smaller than this relative to the largest entry of the jacobian make it singular
+    static constexpr double SINGULAR_TOLERANCE = 1e-12;
+
+    Ariadne::UpperBoxType mBox;
+    // normals by rows and the enclosures of the projections of the form onto them
+    std::vector< double > mNormals;
+    std::vector< NumberT > mProjections;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "cegarObserver.hpp"
 #include "termination.hpp"
 #include "counterexampleStore.hpp"
+#include "incrementalSearch.hpp"
 #include "graphValuePrinter.hpp"
 
 #include "geometry/geometry.hpp"
@@ -19,6 +20,10 @@
 #include <unordered_set>
 #include <list>
 #include <functional>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <memory>
 
 #include <omp.h>
 
@@ -32,73 +37,204 @@ template< typename E >
 using VisitMap = std::map< typename RefinementTree< E >::NodeT, bool, typename RefinementTree< E >::NodeComparator >;
 
 
+/*!
+  \class buffers of findCounterexample kept between searches, so a search over an abstraction that did not grow allocates no buffers anew
+  \note buffers are used by one search at a time
+  \note counterexamples found are still copied into the counterexample store
+*/
+template< typename E >
+struct SearchBuffers
+{
+    typedef typename RefinementTree< E >::SnapshotT::IndexT IndexT;
+
+    //! \brief resets the predecessors of n nodes to no index and the frontiers of noThreads threads to empty, growing buffers if needed
+    void reset( const size_t& n, const size_t& noThreads )
+    {
+	if( n > mCapacity )
+	{
+	    mCapacity = std::max( n, 2 * mCapacity );
+	    mParents.reset( new std::atomic< IndexT >[ mCapacity ] );
+	}
+	for( size_t i = 0; i < n; ++i )
+	    mParents[ i ].store( RefinementTree< E >::SnapshotT::NO_INDEX, std::memory_order_relaxed );
+	mFrontier.clear();
+	if( mLocalFrontiers.size() < noThreads )
+	{
+	    mLocalFrontiers.resize( noThreads );
+	    mLocalUnsafe.resize( noThreads );
+	}
+	for( size_t t = 0; t < mLocalFrontiers.size(); ++t )
+	{
+	    mLocalFrontiers[ t ].clear();
+	    mLocalUnsafe[ t ].clear();
+	}
+    }
+
+    //! \return bytes allocated on the heap
+    size_t heapBytes() const
+    {
+	size_t bytes = mCapacity * sizeof( std::atomic< IndexT > ) + mFrontier.capacity() * sizeof( IndexT )
+	    + ( mLocalFrontiers.capacity() + mLocalUnsafe.capacity() ) * sizeof( std::vector< IndexT > );
+	for( size_t t = 0; t < mLocalFrontiers.size(); ++t )
+	    bytes += ( mLocalFrontiers[ t ].capacity() + mLocalUnsafe[ t ].capacity() ) * sizeof( IndexT );
+	return bytes + mCounterexample.capacity() * sizeof( typename RefinementTree< E >::NodeT );
+    }
+
+    // predecessor of each discovered node along its bfs path, initial nodes are their own predecessor
+    std::unique_ptr< std::atomic< IndexT >[] > mParents;
+    size_t mCapacity = 0;
+    std::vector< IndexT > mFrontier;
+    // per thread buffers of the current level, merged after each level
+    std::vector< std::vector< IndexT > > mLocalFrontiers, mLocalUnsafe;
+    // path of the counterexample rebuilt last, before handing it to the store
+    CounterexampleT< E > mCounterexample;
+};
+
 /*!
   runs BFS to find counterexample
   any path terminates in
   1) loop leading back to state along path
   2) state with violated safety conditions
   \param iImgBegin iterator to beginning of refinement tree nodes describing the image of the initial set, should dereference to RefinementTree< E >::NodeT
+  \param buffers reused by consecutive searches, their capacity is kept
   \return vector of nodes terminated by a possibly unsafe node
+  \note traverses the compact snapshot of the graph storing only the predecessor of each node, paths are rebuilt once found
   \todo add parameter to control ordering of branches in dfs exploration 
   \todo remember which nodes were already explored & safe: if encountered again, no need to check further as it leads to known result!
 */
 template< typename E, typename IterT, typename SH, typename CH >
 void findCounterexample( const RefinementTree< E >& rtree
 			 , const IterT& beginInitial, const IterT& endInitial
-			 , CounterexampleStore< E, SH, CH >& cstore )
+			 , CounterexampleStore< E, SH, CH >& cstore
+			 , SearchBuffers< E >& buffers )
 {
-    std::vector< CounterexampleT< E > > paths, newPaths;
-    NodeSet< E > visited( beginInitial, endInitial, graph::size( rtree.graph() ), NodeHash( rtree ), NodeEqual( rtree ) );
-    std::transform( beginInitial, endInitial, std::back_inserter( paths )
-		    , [] (auto& n) { return CounterexampleT< E >( {n} ); } );
+    CEGAR_PROFILE_SCOPE( SEARCH );
+    typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+    typedef typename SnapshotT::IndexT IndexT;
+
+    const SnapshotT& snap = rtree.snapshot();
+    cstore.updateScoreBound( rtree );
+    // nodes are claimed by the thread that first swaps in a predecessor
+    buffers.reset( snap.size(), omp_get_max_threads() );
+    std::atomic< IndexT >* const parents = buffers.mParents.get();
+    std::vector< IndexT >& frontier = buffers.mFrontier;
+    for( IterT iInitial = beginInitial; iInitial != endInitial; ++iInitial )
+    {
+	IndexT i = snap.index( graph::value( rtree.graph(), *iInitial ) );
+	if( parents[ i ].load( std::memory_order_relaxed ) != SnapshotT::NO_INDEX )
+	    continue;
+	parents[ i ].store( i, std::memory_order_relaxed );
+	frontier.push_back( i );
+    }
 
-    while( !paths.empty() && !cstore.terminateSearch() )
+    std::vector< std::vector< IndexT > >& localFrontiers = buffers.mLocalFrontiers;
+    std::vector< std::vector< IndexT > >& localUnsafe = buffers.mLocalUnsafe;
+    CounterexampleT< E >& cex = buffers.mCounterexample;
+    while( !frontier.empty() && !cstore.terminateSearch() )
     {
-#pragma omp parallel for
-	for( uint np = 0; np < paths.size(); ++np )
+#pragma omp parallel
 	{
-	    auto& boundaryNode = paths[ np ].back();
-
-	    // std::cout << "exploreing counterexample of length " << ip->size() << std::endl;
-	    // std::cout << "boundary " << GraphValuePrinter< E >( *graph::value( rtree.graph(), boundaryNode ), false, true, true, true ) << std::endl;
-	    
-	    if( possibly( !rtree.isSafe( boundaryNode ) ) )
-	    {
-#pragma omp critical
-		cstore.found( rtree, paths[ np ].begin(), paths[ np ].end() );
-	    }
-	    else if( possibly( !rtree.isTransSafe( boundaryNode ) ) )
+	    std::vector< IndexT >& newFrontier = localFrontiers[ omp_get_thread_num() ];
+	    std::vector< IndexT >& unsafe = localUnsafe[ omp_get_thread_num() ];
+#pragma omp for schedule( dynamic, 64 )
+	    for( uint nf = 0; nf < frontier.size(); ++nf )
 	    {
-		auto img = rtree.postimage( boundaryNode );
-		for( auto iImg = img.begin(); iImg != img.end(); ++iImg ) // try not to copy last path expanded
+		const IndexT boundary = frontier[ nf ];
+
+		if( possibly( !snap.isSafe( boundary ) ) )
+		    unsafe.push_back( boundary );
+		else if( possibly( !snap.isTransSafe( boundary ) ) )
 		{
-		    if( visited.find( *iImg ) == visited.end() )
+		    for( auto outs = graph::outEdges( snap.graph(), boundary ); outs.first != outs.second; ++outs.first )
 		    {
-			CounterexampleT< E > copy( paths[ np ].begin(), paths[ np ].end() );
-			copy.push_back( *iImg );
-#pragma omp critical
-			newPaths.push_back( copy );
+			const IndexT img = graph::target( snap.graph(), *outs.first );
+			IndexT expected = SnapshotT::NO_INDEX;
+			if( parents[ img ].load( std::memory_order_relaxed ) == SnapshotT::NO_INDEX
+			    && parents[ img ].compare_exchange_strong( expected, boundary, std::memory_order_relaxed ) )
+			    newFrontier.push_back( img );
 		    }
-#pragma omp critical		
-		    visited.insert( *iImg );
 		}
 	    }
 	}
-	paths = std::move( newPaths );
-	newPaths.clear();
+
+	// predecessors written during the level are visible after the implicit barrier
+	frontier.clear();
+	for( uint t = 0; t < localFrontiers.size(); ++t )
+	{
+	    for( const IndexT& boundary : localUnsafe[ t ] )
+	    {
+		cex.clear();
+		IndexT i = boundary;
+		for( ; parents[ i ].load( std::memory_order_relaxed ) != i; i = parents[ i ].load( std::memory_order_relaxed ) )
+		    cex.push_back( snap.node( i ) );
+		cex.push_back( snap.node( i ) );
+		std::reverse( cex.begin(), cex.end() );
+		cstore.found( rtree, cex.begin(), cex.end() );
+	    }
+	    localUnsafe[ t ].clear();
+	    frontier.insert( frontier.end(), localFrontiers[ t ].begin(), localFrontiers[ t ].end() );
+	    localFrontiers[ t ].clear();
+	}
     }
     cstore.outOfCounterexamples();
-    // std::cout << "returning" << std::endl;
 }
 
+//! \brief overload of findCounterexample using buffers of its own
+template< typename E, typename IterT, typename SH, typename CH >
+void findCounterexample( const RefinementTree< E >& rtree
+			 , const IterT& beginInitial, const IterT& endInitial
+			 , CounterexampleStore< E, SH, CH >& cstore )
+{
+    SearchBuffers< E > buffers;
+    findCounterexample( rtree, beginInitial, endInitial, cstore, buffers );
+}
+
+/*!
+  \class search strategy of cegarLoop running findCounterexample from scratch on the snapshot in each search, in parallel over the levels of the bfs
+  its buffers are kept between searches
+*/
+template< typename E >
+class FullSearch
+{
+  public:
+    typedef typename RefinementTree< E >::NodeT NodeT;
+
+    //! \brief nothing to drop, each search starts from scratch
+    void invalidate( const RefinementTree< E >& rtree, const NodeT& n ) {}
+
+    //! \brief reports counterexamples reachable from the initial nodes to cstore
+    template< typename IterT, typename SH, typename CH >
+    void find( const RefinementTree< E >& rtree, const IterT& beginInitial, const IterT& endInitial, CounterexampleStore< E, SH, CH >& cstore )
+    {
+	findCounterexample( rtree, beginInitial, endInitial, cstore, mBuffers );
+    }
+
+  private:
+    SearchBuffers< E > mBuffers;
+};
+
+//! searches for counterexamples run by the cegar drivers: repairing the exploration of the previous search, or from scratch in parallel
+enum class SearchStrategy : uint8_t { INCREMENTAL, FULL };
+
+//! \class options of the cegar drivers, the defaults are used by the overloads not taking options
+struct CegarOptions
+{
+    SearchStrategy mSearch = SearchStrategy::INCREMENTAL;
+    // number of counterexamples obtained at once and checked for spuriousness concurrently, see cegarLoop
+    uint mCheckBatch = 1;
+    // grid cells along each dimension of the first state of a counterexample whose trajectories are simulated besides its centre, see concretizationPoints
+    uint mDivisions = 0;
+};
+
 /*! 
   \param ibegin iterator over sequence of refinement tree nodes
+  \param eval callable taking the validated kleenean whether a node contains pt and returning bool
   \return iterator to node pt lies in, according to eval
 */
-template< typename E, typename NumberT, typename NodeIterT >
+template< typename E, typename NumberT, typename NodeIterT, typename EvalT >
 NodeIterT findContaining( const RefinementTree< E >& rtree, const Ariadne::Point< NumberT > pt
 			  , NodeIterT ibegin, const NodeIterT& iend
-			  , const std::function< bool( const Ariadne::ValidatedKleenean& ) >& eval )
+			  , const EvalT& eval )
 {
     // center is not contained in initial image
     return std::find_if( ibegin, iend
@@ -111,6 +247,23 @@ NodeIterT findContaining( const RefinementTree< E >& rtree, const Ariadne::Point
 			 } );
 }
 
+/*!
+  \return leaf pt lies in according to eval, located through the split hierarchy of rtree instead of scanning nodes
+  \param eval applied to whether the enclosure of a leaf possibly containing pt contains it
+*/
+template< typename E, typename EvalT >
+std::optional< typename RefinementTree< E >::NodeT > findContaining( const RefinementTree< E >& rtree, const Ariadne::ValidatedPoint& pt
+								     , const EvalT& eval )
+{
+    for( const typename RefinementTree< E >::NodeT& n : rtree.containing( pt ) )
+    {
+	auto val = rtree.nodeValue( n );
+	if( val && eval( val.value().get().getEnclosure().contains( pt ) ) )
+	    return n;
+    }
+    return std::nullopt;
+}
+
 template< typename F >
 Ariadne::ExactBoxType boundsPoint2Box( const Ariadne::Point< Ariadne::Bounds< F > >& pt )
 {
@@ -130,21 +283,77 @@ Ariadne::ExactBoxType exactPoint2Box( const Ariadne::ExactPoint& pt )
     return Ariadne::Box( Ariadne::Vector( intervals ) );
 }
 
+/*!
+  \brief points a counterexample is concretized from: the centre of bx and, unless divisions is 0, the centres of the cells of a grid with divisions cells along each dimension and the corners of bx
+  \return points ordered from the centre outwards, corners possibly lie in neighbouring states as well
+  \note for divisions > 0 there are 1 + divisions^d - divisions % 2 + 2^d points in dimension d, e.g. 2 * 2^d + 1 for divisions 2, each costing a simulated trajectory
+*/
+template< typename IntervalT >
+std::vector< Ariadne::ValidatedPoint > concretizationPoints( const Ariadne::Box< IntervalT >& bx, const uint& divisions )
+{
+    const size_t dim = bx.dimension();
+    std::vector< Ariadne::ValidatedPoint > pts = { bx.centre() };
+    if( divisions == 0 )
+	return pts;
+    std::vector< double > lower( dim ), width( dim );
+    for( size_t d = 0; d < dim; ++d )
+    {
+	lower[ d ] = bx[ d ].lower().get_d();
+	width[ d ] = bx[ d ].upper().get_d() - lower[ d ];
+    }
+
+    // points are exact doubles stored as degenerate boxes
+    Ariadne::Array< Ariadne::ExactIntervalType > intervals( dim );
+    auto addPoint = [&] (const std::vector< double >& x) {
+			for( size_t d = 0; d < dim; ++d )
+			    intervals[ d ] = Ariadne::ExactIntervalType( x[ d ], x[ d ] );
+			pts.push_back( Ariadne::ExactBoxType( Ariadne::Vector( intervals ) ).centre() );
+		    };
+
+    // cells are enumerated as mixed radix numbers, the central cell of an odd grid is the centre already added
+    std::vector< uint > cell( dim, 0 );
+    std::vector< double > x( dim );
+    for( bool more = divisions > 1; more; )
+    {
+	bool central = true;
+	for( size_t d = 0; d < dim; ++d )
+	{
+	    x[ d ] = lower[ d ] + ( cell[ d ] + 0.5 ) * width[ d ] / divisions;
+	    central = central && 2 * cell[ d ] + 1 == divisions;
+	}
+	if( !central )
+	    addPoint( x );
+	size_t d = 0;
+	for( ; d < dim && ++cell[ d ] == divisions; ++d )
+	    cell[ d ] = 0;
+	more = d < dim;
+    }
+
+    for( size_t corner = 0; corner < ( size_t( 1 ) << dim ); ++corner )
+    {
+	for( size_t d = 0; d < dim; ++d )
+	    x[ d ] = lower[ d ] + ( ( corner >> d ) & 1 ) * width[ d ];
+	addPoint( x );
+    }
+    return pts;
+}
+
 // implement this using lower kleenean?
 /*! 
   \param beginCounter and endCounter iterators to beginning and end of counterexample trajectory, should dereference to typename RefinementTree< E >::NodeT
-  \param beginImage and endImage iterators to beginning and end of image of initial set obtained from refinement tree, should dereference to typename RefinementTree< E >::NodeT as well
+  \param divisions number of grid cells along each dimension of the first state whose centres are tested, see concretizationPoints, 0 tests the centre only
   \return false if there definitely exists a point that is mapped to the terminal state of the counterexample, indeterminate otherwise, including if there does not possibly exist such a point 
   why upper kleenean?
   if return false, know for sure that counterexample is not spurious because a point exist with trajectory leading to unsafe state
-  if return true center point did not map along trajectory
+  if return true no point tested mapped along trajectory
   \todo allow divergence from supposed counterexample, i.e. follow trajectory of center point until loop
 */
 template< typename E, typename PathIterT >
 Ariadne::ValidatedUpperKleenean isSpurious( const RefinementTree< E >& rtree
 					    , PathIterT beginCounter, PathIterT endCounter
 					    , const Ariadne::BoundedConstraintSet& initialSet
-					    , const Ariadne::Effort& effort )
+					    , const Ariadne::Effort& effort
+					    , const uint& divisions = 0 )
 {
     typedef RefinementTree< E > Rtree;
     
@@ -161,9 +370,6 @@ Ariadne::ValidatedUpperKleenean isSpurious( const RefinementTree< E >& rtree
 	return true;
     }
 
-    // find correct typedef to work with
-    Ariadne::Point< Ariadne::Bounds< Ariadne::FloatDP > > currPoint = oBeginCex.value().get().getEnclosure().centre();
-
     // std::function< bool( const typename Rtree::NodeT& ) > contains2 = [&currPoint, &rtree] (auto& n) {
     // 	std::function< Ariadne::ValidatedLowerKleenean( const typename Rtree::EnclosureT&, const Ariadne::Point< Ariadne::Bounds< Ariadne::FloatDP > >& ) > contains =
     // 	  [] (auto& enc, auto& pt ) { return enc.contains( pt ); };
@@ -171,31 +377,38 @@ Ariadne::ValidatedUpperKleenean isSpurious( const RefinementTree< E >& rtree
     // if( std::none_of( beginImage, endImage, contains2 ) )
     // 	return true;
 
-    Ariadne::ExactBoxType pointAsExactBox = boundsPoint2Box( currPoint );
-    if( possibly( !initialSet.covers( pointAsExactBox ) ) )
-	return true;
-    
-    //map forward
+    //map forward, true if currPoint possibly follows the whole counterexample
     const typename Rtree::EnclosureT& rtEnc = rtree.initialEnclosure();
-    for( PathIterT nextCounter = beginCounter + 1; nextCounter != endCounter; beginCounter = nextCounter++ )
-    {
-	auto oNext = rtree.nodeValue( *nextCounter );
-	Ariadne::Point< Ariadne::Bounds< Ariadne::FloatDP > > mappedPoint = rtree.dynamics().evaluate( currPoint );
-	Ariadne::ValidatedKleenean containsMapped;
-
-	if( oNext )
-	    containsMapped = oNext.value().get().getEnclosure().contains( mappedPoint );
-	else
-	    containsMapped = !rtEnc.contains( mappedPoint );
-	if( definitely( !containsMapped ) )
-	    return true; // should be indeterminate
-	currPoint = mappedPoint;
-    }
-    return false;
+    auto followsCounterexample = [&] (Ariadne::Point< Ariadne::Bounds< Ariadne::FloatDP > > currPoint) {
+				     Ariadne::ExactBoxType pointAsExactBox = boundsPoint2Box( currPoint );
+				     if( possibly( !initialSet.covers( pointAsExactBox ) ) )
+					 return false;
+				     for( PathIterT nextCounter = beginCounter + 1; nextCounter != endCounter; ++nextCounter )
+				     {
+					 auto oNext = rtree.nodeValue( *nextCounter );
+					 Ariadne::Point< Ariadne::Bounds< Ariadne::FloatDP > > mappedPoint = rtree.compiledDynamics().evaluate( currPoint );
+					 Ariadne::ValidatedKleenean containsMapped;
+
+					 if( oNext )
+					     containsMapped = oNext.value().get().getEnclosure().contains( mappedPoint );
+					 else
+					     containsMapped = !rtEnc.contains( mappedPoint );
+					 if( definitely( !containsMapped ) )
+					     return false;
+					 currPoint = mappedPoint;
+				     }
+				     return true;
+				 };
+
+    const std::vector< Ariadne::ValidatedPoint > pts = concretizationPoints( oBeginCex.value().get().getEnclosure(), divisions );
+    if( std::any_of( pts.begin(), pts.end(), followsCounterexample ) )
+	return false;
+    return true; // should be indeterminate
 }
 
 /*!
   \brief test whether pt begins a trajectory inside sn that begins within the initial set and eventually leafes the safe set.
+  \param visited set of states visited by the trajectory, cleared before use so that it can be shared by subsequent calls
   \return true if pt certainly maps to unsafe state. false if abstract path corresponding to the trajectory of pt contains a loop before reaching an unsafe state
 */
 template< typename E >
@@ -203,7 +416,8 @@ Ariadne::ValidatedUpperKleenean safeTrajectory( const RefinementTree< E >& rtree
 						, const typename RefinementTree< E >::NodeT& sn
 						, const Ariadne::ValidatedPoint& pt
 						, const Ariadne::BoundedConstraintSet& initialSet
-						, const Ariadne::Effort& effort )
+						, const Ariadne::Effort& effort
+						, typename RefinementTree< E >::VisitSetT& visited )
 {
     typedef RefinementTree< E > R;
 
@@ -218,27 +432,145 @@ Ariadne::ValidatedUpperKleenean safeTrajectory( const RefinementTree< E >& rtree
 			return !rtree.initialEnclosure().contains( pt );
 		    };
     
-    typename R::NodeComparator ncomp( rtree );
-    std::set< typename R::NodeT, typename R::NodeComparator > visited( ncomp );
+    visited.clear();
     auto cs = sn;
     Ariadne::ValidatedPoint ptm = pt;
-    while( visited.find( cs ) == visited.end() &&
+    while( !visited.contains( cs ) &&
     	   possibly( rtree.isSafe( cs ) ) &&
     	   possibly( ptInNode( ptm, cs ) ) ) // last clause: catch pt not in sn
     {
     	visited.insert( cs );
-    	ptm = rtree.dynamics().evaluate( ptm );
-    	auto img = rtree.postimage( cs ); 
-    	auto iIn = std::find_if( img.begin(), img.end(), [&ptInNode, &ptm] (auto& n) { return possibly( ptInNode( ptm, n ) ); } );
-
-    	if( iIn == img.end() )
+    	ptm = rtree.compiledDynamics().evaluate( ptm );
+	// locate the mapped point in the leaf index rather than scanning the postimage of cs
+	const std::vector< typename R::NodeT > in = rtree.containing( ptm );
+    	if( in.empty() )
     	    throw std::logic_error( "mapped point needs to map to one abstract state in abstract image" );
-    	cs = *iIn;
+    	cs = in.front();
     }
 
     return possibly( rtree.isSafe( cs ) );
 }
 
+//! \brief overload of safeTrajectory using a visit set of its own
+template< typename E >
+Ariadne::ValidatedUpperKleenean safeTrajectory( const RefinementTree< E >& rtree
+						, const typename RefinementTree< E >::NodeT& sn
+						, const Ariadne::ValidatedPoint& pt
+						, const Ariadne::BoundedConstraintSet& initialSet
+						, const Ariadne::Effort& effort )
+{
+    typename RefinementTree< E >::VisitSetT visited = rtree.visitSet();
+    return safeTrajectory( rtree, sn, pt, initialSet, effort, visited );
+}
+
+
+/*!
+  \brief checks whether the trajectories of points sampled from the first state of cex stay safe
+  \param divisions number of grid cells along each dimension of the first state whose centres are tested, see concretizationPoints, 0 tests the centre only
+  \return false if cex certainly begins an unsafe trajectory, including counterexamples starting outside
+  \note stops at the first point with a trajectory certainly leaving the safe set, so safe counterexamples cost a trajectory for every point tested
+  \note only reads the tree, so counterexamples can be checked concurrently
+*/
+template< typename E >
+Ariadne::ValidatedUpperKleenean isCounterexampleSafe( const RefinementTree< E >& rtree, const CounterexampleT< E >& cex
+						      , const Ariadne::BoundedConstraintSet& initialSet, const Ariadne::Effort& effort
+						      , const uint& divisions = 0 )
+{
+    CEGAR_PROFILE_SCOPE( CHECK );
+    auto cexBeginVal = rtree.nodeValue( cex.front() );
+    if( !cexBeginVal )
+	return false;
+
+    // points separated from the initial set are dropped by an exact test before their trajectory is evaluated
+    typename RefinementTree< E >::VisitSetT visited = rtree.visitSet();
+    for( const Ariadne::ValidatedPoint& pt : concretizationPoints( cexBeginVal.value().get().getEnclosure(), divisions ) )
+    {
+	if( definitely( !safeTrajectory( rtree, cex.front(), pt, initialSet, effort, visited ) ) )
+	    return false;
+    }
+    return true;
+}
+
+/*!
+  \class nodes of a refinement tree possibly intersecting the initial set, kept up to date through refinements
+  nodes inside the initial set are remembered, their refinements are inside it as well and are added without checks
+*/
+template< typename E >
+class InitialImage
+{
+  public:
+    typedef RefinementTree< E > Rtree;
+    typedef typename NodeSet< E >::const_iterator const_iterator;
+
+    //! relation of a node to the initial set, recorded when it is removed for refinement
+    enum class Relation : uint8_t { OUTSIDE, OVERLAPS, INSIDE };
+
+    InitialImage( const Rtree& rtree, const Ariadne::BoundedConstraintSet& initialSet, const Ariadne::Effort& effort )
+	: mRtree( rtree )
+	, mInitialSet( initialSet )
+	, mEffort( effort )
+	, mNodes( 0, NodeHash( rtree ), NodeEqual( rtree ) )
+	, mInterior( 0, NodeHash( rtree ), NodeEqual( rtree ) )
+    {
+	auto interPred = [effort] (const typename Rtree::EnclosureT& enc, const Ariadne::BoundedConstraintSet& cset) {
+	    return !(cset.separated( enc ).check( effort ) ); };
+	const std::vector< typename Rtree::NodeT > img = rtree.intersection( initialSet, interPred );
+	// the image grows as its nodes are refined, reserving ahead saves rehashing during the first refinements
+	mNodes.reserve( 2 * img.size() );
+	for( auto& n : img )
+	{
+	    mNodes.insert( n );
+	    if( isInside( n ) )
+		mInterior.insert( n );
+	}
+    }
+
+    const_iterator begin() const { return mNodes.begin(); }
+
+    const_iterator end() const { return mNodes.end(); }
+
+    size_t size() const { return mNodes.size(); }
+
+    //! \brief removes n, to be called before n is refined \return relation of n to the initial set
+    Relation remove( const typename Rtree::NodeT& n )
+    {
+	if( mInterior.erase( n ) > 0 )
+	{
+	    mNodes.erase( n );
+	    return Relation::INSIDE;
+	}
+	return mNodes.erase( n ) > 0 ? Relation::OVERLAPS : Relation::OUTSIDE;
+    }
+
+    //! \brief adds the refinements [begin, end) of a node removed with relation r that possibly intersect the initial set
+    template< typename IterT >
+    void add( const Relation& r, IterT begin, const IterT& end )
+    {
+	for( ; begin != end && r != Relation::OUTSIDE; ++begin )
+	{
+	    if( r == Relation::INSIDE )
+		mInterior.insert( *begin );
+	    else if( !possibly( mRtree.overlapsConstraints( mInitialSet, *begin ) ) )
+		continue;
+	    else if( isInside( *begin ) )
+		mInterior.insert( *begin );
+	    mNodes.insert( *begin );
+	}
+    }
+
+  private:
+    bool isInside( const typename Rtree::NodeT& n ) const
+    {
+	auto nval = mRtree.nodeValue( n );
+	return nval && definitely( mInitialSet.covers( nval.value().get().getEnclosure() ).check( mEffort ) );
+    }
+
+    const Rtree& mRtree;
+    const Ariadne::BoundedConstraintSet& mInitialSet;
+    Ariadne::Effort mEffort;
+    NodeSet< E > mNodes;
+    NodeSet< E > mInterior;
+};
 
 // can only prove that there exists a true counterexample -> system is unsafe
 /*
@@ -248,34 +580,33 @@ Ariadne::ValidatedUpperKleenean safeTrajectory( const RefinementTree< E >& rtree
   (2) is subcase of (1)
 */
 /*!
-  \param rtree refinement tree to work on
-  \param initialBegin begin of range of set of boxes describing the initial state
-  \param effort effort to use for calculations
-  \param refinementStrat strategy to use for refining individual box
-  \param maxNodes number of nodes in tree after which to stop iterations
-  \return pair of kleenean describing safety and sequence of nodes that forms a trajectory starting from the initial set
+  \brief refinement loop shared by cegar and batchCegar
+  \param pick called as pick( rtree, counterexample ) for a counterexample obtained from the store, returns NodeRefVec of nodes to refine
+  \param counters store collecting the counterexamples of each search, e.g. bounded to the highest scoring ones
+  \param search strategy finding the counterexamples of each search, e.g. IncrementalSearch or FullSearch, told of each node before it is refined
+  \param checkBatch number of counterexamples obtained at once and checked for spuriousness concurrently, at least 1
+  \param divisions passed to isCounterexampleSafe, 0 checks the trajectory of the centre of the first state of each counterexample only
+  \note checks of counterexamples containing nodes refined for an earlier one of the same batch are dropped, they are found again if still present,
+  observers see processCounterexample, checkSpurious and spurious for each counterexample whose check is used and none for dropped ones
 */
-template< typename E, typename RefinementT, typename SH, typename CH, typename TermT, typename ... ObserversT >
-std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegar( RefinementTree< E >& rtree
-								     , const Ariadne::BoundedConstraintSet& initialSet
-								     , const Ariadne::Effort& effort
-								     , RefinementT refinement
-								     , const SH& stateH
-								     , const CH& counterexampleH
-								     , TermT termination
-								     , ObserversT& ... observers )
+template< typename E, typename RefinementT, typename PickT, typename SH, typename CH, typename SearchT, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegarLoop( RefinementTree< E >& rtree
+									 , const Ariadne::BoundedConstraintSet& initialSet
+									 , const Ariadne::Effort& effort
+									 , RefinementT& refinement
+									 , PickT& pick
+									 , CounterexampleStore< E, SH, CH >& counters
+									 , SearchT& search
+									 , const uint& checkBatch
+									 , const uint& divisions
+									 , TermT& termination
+									 , ObserversT& ... observers )
 {
     typedef RefinementTree< E > Rtree;
+    if( checkBatch == 0 )
+	throw std::logic_error( "cegar needs to check at least one counterexample at once" );
 
-    std::function< Ariadne::ValidatedUpperKleenean( const typename Rtree::EnclosureT&, const Ariadne::BoundedConstraintSet& ) > interPred =
-	[effort] (auto& enc, auto& cset) {return !(cset.separated( enc ).check( effort ) ); };
-    
-    NodeSet< E > initialImage = NodeSet< E >( 0, NodeHash( rtree ), NodeEqual( rtree ) );
-    {
-	auto img = rtree.intersection( initialSet, interPred );
-	initialImage.insert( img.begin(), img.end() );
-    }
-    CounterexampleStore< E, SH, CH > counters( stateH, counterexampleH );
+    InitialImage< E > initialImage( rtree, initialSet, effort );
 
     (callInitialized(observers, rtree), ...);
 
@@ -287,7 +618,7 @@ std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegar( RefinementT
 	(callStartIteration( observers, rtree ), ... );
 	(callSearchCounterexample(observers, rtree, initialImage.begin(), initialImage.end() ), ... );
 
-	findCounterexample( rtree, initialImage.begin(), initialImage.end(), counters );
+	search.find( rtree, initialImage.begin(), initialImage.end(), counters );
 
 	(callSearchTerminated( observers, rtree ), ... );
 	
@@ -299,59 +630,214 @@ std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegar( RefinementT
 
 	while( counters.hasCounterexample() && !terminate )
 	{
-	    auto counterexample = counters.obtain();
-	    (callProcessCounterexample( observers, rtree, counterexample.first.begin(), counterexample.first.end() ), ... );
-	    
-	    (callCheckSpurious( observers, rtree, counterexample.first.begin(), counterexample.first.end() ), ... );
-	
-	    auto cexBeginVal = rtree.nodeValue( counterexample.first.front() );
-	    Ariadne::ValidatedUpperKleenean safe = false;
-	    if( cexBeginVal )
+	    // check the best counterexamples concurrently while the tree is not modified
+	    std::vector< std::pair< CounterexampleT< E >, typename Rtree::NodeT > > batch;
+	    // indices are taken before refining, as values of refined nodes are reused by their refinements
+	    std::vector< std::vector< size_t > > batchIndices;
+	    while( batch.size() < checkBatch && counters.hasCounterexample() )
 	    {
-		Ariadne::Point< Ariadne::ValidatedNumericType > cen = cexBeginVal.value().get().getEnclosure().centre();
-		safe = safeTrajectory( rtree, counterexample.first.front()
-					 , cexBeginVal.value().get().getEnclosure().centre()
-					 , initialSet, effort );
+		batch.push_back( counters.obtain() );
+		batchIndices.emplace_back();
+		for( auto& n : batch.back().first )
+		    batchIndices.back().push_back( graph::value( rtree.graph(), n )->index() );
 	    }
-
-	    if( definitely( !safe ) )
+	    // each counterexample checked gets its hooks in order, the first is never dropped so its hooks enclose the concurrent checks
+	    (callProcessCounterexample( observers, rtree, batch.front().first.begin(), batch.front().first.end() ), ... );
+	    (callCheckSpurious( observers, rtree, batch.front().first.begin(), batch.front().first.end() ), ... );
+	    const int noBatch = batch.size();
+	    std::vector< Ariadne::ValidatedUpperKleenean > safeties( noBatch, false );
+#pragma omp parallel for schedule( dynamic ) if( noBatch > 1 )
+	    for( int c = 0; c < noBatch; ++c )
+		safeties[ c ] = isCounterexampleSafe( rtree, batch[ c ].first, initialSet, effort, divisions );
+
+	    // refinements of earlier counterexamples invalidate later ones containing refined nodes, their results are dropped
+	    typename Rtree::VisitSetT refinedInBatch = rtree.visitSet();
+	    for( int c = 0; c < noBatch && !terminate; ++c )
 	    {
-		(callFinished( observers, rtree, Ariadne::ValidatedKleenean( false ) ), ... );
-		return std::make_pair( Ariadne::ValidatedKleenean( false ), counterexample.first );
-	    }
+		auto& counterexample = batch[ c ];
+		if( std::any_of( batchIndices[ c ].begin(), batchIndices[ c ].end(), [&refinedInBatch] (const size_t& i) { return refinedInBatch.containsIndex( i ); } ) )
+		    continue;
+		if( c > 0 )
+		{
+		    (callProcessCounterexample( observers, rtree, counterexample.first.begin(), counterexample.first.end() ), ... );
+		    (callCheckSpurious( observers, rtree, counterexample.first.begin(), counterexample.first.end() ), ... );
+		}
+		(callSpurious( observers, rtree, counterexample.first.begin(), counterexample.first.end(), safeties[ c ] ), ... );
 
-	    // \todo get rid of vector
-	    std::vector< std::reference_wrapper< typename Rtree::NodeT > > nodesToRefine = { counterexample.second };
+		if( definitely( !safeties[ c ] ) )
+		{
+		    (callFinished( observers, rtree, Ariadne::ValidatedKleenean( false ) ), ... );
+		    return std::make_pair( Ariadne::ValidatedKleenean( false ), counterexample.first );
+		}
 
-	    for( const typename Rtree::NodeT& refine : nodesToRefine )
-	    {
-		if( rtree.nodeValue( refine ) && possibly( rtree.isSafe( refine ) ) )
+		NodeRefVec< Rtree > nodesToRefine = pick( rtree, counterexample );
+
+		// copy distinct refinable nodes, as refinement invalidates the counterexample
+		std::vector< typename Rtree::NodeT > refinable;
+		std::vector< typename InitialImage< E >::Relation > relations;
+		for( const typename Rtree::NodeT& refine : nodesToRefine )
 		{
-		    auto iRefined = initialImage.find( refine );
+		    if( !rtree.nodeValue( refine ) || !possibly( rtree.isSafe( refine ) )
+			|| std::any_of( refinable.begin(), refinable.end(), [&] (auto& n) { return rtree.equal( n, refine ); } ) )
+			continue;
 
 		    (callStartRefinement( observers, rtree, refine ), ... );
 
 		    counters.invalidate( rtree, refine );
-		    auto refinedNodes = rtree.refine( refine, refinement );
-		    
-		    (callRefined( observers, rtree, refinedNodes.begin(), refinedNodes.end() ), ... );
-	 
-		    if( iRefined != initialImage.end() )
-		    {
-			initialImage.erase( iRefined );
-			for( auto& nrefd : refinedNodes )
-			{
-			    if( possibly( rtree.overlapsConstraints( initialSet, nrefd ) ) )
-				initialImage.insert( nrefd );
-			}
-		    }
+		    search.invalidate( rtree, refine );
+		    refinable.push_back( refine );
+		    refinedInBatch.insertIndex( graph::value( rtree.graph(), refine )->index() );
+		    relations.push_back( initialImage.remove( refine ) );
 		}
+
+		auto refinedNodes = rtree.refine( refinable.begin(), refinable.end(), refinement );
+
+		for( uint i = 0; i < refinedNodes.size(); ++i )
+		{
+		    (callRefined( observers, rtree, refinedNodes[ i ].begin(), refinedNodes[ i ].end() ), ... );
+
+		    initialImage.add( relations[ i ], refinedNodes[ i ].begin(), refinedNodes[ i ].end() );
+		}
+		terminate = termination( rtree ); // check in each inner loop for quick response
 	    }
-	    terminate = termination( rtree ); // check in each inner loop for quick response
 	}
     }
     (callFinished( observers, rtree, Ariadne::ValidatedKleenean( Ariadne::indeterminate ) ), ... );
     return make_pair( Ariadne::ValidatedKleenean( Ariadne::indeterminate ), std::vector< typename Rtree::NodeT >() );
 }
 
+//! \brief calls loop( search ) with the search strategy selected by options
+template< typename E, typename LoopT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > withSearch( const CegarOptions& options, const LoopT& loop )
+{
+    if( options.mSearch == SearchStrategy::FULL )
+    {
+	FullSearch< E > search;
+	return loop( search );
+    }
+    IncrementalSearch< E > search; // keeps exploration of nodes not refined between iterations
+    return loop( search );
+}
+
+/*!
+  \param rtree refinement tree to work on
+  \param initialBegin begin of range of set of boxes describing the initial state
+  \param effort effort to use for calculations
+  \param refinementStrat strategy to use for refining individual box
+  \param maxNodes number of nodes in tree after which to stop iterations
+  \param options search strategy run in each iteration, number of counterexamples checked concurrently and points each is checked from, overloads without options use the defaults
+  \return pair of kleenean describing safety and sequence of nodes that forms a trajectory starting from the initial set
+*/
+template< typename E, typename RefinementT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegar( RefinementTree< E >& rtree
+								     , const Ariadne::BoundedConstraintSet& initialSet
+								     , const Ariadne::Effort& effort
+								     , RefinementT refinement
+								     , const SH& stateH
+								     , const CH& counterexampleH
+								     , TermT termination
+								     , CegarOptions options
+								     , ObserversT& ... observers )
+{
+    // refine the state preferred by the state heuristic
+    auto pick = [] (const RefinementTree< E >& rtree, auto& counterexample) {
+	return NodeRefVec< RefinementTree< E > >( { std::ref( counterexample.second ) } ); };
+    CounterexampleStore< E, SH, CH > counters( stateH, counterexampleH );
+    return withSearch< E >( options, [&] (auto& search) {
+	return cegarLoop( rtree, initialSet, effort, refinement, pick, counters, search, options.mCheckBatch, options.mDivisions, termination, observers ... ); } );
+}
+
+//! \brief cegar with the default options
+template< typename E, typename RefinementT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > cegar( RefinementTree< E >& rtree
+								     , const Ariadne::BoundedConstraintSet& initialSet
+								     , const Ariadne::Effort& effort
+								     , RefinementT refinement
+								     , const SH& stateH
+								     , const CH& counterexampleH
+								     , TermT termination
+								     , ObserversT& ... observers )
+{
+    return cegar( rtree, initialSet, effort, refinement, stateH, counterexampleH, termination, CegarOptions(), observers ... );
+}
+
+/*!
+  \brief runs cegar keeping only the capacity highest scoring counterexamples of each search
+  searches stop once the store is full of counterexamples reaching the score bound the heuristics declare, e.g. StateVolume with GreatestState,
+  instead of exploring all reachable nodes
+  \param capacity number of counterexamples kept per search, at least 1
+*/
+template< typename E, typename RefinementT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > boundedCegar( RefinementTree< E >& rtree
+									    , const Ariadne::BoundedConstraintSet& initialSet
+									    , const Ariadne::Effort& effort
+									    , RefinementT refinement
+									    , const SH& stateH
+									    , const CH& counterexampleH
+									    , const size_t& capacity
+									    , TermT termination
+									    , CegarOptions options
+									    , ObserversT& ... observers )
+{
+    auto pick = [] (const RefinementTree< E >& rtree, auto& counterexample) {
+	return NodeRefVec< RefinementTree< E > >( { std::ref( counterexample.second ) } ); };
+    CounterexampleStore< E, SH, CH > counters( stateH, counterexampleH, capacity );
+    return withSearch< E >( options, [&] (auto& search) {
+	return cegarLoop( rtree, initialSet, effort, refinement, pick, counters, search, options.mCheckBatch, options.mDivisions, termination, observers ... ); } );
+}
+
+//! \brief boundedCegar with the default options
+template< typename E, typename RefinementT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > boundedCegar( RefinementTree< E >& rtree
+									    , const Ariadne::BoundedConstraintSet& initialSet
+									    , const Ariadne::Effort& effort
+									    , RefinementT refinement
+									    , const SH& stateH
+									    , const CH& counterexampleH
+									    , const size_t& capacity
+									    , TermT termination
+									    , ObserversT& ... observers )
+{
+    return boundedCegar( rtree, initialSet, effort, refinement, stateH, counterexampleH, capacity, termination, CegarOptions(), observers ... );
+}
+
+/*!
+  \brief runs cegar refining all nodes the locator selects from a counterexample at once
+  \param locator returns NodeRefVec of nodes to refine for a counterexample, e.g. CompleteCounterexample
+  \note transitive safety is determined once for the refinements of all selected nodes
+*/
+template< typename E, typename RefinementT, typename LocatorT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > batchCegar( RefinementTree< E >& rtree
+									  , const Ariadne::BoundedConstraintSet& initialSet
+									  , const Ariadne::Effort& effort
+									  , RefinementT refinement
+									  , LocatorT locator
+									  , const SH& stateH
+									  , const CH& counterexampleH
+									  , TermT termination
+									  , CegarOptions options
+									  , ObserversT& ... observers )
+{
+    auto pick = [&locator] (const RefinementTree< E >& rtree, auto& counterexample) {
+	return locator( rtree, counterexample.first.begin(), counterexample.first.end() ); };
+    CounterexampleStore< E, SH, CH > counters( stateH, counterexampleH );
+    return withSearch< E >( options, [&] (auto& search) {
+	return cegarLoop( rtree, initialSet, effort, refinement, pick, counters, search, options.mCheckBatch, options.mDivisions, termination, observers ... ); } );
+}
+
+//! \brief batchCegar with the default options
+template< typename E, typename RefinementT, typename LocatorT, typename SH, typename CH, typename TermT, typename ... ObserversT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > batchCegar( RefinementTree< E >& rtree
+									  , const Ariadne::BoundedConstraintSet& initialSet
+									  , const Ariadne::Effort& effort
+									  , RefinementT refinement
+									  , LocatorT locator
+									  , const SH& stateH
+									  , const CH& counterexampleH
+									  , TermT termination
+									  , ObserversT& ... observers )
+{
+    return batchCegar( rtree, initialSet, effort, refinement, locator, stateH, counterexampleH, termination, CegarOptions(), observers ... );
+}
+
 #endif
@@ -2,6 +2,8 @@
 #define CEGAR_OBSERVER_HPP
 
 #include "refinementTree.hpp"
+#include "phaseProfiler.hpp"
+#include "memoryUsage.hpp"
 
 #include <chrono>
 #include <vector>
@@ -9,119 +11,143 @@
 #include <iterator>
 #include <functional>
 #include <ostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <type_traits>
 
 /*!
   \class blueprint for observers passed to cegar function
   \note do not use as base class because member functions are not virtual
+  \note hooks return Unobserved, hooks of derived observers return void and hide them, so the call functions skip hooks an observer does not define at compile time
 */
 // should template methods also be defined in header file rather than source file?
 struct CegarObserver
 {
+    //! result type of hooks not defined by an observer
+    struct Unobserved {};
+
     //! \brief called immediatly after the set of initial nodes has been determined, before the start of the loop
     template< typename Rtree >
-    void initialized( const Rtree& rtree ) {}
+    Unobserved initialized( const Rtree& rtree ) { return Unobserved(); }
 
     //! \brief first statement called in loop
     template< typename Rtree >
-    void startIteration( const Rtree& rtree ) {}
+    Unobserved startIteration( const Rtree& rtree ) { return Unobserved(); }
 
     //! \brief immediatly called before the refinement tree is searched for counterexamples
     template< typename Rtree, typename IterT >
-    void searchCounterexample( const Rtree& rtree, IterT iAbstractionsBegin, const IterT& iAbstractionsEnd ) {}
+    Unobserved searchCounterexample( const Rtree& rtree, IterT iAbstractionsBegin, const IterT& iAbstractionsEnd ) { return Unobserved(); }
 
     //! \brief immediatly called after search terminated
     template< typename Rtree >
-    void searchTerminated( const Rtree& rtree ) {}
+    Unobserved searchTerminated( const Rtree& rtree ) { return Unobserved(); }
     
     //! \brief called immediatly after a counterexample has been found
     template< typename Rtree, typename IterT >
-    void processCounterexample( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) {}
+    Unobserved processCounterexample( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) { return Unobserved(); }
 
     //! \brief called immediatly before counterexample is checked
     template< typename Rtree, typename IterT >
-    void checkSpurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) {}
+    Unobserved checkSpurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) { return Unobserved(); }
 
     //! \brief called immediatly after counterexample has been checked
     template< typename Rtree, typename IterT >
-    void spurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd, const Ariadne::ValidatedUpperKleenean& spurious ) {}
+    Unobserved spurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd, const Ariadne::ValidatedUpperKleenean& spurious ) { return Unobserved(); }
 
     //! \brief called immediatly before abstraction is refined
     template< typename Rtree >
-    void startRefinement( const Rtree& rtree, const typename Rtree::NodeT& toRefine ) {}
+    Unobserved startRefinement( const Rtree& rtree, const typename Rtree::NodeT& toRefine ) { return Unobserved(); }
     
     //! \brief called immediatly after an abstraction has been refined
     template< typename Rtree, typename IterT >
-    void refined( const Rtree& rtree, IterT iRefinedBegin, const IterT& iRefinedEnd ) {}
+    Unobserved refined( const Rtree& rtree, IterT iRefinedBegin, const IterT& iRefinedEnd ) { return Unobserved(); }
 
     //! \brief last statement before return
     template< typename Rtree >
-    void finished( const Rtree& rtree, const Ariadne::ValidatedKleenean safe ) {}
+    Unobserved finished( const Rtree& rtree, const Ariadne::ValidatedKleenean safe ) { return Unobserved(); }
 };
 
+//! \return true unless HookResultT is the result of a hook an observer inherits from CegarObserver
+template< typename HookResultT >
+constexpr bool isObserved = !std::is_same< HookResultT, CegarObserver::Unobserved >::value;
+
 template< typename ObserverT, typename Rtree >
 void callInitialized( ObserverT& obs, const Rtree& rtree )
 {
-    obs.initialized( rtree );
+    if constexpr( isObserved< decltype( obs.initialized( rtree ) ) > )
+	obs.initialized( rtree );
 }
 
 template< typename ObserverT, typename Rtree >
 void callStartIteration( ObserverT& obs, const Rtree& rtree )
 {
-    obs.startIteration( rtree );
+    if constexpr( isObserved< decltype( obs.startIteration( rtree ) ) > )
+	obs.startIteration( rtree );
 }
 
 template< typename ObserverT, typename Rtree, typename IterT >
 void callSearchCounterexample( ObserverT& obs, const Rtree& rtree, const IterT& iAbstractionsBegin, const IterT& iAbstractionsEnd )
 {
-    obs.searchCounterexample( rtree, iAbstractionsBegin, iAbstractionsEnd );
+    if constexpr( isObserved< decltype( obs.searchCounterexample( rtree, iAbstractionsBegin, iAbstractionsEnd ) ) > )
+	obs.searchCounterexample( rtree, iAbstractionsBegin, iAbstractionsEnd );
 }
 
 template< typename ObserverT, typename Rtree >
 void callSearchTerminated( ObserverT& obs, const Rtree& rtree )
 {
-    obs.searchTerminated( rtree );
+    if constexpr( isObserved< decltype( obs.searchTerminated( rtree ) ) > )
+	obs.searchTerminated( rtree );
 }
 
 //! \brief called immediatly after a counterexample has been found
 template< typename ObserverT, typename Rtree, typename IterT >
 void callProcessCounterexample( ObserverT& obs, const Rtree& rtree, const IterT& iCounterexBegin, const IterT& iCounterexEnd )
 {
-    obs.processCounterexample( rtree, iCounterexBegin, iCounterexEnd );
+    if constexpr( isObserved< decltype( obs.processCounterexample( rtree, iCounterexBegin, iCounterexEnd ) ) > )
+	obs.processCounterexample( rtree, iCounterexBegin, iCounterexEnd );
 }
 
 //! \brief called immediatly before counterexample is checked
 template< typename ObserverT, typename Rtree, typename IterT >
 void callCheckSpurious( ObserverT& obs, const Rtree& rtree, const IterT& iCounterexBegin, const IterT& iCounterexEnd )
 {
-    obs.checkSpurious( rtree, iCounterexBegin, iCounterexEnd );
+    if constexpr( isObserved< decltype( obs.checkSpurious( rtree, iCounterexBegin, iCounterexEnd ) ) > )
+	obs.checkSpurious( rtree, iCounterexBegin, iCounterexEnd );
 }
 
 //! \brief called immediatly after counterexample has been checked
 template< typename ObserverT, typename Rtree, typename IterT >
 void callSpurious( ObserverT& obs, const Rtree& rtree, const IterT& iCounterexBegin, const IterT& iCounterexEnd, const Ariadne::ValidatedUpperKleenean& spurious )
 {
-    obs.spurious( rtree, iCounterexBegin, iCounterexEnd, spurious );
+    if constexpr( isObserved< decltype( obs.spurious( rtree, iCounterexBegin, iCounterexEnd, spurious ) ) > )
+	obs.spurious( rtree, iCounterexBegin, iCounterexEnd, spurious );
 }
 
 //! \brief called immediatly before abstraction is refined
 template< typename ObserverT, typename Rtree >
 void callStartRefinement( ObserverT& obs, const Rtree& rtree, const typename Rtree::NodeT& toRefine )
 {
-    obs.startRefinement( rtree, toRefine );
+    if constexpr( isObserved< decltype( obs.startRefinement( rtree, toRefine ) ) > )
+	obs.startRefinement( rtree, toRefine );
 }
     
 //! \brief called immediatly after an abstraction has been refined
 template< typename ObserverT, typename Rtree, typename IterT >
 void callRefined( ObserverT& obs, const Rtree& rtree, const IterT& iRefinedBegin, const IterT& iRefinedEnd )
 {
-    obs.refined( rtree, iRefinedBegin, iRefinedEnd );
+    if constexpr( isObserved< decltype( obs.refined( rtree, iRefinedBegin, iRefinedEnd ) ) > )
+	obs.refined( rtree, iRefinedBegin, iRefinedEnd );
 }
 
 //! \brief last statement before return
 template< typename ObserverT, typename Rtree >
 void callFinished( ObserverT& obs, const Rtree& rtree, const Ariadne::ValidatedKleenean safe )
 {
-    obs.finished( rtree, safe );
+    if constexpr( isObserved< decltype( obs.finished( rtree, safe ) ) > )
+	obs.finished( rtree, safe );
 }
 
 //! \class logs how much time is spent on
@@ -215,6 +241,311 @@ class CegarTimer : public CegarObserver
     ClockT::duration mTotal, mSearch, mSpurious, mRefine, mOther;
 };
 
+/*!
+  \class collects the phases profiled by PhaseProfiler for each iteration of the cegar loop
+  an iteration lasts from one start of an iteration to the next, the last one until the loop finishes
+  \note phases are only recorded if the code is compiled with CEGAR_PROFILE, observe at most one loop at a time as the profiler is process wide
+*/
+class PhaseProfileObserver : public CegarObserver
+{
+  public:
+    //! \return calls and latencies of the phases in each iteration
+    const std::vector< PhaseProfileT >& iterations() const { return mIterations; }
+
+    //! \return calls and latencies of the phases summed over all iterations
+    PhaseProfileT total() const
+    {
+	PhaseProfileT sum;
+	for( const PhaseProfileT& it : mIterations )
+	    for( size_t p = 0; p < NO_PHASES; ++p )
+		sum[ p ] += it[ p ];
+	return sum;
+    }
+
+    //! \brief writes csv lines of iteration, phase, calls, nanoseconds and histogram buckets
+    template< typename CharT, typename Traits >
+    std::basic_ostream< CharT, Traits >& write( std::basic_ostream< CharT, Traits >& os ) const
+    {
+	for( size_t i = 0; i < mIterations.size(); ++i )
+	    writeProfile( os, mIterations[ i ], std::to_string( i ) + "," );
+	return os;
+    }
+
+    template< typename Rtree >
+    void initialized( const Rtree& rtree )
+    {
+	mIterations.clear();
+	mOpen = false;
+    }
+
+    template< typename Rtree >
+    void startIteration( const Rtree& rtree )
+    {
+	closeIteration();
+	mLast = PhaseProfiler::instance().collect();
+	mOpen = true;
+    }
+
+    template< typename Rtree >
+    void finished( const Rtree& rtree, const Ariadne::ValidatedKleenean& safe )
+    {
+	closeIteration();
+    }
+
+  private:
+    void closeIteration()
+    {
+	if( !mOpen )
+	    return;
+	PhaseProfileT now = PhaseProfiler::instance().collect();
+	for( size_t p = 0; p < NO_PHASES; ++p )
+	    now[ p ] -= mLast[ p ];
+	mIterations.push_back( now );
+	mOpen = false;
+    }
+
+    std::vector< PhaseProfileT > mIterations;
+    PhaseProfileT mLast;
+    bool mOpen = false;
+};
+
+//! \class record of one iteration of the cegar loop, as written by IterationLog
+struct IterationRecord
+{
+    uint64_t mIteration = 0;
+    // size of the abstraction at the start of the iteration
+    uint64_t mNodes = 0, mEdges = 0;
+    // abstractions the search starts from
+    uint64_t mFrontier = 0;
+    uint64_t mCounterexamples = 0;
+    uint64_t mSearchNs = 0, mCheckNs = 0, mRefineNs = 0, mOtherNs = 0;
+};
+
+//! \brief writes r as one csv line in the order of IterationLog::header
+inline std::ostream& operator <<( std::ostream& os, const IterationRecord& r )
+{
+    return os << r.mIteration << "," << r.mNodes << "," << r.mEdges << "," << r.mFrontier << "," << r.mCounterexamples
+	      << "," << r.mSearchNs << "," << r.mCheckNs << "," << r.mRefineNs << "," << r.mOtherNs << "\n";
+}
+
+/*!
+  \class streams one csv record per iteration of the cegar loop
+  records are queued by the thread running the loop and written by a writer thread of the log, which flushes the stream after each batch,
+  so a run that is killed keeps the iterations completed before
+  time between callbacks is attributed to the phase ending in the later callback, as by CegarTimer
+  \note the stream may not be used by others while the log exists, all records are written once finished returns
+*/
+class IterationLog : public CegarObserver
+{
+  public:
+    typedef std::chrono::steady_clock ClockT;
+
+    explicit IterationLog( std::ostream& os )
+	: mOs( os )
+    {
+	mOs << header() << std::endl;
+	mWriter = std::thread( [this] () { writeQueued(); } );
+    }
+
+    IterationLog( const IterationLog& ) = delete;
+    IterationLog& operator =( const IterationLog& ) = delete;
+
+    ~IterationLog()
+    {
+	{
+	    std::lock_guard< std::mutex > lock( mMutex );
+	    mStop = true;
+	}
+	mQueued.notify_one();
+	mWriter.join();
+    }
+
+    static const char* header() { return "iteration,nodes,edges,frontier,counterexamples,searchNs,checkNs,refineNs,otherNs"; }
+
+    //! \brief blocks until all records queued so far are written and flushed
+    void flush()
+    {
+	std::unique_lock< std::mutex > lock( mMutex );
+	mWritten.wait( lock, [this] () { return mQueue.empty() && !mWriting; } );
+    }
+
+    template< typename Rtree >
+    void initialized( const Rtree& rtree )
+    {
+	mNextIteration = 0;
+	mOpen = false;
+    }
+
+    template< typename Rtree >
+    void startIteration( const Rtree& rtree )
+    {
+	closeIteration();
+	mCurrent = IterationRecord();
+	mCurrent.mIteration = mNextIteration++;
+	mCurrent.mNodes = graph::size( rtree.graph() );
+	mCurrent.mEdges = rtree.graph().edgeCount();
+	mLastCall = ClockT::now();
+	mOpen = true;
+    }
+
+    template< typename Rtree, typename IterT >
+    void searchCounterexample( const Rtree& rtree, IterT iAbstractionsBegin, const IterT& iAbstractionsEnd )
+    {
+	attribute( mCurrent.mOtherNs );
+	mCurrent.mFrontier = std::distance( iAbstractionsBegin, iAbstractionsEnd );
+    }
+
+    template< typename Rtree >
+    void searchTerminated( const Rtree& rtree ) { attribute( mCurrent.mSearchNs ); }
+
+    template< typename Rtree, typename IterT >
+    void processCounterexample( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) { ++mCurrent.mCounterexamples; }
+
+    template< typename Rtree, typename IterT >
+    void checkSpurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd ) { attribute( mCurrent.mOtherNs ); }
+
+    template< typename Rtree, typename IterT >
+    void spurious( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd, const Ariadne::ValidatedUpperKleenean& spurious ) { attribute( mCurrent.mCheckNs ); }
+
+    template< typename Rtree >
+    void startRefinement( const Rtree& rtree, const typename Rtree::NodeT& toRefine ) { attribute( mCurrent.mOtherNs ); }
+
+    template< typename Rtree, typename IterT >
+    void refined( const Rtree& rtree, IterT iRefinedBegin, const IterT& iRefinedEnd ) { attribute( mCurrent.mRefineNs ); }
+
+    template< typename Rtree >
+    void finished( const Rtree& rtree, const Ariadne::ValidatedKleenean& safe )
+    {
+	closeIteration();
+	flush();
+    }
+
+  private:
+    void attribute( uint64_t& ns )
+    {
+	const ClockT::time_point now = ClockT::now();
+	ns += std::chrono::duration_cast< std::chrono::nanoseconds >( now - mLastCall ).count();
+	mLastCall = now;
+    }
+
+    void closeIteration()
+    {
+	if( !mOpen )
+	    return;
+	attribute( mCurrent.mOtherNs );
+	{
+	    std::lock_guard< std::mutex > lock( mMutex );
+	    mQueue.push_back( mCurrent );
+	}
+	mQueued.notify_one();
+	mOpen = false;
+    }
+
+    // runs on the writer thread, writing batches of records outside the lock
+    void writeQueued()
+    {
+	std::vector< IterationRecord > batch;
+	std::unique_lock< std::mutex > lock( mMutex );
+	while( true )
+	{
+	    mQueued.wait( lock, [this] () { return !mQueue.empty() || mStop; } );
+	    if( mQueue.empty() )
+		return;
+	    batch.swap( mQueue );
+	    mWriting = true;
+	    lock.unlock();
+	    for( const IterationRecord& r : batch )
+		mOs << r;
+	    mOs.flush();
+	    batch.clear();
+	    lock.lock();
+	    mWriting = false;
+	    mWritten.notify_all();
+	}
+    }
+
+    std::ostream& mOs;
+    IterationRecord mCurrent;
+    uint64_t mNextIteration = 0;
+    bool mOpen = false;
+    ClockT::time_point mLastCall;
+
+    std::mutex mMutex;
+    std::condition_variable mQueued, mWritten;
+    std::vector< IterationRecord > mQueue;
+    bool mWriting = false, mStop = false;
+    std::thread mWriter;
+};
+
+/*!
+  \class samples the memory used by the refinement tree at the start of each iteration and once the loop finished
+  counterexamples are included if a store is watched, e.g. the one passed to cegarLoop
+*/
+class MemoryObserver : public CegarObserver
+{
+  public:
+    struct Sample
+    {
+	uint64_t mNodes = 0, mEdges = 0;
+	MemoryUsage mUsage;
+
+	//! \return bytes of vertices, values and indices for each node
+	double bytesPerNode() const { return mNodes > 0 ? double( mUsage.mVertices + mUsage.mValues + mUsage.mIndices ) / mNodes : 0.0; }
+
+	//! \return bytes of edge containers for each edge
+	double bytesPerEdge() const { return mEdges > 0 ? double( mUsage.mEdges ) / mEdges : 0.0; }
+    };
+
+    //! \brief includes the counterexamples of store in the samples, store has to outlive sampling
+    template< typename StoreT >
+    void watch( const StoreT& store ) { mCounterexampleBytes = [&store] () { return store.heapBytes(); }; }
+
+    //! \return samples taken in order, the last one taken when the loop finished
+    const std::vector< Sample >& samples() const { return mSamples; }
+
+    static const char* header() { return "sample,nodes,edges,vertexBytes,edgeBytes,valueBytes,indexBytes,counterexampleBytes,totalBytes,bytesPerNode,bytesPerEdge"; }
+
+    //! \brief writes header and samples as csv lines
+    template< typename CharT, typename Traits >
+    std::basic_ostream< CharT, Traits >& write( std::basic_ostream< CharT, Traits >& os ) const
+    {
+	os << header() << std::endl;
+	for( size_t i = 0; i < mSamples.size(); ++i )
+	{
+	    const Sample& s = mSamples[ i ];
+	    os << i << "," << s.mNodes << "," << s.mEdges << "," << s.mUsage.mVertices << "," << s.mUsage.mEdges << "," << s.mUsage.mValues
+	       << "," << s.mUsage.mIndices << "," << s.mUsage.mCounterexamples << "," << s.mUsage.total()
+	       << "," << s.bytesPerNode() << "," << s.bytesPerEdge() << std::endl;
+	}
+	return os;
+    }
+
+    template< typename Rtree >
+    void initialized( const Rtree& rtree ) { mSamples.clear(); }
+
+    template< typename Rtree >
+    void startIteration( const Rtree& rtree ) { sample( rtree ); }
+
+    template< typename Rtree >
+    void finished( const Rtree& rtree, const Ariadne::ValidatedKleenean& safe ) { sample( rtree ); }
+
+  private:
+    template< typename Rtree >
+    void sample( const Rtree& rtree )
+    {
+	Sample s;
+	s.mNodes = graph::size( rtree.graph() );
+	s.mEdges = rtree.graph().edgeCount();
+	s.mUsage = rtree.memoryUsage();
+	if( mCounterexampleBytes )
+	    s.mUsage.mCounterexamples = mCounterexampleBytes();
+	mSamples.push_back( s );
+    }
+
+    std::function< size_t() > mCounterexampleBytes;
+    std::vector< Sample > mSamples;
+};
+
 class IterationCounter : public CegarObserver
 {
   public:
@@ -242,6 +573,9 @@ class CounterexampleLengthAverage : public CegarObserver
 
     double average() const {return mAvg;}
 
+    //! \return number of counterexamples averaged
+    uint counterexamples() const {return mNums;}
+
     template< typename Rtree, typename IterT >
     void processCounterexample( const Rtree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd )
     {
@@ -0,0 +1,436 @@
+#ifndef CERTIFICATE_HPP
+#define CERTIFICATE_HPP
+
+#include "dynamicsTape.hpp"
+#include "counterRandom.hpp"
+
+#include "geometry/box.hpp"
+#include "geometry/function_set.hpp"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <functional>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+#include <algorithm>
+
+/*!
+  \class certificate of the safety of an initial set, a flat copy of the final partition of a refinement tree proven safe
+  stores the leaves as boxes sorted by their lower bounds, whether each leaf belongs to the invariant, i.e. is reachable from
+  the initial set, a digest of the edges leaving the invariant and the enclosure of the images the edges were determined by;
+  neither the graph nor the dynamics are kept
+  verify re-establishes the proof box by box from dynamics and safe set alone:
+  - the boxes partition the bounding box: they lie inside it, their interiors are disjoint and they tile it without gaps
+  - the boxes overlapping the initial set belong to the invariant
+  - boxes of the invariant are safe and their images, enclosed as by the proof, only overlap boxes of the invariant
+  \note numbers are written in the byte order of the machine
+*/
+class SafetyCertificate
+{
+  public:
+    typedef Ariadne::ExactBoxType BoxT;
+
+    static constexpr size_t NO_BOX = std::numeric_limits< size_t >::max();
+
+    //! \class result of verifying a certificate
+    struct Check
+    {
+	bool mVerified = true;
+	// true if the edges recomputed from the dynamics have the digest stored, the proof does not depend on it
+	bool mDigestMatches = true;
+	// first box violating the proof found, NO_BOX if the violation does not concern a single box
+	size_t mFailedBox = NO_BOX;
+	std::string mReason;
+    };
+
+    /*!
+      \brief certifies the safety of initialSet by the partition of rtree
+      \param rtree refinement tree in which no unsafe node is reachable from the abstraction of initialSet
+    */
+    template< typename Rtree >
+    SafetyCertificate( const Rtree& rtree, const Ariadne::BoundedConstraintSet& initialSet )
+	: mDimension( rtree.initialEnclosure().dimension() )
+	, mEdgeDigest( 0 )
+	, mImageEnclosure( rtree.imageEnclosure() )
+    {
+	typedef typename Rtree::NodeT NodeT;
+	const auto& g = rtree.graph();
+	for( uint64_t d = 0; d < mDimension; ++d )
+	{
+	    mBounds.push_back( rtree.initialEnclosure()[ d ].lower().get_d() );
+	    mBounds.push_back( rtree.initialEnclosure()[ d ].upper().get_d() );
+	}
+
+	// sort the leaves, positions of their values index by the value index
+	std::vector< NodeT > leaves;
+	size_t maxIndex = 0;
+	for( auto vs = graph::vertices( g ); vs.first != vs.second; ++vs.first )
+	{
+	    if( rtree.nodeValue( *vs.first ) )
+	    {
+		leaves.push_back( *vs.first );
+		maxIndex = std::max( maxIndex, graph::value( g, *vs.first )->index() );
+	    }
+	}
+	auto lowerBounds = [&rtree] (const NodeT& n) {
+			       std::vector< double > lower;
+			       const BoxT& bx = rtree.nodeValue( n ).value().get().getEnclosure();
+			       for( size_t d = 0; d < bx.dimension(); ++d )
+				   lower.push_back( bx[ d ].lower().get_d() );
+			       return lower; };
+	std::sort( leaves.begin(), leaves.end(), [&lowerBounds] (const NodeT& n1, const NodeT& n2) { return lowerBounds( n1 ) < lowerBounds( n2 ); } );
+	std::vector< size_t > position( maxIndex + 1, NO_BOX );
+	for( size_t i = 0; i < leaves.size(); ++i )
+	{
+	    position[ graph::value( g, leaves[ i ] )->index() ] = i;
+	    const BoxT& bx = rtree.nodeValue( leaves[ i ] ).value().get().getEnclosure();
+	    for( size_t d = 0; d < mDimension; ++d )
+	    {
+		mBoxes.push_back( bx[ d ].lower().get_d() );
+		mBoxes.push_back( bx[ d ].upper().get_d() );
+	    }
+	}
+
+	// the invariant is everything reachable from the initial abstraction, as in the search for counterexamples
+	mInvariant.assign( leaves.size(), 0 );
+	const Ariadne::Effort effort = rtree.effort();
+	auto interPred = [effort] (const typename Rtree::EnclosureT& enc, const Ariadne::BoundedConstraintSet& cset) {
+	    return !( cset.separated( enc ).check( effort ) ); };
+	std::deque< NodeT > queue;
+	auto enqueue = [&] (const NodeT& n) {
+			   if( !rtree.nodeValue( n ) || !definitely( rtree.isSafe( n ) ) )
+			       throw std::logic_error( "refinement tree does not prove safety of the initial set" );
+			   uint8_t& inInvariant = mInvariant[ position[ graph::value( g, n )->index() ] ];
+			   if( !inInvariant )
+			   {
+			       inInvariant = 1;
+			       queue.push_back( n );
+			   }
+		       };
+	for( const NodeT& n : rtree.intersection( initialSet, interPred ) )
+	    enqueue( n );
+	while( !queue.empty() )
+	{
+	    const NodeT n = queue.front();
+	    queue.pop_front();
+	    const size_t src = position[ graph::value( g, n )->index() ];
+	    for( const NodeT post : rtree.postimageRange( n ) )
+	    {
+		enqueue( post );
+		mEdgeDigest += edgeHash( src, position[ graph::value( g, post )->index() ] );
+	    }
+	}
+    }
+
+    //! \brief reads a certificate written by save
+    explicit SafetyCertificate( std::istream& is )
+    {
+	if( readRaw< uint64_t >( is ) != MAGIC )
+	    throw std::logic_error( "stream does not contain a safety certificate" );
+	mDimension = readRaw< uint64_t >( is );
+	const uint64_t noBoxes = readRaw< uint64_t >( is );
+	mEdgeDigest = readRaw< uint64_t >( is );
+	const uint64_t enclosure = readRaw< uint64_t >( is );
+	if( !is || mDimension == 0 )
+	    throw std::logic_error( "header of safety certificate truncated" );
+	if( enclosure > uint64_t( ImageEnclosure::AFFINE ) )
+	    throw std::logic_error( "safety certificate encloses images by an unknown enclosure" );
+	mImageEnclosure = ImageEnclosure( enclosure );
+	mBounds.resize( 2 * mDimension );
+	for( double& b : mBounds )
+	    b = readRaw< double >( is );
+	mBoxes.resize( 2 * mDimension * noBoxes );
+	for( double& b : mBoxes )
+	    b = readRaw< double >( is );
+	mInvariant.resize( noBoxes );
+	for( uint8_t& inInvariant : mInvariant )
+	    inInvariant = readRaw< uint8_t >( is );
+	if( !is )
+	    throw std::logic_error( "safety certificate truncated" );
+    }
+
+    /*!
+      \brief certifies the safety of initialSet by the partition of the tree at pRtree and destroys the tree
+      \return certificate, sized by the leaves of the tree only
+    */
+    template< typename Rtree >
+    static SafetyCertificate compact( std::unique_ptr< Rtree >& pRtree, const Ariadne::BoundedConstraintSet& initialSet )
+    {
+	SafetyCertificate certificate( *pRtree, initialSet );
+	pRtree.reset();
+	return certificate;
+    }
+
+    void save( std::ostream& os ) const
+    {
+	writeRaw< uint64_t >( os, MAGIC );
+	writeRaw< uint64_t >( os, mDimension );
+	writeRaw< uint64_t >( os, size() );
+	writeRaw< uint64_t >( os, mEdgeDigest );
+	writeRaw< uint64_t >( os, uint64_t( mImageEnclosure ) );
+	for( const double& b : mBounds )
+	    writeRaw( os, b );
+	for( const double& b : mBoxes )
+	    writeRaw( os, b );
+	for( const uint8_t& inInvariant : mInvariant )
+	    writeRaw( os, inInvariant );
+    }
+
+    size_t dimension() const { return mDimension; }
+
+    //! \return number of boxes of the partition
+    size_t size() const { return mInvariant.size(); }
+
+    //! \return number of boxes reachable from the initial set
+    size_t invariantSize() const { return std::accumulate( mInvariant.begin(), mInvariant.end(), size_t( 0 ) ); }
+
+    bool isInvariant( const size_t& i ) const { return mInvariant[ i ]; }
+
+    BoxT box( const size_t& i ) const
+    {
+	Ariadne::Array< Ariadne::ExactIntervalType > intervals( mDimension );
+	for( size_t d = 0; d < mDimension; ++d )
+	    intervals[ d ] = Ariadne::ExactIntervalType( lower( i, d ), upper( i, d ) );
+	return BoxT( Ariadne::Vector( intervals ) );
+    }
+
+    //! \return enclosure of the images the edges of the proof were determined by, also used by verify
+    const ImageEnclosure& imageEnclosure() const { return mImageEnclosure; }
+
+    //! \return order independent hash of the edges from boxes of the invariant by positions of their boxes
+    uint64_t edgeDigest() const { return mEdgeDigest; }
+
+    size_t heapBytes() const { return ( mBounds.capacity() + mBoxes.capacity() ) * sizeof( double ) + mInvariant.capacity(); }
+
+    /*!
+      \brief verifies that no state of initialSet leaves safeSet under dynamics, checking boxes concurrently
+      images are evaluated and enclosed as by the refinement tree, so the digest of the edges found matches the one stored for the same dynamics
+    */
+    Check verify( const Ariadne::EffectiveVectorFunction& dynamics
+		  , const Ariadne::BoundedConstraintSet& safeSet
+		  , const Ariadne::BoundedConstraintSet& initialSet
+		  , const Ariadne::Effort& effort ) const
+    {
+	Check check;
+	if( dynamics.argument_size() != mDimension || dynamics.result_size() != mDimension )
+	    return failed( check, NO_BOX, "dynamics are of a different dimension than the partition" );
+	const Ariadne::UpperBoxType initialBb = initialSet.bounding_box();
+	for( size_t d = 0; d < mDimension; ++d )
+	{
+	    if( initialBb[ d ].lower().get_d() < mBounds[ 2 * d ] || initialBb[ d ].upper().get_d() > mBounds[ 2 * d + 1 ] )
+		return failed( check, NO_BOX, "initial set exceeds the partition" );
+	}
+	double volume = 0, boundsVolume = 1;
+	for( size_t d = 0; d < mDimension; ++d )
+	    boundsVolume *= mBounds[ 2 * d + 1 ] - mBounds[ 2 * d ];
+
+	const DynamicsTape tape( dynamics );
+	const int noBoxes = size();
+	std::vector< std::string > reasons( noBoxes );
+	uint64_t digest = 0;
+#pragma omp parallel for schedule( dynamic ) reduction( + : volume, digest )
+	for( int i = 0; i < noBoxes; ++i )
+	{
+	    volume += boxVolume( i );
+	    reasons[ i ] = verifyBox( i, tape, safeSet, initialSet, effort, digest );
+	}
+	for( int i = 0; i < noBoxes; ++i )
+	{
+	    if( !reasons[ i ].empty() )
+		return failed( check, i, reasons[ i ] );
+	}
+	// volumes of partitions sum almost exactly, a quick rejection before checking the tiling exactly
+	if( std::abs( volume - boundsVolume ) > VOLUME_TOLERANCE * boundsVolume )
+	    return failed( check, NO_BOX, "boxes do not cover the bounding box" );
+	if( !tilesBounds() )
+	    return failed( check, NO_BOX, "boxes do not tile the bounding box" );
+	check.mDigestMatches = digest == mEdgeDigest;
+	return check;
+    }
+
+  private:
+    static constexpr uint64_t MAGIC = 0x43455254494632ull; // "CERTIF2" in ascii, certificates storing their image enclosure
+    static constexpr uint64_t DIGEST_SEED = 0x5afe;
+    static constexpr double VOLUME_TOLERANCE = 1e-9;
+
+    static uint64_t edgeHash( const size_t& src, const size_t& trg ) { return CounterRandom( DIGEST_SEED ).bits( src, trg ); }
+
+    template< typename T >
+    static void writeRaw( std::ostream& os, const T& t )
+    {
+	os.write( reinterpret_cast< const char* >( &t ), sizeof( T ) );
+    }
+
+    template< typename T >
+    static T readRaw( std::istream& is )
+    {
+	T t;
+	is.read( reinterpret_cast< char* >( &t ), sizeof( T ) );
+	return t;
+    }
+
+    static Check& failed( Check& check, const size_t& box, const std::string& reason )
+    {
+	check.mVerified = false;
+	check.mDigestMatches = false;
+	check.mFailedBox = box;
+	check.mReason = reason;
+	return check;
+    }
+
+    double lower( const size_t& i, const size_t& d ) const { return mBoxes[ 2 * ( i * mDimension + d ) ]; }
+
+    double upper( const size_t& i, const size_t& d ) const { return mBoxes[ 2 * ( i * mDimension + d ) + 1 ]; }
+
+    double boxVolume( const size_t& i ) const
+    {
+	double volume = 1;
+	for( size_t d = 0; d < mDimension; ++d )
+	    volume *= upper( i, d ) - lower( i, d );
+	return volume;
+    }
+
+    /*!
+      \return true if the boxes cover the bounding box, compared exactly instead of by volume
+      the bounds of all boxes cut the bounding box into a grid of cells, each box covering whole cells,
+      so boxes with disjoint interiors inside the bounding box cover it if and only if they cover as many cells as the grid has
+      \note also false if the cells are too many to be counted in 64 bits
+    */
+    bool tilesBounds() const
+    {
+	std::vector< std::vector< double > > cuts( mDimension );
+	for( size_t d = 0; d < mDimension; ++d )
+	{
+	    std::vector< double >& c = cuts[ d ];
+	    c.reserve( 2 * size() + 2 );
+	    c.push_back( mBounds[ 2 * d ] );
+	    c.push_back( mBounds[ 2 * d + 1 ] );
+	    for( size_t i = 0; i < size(); ++i )
+	    {
+		c.push_back( lower( i, d ) );
+		c.push_back( upper( i, d ) );
+	    }
+	    std::sort( c.begin(), c.end() );
+	    c.erase( std::unique( c.begin(), c.end() ), c.end() );
+	}
+	auto multiply = [] (uint64_t& product, const uint64_t& factor) {
+			    if( factor != 0 && product > std::numeric_limits< uint64_t >::max() / factor )
+				return false;
+			    product *= factor;
+			    return true; };
+
+	uint64_t gridCells = 1;
+	for( size_t d = 0; d < mDimension; ++d )
+	{
+	    if( !multiply( gridCells, cuts[ d ].size() - 1 ) )
+		return false;
+	}
+	uint64_t coveredCells = 0;
+	for( size_t i = 0; i < size(); ++i )
+	{
+	    uint64_t cells = 1;
+	    for( size_t d = 0; d < mDimension; ++d )
+	    {
+		const std::vector< double >& c = cuts[ d ];
+		const uint64_t span = std::lower_bound( c.begin(), c.end(), upper( i, d ) ) - std::lower_bound( c.begin(), c.end(), lower( i, d ) );
+		if( !multiply( cells, span ) )
+		    return false;
+	    }
+	    if( cells > gridCells - coveredCells )
+		return false;
+	    coveredCells += cells;
+	}
+	return coveredCells == gridCells;
+    }
+
+    //! \return one past the last box whose lower bound in the first dimension is at most bound
+    size_t endLowerAtMost( const double& bound ) const
+    {
+	size_t first = 0, count = size();
+	while( count > 0 )
+	{
+	    const size_t step = count / 2;
+	    if( lower( first + step, 0 ) <= bound )
+	    {
+		first += step + 1;
+		count -= step + 1;
+	    }
+	    else
+		count = step;
+	}
+	return first;
+    }
+
+    /*!
+      \return reason box i violates the proof, empty if it does not
+      \param digest hashes of the edges from box i are added to digest
+    */
+    std::string verifyBox( const size_t& i
+			   , const DynamicsTape& tape
+			   , const Ariadne::BoundedConstraintSet& safeSet
+			   , const Ariadne::BoundedConstraintSet& initialSet
+			   , const Ariadne::Effort& effort
+			   , uint64_t& digest ) const
+    {
+	for( size_t d = 0; d < mDimension; ++d )
+	{
+	    if( !( lower( i, d ) < upper( i, d ) ) || lower( i, d ) < mBounds[ 2 * d ] || upper( i, d ) > mBounds[ 2 * d + 1 ] )
+		return "box is empty or exceeds the bounding box";
+	}
+	// boxes sorted later overlapping the interior of box i
+	for( size_t j = i + 1, end = endLowerAtMost( upper( i, 0 ) ); j < end; ++j )
+	{
+	    bool overlaps = true;
+	    for( size_t d = 0; d < mDimension && overlaps; ++d )
+		overlaps = lower( j, d ) < upper( i, d ) && lower( i, d ) < upper( j, d );
+	    if( overlaps )
+		return "interior of box overlaps box " + std::to_string( j );
+	}
+
+	const BoxT bx = box( i );
+	if( !isInvariant( i ) )
+	{
+	    if( possibly( !( initialSet.separated( bx ).check( effort ) ) ) )
+		return "box overlaps the initial set but is not in the invariant";
+	    return std::string();
+	}
+	if( !definitely( safeSet.covers( bx ).check( effort ) ) )
+	    return "box of the invariant is not safe";
+	// mean value forms are bounded by the box image, as cached by the refinement tree
+	const AffineImage form = mImageEnclosure == ImageEnclosure::AFFINE ? tape.affineImage( bx, tape.image( bx ) ) : AffineImage( tape.image( bx ) );
+	const Ariadne::UpperBoxType& image = form.boundingBox();
+	for( size_t d = 0; d < mDimension; ++d )
+	{
+	    if( image[ d ].lower().get_d() < mBounds[ 2 * d ] || image[ d ].upper().get_d() > mBounds[ 2 * d + 1 ] )
+		return "image of box leaves the partition";
+	}
+	for( size_t j = 0, end = endLowerAtMost( image[ 0 ].upper().get_d() ); j < end; ++j )
+	{
+	    if( possibly( form.intersects( box( j ) ) ) )
+	    {
+		if( !isInvariant( j ) )
+		    return "image of box reaches box " + std::to_string( j ) + " not in the invariant";
+		digest += edgeHash( i, j );
+	    }
+	}
+	return std::string();
+    }
+
+    uint64_t mDimension;
+    // lower and upper bound of each dimension of the bounding box
+    std::vector< double > mBounds;
+    // lower and upper bound of each dimension for each box
+    std::vector< double > mBoxes;
+    std::vector< uint8_t > mInvariant;
+    uint64_t mEdgeDigest;
+    ImageEnclosure mImageEnclosure;
+};
+
+#endif
@@ -2,11 +2,17 @@
 #define COUNTEREXAMPLE_STORE_HPP
 
 #include "refinementTree.hpp"
+#include "locator.hpp"
 
 #include <vector>
-#include <map>
 #include <iterator>
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <limits>
+#include <functional>
+#include <cmath>
+#include <type_traits>
 
 template< typename E >
 using CounterexampleT = std::vector< typename RefinementTree< E >::NodeT >;
@@ -38,6 +44,16 @@ struct ScoredCounterexample
 				   , [&] (const double& val, auto& stateValue) { return ch( val, stateValue.second ); } ) )
     {  }
 
+    //! \param scoresBegin iterator over the scores of the states in [cexBegin, cexEnd), total combines them
+    template< typename IterT, typename ScoreIterT >
+    ScoredCounterexample( const IterT& cexBegin, const IterT& cexEnd, ScoreIterT scoresBegin, const double& total )
+	: mTotal( total )
+    {
+	mStates.reserve( std::distance( cexBegin, cexEnd ) );
+	for( auto istate = cexBegin; istate != cexEnd; ++istate, ++scoresBegin )
+	    mStates.push_back( std::make_pair( *istate, *scoresBegin ) );
+    }
+
     bool operator <( const ScoredCounterexample< E >& other ) const
     {
 	return this->mTotal < other.mTotal;
@@ -56,8 +72,32 @@ struct std::greater< ScoredCounterexample< E > >
     }
 };
 
+//! \class whether counterexample heuristic CH declares bound
+template< typename CH, typename = void >
+struct DeclaresScoreBound : std::false_type {};
+
+template< typename CH >
+struct DeclaresScoreBound< CH, std::void_t< decltype( std::declval< const CH& >().bound( 0.0 ) ) > > : std::true_type {};
+
+/*!
+  \return upper bound on the scores of counterexamples in rtree, derived from the bounds the heuristics declare
+  infinity unless stateH declares maxScore and counterexampleH declares bound
+*/
+template< typename E, typename SH, typename CH >
+double counterexampleScoreBound( const RefinementTree< E >& rtree, const SH& stateH, const CH& counterexampleH )
+{
+    if constexpr( DeclaresMaxScore< SH, RefinementTree< E > >::value && DeclaresScoreBound< CH >::value )
+	return counterexampleH.bound( maxStateScore( rtree, stateH ) );
+    else
+	return std::numeric_limits< double >::infinity();
+}
+
 /*!
   \class maintains a store of counterexample for efficient retrieval of most highly scoring counterexample
+  counterexamples are kept in a heap by score, removed ones are only dropped from the heap when they reach its top,
+  an index from node to the counterexamples containing it allows invalidating a node in time linear in the number of those
+  with a capacity, only the highest scoring counterexamples are kept and lower scoring ones are rejected before their path is stored
+  scores of state heuristics declaring their ScoreDependence are cached per node or edge until the node is invalidated
   \param SH state heuristic: assign score to state, higher scores meaning more suitable for refinement
   \param CH counterexample heuristic: maps states in counterexample and their score to single score
 */
@@ -65,11 +105,24 @@ template< typename E, typename SH, typename CH >
 class CounterexampleStore
 {
   public:
-    CounterexampleStore( const SH& stateH, const CH& counterexampleH )
-	: mCSet()
-	, mStateH( stateH )
+    /*!
+      \param capacity number of counterexamples kept at most
+      \param scoreBound upper bound on scores of counterexamples, searches may terminate once capacity counterexamples reach it,
+      tightened by updateScoreBound to the bound derived from the heuristics
+    */
+    CounterexampleStore( const SH& stateH, const CH& counterexampleH
+			 , const size_t& capacity = std::numeric_limits< size_t >::max()
+			 , const double& scoreBound = std::numeric_limits< double >::infinity() )
+	: mStateH( stateH )
 	, mCounterexampleH( counterexampleH )
-    {}
+	, mCapacity( capacity )
+	, mFixedScoreBound( scoreBound )
+	, mScoreBound( scoreBound )
+	, mLiveCount( 0 )
+    {
+	if( mCapacity == 0 )
+	    throw std::logic_error( "counterexample store needs to be able to hold at least one counterexample" );
+    }
 
     //! \return counterexample and most preferred state for refinement
     std::pair< CounterexampleT< E >, typename RefinementTree< E >::NodeT > obtain()
@@ -77,73 +130,267 @@ class CounterexampleStore
 	if( !hasCounterexample() )
 	    throw std::runtime_error( "counterexample store does not hold counterexamples but is asked for one" );
 
+	while( !mLive[ mHeap.front().second ] )
+	    popHeap();
+	const HandleT h = mHeap.front().second;
+	popHeap();
+	const ScoredCounterexample< E >& scex = mCounterexamples[ h ];
+
 	std::pair< CounterexampleT< E >, typename RefinementTree< E >::NodeT > ret;
-	ret.first.reserve( mCSet.begin()->mStates.size() );
-	std::transform( mCSet.begin()->mStates.begin(), mCSet.begin()->mStates.end(), std::back_inserter( ret.first )
+	ret.first.reserve( scex.mStates.size() );
+	std::transform( scex.mStates.begin(), scex.mStates.end(), std::back_inserter( ret.first )
 			, [] (auto& stateVal) {return stateVal.first;} );
 
-	auto ispick = std::max_element( mCSet.begin()->mStates.begin(), mCSet.begin()->mStates.end()
+	auto ispick = std::max_element( scex.mStates.begin(), scex.mStates.end()
 					, [] (auto& sv1, auto& sv2) {return sv1.second < sv2.second;} );
 	ret.second = ispick->first;
 
-	mCSet.erase( mCSet.begin() );
-
+	remove( h );
 	return ret;
     }
     
     bool hasCounterexample() const
     {
-	return !mCSet.empty();
+	return mLiveCount != 0;
     }
 
-    //! \todo find condition on which to terminate (find counterexample with value as high as last one?)
-    bool terminateSearch() const
+    //! \return number of counterexamples stored
+    size_t size() const { return mLiveCount; }
+
+    //! \return capacity of the store
+    size_t capacity() const { return mCapacity; }
+
+    //! \return bytes allocated on the heap for counterexamples, heaps, node index and cached scores, including removed counterexamples not released yet
+    size_t heapBytes() const
+    {
+	size_t bytes = mCounterexamples.capacity() * sizeof( ScoredCounterexample< E > ) + mLive.capacity() / 8
+	    + ( mHeap.capacity() + mMinHeap.capacity() ) * sizeof( HeapItemT )
+	    + mCounterexamplesOfNode.capacity() * sizeof( std::vector< HandleT > )
+	    + ( mScores.capacity() + mStateScores.capacity() ) * sizeof( double )
+	    + mSuccessorScores.capacity() * sizeof( std::vector< std::pair< size_t, double > > );
+	for( const ScoredCounterexample< E >& scex : mCounterexamples )
+	    bytes += scex.mStates.capacity() * sizeof( typename ScoredCounterexample< E >::ScorePathT::value_type );
+	for( const std::vector< HandleT >& handles : mCounterexamplesOfNode )
+	    bytes += handles.capacity() * sizeof( HandleT );
+	for( const std::vector< std::pair< size_t, double > >& scores : mSuccessorScores )
+	    bytes += scores.capacity() * sizeof( std::pair< size_t, double > );
+	return bytes;
+    }
+
+    //! \return true if the store is full and no counterexample found later could score higher than those stored
+    bool terminateSearch()
+    {
+	return isFull() && minLive().first >= mScoreBound;
+    }
+
+    /*!
+      \brief sets the score bound to the lesser of the bound passed on construction and the one the heuristics declare for rtree
+      searches call this before exploring, as refinement lowers the scores states can reach
+    */
+    void updateScoreBound( const RefinementTree< E >& rtree )
     {
-	return false; // never terminate
+	// without capacity the store is never full, spare scanning the leaves
+	if( isBounded() )
+	    mScoreBound = std::min( mFixedScoreBound, counterexampleScoreBound( rtree, mStateH, mCounterexampleH ) );
     }
 
+    //! \return score a full store has to reach to terminate searches
+    double scoreBound() const { return mScoreBound; }
+
     //! \todo abandon in favor of clean
     void startSearch()
     {
-	mCSet.clear();
+	clear();
     }
 
+    //! \brief stores the counterexample [beginCex, endCex) unless the store is full of counterexamples scoring at least as high
     template< typename IterT >
     void found( const RefinementTree< E >& rtree, const IterT& beginCex, const IterT& endCex )
     {
-	mCSet.emplace( rtree, beginCex, endCex, mStateH, mCounterexampleH );
+	// score first, the state heuristic is called once per state
+	mScores.clear();
+	for( auto istate = beginCex; istate != endCex; ++istate )
+	    mScores.push_back( stateScore( rtree, beginCex, endCex, istate ) );
+	const double total = std::accumulate( mScores.begin(), mScores.end(), 0.0
+					      , [this] (const double& val, const double& score) { return mCounterexampleH( val, score ); } );
+	if( isFull() )
+	{
+	    const HeapItemT lowest = minLive();
+	    if( total <= lowest.first )
+		return;
+	    remove( lowest.second );
+	}
+
+	const HandleT h = mCounterexamples.size();
+	mCounterexamples.emplace_back( beginCex, endCex, mScores.begin(), total );
+	mLive.push_back( true );
+	++mLiveCount;
+	mHeap.push_back( HeapItemT( total, h ) );
+	std::push_heap( mHeap.begin(), mHeap.end() );
+	if( isBounded() )
+	{
+	    mMinHeap.push_back( HeapItemT( total, h ) );
+	    std::push_heap( mMinHeap.begin(), mMinHeap.end(), std::greater< HeapItemT >() );
+	}
+
+	for( auto istate = beginCex; istate != endCex; ++istate )
+	{
+	    const size_t i = graph::value( rtree.graph(), *istate )->index();
+	    if( i >= mCounterexamplesOfNode.size() )
+		mCounterexamplesOfNode.resize( std::max( i + 1, 2 * mCounterexamplesOfNode.size() ) );
+	    std::vector< HandleT >& handles = mCounterexamplesOfNode[ i ];
+	    if( handles.empty() || handles.back() != h )
+		handles.push_back( h );
+	}
     }
 
     //! \brief signals that n is being invalidated, thus no counterexample containing n should be handed out anymore
     void invalidate( const RefinementTree< E >& rtree, const typename RefinementTree< E >::NodeT& n )
     {
-	typename RefinementTree< E >::NodeComparator ncomp( rtree );
+	CEGAR_PROFILE_SCOPE( INVALIDATE );
+	const size_t i = graph::value( rtree.graph(), n )->index();
+	// refinement removes n, so its index is never scored again, neither as state nor as successor of its predecessors
+	if( i < mStateScores.size() )
+	    mStateScores[ i ] = NO_SCORE;
+	if( i < mSuccessorScores.size() )
+	{
+	    std::vector< std::pair< size_t, double > >().swap( mSuccessorScores[ i ] );
+	    rtree.visitPreimage( n, [this, &rtree, &i] (const typename RefinementTree< E >::NodeT& pre) {
+		    const size_t p = graph::value( rtree.graph(), pre )->index();
+		    if( p >= mSuccessorScores.size() )
+			return;
+		    std::vector< std::pair< size_t, double > >& scores = mSuccessorScores[ p ];
+		    scores.erase( std::remove_if( scores.begin(), scores.end(), [&i] (auto& sscore) { return sscore.first == i; } ), scores.end() ); } );
+	}
+	if( i >= mCounterexamplesOfNode.size() )
+	    return;
 
-	auto icset = mCSet.begin();
-	while( icset != mCSet.end() )
+	// swap out first, removing the last counterexample resets the store including the index
+	std::vector< HandleT > handles;
+	handles.swap( mCounterexamplesOfNode[ i ] );
+	for( const HandleT& h : handles )
 	{
-	    if( std::any_of( icset->mStates.begin(), icset->mStates.end(), [&] (auto& stateVal) {
-				   return rtree.equal( n, stateVal.first ); } ) )
-		icset = mCSet.erase( icset );
-	    else
-		++icset;
+	    if( h < mLive.size() && mLive[ h ] )
+		remove( h );
 	}
     }
 
+    /*!
+      \return number of scores cached for the node of index i, as state and as successor of other states
+      \note scans all cached successor scores, meant for checking the cache rather than for use in searches
+    */
+    size_t cachedScores( const size_t& i ) const
+    {
+	size_t cached = i < mStateScores.size() && !std::isnan( mStateScores[ i ] ) ? 1 : 0;
+	if( i < mSuccessorScores.size() )
+	    cached += mSuccessorScores[ i ].size();
+	for( const std::vector< std::pair< size_t, double > >& scores : mSuccessorScores )
+	    cached += std::count_if( scores.begin(), scores.end(), [&i] (auto& sscore) { return sscore.first == i; } );
+	return cached;
+    }
+
     //! \todo remove from interface once definitely not needed
     void outOfCounterexamples() {} // don't care for now
 
+    //! \brief drops all counterexamples, cached scores are kept
     void clear()
     {
-	mCSet.clear();
+	mCounterexamples.clear();
+	mLive.clear();
+	mHeap.clear();
+	mMinHeap.clear();
+	mCounterexamplesOfNode.clear();
+	mLiveCount = 0;
     }
 
   private:
-    typedef std::set< ScoredCounterexample< E >, std::greater< ScoredCounterexample< E > > > CSetT;
+    // handles are positions in mCounterexamples, they are only reused once the store ran empty
+    typedef size_t HandleT;
+    typedef std::pair< double, HandleT > HeapItemT;
+
+    static constexpr double NO_SCORE = std::numeric_limits< double >::quiet_NaN();
+    static constexpr size_t NO_SUCCESSOR = std::numeric_limits< size_t >::max();
+
+    //! \return score of istate in [beginCex, endCex), cached depending on the dependence declared by the state heuristic
+    template< typename IterT >
+    double stateScore( const RefinementTree< E >& rtree, const IterT& beginCex, const IterT& endCex, const IterT& istate )
+    {
+	constexpr ScoreDependence dependence = ScoreDependenceOf< SH >::value;
+	if constexpr( dependence == ScoreDependence::PATH )
+	    return mStateH( rtree, beginCex, endCex, istate );
+	else
+	{
+	    const size_t i = graph::value( rtree.graph(), *istate )->index();
+	    if constexpr( dependence == ScoreDependence::STATE )
+	    {
+		if( i >= mStateScores.size() )
+		    mStateScores.resize( std::max( i + 1, 2 * mStateScores.size() ), NO_SCORE );
+		double& score = mStateScores[ i ];
+		if( std::isnan( score ) )
+		    score = mStateH( rtree, beginCex, endCex, istate );
+		return score;
+	    }
+	    else
+	    {
+		IterT inext = istate;
+		++inext;
+		const size_t j = inext == endCex ? NO_SUCCESSOR : graph::value( rtree.graph(), *inext )->index();
+		if( i >= mSuccessorScores.size() )
+		    mSuccessorScores.resize( std::max( i + 1, 2 * mSuccessorScores.size() ) );
+		std::vector< std::pair< size_t, double > >& scores = mSuccessorScores[ i ];
+		auto iscore = std::find_if( scores.begin(), scores.end(), [&j] (auto& sscore) { return sscore.first == j; } );
+		if( iscore != scores.end() )
+		    return iscore->second;
+		scores.push_back( std::make_pair( j, mStateH( rtree, beginCex, endCex, istate ) ) );
+		return scores.back().second;
+	    }
+	}
+    }
+
+    void popHeap()
+    {
+	std::pop_heap( mHeap.begin(), mHeap.end() );
+	mHeap.pop_back();
+    }
+
+    bool isBounded() const { return mCapacity != std::numeric_limits< size_t >::max(); }
+
+    bool isFull() const { return mLiveCount >= mCapacity; }
+
+    //! \return score and handle of the lowest scoring counterexample stored, only maintained for bounded stores
+    const HeapItemT& minLive()
+    {
+	while( !mLive[ mMinHeap.front().second ] )
+	{
+	    std::pop_heap( mMinHeap.begin(), mMinHeap.end(), std::greater< HeapItemT >() );
+	    mMinHeap.pop_back();
+	}
+	return mMinHeap.front();
+    }
+
+    //! \brief drops counterexample h, leaving its entries in the heap and the node index to be skipped later
+    void remove( const HandleT& h )
+    {
+	mLive[ h ] = false;
+	mCounterexamples[ h ].mStates = typename ScoredCounterexample< E >::ScorePathT();
+	if( --mLiveCount == 0 )
+	    clear();
+    }
 
-    CSetT mCSet;
+    std::vector< ScoredCounterexample< E > > mCounterexamples;
+    std::vector< bool > mLive;
+    std::vector< HeapItemT > mHeap;                            // max heap by score, possibly holding removed counterexamples
+    std::vector< HeapItemT > mMinHeap;                         // min heap by score for bounded stores, possibly holding removed counterexamples
+    std::vector< std::vector< HandleT > > mCounterexamplesOfNode;  // by node index, possibly holding removed counterexamples
     SH mStateH;
     CH mCounterexampleH;
+    size_t mCapacity;
+    double mFixedScoreBound;                                   // bound passed on construction
+    double mScoreBound;                                        // bound of the current search
+    size_t mLiveCount;
+    std::vector< double > mScores;                             // scratch scores of the counterexample being found
+    std::vector< double > mStateScores;                        // by node index for heuristics depending on the state only
+    std::vector< std::vector< std::pair< size_t, double > > > mSuccessorScores;  // by node index, scores for each successor index
 };
 
 #endif
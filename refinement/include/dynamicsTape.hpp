@@ -0,0 +1,354 @@
+#ifndef DYNAMICS_TAPE_HPP
+#define DYNAMICS_TAPE_HPP
+
+#include "function/function.hpp"
+#include "expression/formula.hpp"
+#include "geometry/box.hpp"
+
+#include "phaseProfiler.hpp"
+#include "affineImage.hpp"
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+
+/*!
+  \class dynamics lowered once into a flat tape of instructions, evaluated without interpreting the expression tree of the function
+  every instruction writes the register of its position, arguments refer to registers of earlier instructions
+  coordinates and constants are loaded once, products of a register with itself are squares
+  \note functions using operations other than arithmetic and powers are not lowered, those are evaluated by the function itself
+*/
+class DynamicsTape
+{
+  public:
+    typedef Ariadne::Bounds< Ariadne::FloatDP > NumberT;
+
+    explicit DynamicsTape( const Ariadne::EffectiveVectorFunction& f )
+	: mFunction( f )
+	, mArgumentSize( f.argument_size() )
+	, mRegisterOfCoordinate( f.argument_size(), NO_REGISTER )
+	, mCompiled( true )
+    {
+	auto formulae = f( Ariadne::Formula< Ariadne::EffectiveNumber >::identity( mArgumentSize ) );
+	for( size_t i = 0; i < formulae.size() && mCompiled; ++i )
+	    mResults.push_back( emit( formulae[ i ] ) );
+	if( !mCompiled )
+	{
+	    mTape.clear();
+	    mConstants.clear();
+	    mResults.clear();
+	}
+    }
+
+    //! \return true if the function was lowered into a tape
+    bool isCompiled() const { return mCompiled; }
+
+    //! \return number of instructions of the tape
+    size_t size() const { return mTape.size(); }
+
+    //! \return bytes allocated on the heap by the tape, excluding the function
+    size_t heapBytes() const
+    {
+	return mTape.capacity() * sizeof( Instruction ) + mConstants.capacity() * sizeof( NumberT )
+	    + ( mRegisterOfCoordinate.capacity() + mResults.capacity() ) * sizeof( RegisterT );
+    }
+
+    //! \return function the tape was lowered from
+    const Ariadne::EffectiveVectorFunction& function() const { return mFunction; }
+
+    //! \return image of pt
+    Ariadne::ValidatedPoint evaluate( const Ariadne::ValidatedPoint& pt ) const
+    {
+	if( !mCompiled )
+	    return mFunction.evaluate( pt );
+
+	std::vector< NumberT > args( pt.array().begin(), pt.array().end() );
+	const std::vector< NumberT > regs = run( args );
+	Ariadne::ValidatedPoint mapped( mResults.size() );
+	for( size_t i = 0; i < mResults.size(); ++i )
+	    mapped[ i ] = regs[ mResults[ i ] ];
+	return mapped;
+    }
+
+    //! \return over approximation of the image of bx, computed by interval arithmetic
+    template< typename I >
+    Ariadne::UpperBoxType image( const Ariadne::Box< I >& bx ) const
+    {
+	CEGAR_PROFILE_SCOPE( IMAGE );
+	if( !mCompiled )
+	    return Ariadne::image( bx, mFunction );
+
+	std::vector< NumberT > args( bx.dimension() );
+	for( size_t d = 0; d < bx.dimension(); ++d )
+	    args[ d ] = NumberT( bx[ d ].lower(), bx[ d ].upper() );
+	const std::vector< NumberT > regs = run( args );
+	Ariadne::UpperBoxType mapped( mResults.size() );
+	for( size_t i = 0; i < mResults.size(); ++i )
+	    mapped[ i ] = Ariadne::UpperIntervalType( regs[ mResults[ i ] ].lower(), regs[ mResults[ i ] ].upper() );
+	return mapped;
+    }
+
+    /*!
+      \return mean value form of the image of bx, its jacobian enclosed by forward differentiation of the tape over bx
+      \param image box image of bx, the bounding box of the form is intersected with it
+      \note forms of functions not lowered consist of image only
+    */
+    template< typename I >
+    AffineImage affineImage( const Ariadne::Box< I >& bx, const Ariadne::UpperBoxType& image ) const
+    {
+	CEGAR_PROFILE_SCOPE( IMAGE );
+	if( !mCompiled )
+	    return AffineImage( image );
+
+	std::vector< NumberT > args( mArgumentSize ), centre( mArgumentSize ), offsets( mArgumentSize );
+	for( size_t d = 0; d < mArgumentSize; ++d )
+	{
+	    args[ d ] = NumberT( bx[ d ].lower(), bx[ d ].upper() );
+	    centre[ d ] = NumberT( bx[ d ].midpoint(), bx[ d ].midpoint() );
+	    offsets[ d ] = args[ d ] - centre[ d ];
+	}
+	const std::vector< NumberT > centreRegs = run( centre ), jacobianRegs = runJacobian( args );
+	const size_t stride = mArgumentSize + 1;
+	std::vector< NumberT > centreImage( mResults.size() ), jacobian( mResults.size() * mArgumentSize );
+	for( size_t i = 0; i < mResults.size(); ++i )
+	{
+	    centreImage[ i ] = centreRegs[ mResults[ i ] ];
+	    std::copy( &jacobianRegs[ mResults[ i ] * stride + 1 ], &jacobianRegs[ mResults[ i ] * stride + stride ], &jacobian[ i * mArgumentSize ] );
+	}
+	return AffineImage( centreImage, jacobian, offsets, image );
+    }
+
+    //! \class arguments and registers of batched evaluations, kept with their capacity so that batches of similar size do not allocate
+    struct Scratch
+    {
+	size_t heapBytes() const { return ( mArgs.capacity() + mRegs.capacity() ) * sizeof( NumberT ); }
+
+	std::vector< NumberT > mArgs, mRegs;
+    };
+
+    /*!
+      \brief writes the images of all boxes in [beginBoxes, endBoxes) to mapped, running each instruction over all boxes before the next
+      registers of the boxes are stored contiguously for each instruction, so the tape is decoded once per batch instead of once per box,
+      the lanes hold Ariadne bounds evaluated one after the other, as Ariadne rounds each operation
+      \param beginBoxes iterator dereferencing to Ariadne::Box
+      \param mapped output iterator over Ariadne::UpperBoxType, assigned one image per box
+      \param scratch buffers of arguments and registers, e.g. one per thread reused across batches
+    */
+    template< typename IterT, typename OutIterT >
+    void batchImages( IterT beginBoxes, const IterT& endBoxes, OutIterT mapped, Scratch& scratch ) const
+    {
+	CEGAR_PROFILE_SCOPE( IMAGE );
+	if( !mCompiled )
+	{
+	    for( ; beginBoxes != endBoxes; ++beginBoxes, ++mapped )
+		*mapped = Ariadne::image( *beginBoxes, mFunction );
+	    return;
+	}
+
+	const size_t noBoxes = std::distance( beginBoxes, endBoxes );
+	if( noBoxes == 0 )
+	    return;
+	std::vector< NumberT >& args = scratch.mArgs;
+	args.resize( mArgumentSize * noBoxes );
+	for( size_t b = 0; beginBoxes != endBoxes; ++beginBoxes, ++b )
+	{
+	    for( size_t d = 0; d < mArgumentSize; ++d )
+		args[ d * noBoxes + b ] = NumberT( ( *beginBoxes )[ d ].lower(), ( *beginBoxes )[ d ].upper() );
+	}
+	run( args.data(), noBoxes, scratch.mRegs );
+	const std::vector< NumberT >& regs = scratch.mRegs;
+	for( size_t b = 0; b < noBoxes; ++b, ++mapped )
+	{
+	    Ariadne::UpperBoxType img( mResults.size() );
+	    for( size_t i = 0; i < mResults.size(); ++i )
+	    {
+		const NumberT& result = regs[ mResults[ i ] * noBoxes + b ];
+		img[ i ] = Ariadne::UpperIntervalType( result.lower(), result.upper() );
+	    }
+	    *mapped = std::move( img );
+	}
+    }
+
+    //! \brief overload of batchImages returning the images, using scratch buffers of its own
+    template< typename IterT >
+    std::vector< Ariadne::UpperBoxType > batchImages( const IterT& beginBoxes, const IterT& endBoxes ) const
+    {
+	std::vector< Ariadne::UpperBoxType > mapped( std::distance( beginBoxes, endBoxes ) );
+	Scratch scratch;
+	batchImages( beginBoxes, endBoxes, mapped.begin(), scratch );
+	return mapped;
+    }
+
+  private:
+    typedef uint32_t RegisterT;
+
+    static constexpr RegisterT NO_REGISTER = std::numeric_limits< RegisterT >::max();
+
+    enum class Code : uint8_t { CONSTANT, COORDINATE, ADD, SUB, MUL, DIV, NEG, SQR, POW };
+
+    struct Instruction
+    {
+	Code mCode;
+	// registers of the operands, index of the constant or coordinate loaded, or exponent of powers
+	RegisterT mArg1, mArg2;
+    };
+
+    RegisterT push( const Code& code, const RegisterT& arg1, const RegisterT& arg2 = NO_REGISTER )
+    {
+	mTape.push_back( Instruction{ code, arg1, arg2 } );
+	return mTape.size() - 1;
+    }
+
+    //! \return register storing the value of f, NO_REGISTER if f cannot be lowered
+    RegisterT emit( const Ariadne::Formula< Ariadne::EffectiveNumber >& f )
+    {
+	switch( f.op() )
+	{
+	  case Ariadne::OperatorCode::CNST:
+	      mConstants.push_back( NumberT( f.val(), Ariadne::dp ) );
+	      return push( Code::CONSTANT, mConstants.size() - 1 );
+	  case Ariadne::OperatorCode::IND:
+	      if( mRegisterOfCoordinate[ f.ind() ] == NO_REGISTER )
+		  mRegisterOfCoordinate[ f.ind() ] = push( Code::COORDINATE, f.ind() );
+	      return mRegisterOfCoordinate[ f.ind() ];
+	  case Ariadne::OperatorCode::ADD:
+	  case Ariadne::OperatorCode::SUB:
+	  case Ariadne::OperatorCode::MUL:
+	  case Ariadne::OperatorCode::DIV:
+	  {
+	      const RegisterT arg1 = emit( f.arg1() ), arg2 = emit( f.arg2() );
+	      if( !mCompiled )
+		  return NO_REGISTER;
+	      switch( f.op() )
+	      {
+		case Ariadne::OperatorCode::ADD: return push( Code::ADD, arg1, arg2 );
+		case Ariadne::OperatorCode::SUB: return push( Code::SUB, arg1, arg2 );
+		case Ariadne::OperatorCode::DIV: return push( Code::DIV, arg1, arg2 );
+		default: return arg1 == arg2 ? push( Code::SQR, arg1 ) : push( Code::MUL, arg1, arg2 );
+	      }
+	  }
+	  case Ariadne::OperatorCode::POS:
+	      return emit( f.arg() );
+	  case Ariadne::OperatorCode::NEG:
+	  case Ariadne::OperatorCode::SQR:
+	  {
+	      const RegisterT arg = emit( f.arg() );
+	      if( !mCompiled )
+		  return NO_REGISTER;
+	      return push( f.op() == Ariadne::OperatorCode::NEG ? Code::NEG : Code::SQR, arg );
+	  }
+	  case Ariadne::OperatorCode::POW:
+	  {
+	      const RegisterT arg = emit( f.arg() );
+	      if( !mCompiled || f.num() < 0 )
+		  break;
+	      return push( Code::POW, arg, f.num() );
+	  }
+	  default:
+	      break;
+	}
+	mCompiled = false;
+	return NO_REGISTER;
+    }
+
+    //! \return registers after running the tape on the arguments of a single evaluation
+    std::vector< NumberT > run( const std::vector< NumberT >& args ) const
+    {
+	std::vector< NumberT > regs;
+	run( args.data(), 1, regs );
+	return regs;
+    }
+
+    /*!
+      \brief runs the tape on args, storing the registers in regs
+      \param args arguments of noLanes evaluations, args[ d * noLanes + l ] is coordinate d of evaluation l, registers are stored alike
+    */
+    void run( const NumberT* args, const size_t& noLanes, std::vector< NumberT >& regs ) const
+    {
+	regs.resize( mTape.size() * noLanes );
+	for( size_t i = 0; i < mTape.size(); ++i )
+	{
+	    const Instruction& in = mTape[ i ];
+	    NumberT* r = &regs[ i * noLanes ];
+	    const NumberT* x = in.mCode == Code::COORDINATE ? &args[ in.mArg1 * noLanes ]
+		: ( in.mCode == Code::CONSTANT ? nullptr : &regs[ in.mArg1 * noLanes ] );
+	    const NumberT* y = in.mArg2 != NO_REGISTER && in.mCode != Code::POW ? &regs[ in.mArg2 * noLanes ] : nullptr;
+	    switch( in.mCode )
+	    {
+	      case Code::CONSTANT: std::fill( r, r + noLanes, mConstants[ in.mArg1 ] ); break;
+	      case Code::COORDINATE: std::copy( x, x + noLanes, r ); break;
+	      case Code::ADD: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = x[ l ] + y[ l ]; break;
+	      case Code::SUB: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = x[ l ] - y[ l ]; break;
+	      case Code::MUL: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = x[ l ] * y[ l ]; break;
+	      case Code::DIV: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = x[ l ] / y[ l ]; break;
+	      case Code::NEG: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = -x[ l ]; break;
+	      case Code::SQR: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = sqr( x[ l ] ); break;
+	      case Code::POW: for( size_t l = 0; l < noLanes; ++l ) r[ l ] = pow( x[ l ], static_cast< int >( in.mArg2 ) ); break;
+	    }
+	}
+    }
+
+    /*!
+      \return registers and their derivatives by all coordinates over args, forward differentiating the tape
+      register i is stored at i * ( n + 1 ) followed by its n derivatives, n being the number of arguments
+    */
+    std::vector< NumberT > runJacobian( const std::vector< NumberT >& args ) const
+    {
+	const size_t n = mArgumentSize, stride = n + 1;
+	std::vector< NumberT > regs( mTape.size() * stride, NumberT( 0 ) );
+	for( size_t i = 0; i < mTape.size(); ++i )
+	{
+	    const Instruction& in = mTape[ i ];
+	    NumberT* r = &regs[ i * stride ];
+	    const NumberT* x = in.mCode == Code::CONSTANT || in.mCode == Code::COORDINATE ? nullptr : &regs[ in.mArg1 * stride ];
+	    const NumberT* y = in.mArg2 != NO_REGISTER && in.mCode != Code::POW ? &regs[ in.mArg2 * stride ] : nullptr;
+	    switch( in.mCode )
+	    {
+	      case Code::CONSTANT: r[ 0 ] = mConstants[ in.mArg1 ]; break;
+	      case Code::COORDINATE: r[ 0 ] = args[ in.mArg1 ]; r[ 1 + in.mArg1 ] = NumberT( 1 ); break;
+	      case Code::ADD: for( size_t k = 0; k < stride; ++k ) r[ k ] = x[ k ] + y[ k ]; break;
+	      case Code::SUB: for( size_t k = 0; k < stride; ++k ) r[ k ] = x[ k ] - y[ k ]; break;
+	      case Code::MUL:
+		  r[ 0 ] = x[ 0 ] * y[ 0 ];
+		  for( size_t k = 1; k < stride; ++k ) r[ k ] = x[ k ] * y[ 0 ] + x[ 0 ] * y[ k ];
+		  break;
+	      case Code::DIV:
+		  // ( x / y )' = ( x' - ( x / y ) y' ) / y
+		  r[ 0 ] = x[ 0 ] / y[ 0 ];
+		  for( size_t k = 1; k < stride; ++k ) r[ k ] = ( x[ k ] - r[ 0 ] * y[ k ] ) / y[ 0 ];
+		  break;
+	      case Code::NEG: for( size_t k = 0; k < stride; ++k ) r[ k ] = -x[ k ]; break;
+	      case Code::SQR:
+	      {
+		  r[ 0 ] = sqr( x[ 0 ] );
+		  const NumberT twice = x[ 0 ] + x[ 0 ];
+		  for( size_t k = 1; k < stride; ++k ) r[ k ] = twice * x[ k ];
+		  break;
+	      }
+	      case Code::POW:
+	      {
+		  const int e = static_cast< int >( in.mArg2 );
+		  r[ 0 ] = pow( x[ 0 ], e );
+		  if( e == 0 )
+		      break;
+		  const NumberT derivative = NumberT( e ) * pow( x[ 0 ], e - 1 );
+		  for( size_t k = 1; k < stride; ++k ) r[ k ] = derivative * x[ k ];
+		  break;
+	      }
+	    }
+	}
+	return regs;
+    }
+
+    Ariadne::EffectiveVectorFunction mFunction;
+    size_t mArgumentSize;
+    std::vector< Instruction > mTape;
+    std::vector< NumberT > mConstants;
+    std::vector< RegisterT > mRegisterOfCoordinate;
+    std::vector< RegisterT > mResults;
+    bool mCompiled;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef EFFORT_SCHEDULE_HPP
+#define EFFORT_SCHEDULE_HPP
+
+#include "numeric/logical.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+/*!
+  \class escalating effort of validated predicates: a check starts at low effort and is repeated at higher effort only while its result is undecided
+  most boxes are decided at low effort, only boxes close to the boundary of a set need the maximum effort
+*/
+class EffortSchedule
+{
+  public:
+    /*!
+      \param maximum effort of the last attempt
+      \param initial effort of the first attempt, at least 1 and at most maximum
+      \param factor effort is multiplied by after an undecided attempt, at least 2
+    */
+    explicit EffortSchedule( const Ariadne::Effort& maximum, const uint initial = 1, const uint factor = 2 )
+	: mMaximum( std::max< uint >( maximum.work(), 1 ) )
+	, mInitial( std::min( std::max< uint >( initial, 1 ), mMaximum ) )
+	, mFactor( factor )
+    {
+	if( mFactor < 2 )
+	    throw std::logic_error( "effort schedule has to raise effort by a factor of at least 2" );
+    }
+
+    //! \return schedule checking at effort only, as without escalation
+    static EffortSchedule fixed( const Ariadne::Effort& effort ) { return EffortSchedule( effort, effort.work() ); }
+
+    uint initial() const { return mInitial; }
+
+    uint maximum() const { return mMaximum; }
+
+    /*!
+      \brief evaluates check at increasing effort until its result is decided or the maximum effort is reached
+      \param check callable taking an Ariadne::Effort and returning a validated kleenean, lower kleeneans being decided if definitely true only
+      \param work effort to start at, clamped to the schedule, set to the effort of the last attempt
+      \return result of the last attempt
+    */
+    template< typename CheckT >
+    auto decide( const CheckT& check, uint& work ) const -> decltype( check( std::declval< Ariadne::Effort >() ) )
+    {
+	uint w = std::min( std::max( work, mInitial ), mMaximum );
+	while( true )
+	{
+	    auto result = check( Ariadne::Effort( w ) );
+	    if( isDecided( result ) || w >= mMaximum )
+	    {
+		work = w;
+		return result;
+	    }
+	    w = std::min( mMaximum, w * mFactor );
+	}
+    }
+
+    //! \brief evaluates check starting at the initial effort
+    template< typename CheckT >
+    auto decide( const CheckT& check ) const -> decltype( check( std::declval< Ariadne::Effort >() ) )
+    {
+	uint work = mInitial;
+	return decide( check, work );
+    }
+
+  private:
+    template< typename K >
+    static bool isDecided( const K& k )
+    {
+	if constexpr( std::is_same< K, Ariadne::ValidatedKleenean >::value )
+	    return definitely( k ) || definitely( !k );
+	else
+	    return definitely( k );
+    }
+
+    uint mMaximum, mInitial, mFactor;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef GRAPH_SNAPSHOT_HPP
+#define GRAPH_SNAPSHOT_HPP
+
+#include "csrDiGraph.hpp"
+#include "condensation.hpp"
+#include "graphValue.hpp"
+
+#include "numeric/logical.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+/*!
+  \class compact read-only view of a refinement tree graph used during counterexample search
+  stores the graph as CsrDiGraph and the safety and transitive safety of each vertex packed into a byte, copied from the flags of the refinement tree
+  \param G graph type of the refinement tree
+  \param E type of enclosure stored
+*/
+template< typename G, typename E >
+class GraphSnapshot
+{
+  public:
+    typedef graph::CsrDiGraph< G > CsrT;
+    typedef typename CsrT::VertexT IndexT;
+    typedef graph::Condensation< CsrT > CondensationT;
+
+    static constexpr IndexT NO_INDEX = CsrT::NO_VERTEX;
+
+    /*!
+      \brief rebuilds the snapshot from g
+      \param safetyOfIndex safety flags packed by PackedSafety for each value index of g
+    */
+    void assign( const G& g, const std::vector< uint8_t >& safetyOfIndex )
+    {
+	mCsr.assign( g );
+	mFlags.resize( mCsr.size() );
+	for( IndexT i = 0; i < mCsr.size(); ++i )
+	    mFlags[ i ] = safetyOfIndex[ mCsr.value( i )->index() ];
+	mCondensationStale = true;
+    }
+
+    //! \return snapshot of the graph
+    const CsrT& graph() const { return mCsr; }
+
+    size_t size() const { return mCsr.size(); }
+
+    //! \return vertex of the refinement tree graph for index i
+    const typename G::VertexT& node( const IndexT& i ) const { return mCsr.original( i ); }
+
+    //! \return index of the vertex storing val, NO_INDEX if none exists
+    IndexT index( const typename G::ValueT& val ) const { return mCsr.index( val ); }
+
+    //! \return safety of node i at the time the snapshot was taken
+    Ariadne::ValidatedKleenean isSafe( const IndexT& i ) const { return PackedSafety::safe( mFlags[ i ] ); }
+
+    //! \return transitive safety of node i at the time the snapshot was taken
+    Ariadne::ValidatedKleenean isTransSafe( const IndexT& i ) const { return PackedSafety::transSafe( mFlags[ i ] ); }
+
+    /*!
+      \return strongly connected components of the snapshot, computed on first use after the snapshot was rebuilt
+      \note computing them is not thread safe, obtain them before starting parallel work on them
+    */
+    const CondensationT& condensation() const
+    {
+	if( mCondensationStale )
+	{
+	    mCondensation.assign( mCsr );
+	    mCondensationStale = false;
+	}
+	return mCondensation;
+    }
+
+    /*!
+      \brief determines transitive safety of all nodes at once, by a pass over the components in reverse topological order
+      a component is transitively safe if all of its nodes are definitely safe and all components it reaches are transitively safe
+      \return definite transitive safety by component of condensation()
+    */
+    std::vector< bool > transSafeComponents() const
+    {
+	const CondensationT& cond = condensation();
+	std::vector< bool > safe( cond.size() );
+	for( typename CondensationT::ComponentT c = 0; c < cond.size(); ++c )
+	{
+	    auto ms = cond.members( c );
+	    auto ss = cond.successors( c );
+	    safe[ c ] = std::all_of( ms.first, ms.second, [this] (const IndexT& i) { return definitely( isSafe( i ) ); } )
+		&& std::all_of( ss.first, ss.second, [&safe] (const typename CondensationT::ComponentT& d) { return safe[ d ]; } );
+	}
+	return safe;
+    }
+
+    //! \return bytes allocated on the heap
+    size_t heapBytes() const { return mCsr.heapBytes() + mFlags.capacity() + mCondensation.heapBytes(); }
+
+  private:
+    CsrT mCsr;
+    std::vector< uint8_t > mFlags;
+    mutable CondensationT mCondensation;
+    mutable bool mCondensationStale = true;
+};
+
+#endif
@@ -4,110 +4,148 @@
 #include "geometry/box.hpp"
 #include "numeric/logical.hpp"
 
-//! \class abstract base class for value to store in graph
-struct IGraphValue
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+//! \class base class for value to store in graph, identified by a dense index
+//! \note not polymorphic, the outside value is the one with index OUTSIDE_INDEX and all others are inside values
+class IGraphValue
 {
-    virtual ~IGraphValue() = default;
-    
-    virtual bool isInside() const = 0;
+  public:
+    static constexpr size_t OUTSIDE_INDEX = 0;
+
+    bool isInside() const { return mIndex != OUTSIDE_INDEX; }
+
+    //! \return dense index unique among values stored in the same graph, used to locate vertices
+    size_t index() const { return mIndex; }
+
+  protected:
+    explicit IGraphValue( const size_t& index ) : mIndex( index ) {}
+
+    IGraphValue( const IGraphValue& orig ) = default;
+
+    ~IGraphValue() = default;
+
+    IGraphValue& operator =( const IGraphValue& orig ) = default;
+
+    size_t mIndex;
+};
+
+/*!
+  \class safety and transitive safety of a node packed into a byte, used to keep flags of all nodes in a dense array
+  each flag uses two bits, 2 for true, 1 for indeterminate and 0 for false
+*/
+struct PackedSafety
+{
+    static uint8_t pack( const Ariadne::ValidatedKleenean& safe, const Ariadne::ValidatedKleenean& transSafe )
+    {
+	return packKleenean( safe ) | ( packKleenean( transSafe ) << TRANS_SAFE_SHIFT );
+    }
+
+    static Ariadne::ValidatedKleenean safe( const uint8_t& bits ) { return unpackKleenean( bits & KLEENEAN_MASK ); }
+
+    static Ariadne::ValidatedKleenean transSafe( const uint8_t& bits ) { return unpackKleenean( ( bits >> TRANS_SAFE_SHIFT ) & KLEENEAN_MASK ); }
+
+    //! \return bits with transitive safety replaced by transSafe
+    static uint8_t withTransSafe( const uint8_t& bits, const Ariadne::ValidatedKleenean& transSafe )
+    {
+	return ( bits & KLEENEAN_MASK ) | ( packKleenean( transSafe ) << TRANS_SAFE_SHIFT );
+    }
+
+  private:
+    static const uint8_t KLEENEAN_MASK = 3, TRANS_SAFE_SHIFT = 2;
+
+    static uint8_t packKleenean( const Ariadne::ValidatedKleenean& k )
+    {
+	return definitely( k ) ? 2 : ( definitely( !k ) ? 0 : 1 );
+    }
+
+    static Ariadne::ValidatedKleenean unpackKleenean( const uint8_t& bits )
+    {
+	return bits == 2 ? Ariadne::ValidatedKleenean( true )
+	    : ( bits == 0 ? Ariadne::ValidatedKleenean( false ) : Ariadne::ValidatedKleenean( Ariadne::indeterminate ) );
+    }
+};
+
+//! \class volumes of nodes summed by safety, kept up to date by the refinement tree
+struct SafetyVolumes
+{
+    double mSafe = 0;
+    double mUnsafe = 0;
+    double mIndeterminate = 0;
+
+    double total() const { return mSafe + mUnsafe + mIndeterminate; }
+
+    //! \brief adds volume to the sum of safety k, subtracts it if volume is negative
+    void add( const Ariadne::ValidatedKleenean& k, const double& volume )
+    {
+	if( definitely( k ) )
+	    mSafe += volume;
+	else if( definitely( !k ) )
+	    mUnsafe += volume;
+	else
+	    mIndeterminate += volume;
+    }
 };
 
 //! \class value to store in graph of region inside first initial abstraction
+//! \note safety and transitive safety of the region are kept by the refinement tree, see RefinementTree::isSafe
 template< typename EnclosureT >
 class InsideGraphValue : public IGraphValue
 {
   public:
     InsideGraphValue()
-	: mId( -1 )
+	: IGraphValue( NO_INDEX )
 	, mEnclosure()
-	, mSafe( false )
-	, mTransSafe( Ariadne::indeterminate )
     {}
     
-    InsideGraphValue( const unsigned long& id, const EnclosureT& e, const Ariadne::ValidatedKleenean& safe )
-	: mId( id )
+    InsideGraphValue( const unsigned long& id, const EnclosureT& e )
+	: IGraphValue( id + 1 )
 	, mEnclosure( e )
-	, mSafe( safe )
-	, mTransSafe( Ariadne::indeterminate )
     {}
 
     InsideGraphValue( const InsideGraphValue& orig ) = default;
 
-    virtual ~InsideGraphValue() = default;
+    ~InsideGraphValue() = default;
 
     InsideGraphValue& operator =( const InsideGraphValue& orig ) = default;
 
-    bool isInside() const { return true; }
-
-    //! \return unique identifier of this value
-    const unsigned long& id() const { return mId; }
+    //! \return unique identifier of this value, its index shifted by one as index 0 is reserved for the outside value
+    unsigned long id() const { return mIndex - 1; }
 
     //! \return box stored
     const EnclosureT& getEnclosure() const { return mEnclosure; }
 
-    //! \return true if the box stored is completely covered by all constraints, indeterminate if it lies within the initial abstraction but is not covered completely by all constraints and false if it lies outside of the initial abstraction
-    Ariadne::ValidatedKleenean isSafe() const { return mSafe; }
-
-    //! \return true if no unsafe state can be reached, false if unsafe state can be reached, indeterminate if not set
-    Ariadne::ValidatedKleenean isTransSafe() const { return mTransSafe; }
-
     bool operator ==( const InsideGraphValue< EnclosureT >& tv ) const
     {
-	return this->mId == tv.mId;
+	return this->mIndex == tv.mIndex;
     }
 
     //! \brief initializes graph value, required for pooling
-    void init( const unsigned long& id, const EnclosureT& e, const Ariadne::ValidatedKleenean& safe )
+    void init( const unsigned long& id, const EnclosureT& e )
     {
-	this->mId = id;
+	this->mIndex = id + 1;
 	this->mEnclosure = e;
-	this->mSafe = safe;
-	this->mTransSafe = Ariadne::indeterminate;
-    }
-
-    void resetTransSafe()
-    {
-	mTransSafe = Ariadne::indeterminate;
-    }
-
-    void transSafe()
-    {
-	// if( definitely( mTransSafe ) )
-	    // throw std::logic_error( "attempt to set node safe, even though node is already set safe" );
-	mTransSafe = true;
-    }
-
-    void transUnsafe()
-    {
-	if( definitely( mTransSafe ) )
-	    throw std::logic_error( "attempt to set node unsafe, even though node is already set safe" );
-	mTransSafe = false;
     }
 
   private:
-    unsigned long mId;
+    // index of values not initialized yet, inside but not referring to any node
+    static constexpr size_t NO_INDEX = std::numeric_limits< size_t >::max();
+
     EnclosureT mEnclosure;
-    Ariadne::ValidatedKleenean mSafe;
-    Ariadne::ValidatedKleenean mTransSafe;
 };
 
 //! \class value to store in graph of region outside first initial abstractio
 struct OutsideGraphValue : public IGraphValue
 {
-    virtual ~OutsideGraphValue() = default;
-
-    bool isInside() const { return false; }
+    OutsideGraphValue() : IGraphValue( OUTSIDE_INDEX ) {}
 };
 
 template< typename E, typename CharT, typename TraitsT >
 std::basic_ostream< CharT, TraitsT >& operator <<( std::basic_ostream< CharT, TraitsT >& os, const InsideGraphValue< E >& val )
 {
-    os << val.id() << ": ";
-    os << val.getEnclosure() << " (";
-    os << val.isSafe() << ", ";
-    os << val.isTransSafe() << ") ";
-    return os;
-    // return os << val.id() << ": " << val.getEnclosure() << " (" << val.isSafe() << ", " << val.isTransSafe() << ") ";
+    return os << val.id() << ": " << val.getEnclosure() << " ";
 }
 
 template< typename CharT, typename TraitsT >
@@ -7,14 +7,15 @@ template< typename E >
 struct GraphValuePrinter
 {
 
+    //! \param rtree tree keeping the safety of the values printed, has to outlive the function returned
     static std::function< GraphValuePrinter< E >( const typename RefinementTree< E >::MappingT::ValueT& ) >
-    makeFun( bool printId, bool printEnc, bool printLoc, bool printTrans )
+    makeFun( const RefinementTree< E >& rtree, bool printId, bool printEnc, bool printLoc, bool printTrans )
     {
-	return [=] (const typename RefinementTree< E >::MappingT::ValueT& val ) {
-		   return GraphValuePrinter( *val, printId, printEnc, printLoc, printTrans ); };
+	return [=, &rtree] (const typename RefinementTree< E >::MappingT::ValueT& val ) {
+		   return GraphValuePrinter( rtree, *val, printId, printEnc, printLoc, printTrans ); };
     }
     
-    GraphValuePrinter( const IGraphValue& gval, bool printId, bool printEnc, bool printLoc, bool printTrans )
+    GraphValuePrinter( const RefinementTree< E >& rtree, const IGraphValue& gval, bool printId, bool printEnc, bool printLoc, bool printTrans )
 	: mEnc( Ariadne::Vector< typename E::IntervalType >() )
 	, mPrintEnc( printEnc ), mPrintLoc( printLoc ), mPrintTrans( printTrans ), mPrintId( printId )
     {
@@ -22,8 +23,8 @@ struct GraphValuePrinter
 	{
 	    const InsideGraphValue< E >& pIn = static_cast< const InsideGraphValue< E > &>( gval );
 	    mEnc = pIn.getEnclosure();
-	    mLocSafety = pIn.isSafe();
-	    mTransSafety = pIn.isTransSafe();
+	    mLocSafety = rtree.isSafe( pIn );
+	    mTransSafety = rtree.isTransSafe( pIn );
 	    mId = pIn.id();
 	}
 	else
@@ -14,6 +14,7 @@
   double operator ()( const double& a, const double& e )
   accumulating function with accumulated value a, element e
   std::string name() ocnst
+  and may declare double bound( const double& stateBound ) const, bounding the scores of counterexamples whose states score at most stateBound
 */
 
 struct GreatestState
@@ -23,6 +24,12 @@ struct GreatestState
 	return a < e ? e : a;
     }
 
+    //! \return stateBound, a counterexample scores as its highest state
+    double bound( const double& stateBound ) const
+    {
+	return stateBound;
+    }
+
     std::string name() const
     {
 	return "greatest_state";
@@ -0,0 +1,108 @@
+#ifndef GUIDED_SEARCH_HPP
+#define GUIDED_SEARCH_HPP
+
+#include "refinementTree.hpp"
+#include "counterexampleStore.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+/*!
+  \brief best first search for counterexamples, expanding the most promising partial paths first
+  the priority of a node combines the priority of its predecessor with the score the state heuristic assigns to the node on the path from its
+  predecessor by the counterexample heuristic, e.g. with GreatestState paths through the highest scoring states are followed first
+  nodes are claimed by the path first discovering them, as in findCounterexample, possibly unsafe nodes are passed to cstore once discovered
+  \param stateH and counterexampleH heuristics guiding the search, usually those of cstore
+  \param beamWidth number of nodes kept in the frontier, nodes of lowest priority beyond it are dropped and may be discovered again along other paths,
+  0 keeps all nodes
+  \return number of nodes expanded
+  \note without a beam the search reaches the same possibly unsafe nodes as findCounterexample, possibly along longer paths
+  \note priorities see a path up to the node scored only, so they guide the order of expansion while the store scores counterexamples as usual,
+  the search stops once cstore.terminateSearch() holds, e.g. as soon as a bounded store holds counterexamples scoring its bound
+*/
+template< typename E, typename IterT, typename SH, typename CH >
+size_t guidedCounterexample( const RefinementTree< E >& rtree
+			     , const IterT& beginInitial, const IterT& endInitial
+			     , CounterexampleStore< E, SH, CH >& cstore
+			     , SH stateH, CH counterexampleH
+			     , const size_t& beamWidth = 0 )
+{
+    CEGAR_PROFILE_SCOPE( SEARCH );
+    typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+    typedef typename SnapshotT::IndexT IndexT;
+    typedef typename RefinementTree< E >::NodeT NodeT;
+    // priority and node, the frontier is a max heap by priority
+    typedef std::pair< double, IndexT > ItemT;
+
+    const SnapshotT& snap = rtree.snapshot();
+    cstore.updateScoreBound( rtree );
+    std::vector< IndexT > parents( snap.size(), SnapshotT::NO_INDEX );
+    std::vector< ItemT > frontier;
+    std::vector< NodeT > window, cex;
+
+    auto report = [&] (const IndexT& u) {
+	cex.clear();
+	IndexT i = u;
+	for( ; parents[ i ] != i; i = parents[ i ] )
+	    cex.push_back( snap.node( i ) );
+	cex.push_back( snap.node( i ) );
+	std::reverse( cex.begin(), cex.end() );
+	cstore.found( rtree, cex.begin(), cex.end() );
+    };
+    // claims u for the path through pred, initial nodes are their own predecessor
+    auto discover = [&] (const IndexT& u, const IndexT& pred, const double& predPriority) {
+	parents[ u ] = pred;
+	if( possibly( !snap.isSafe( u ) ) )
+	{
+	    report( u );
+	    return;
+	}
+	if( definitely( snap.isTransSafe( u ) ) )
+	    return;
+	window.clear();
+	if( pred != u )
+	    window.push_back( snap.node( pred ) );
+	window.push_back( snap.node( u ) );
+	const double score = stateH( rtree, window.begin(), window.end(), window.end() - 1 );
+	frontier.push_back( ItemT( counterexampleH( predPriority, score ), u ) );
+	std::push_heap( frontier.begin(), frontier.end() );
+    };
+
+    for( IterT iInitial = beginInitial; iInitial != endInitial; ++iInitial )
+    {
+	const IndexT i = snap.index( graph::value( rtree.graph(), *iInitial ) );
+	if( parents[ i ] == SnapshotT::NO_INDEX )
+	    discover( i, i, 0.0 );
+    }
+
+    size_t expanded = 0;
+    while( !frontier.empty() && !cstore.terminateSearch() )
+    {
+	std::pop_heap( frontier.begin(), frontier.end() );
+	const ItemT top = frontier.back();
+	frontier.pop_back();
+	++expanded;
+	for( auto outs = graph::outEdges( snap.graph(), top.second ); outs.first != outs.second; ++outs.first )
+	{
+	    const IndexT img = graph::target( snap.graph(), *outs.first );
+	    if( parents[ img ] == SnapshotT::NO_INDEX )
+		discover( img, top.second, top.first );
+	}
+
+	// the beam is cut back once it holds twice its width, so cutting takes amortized constant time per node
+	if( beamWidth > 0 && frontier.size() > 2 * beamWidth )
+	{
+	    std::nth_element( frontier.begin(), frontier.begin() + beamWidth, frontier.end(), std::greater< ItemT >() );
+	    for( auto idropped = frontier.begin() + beamWidth; idropped != frontier.end(); ++idropped )
+		parents[ idropped->second ] = SnapshotT::NO_INDEX;
+	    frontier.resize( beamWidth );
+	    std::make_heap( frontier.begin(), frontier.end() );
+	}
+    }
+    cstore.outOfCounterexamples();
+    return expanded;
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef INCREMENTAL_SEARCH_HPP
+#define INCREMENTAL_SEARCH_HPP
+
+#include "refinementTree.hpp"
+#include "counterexampleStore.hpp"
+
+#include <vector>
+#include <queue>
+#include <tuple>
+#include <limits>
+#include <functional>
+#include <algorithm>
+
+/*!
+  \class counterexample search that keeps its bfs tree between searches
+  refining a node only drops the exploration through that node, the next search repairs the dropped part starting
+  from the nodes still reached, so its cost depends on the size of the change instead of the size of the abstraction
+  \note refinement only removes transitions, so paths kept remain valid and unexplored nodes cannot become reachable except through new ones
+  \note reports all possibly unsafe nodes reached in each search, as findCounterexample does, but may pick different paths to them
+  \note stops once the store terminates the search, the sources of the exploration left are repaired by the next search
+*/
+template< typename E >
+class IncrementalSearch
+{
+  public:
+    typedef RefinementTree< E > Rtree;
+    typedef typename Rtree::NodeT NodeT;
+
+    /*!
+      \brief drops the exploration through n
+      \note call before refining n, as its neighbourhood in the graph is required
+    */
+    void invalidate( const Rtree& rtree, const NodeT& n )
+    {
+	const KeyT rkey = key( rtree, n );
+	if( !isReached( rkey ) )
+	{
+	    forget( rkey );
+	    return;
+	}
+
+	// drop the subtree of n in the bfs tree, tree edges are graph edges as long as both nodes exist
+	std::vector< KeyT > stack = { rkey };
+	while( !stack.empty() )
+	{
+	    const KeyT k = stack.back();
+	    stack.pop_back();
+	    const NodeT& v = mEntries[ k ].mNode;
+	    for( auto outs = graph::outEdges( rtree.graph(), v ); outs.first != outs.second; ++outs.first )
+	    {
+		const KeyT t = key( rtree, graph::target( rtree.graph(), *outs.first ) );
+		if( t != k && isReached( t ) && mEntries[ t ].mParent == k )
+		{
+		    mEntries[ t ].mParent = NO_KEY;
+		    mPendingNodes.push_back( t );
+		    stack.push_back( t );
+		}
+	    }
+	}
+	mEntries[ rkey ].mParent = NO_KEY;
+
+	// remaining nodes reaching n may reach its refinement
+	for( auto ins = graph::inEdges( rtree.graph(), n ); ins.first != ins.second; ++ins.first )
+	{
+	    const KeyT s = key( rtree, graph::source( rtree.graph(), *ins.first ) );
+	    if( isReached( s ) )
+		mPendingSources.push_back( s );
+	}
+	forget( rkey );
+    }
+
+    /*!
+      \brief reports counterexamples reachable from the initial nodes to cstore, repairing the exploration dropped since the last search
+      unsafe nodes still reached are reported first, then new ones as they are reached until cstore terminates the search
+      \param beginInitial iterator over the current abstraction of the initial set
+    */
+    template< typename IterT, typename SH, typename CH >
+    void find( const Rtree& rtree, const IterT& beginInitial, const IterT& endInitial, CounterexampleStore< E, SH, CH >& cstore )
+    {
+	CEGAR_PROFILE_SCOPE( SEARCH );
+	cstore.updateScoreBound( rtree );
+	QueueT queue;
+	for( IterT iInitial = beginInitial; iInitial != endInitial; ++iInitial )
+	{
+	    const KeyT k = remember( rtree, *iInitial );
+	    if( !isReached( k ) )
+		queue.push( ItemT( 0, k, k ) );
+	}
+	for( const KeyT& s : mPendingSources )
+	{
+	    if( isReached( s ) && isExpanded( rtree, s ) )
+		push( rtree, s, queue );
+	}
+	for( const KeyT& n : mPendingNodes )
+	{
+	    if( !isKnown( n ) || isReached( n ) )
+		continue;
+	    for( auto ins = graph::inEdges( rtree.graph(), mEntries[ n ].mNode ); ins.first != ins.second; ++ins.first )
+	    {
+		const KeyT s = key( rtree, graph::source( rtree.graph(), *ins.first ) );
+		if( isReached( s ) && isExpanded( rtree, s ) )
+		    queue.push( ItemT( mEntries[ s ].mDepth + 1, n, s ) );
+	    }
+	}
+	mPendingSources.clear();
+	mPendingNodes.clear();
+
+	// report unsafe nodes still reached by the kept exploration, dropping the others
+	auto iKeep = mUnsafe.begin();
+	for( const KeyT& u : mUnsafe )
+	{
+	    if( !isReached( u ) )
+	    {
+		mEntries[ u ].mListed = false;
+		continue;
+	    }
+	    *iKeep++ = u;
+	    if( !cstore.terminateSearch() )
+		report( rtree, u, cstore );
+	}
+	mUnsafe.erase( iKeep, mUnsafe.end() );
+
+	while( !queue.empty() && !cstore.terminateSearch() )
+	{
+	    const ItemT item = queue.top();
+	    queue.pop();
+	    const KeyT k = std::get< 1 >( item );
+	    if( isReached( k ) )
+		continue;
+	    Entry& e = mEntries[ k ];
+	    e.mDepth = std::get< 0 >( item );
+	    e.mParent = std::get< 2 >( item );
+
+	    if( possibly( !rtree.isSafe( e.mNode ) ) )
+	    {
+		if( !e.mListed )
+		    mUnsafe.push_back( k );
+		e.mListed = true;
+		report( rtree, k, cstore );
+	    }
+	    else if( possibly( !rtree.isTransSafe( e.mNode ) ) )
+		push( rtree, k, queue );
+	}
+
+	// nodes left in the queue of a terminated search are queued again from their sources by the next search
+	for( ; !queue.empty(); queue.pop() )
+	{
+	    if( std::get< 1 >( queue.top() ) != std::get< 2 >( queue.top() ) )
+		mPendingSources.push_back( std::get< 2 >( queue.top() ) );
+	}
+	cstore.outOfCounterexamples();
+    }
+
+    //! \return true if n is reached by the exploration kept
+    bool isReached( const Rtree& rtree, const NodeT& n ) const
+    {
+	return isReached( key( rtree, n ) );
+    }
+
+    //! \brief forgets all exploration, the next search starts from scratch
+    void clear()
+    {
+	mEntries.clear();
+	mUnsafe.clear();
+	mPendingSources.clear();
+	mPendingNodes.clear();
+	mCounterexample.clear();
+    }
+
+  private:
+    typedef size_t KeyT;
+    // depth, node and predecessor, ordered by depth to keep paths short
+    typedef std::tuple< size_t, KeyT, KeyT > ItemT;
+    typedef std::priority_queue< ItemT, std::vector< ItemT >, std::greater< ItemT > > QueueT;
+
+    static const KeyT NO_KEY = std::numeric_limits< KeyT >::max();
+
+    struct Entry
+    {
+	NodeT mNode;
+	KeyT mParent = NO_KEY;
+	size_t mDepth = 0;
+	bool mKnown = false;
+	bool mListed = false;
+    };
+
+    static KeyT key( const Rtree& rtree, const NodeT& n ) { return graph::value( rtree.graph(), n )->index(); }
+
+    bool isKnown( const KeyT& k ) const { return k < mEntries.size() && mEntries[ k ].mKnown; }
+
+    bool isReached( const KeyT& k ) const { return isKnown( k ) && mEntries[ k ].mParent != NO_KEY; }
+
+    //! \return true if the search continues from k
+    bool isExpanded( const Rtree& rtree, const KeyT& k ) const
+    {
+	const NodeT& n = mEntries[ k ].mNode;
+	return !possibly( !rtree.isSafe( n ) ) && possibly( !rtree.isTransSafe( n ) );
+    }
+
+    KeyT remember( const Rtree& rtree, const NodeT& n )
+    {
+	const KeyT k = key( rtree, n );
+	if( k >= mEntries.size() )
+	    mEntries.resize( std::max( k + 1, 2 * mEntries.size() ) );
+	if( !mEntries[ k ].mKnown )
+	{
+	    mEntries[ k ].mNode = n;
+	    mEntries[ k ].mKnown = true;
+	}
+	return k;
+    }
+
+    void forget( const KeyT& k )
+    {
+	if( k >= mEntries.size() )
+	    return;
+	mEntries[ k ].mNode = NodeT();
+	mEntries[ k ].mKnown = false;
+	mEntries[ k ].mParent = NO_KEY;
+    }
+
+    //! \brief hands the path of the bfs tree to the reached node u to cstore
+    template< typename SH, typename CH >
+    void report( const Rtree& rtree, const KeyT& u, CounterexampleStore< E, SH, CH >& cstore )
+    {
+	CounterexampleT< E >& cex = mCounterexample;
+	cex.clear();
+	KeyT k = u;
+	for( ; mEntries[ k ].mParent != k; k = mEntries[ k ].mParent )
+	    cex.push_back( mEntries[ k ].mNode );
+	cex.push_back( mEntries[ k ].mNode );
+	std::reverse( cex.begin(), cex.end() );
+	cstore.found( rtree, cex.begin(), cex.end() );
+    }
+
+    //! \brief queues all unreached successors of k
+    void push( const Rtree& rtree, const KeyT& k, QueueT& queue )
+    {
+	const size_t depth = mEntries[ k ].mDepth + 1;
+	for( auto outs = graph::outEdges( rtree.graph(), mEntries[ k ].mNode ); outs.first != outs.second; ++outs.first )
+	{
+	    const KeyT t = remember( rtree, graph::target( rtree.graph(), *outs.first ) );
+	    if( !isReached( t ) )
+		queue.push( ItemT( depth, t, k ) );
+	}
+    }
+
+    std::vector< Entry > mEntries;
+    std::vector< KeyT > mUnsafe;
+    std::vector< KeyT > mPendingSources;
+    std::vector< KeyT > mPendingNodes;
+    // path of the counterexample rebuilt last, before handing it to the store
+    CounterexampleT< E > mCounterexample;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef LEAF_INDEX_HPP
+#define LEAF_INDEX_HPP
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstdint>
+
+/*!
+  \class spatial index over the leaves of a refinement, mirroring its split structure
+  every entry stores a box, refined entries keep their box and link to the contiguous entries of their refinement
+  queries only descend into entries possibly overlapping the query, so they cost O(depth + k) for k leaves found
+  \param E type of enclosure stored, refinements have to be contained in the enclosure refined
+  \param T type of value stored at leaves
+*/
+template< typename E, typename T >
+class LeafIndex
+{
+  public:
+    typedef uint32_t EntryT;
+
+    static constexpr EntryT NO_ENTRY = std::numeric_limits< EntryT >::max();
+
+    //! \class leaf to add to the index, identified by a dense key
+    struct Leaf
+    {
+	size_t mKey;
+	E mBox;
+	T mValue;
+    };
+
+    //! \brief resets the index to the single leaf root
+    void reset( const Leaf& root )
+    {
+	mEntries.clear();
+	mEntryOfKey.clear();
+	mLeafCount = 0;
+	addEntry( root );
+    }
+
+    /*!
+      \brief replaces the leaf stored for parentKey by the leaves in [beginLeaves, endLeaves)
+      \param beginLeaves iterator dereferencing to Leaf
+    */
+    template< typename IterT >
+    void split( const size_t& parentKey, IterT beginLeaves, const IterT& endLeaves )
+    {
+	const EntryT parent = entry( parentKey );
+	if( parent == NO_ENTRY || mEntries[ parent ].mChildCount != 0 )
+	    throw std::logic_error( "cannot split entry of index, key does not refer to a leaf" );
+
+	const EntryT firstChild = mEntries.size();
+	for( ; beginLeaves != endLeaves; ++beginLeaves )
+	    addEntry( *beginLeaves );
+
+	Entry& parentEntry = mEntries[ parent ];
+	parentEntry.mFirstChild = firstChild;
+	parentEntry.mChildCount = mEntries.size() - firstChild;
+	parentEntry.mValue = T();
+	mEntryOfKey[ parentKey ] = NO_ENTRY;
+	--mLeafCount;
+    }
+
+    //! \return number of leaves stored
+    size_t size() const { return mLeafCount; }
+
+    /*!
+      \brief calls visit( value ) for every leaf whose box possibly overlaps the query
+      \param overlaps can be called as overlaps( const E& ) and returns true if the box possibly overlaps the query
+    */
+    template< typename OverlapT, typename VisitT >
+    void visitLeaves( const OverlapT& overlaps, VisitT& visit ) const
+    {
+	if( mEntries.empty() )
+	    return;
+
+	std::vector< EntryT > stack = { 0 };
+	while( !stack.empty() )
+	{
+	    const Entry& e = mEntries[ stack.back() ];
+	    stack.pop_back();
+	    if( !overlaps( e.mBox ) )
+		continue;
+	    if( e.mChildCount == 0 )
+		visit( e.mValue );
+	    else
+		for( EntryT c = e.mFirstChild + e.mChildCount; c-- > e.mFirstChild; )
+		    stack.push_back( c );
+	}
+    }
+
+    //! \return values of all leaves whose box possibly overlaps the query
+    template< typename OverlapT >
+    std::vector< T > leaves( const OverlapT& overlaps ) const
+    {
+	std::vector< T > found;
+	auto collect = [&found] (const T& val) { found.push_back( val ); };
+	visitLeaves( overlaps, collect );
+	return found;
+    }
+
+    //! \return number of entries, including those refined
+    size_t entryCount() const { return mEntries.size(); }
+
+    //! \return box of entry e, entries are ordered such that refinements follow the entry refined
+    const E& box( const EntryT& e ) const { return mEntries[ e ].mBox; }
+
+    //! \return first entry of the refinement of e
+    EntryT firstChild( const EntryT& e ) const { return mEntries[ e ].mFirstChild; }
+
+    //! \return number of entries of the refinement of e, 0 for leaves
+    EntryT childCount( const EntryT& e ) const { return mEntries[ e ].mChildCount; }
+
+    //! \return value stored for entry e, only meaningful for leaves
+    const T& value( const EntryT& e ) const { return mEntries[ e ].mValue; }
+
+    //! \return bytes allocated on the heap by the index itself, excluding storage the boxes of entries allocate
+    size_t heapBytes() const { return mEntries.capacity() * sizeof( Entry ) + mEntryOfKey.capacity() * sizeof( EntryT ); }
+
+  private:
+    struct Entry
+    {
+	E mBox;
+	T mValue;
+	EntryT mFirstChild;
+	EntryT mChildCount;
+    };
+
+    EntryT entry( const size_t& key ) const
+    {
+	return key < mEntryOfKey.size() ? mEntryOfKey[ key ] : NO_ENTRY;
+    }
+
+    void addEntry( const Leaf& l )
+    {
+	if( l.mKey >= mEntryOfKey.size() )
+	    mEntryOfKey.resize( std::max( l.mKey + 1, 2 * mEntryOfKey.size() ), NO_ENTRY );
+	mEntryOfKey[ l.mKey ] = mEntries.size();
+	mEntries.push_back( Entry{ l.mBox, l.mValue, NO_ENTRY, 0 } );
+	++mLeafCount;
+    }
+
+    std::vector< Entry > mEntries;
+    std::vector< EntryT > mEntryOfKey;
+    size_t mLeafCount = 0;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define LOCATOR_HPP
 
 #include "refinementTree.hpp"
+#include "counterRandom.hpp"
 
 #include <vector>
 #include <functional>
@@ -9,19 +10,82 @@
 #include <random>
 #include <cmath>
 #include <limits>
+#include <type_traits>
+#include <cstdint>
 
 /* \brief a state heuristic supports 
    template< typename Rtree > double operator ()( const Rtree&, const typename Rtree::NodeT )
    mapping states to real values and
    std::string name() const 
    returing a describing name
+   it may declare static constexpr ScoreDependence scoreDependence to allow caching its scores
+   and template< typename Rtree > double maxScore( const Rtree& ) const bounding the scores of all states, letting bounded searches stop early
 */
 
+//! \brief what the score of a state in a counterexample depends on
+enum class ScoreDependence
+{
+    PATH,      // the whole counterexample or nothing reproducible, never cached
+    STATE,     // only the state, cached per node
+    SUCCESSOR  // the state and its successor in the counterexample, cached per edge
+};
+
+//! \class dependence declared by state heuristic SH, PATH if it declares none
+template< typename SH, typename = void >
+struct ScoreDependenceOf
+{
+    static constexpr ScoreDependence value = ScoreDependence::PATH;
+};
+
+template< typename SH >
+struct ScoreDependenceOf< SH, std::void_t< decltype( SH::scoreDependence ) > >
+{
+    static constexpr ScoreDependence value = SH::scoreDependence;
+};
+
+//! \class whether state heuristic SH declares maxScore for refinement trees Rtree
+template< typename SH, typename Rtree, typename = void >
+struct DeclaresMaxScore : std::false_type {};
+
+template< typename SH, typename Rtree >
+struct DeclaresMaxScore< SH, Rtree, std::void_t< decltype( std::declval< const SH& >().maxScore( std::declval< const Rtree& >() ) ) > >
+    : std::true_type {};
+
+//! \return upper bound on the scores stateH assigns to states of rtree, infinity if it declares no maxScore
+template< typename Rtree, typename SH >
+double maxStateScore( const Rtree& rtree, const SH& stateH )
+{
+    if constexpr( DeclaresMaxScore< SH, Rtree >::value )
+	return stateH.maxScore( rtree );
+    else
+	return std::numeric_limits< double >::infinity();
+}
+
+//! \return largest value of measure over the enclosures of the leaves inside of rtree, 0 if there are none
+template< typename Rtree, typename MeasureT >
+double maxLeafMeasure( const Rtree& rtree, const MeasureT& measure )
+{
+    const typename Rtree::SnapshotT& snap = rtree.snapshot();
+    double greatest = 0;
+    for( typename Rtree::SnapshotT::IndexT i = 0; i < snap.size(); ++i )
+    {
+	auto nval = rtree.nodeValue( snap.node( i ) );
+	if( nval )
+	    greatest = std::max( greatest, measure( nval.value().get().getEnclosure() ) );
+    }
+    return greatest;
+}
+
 class RandomStateValue
 {
   public:
     RandomStateValue()
-	: mRandom( std::random_device()() )
+	: RandomStateValue( std::random_device()() )
+    {}
+
+    //! \param seed of the generator, so runs with equal seeds score states alike
+    explicit RandomStateValue( const std::default_random_engine::result_type& seed )
+	: mRandom( seed )
 	, mDist( std::numeric_limits< double >::min(), std::numeric_limits< double >::max() )
     {}
 
@@ -43,6 +107,8 @@ class RandomStateValue
 
 struct StateVolume
 {
+    static constexpr ScoreDependence scoreDependence = ScoreDependence::STATE;
+
     template< typename Rtree, typename IterT >
     double operator ()( const Rtree& rtree, const IterT& cexBegin, const IterT& cexEnd, const IterT& istate )
     {
@@ -52,6 +118,13 @@ struct StateVolume
 	return 0;
     }
 
+    //! \return volume of the largest leaf, no state scores higher
+    template< typename Rtree >
+    double maxScore( const Rtree& rtree ) const
+    {
+	return maxLeafMeasure( rtree, [] (const typename Rtree::EnclosureT& enc) { return enc.measure().get_d(); } );
+    }
+
     std::string name() const
     {
 	return "state_volume";
@@ -60,6 +133,8 @@ struct StateVolume
 
 struct StateSideLength
 {
+    static constexpr ScoreDependence scoreDependence = ScoreDependence::STATE;
+
     template< typename Rtree, typename IterT >
     double operator ()( const Rtree& rtree, const IterT& cexBegin, const IterT& cexEnd, const IterT& istate )
     {
@@ -69,6 +144,13 @@ struct StateSideLength
 	return 0;
     }
 
+    //! \return largest radius of a leaf, no state scores higher
+    template< typename Rtree >
+    double maxScore( const Rtree& rtree ) const
+    {
+	return maxLeafMeasure( rtree, [] (const typename Rtree::EnclosureT& enc) { return enc.radius().get_d(); } );
+    }
+
     std::string name() const
     {
 	return "state_side_length";
@@ -77,6 +159,8 @@ struct StateSideLength
 
 struct StateVolumeDifference
 {
+    static constexpr ScoreDependence scoreDependence = ScoreDependence::SUCCESSOR;
+
     //! \param endpointFactor factor to multiply volume with if no next state is available
     StateVolumeDifference( const double& endpointFactor ) : mEndpointFactor( endpointFactor ) {}
     
@@ -175,6 +259,11 @@ struct LargestBox
     std::string name() const {return "refine_largest_box"; }
 };
 
+/*!
+  \class selects the state whose sampled points are split most evenly between safe and possibly unsafe ones
+  samples are drawn from counter based streams, one per candidate, so candidates are scored concurrently
+  \param NSamples number of points sampled per state
+*/
 template< size_t NSamples >
 class MaximumEntropy
 {
@@ -183,48 +272,83 @@ class MaximumEntropy
     using Rtree = RefinementTree< Ariadne::Box< IntervalT > >;
 
     MaximumEntropy()
-	: mRandom( std::default_random_engine( std::random_device()() ) )
+	: mRandom( std::random_device()() )
+	, mCall( 0 )
+    {}
+
+    //! \param seed determines all points sampled, e.g. to reproduce runs
+    explicit MaximumEntropy( const uint64_t& seed )
+	: mRandom( seed )
+	, mCall( 0 )
     {}
 
+    //! \return NSamples points uniformly distributed in bx drawn from stream of random, coordinates of a point are consecutive
     template< typename IntervalT >
-    typename Rtree< IntervalT >::EnclosureT randomPointBox( const Ariadne::Box< IntervalT >& bx )
+    static std::vector< double > samplePoints( const Ariadne::Box< IntervalT >& bx, const CounterRandom& random, const uint64_t& stream )
     {
-	auto pt = bx.lower_bounds() + mDist( mRandom ) * bx.upper_bounds();
-
-	Ariadne::Array< Ariadne::ExactIntervalType > intervals( pt.size() );
-	std::transform( pt.array().begin(), pt.array().end(), intervals.begin()
-			, [] (const Ariadne::Approximation< Ariadne::FloatDP >& x) {
-			    return Ariadne::ExactIntervalType( cast_exact( x ), cast_exact( x ) ); } );
-	return typename Rtree< IntervalT >::EnclosureT( Ariadne::Vector( intervals ) );
+	const size_t dim = bx.dimension();
+	std::vector< double > pts( NSamples * dim );
+	for( size_t d = 0; d < dim; ++d )
+	{
+	    const double lower = bx[ d ].lower().get_d(), width = bx[ d ].upper().get_d() - lower;
+	    for( size_t cSample = 0; cSample < NSamples; ++cSample )
+		pts[ cSample * dim + d ] = lower + random.uniform( stream, cSample * dim + d ) * width;
+	}
+	return pts;
     }
 
+    //! \return entropy of the split of points sampled from bx into safe and possibly unsafe ones
     template< typename IntervalT >
-    double safeUnsafeScore( const Rtree< IntervalT >& rtree, const Ariadne::Box< IntervalT >& bx )
+    static double safeUnsafeScore( const Rtree< IntervalT >& rtree, const Ariadne::Box< IntervalT >& bx
+				   , const CounterRandom& random, const uint64_t& stream )
     {
-	uint safe = 0, unsafe = 0;
-	for( uint cSample = 0; cSample < NSamples; ++cSample )
+	const size_t dim = bx.dimension();
+	const std::vector< double > pts = samplePoints( bx, random, stream );
+	const typename Rtree< IntervalT >::EnclosureT& bounds = rtree.initialEnclosure();
+
+	uint safe = 0;
+	Ariadne::Array< Ariadne::ExactIntervalType > intervals( dim );
+	for( size_t cSample = 0; cSample < NSamples; ++cSample )
 	{
-	    auto sample = randomPointBox( bx );
-	    if( definitely( rtree.constraints().covers( Ariadne::Box< IntervalT >( sample ) ) ) )
+	    // points are exact doubles, those outside the bounding box of the safe set are not covered
+	    bool inBounds = true;
+	    for( size_t d = 0; d < dim; ++d )
+	    {
+		const double x = pts[ cSample * dim + d ];
+		inBounds = inBounds && bounds[ d ].lower().get_d() <= x && x <= bounds[ d ].upper().get_d();
+		intervals[ d ] = Ariadne::ExactIntervalType( x, x );
+	    }
+	    if( !inBounds )
+		continue;
+	    const typename Rtree< IntervalT >::EnclosureT sample = typename Rtree< IntervalT >::EnclosureT( Ariadne::Vector( intervals ) );
+	    if( definitely( rtree.effortSchedule().decide( [&rtree, &sample] (const Ariadne::Effort& e) {
+			    return rtree.constraints().covers( sample ).check( e ); } ) ) )
 		++safe;
-	    else
-		++unsafe;
 	}
-	double safeRatio = safe / static_cast< const double& >( NSamples )
-	    , unsafeRatio = unsafe / static_cast< const double& >( NSamples );
-	return -safeRatio*std::log( safeRatio ) - unsafeRatio*std::log( unsafeRatio );
+	return entropy( safe / static_cast< double >( NSamples ) );
     }
 
     template< typename IntervalT, typename IterT >
     NodeRefVec< Rtree< IntervalT > > operator ()( const Rtree< IntervalT >& rtree, IterT ibegin, const IterT& iend )
     {
-	std::vector< double > scores( std::distance( ibegin, iend ) );
-	std::transform( ibegin, iend, scores.begin()
-			, [&rtree, this] (const typename Rtree< IntervalT >::NodeT& n) {
-			    auto nval = rtree.nodeValue( n );
-			    if( !nval )
-				return 0.0;
-			    return safeUnsafeScore( rtree, nval.value().get().getEnclosure() ); } );
+	// states of known safety are split evenly by no sample, so only the others are sampled
+	std::vector< const typename Rtree< IntervalT >::EnclosureT* > boxes;
+	for( IterT istate = ibegin; istate != iend; ++istate )
+	{
+	    auto nval = rtree.nodeValue( *istate );
+	    const Ariadne::ValidatedKleenean safe = rtree.isSafe( *istate );
+	    boxes.push_back( nval && !definitely( safe ) && !definitely( !safe ) ? &nval.value().get().getEnclosure() : nullptr );
+	}
+
+	const uint64_t call = mCall++;
+	const int noStates = boxes.size();
+	std::vector< double > scores( noStates, 0.0 );
+#pragma omp parallel for schedule( dynamic )
+	for( int cState = 0; cState < noStates; ++cState )
+	{
+	    if( boxes[ cState ] )
+		scores[ cState ] = safeUnsafeScore( rtree, *boxes[ cState ], mRandom, ( call << 32 ) | cState );
+	}
 	std::advance( ibegin, std::distance( scores.begin(), std::max_element( scores.begin(), scores.end() ) ) );
 	return { *ibegin };
     }
@@ -232,8 +356,16 @@ class MaximumEntropy
     std::string name() const {return "refine_most_heterogenous_state"; }
 
   private:
-    std::uniform_real_distribution<> mDist;
-    std::default_random_engine mRandom;
+    //! \return binary entropy of ratio, 0 for ratios 0 and 1
+    static double entropy( const double& ratio )
+    {
+	if( ratio <= 0 || ratio >= 1 )
+	    return 0;
+	return -ratio*std::log( ratio ) - ( 1 - ratio )*std::log( 1 - ratio );
+    }
+
+    CounterRandom mRandom;
+    uint64_t mCall;
 };
 
 #endif
@@ -0,0 +1,350 @@
+#ifndef MAPPED_GRAPH_HPP
+#define MAPPED_GRAPH_HPP
+
+#include "refinementTree.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+#include <algorithm>
+
+/*!
+  \class read-only refinement graph stored in a file and accessed through a memory mapping
+  vertices are stored in the order of the graph snapshot of the refinement tree, as fixed width records in separate sections
+  so phases reading only part of the records page in only those, sections in order of the file, each aligned to 8 bytes:
+  - header, followed by lower and upper bounds of the bounding box of the safe set
+  - boxes: lower and upper bound of each dimension for each vertex, NaN for the outside vertex
+  - ids: id of each vertex, NO_ID for the outside vertex
+  - offsets: uint64 into the targets for each vertex and one past the last
+  - targets: uint32 target of each edge, sorted for each source
+  - flags: packed safety of each vertex, see PackedSafety
+  \note numbers are stored in the byte order of the machine writing the file
+*/
+class MappedGraph
+{
+  public:
+    typedef uint32_t VertexT;
+
+    static constexpr VertexT NO_VERTEX = std::numeric_limits< VertexT >::max();
+    static constexpr uint64_t NO_ID = std::numeric_limits< uint64_t >::max();
+
+    explicit MappedGraph( const std::string& path )
+    {
+	const int fd = ::open( path.c_str(), O_RDONLY );
+	if( fd < 0 )
+	    throw std::logic_error( "cannot open mapped graph " + path );
+	struct stat st;
+	if( ::fstat( fd, &st ) != 0 || st.st_size < static_cast< off_t >( sizeof( Header ) ) )
+	{
+	    ::close( fd );
+	    throw std::logic_error( "mapped graph " + path + " too small to contain a header" );
+	}
+	mSize = st.st_size;
+	void* pMapped = ::mmap( nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0 );
+	::close( fd );
+	if( pMapped == MAP_FAILED )
+	    throw std::logic_error( "cannot map graph " + path );
+	mpBase = static_cast< const char* >( pMapped );
+
+	mpHeader = reinterpret_cast< const Header* >( mpBase );
+	if( mpHeader->mMagic != MAGIC || mpHeader->mFileSize != mSize )
+	{
+	    unmap();
+	    throw std::logic_error( "file " + path + " does not contain a mapped graph" );
+	}
+	// every section has to fit between its offset and the next one, so a corrupt header is rejected before any section is read
+	const uint64_t dim = mpHeader->mDimension, nv = mpHeader->mVertexCount, ne = mpHeader->mEdgeCount;
+	if( dim == 0 || dim > MAX_DIMENSION || nv > NO_VERTEX || ne > mSize / sizeof( VertexT ) )
+	{
+	    unmap();
+	    throw std::logic_error( "mapped graph " + path + " declares more dimensions, vertices or edges than it can hold" );
+	}
+	checkSection( path, "bounds", sizeof( Header ), 2 * dim, sizeof( double ), mpHeader->mBoxesOffset );
+	checkSection( path, "boxes", mpHeader->mBoxesOffset, 2 * dim * nv, sizeof( double ), mpHeader->mIdsOffset );
+	checkSection( path, "ids", mpHeader->mIdsOffset, nv, sizeof( uint64_t ), mpHeader->mOffsetsOffset );
+	checkSection( path, "offsets", mpHeader->mOffsetsOffset, nv + 1, sizeof( uint64_t ), mpHeader->mTargetsOffset );
+	checkSection( path, "targets", mpHeader->mTargetsOffset, ne, sizeof( VertexT ), mpHeader->mFlagsOffset );
+	checkSection( path, "flags", mpHeader->mFlagsOffset, nv, sizeof( uint8_t ), mSize );
+
+	mpBounds = section< double >( sizeof( Header ) );
+	mpBoxes = section< double >( mpHeader->mBoxesOffset );
+	mpIds = section< uint64_t >( mpHeader->mIdsOffset );
+	mpOffsets = section< uint64_t >( mpHeader->mOffsetsOffset );
+	mpTargets = section< VertexT >( mpHeader->mTargetsOffset );
+	mpFlags = section< uint8_t >( mpHeader->mFlagsOffset );
+	// the edges of each vertex have to lie within the targets and each target has to be a vertex, so searches index by targets unchecked
+	bool ordered = mpOffsets[ 0 ] == 0 && mpOffsets[ nv ] == ne;
+	for( uint64_t v = 0; v < nv && ordered; ++v )
+	    ordered = mpOffsets[ v ] <= mpOffsets[ v + 1 ];
+	if( !ordered )
+	{
+	    unmap();
+	    throw std::logic_error( "edge offsets of mapped graph " + path + " do not partition its edges" );
+	}
+	if( std::any_of( mpTargets, mpTargets + ne, [nv] (const VertexT& t) { return t >= nv; } ) )
+	{
+	    unmap();
+	    throw std::logic_error( "edge targets of mapped graph " + path + " are not all vertices" );
+	}
+	// sequential phases read sections front to back
+	::madvise( const_cast< char* >( mpBase ), mSize, MADV_SEQUENTIAL );
+    }
+
+    MappedGraph( const MappedGraph& ) = delete;
+    MappedGraph& operator =( const MappedGraph& ) = delete;
+
+    ~MappedGraph() { unmap(); }
+
+    /*!
+      \brief writes the graph of rtree, its boxes and safety to path
+      \note export only: the sections are streamed to the file, but from the graph snapshot of rtree, so the tree has to fit in memory,
+      vertex indices are those of the snapshot
+    */
+    template< typename E >
+    static void write( const RefinementTree< E >& rtree, const std::string& path )
+    {
+	typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+	const SnapshotT& snap = rtree.snapshot();
+	const auto& csr = snap.graph();
+	const uint64_t dim = rtree.initialEnclosure().dimension(), nv = snap.size(), ne = csr.edgeCount();
+
+	Header header;
+	header.mMagic = MAGIC;
+	header.mDimension = dim;
+	header.mVertexCount = nv;
+	header.mEdgeCount = ne;
+	header.mBoxesOffset = align( sizeof( Header ) + 2 * dim * sizeof( double ) );
+	header.mIdsOffset = align( header.mBoxesOffset + 2 * dim * nv * sizeof( double ) );
+	header.mOffsetsOffset = align( header.mIdsOffset + nv * sizeof( uint64_t ) );
+	header.mTargetsOffset = align( header.mOffsetsOffset + ( nv + 1 ) * sizeof( uint64_t ) );
+	header.mFlagsOffset = align( header.mTargetsOffset + ne * sizeof( VertexT ) );
+	header.mFileSize = align( header.mFlagsOffset + nv );
+
+	std::ofstream os( path, std::ios::binary | std::ios::trunc );
+	if( !os )
+	    throw std::logic_error( "cannot write mapped graph " + path );
+	writeRaw( os, header );
+	for( uint64_t d = 0; d < dim; ++d )
+	{
+	    writeRaw( os, rtree.initialEnclosure()[ d ].lower().get_d() );
+	    writeRaw( os, rtree.initialEnclosure()[ d ].upper().get_d() );
+	}
+
+	pad( os, header.mBoxesOffset );
+	for( typename SnapshotT::IndexT v = 0; v < nv; ++v )
+	{
+	    auto vval = rtree.nodeValue( snap.node( v ) );
+	    for( uint64_t d = 0; d < dim; ++d )
+	    {
+		writeRaw( os, vval ? vval.value().get().getEnclosure()[ d ].lower().get_d() : std::nan( "" ) );
+		writeRaw( os, vval ? vval.value().get().getEnclosure()[ d ].upper().get_d() : std::nan( "" ) );
+	    }
+	}
+
+	pad( os, header.mIdsOffset );
+	for( typename SnapshotT::IndexT v = 0; v < nv; ++v )
+	{
+	    auto vval = rtree.nodeValue( snap.node( v ) );
+	    writeRaw< uint64_t >( os, vval ? vval.value().get().id() : NO_ID );
+	}
+
+	pad( os, header.mOffsetsOffset );
+	uint64_t offset = 0;
+	writeRaw( os, offset );
+	for( typename SnapshotT::IndexT v = 0; v < nv; ++v )
+	{
+	    auto outs = csr.outEdges( v );
+	    offset += outs.second - outs.first;
+	    writeRaw( os, offset );
+	}
+
+	pad( os, header.mTargetsOffset );
+	for( typename SnapshotT::IndexT v = 0; v < nv; ++v )
+	{
+	    for( auto outs = csr.outEdges( v ); outs.first != outs.second; ++outs.first )
+		writeRaw< VertexT >( os, csr.target( *outs.first ) );
+	}
+
+	pad( os, header.mFlagsOffset );
+	for( typename SnapshotT::IndexT v = 0; v < nv; ++v )
+	    writeRaw< uint8_t >( os, PackedSafety::pack( snap.isSafe( v ), snap.isTransSafe( v ) ) );
+	pad( os, header.mFileSize );
+	if( !os )
+	    throw std::logic_error( "writing mapped graph " + path + " failed" );
+    }
+
+    //! \return number of vertices, including the outside vertex
+    size_t size() const { return mpHeader->mVertexCount; }
+
+    size_t edgeCount() const { return mpHeader->mEdgeCount; }
+
+    size_t dimension() const { return mpHeader->mDimension; }
+
+    //! \return lower and upper bound of dimension d of the bounding box of the safe set
+    std::pair< double, double > bounds( const size_t& d ) const { return std::make_pair( mpBounds[ 2 * d ], mpBounds[ 2 * d + 1 ] ); }
+
+    //! \return lower and upper bound of dimension d of the box of v, NaN for the outside vertex
+    std::pair< double, double > bounds( const VertexT& v, const size_t& d ) const
+    {
+	const double* pBox = mpBoxes + 2 * dimension() * v;
+	return std::make_pair( pBox[ 2 * d ], pBox[ 2 * d + 1 ] );
+    }
+
+    //! \return true if v is not the outside vertex
+    bool isInside( const VertexT& v ) const { return mpIds[ v ] != NO_ID; }
+
+    //! \return id of the node of the refinement tree stored at v
+    uint64_t id( const VertexT& v ) const { return mpIds[ v ]; }
+
+    Ariadne::ValidatedKleenean isSafe( const VertexT& v ) const { return PackedSafety::safe( mpFlags[ v ] ); }
+
+    Ariadne::ValidatedKleenean isTransSafe( const VertexT& v ) const { return PackedSafety::transSafe( mpFlags[ v ] ); }
+
+    //! \return range of the targets of the edges from v
+    std::pair< const VertexT*, const VertexT* > successors( const VertexT& v ) const
+    {
+	return std::make_pair( mpTargets + mpOffsets[ v ], mpTargets + mpOffsets[ v + 1 ] );
+    }
+
+    /*!
+      \return inside vertices whose box overlaps the box given by lower and upper bounds of each dimension
+      \note scans the boxes section front to back, the file holds no spatial index and building one would read all boxes as well,
+      so queries are meant for locating few regions once, e.g. the initial set before a search
+    */
+    std::vector< VertexT > overlapping( const std::vector< double >& lower, const std::vector< double >& upper ) const
+    {
+	std::vector< VertexT > found;
+	for( VertexT v = 0; v < size(); ++v )
+	{
+	    bool overlaps = isInside( v );
+	    for( size_t d = 0; d < dimension() && overlaps; ++d )
+	    {
+		const std::pair< double, double > b = bounds( v, d );
+		overlaps = b.first <= upper[ d ] && lower[ d ] <= b.second;
+	    }
+	    if( overlaps )
+		found.push_back( v );
+	}
+	return found;
+    }
+
+  private:
+    static constexpr uint64_t MAGIC = 0x4d4150524547ull; // "MAPREG" in ascii
+
+    //! dimensions of graphs accepted on opening, bounding the sizes computed from the header
+    static constexpr uint64_t MAX_DIMENSION = 64;
+
+    struct Header
+    {
+	uint64_t mMagic, mDimension, mVertexCount, mEdgeCount;
+	uint64_t mBoxesOffset, mIdsOffset, mOffsetsOffset, mTargetsOffset, mFlagsOffset, mFileSize;
+    };
+
+    static uint64_t align( const uint64_t& offset ) { return ( offset + 7 ) & ~uint64_t( 7 ); }
+
+    template< typename T >
+    static void writeRaw( std::ostream& os, const T& t )
+    {
+	os.write( reinterpret_cast< const char* >( &t ), sizeof( T ) );
+    }
+
+    //! \brief pads os with zeros up to offset
+    static void pad( std::ostream& os, const uint64_t& offset )
+    {
+	for( uint64_t pos = os.tellp(); pos < offset; ++pos )
+	    os.put( 0 );
+    }
+
+    /*!
+      \brief throws unless count values of width bytes fit between offset and end, offset being aligned and end within the mapping
+      \note unmaps before throwing, as the destructor of a partially constructed graph is not run
+    */
+    void checkSection( const std::string& path, const std::string& name, const uint64_t& offset, const uint64_t& count
+		       , const uint64_t& width, const uint64_t& end )
+    {
+	if( offset % 8 != 0 || offset > end || end > mSize || count > ( end - offset ) / width )
+	{
+	    unmap();
+	    throw std::logic_error( "section " + name + " of mapped graph " + path + " does not fit in the file" );
+	}
+    }
+
+    template< typename T >
+    const T* section( const uint64_t& offset ) const { return reinterpret_cast< const T* >( mpBase + offset ); }
+
+    void unmap()
+    {
+	if( mpBase )
+	    ::munmap( const_cast< char* >( mpBase ), mSize );
+	mpBase = nullptr;
+    }
+
+    const char* mpBase = nullptr;
+    size_t mSize = 0;
+    const Header* mpHeader = nullptr;
+    const double* mpBounds = nullptr;
+    const double* mpBoxes = nullptr;
+    const uint64_t* mpIds = nullptr;
+    const uint64_t* mpOffsets = nullptr;
+    const MappedGraph::VertexT* mpTargets = nullptr;
+    const uint8_t* mpFlags = nullptr;
+};
+
+/*!
+  \brief breadth first search for a shortest path from the initial vertices to a possibly unsafe vertex, as findCounterexample on a refinement tree
+  only continues through vertices that are not possibly unsafe and possibly not transitively safe
+  \param beginInitial iterator over the vertices of the abstraction of the initial set
+  \return path of vertices ending in a possibly unsafe vertex, empty if none is reachable
+*/
+template< typename IterT >
+std::vector< MappedGraph::VertexT > findMappedCounterexample( const MappedGraph& g, IterT beginInitial, const IterT& endInitial )
+{
+    typedef MappedGraph::VertexT VertexT;
+    std::vector< VertexT > parent( g.size(), MappedGraph::NO_VERTEX );
+    std::deque< VertexT > queue;
+    for( ; beginInitial != endInitial; ++beginInitial )
+    {
+	if( parent[ *beginInitial ] == MappedGraph::NO_VERTEX )
+	{
+	    parent[ *beginInitial ] = *beginInitial;
+	    queue.push_back( *beginInitial );
+	}
+    }
+
+    while( !queue.empty() )
+    {
+	const VertexT v = queue.front();
+	queue.pop_front();
+	if( possibly( !g.isSafe( v ) ) )
+	{
+	    std::vector< VertexT > path = { v };
+	    for( VertexT u = v; parent[ u ] != u; u = parent[ u ] )
+		path.push_back( parent[ u ] );
+	    std::reverse( path.begin(), path.end() );
+	    return path;
+	}
+	if( !possibly( !g.isTransSafe( v ) ) )
+	    continue;
+	for( auto succs = g.successors( v ); succs.first != succs.second; ++succs.first )
+	{
+	    if( parent[ *succs.first ] == MappedGraph::NO_VERTEX )
+	    {
+		parent[ *succs.first ] = v;
+		queue.push_back( *succs.first );
+	    }
+	}
+    }
+    return std::vector< VertexT >();
+}
+
+#endif
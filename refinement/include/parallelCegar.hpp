@@ -0,0 +1,150 @@
+#ifndef PARALLEL_CEGAR_HPP
+#define PARALLEL_CEGAR_HPP
+
+#include "cegar.hpp"
+
+#include <vector>
+#include <optional>
+
+#include <omp.h>
+
+/*!
+  \brief groups initial nodes by the regions of the abstraction a counterexample search from them explores
+  a node is expanded if it is definitely safe and not definitely transitively safe, as in findCounterexample, nodes possibly unsafe end a counterexample
+  initial nodes are in one group if the regions they expand meet, possibly through other initial nodes
+  \return groups of the initial nodes, searching each group on its own finds the counterexamples of the whole search
+  \note counterexamples of different groups share terminal nodes only, such as the outside node
+*/
+template< typename E, typename IterT >
+std::vector< std::vector< typename RefinementTree< E >::NodeT > > searchComponents( const RefinementTree< E >& rtree
+										     , IterT beginInitial, const IterT& endInitial )
+{
+    typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+    typedef typename SnapshotT::IndexT IndexT;
+
+    const SnapshotT& snap = rtree.snapshot();
+    // union find over the initial nodes, labels of the snapshot vertices refer to the initial node whose search claimed them
+    std::vector< IndexT > label( snap.size(), SnapshotT::NO_INDEX ), initial;
+    std::vector< size_t > parent;
+    auto find = [&parent] (size_t c) {
+	while( parent[ c ] != c )
+	    c = parent[ c ] = parent[ parent[ c ] ];
+	return c; };
+    auto merge = [&parent, &find] (const size_t& c, const size_t& d) { parent[ find( c ) ] = find( d ); };
+    auto expands = [&snap] (const IndexT& i) { return definitely( snap.isSafe( i ) ) && possibly( !snap.isTransSafe( i ) ); };
+
+    std::vector< IndexT > frontier;
+    for( ; beginInitial != endInitial; ++beginInitial )
+    {
+	const IndexT i = snap.index( graph::value( rtree.graph(), *beginInitial ) );
+	if( label[ i ] != SnapshotT::NO_INDEX )
+	    continue;
+	label[ i ] = parent.size();
+	parent.push_back( parent.size() );
+	initial.push_back( i );
+	frontier.push_back( i );
+    }
+    while( !frontier.empty() )
+    {
+	const IndexT boundary = frontier.back();
+	frontier.pop_back();
+	if( !expands( boundary ) )
+	    continue;
+	for( auto outs = graph::outEdges( snap.graph(), boundary ); outs.first != outs.second; ++outs.first )
+	{
+	    const IndexT img = graph::target( snap.graph(), *outs.first );
+	    if( label[ img ] == SnapshotT::NO_INDEX )
+	    {
+		label[ img ] = label[ boundary ];
+		frontier.push_back( img );
+	    }
+	    else if( expands( img ) )
+		merge( label[ img ], label[ boundary ] );
+	}
+    }
+
+    std::vector< std::vector< typename RefinementTree< E >::NodeT > > components;
+    std::vector< size_t > componentOf( parent.size(), parent.size() );
+    for( size_t c = 0; c < parent.size(); ++c )
+    {
+	size_t& comp = componentOf[ find( c ) ];
+	if( comp == parent.size() )
+	{
+	    comp = components.size();
+	    components.emplace_back();
+	}
+	components[ comp ].push_back( snap.node( initial[ c ] ) );
+    }
+    return components;
+}
+
+/*!
+  \brief runs cegar with the search and check of each component of the initial image, see searchComponents, run concurrently
+  each round, every component is searched with a counterexample store of its own and its best counterexample is checked by the thread searching it,
+  components are scheduled dynamically so threads finishing small components take over the remaining ones
+  the nodes picked by the state heuristic for all components are then refined at once, so the tree is only modified between rounds
+  \param stateH and counterexampleH copied for each component
+  \note termination is checked once per round, observers are not supported
+  \return pair of kleenean describing safety and sequence of nodes that forms a trajectory starting from the initial set, as cegar
+*/
+template< typename E, typename RefinementT, typename SH, typename CH, typename TermT >
+std::pair< Ariadne::ValidatedKleenean, CounterexampleT< E > > parallelCegar( RefinementTree< E >& rtree
+									     , const Ariadne::BoundedConstraintSet& initialSet
+									     , const Ariadne::Effort& effort
+									     , RefinementT refinement
+									     , const SH& stateH
+									     , const CH& counterexampleH
+									     , TermT termination )
+{
+    typedef RefinementTree< E > Rtree;
+
+    InitialImage< E > initialImage( rtree, initialSet, effort );
+    // search buffers of each thread are kept between rounds
+    std::vector< SearchBuffers< E > > buffers( omp_get_max_threads() );
+    termination.start( rtree );
+
+    for( bool terminate = false; !terminate; terminate = termination( rtree ) )
+    {
+	// the snapshot is rebuilt before the components are searched concurrently
+	rtree.snapshot();
+	const std::vector< std::vector< typename Rtree::NodeT > > components = searchComponents( rtree, initialImage.begin(), initialImage.end() );
+	const int noComponents = components.size();
+	std::vector< std::optional< std::pair< CounterexampleT< E >, typename Rtree::NodeT > > > found( noComponents );
+	std::vector< Ariadne::ValidatedUpperKleenean > safeties( noComponents, true );
+#pragma omp parallel for schedule( dynamic ) if( noComponents > 1 )
+	for( int c = 0; c < noComponents; ++c )
+	{
+	    CounterexampleStore< E, SH, CH > counters( stateH, counterexampleH );
+	    findCounterexample( rtree, components[ c ].begin(), components[ c ].end(), counters, buffers[ omp_get_thread_num() ] );
+	    if( !counters.hasCounterexample() )
+		continue;
+	    found[ c ] = counters.obtain();
+	    safeties[ c ] = isCounterexampleSafe( rtree, found[ c ]->first, initialSet, effort );
+	}
+
+	std::vector< typename Rtree::NodeT > refinable;
+	for( int c = 0; c < noComponents; ++c )
+	{
+	    if( !found[ c ] )
+		continue;
+	    if( definitely( !safeties[ c ] ) )
+		return std::make_pair( Ariadne::ValidatedKleenean( false ), found[ c ]->first );
+	    const typename Rtree::NodeT& refine = found[ c ]->second;
+	    if( rtree.nodeValue( refine ) && possibly( rtree.isSafe( refine ) )
+		&& std::none_of( refinable.begin(), refinable.end(), [&] (auto& n) { return rtree.equal( n, refine ); } ) )
+		refinable.push_back( refine );
+	}
+	if( std::none_of( found.begin(), found.end(), [] (auto& f) { return f.has_value(); } ) )
+	    return std::make_pair( Ariadne::ValidatedKleenean( true ), CounterexampleT< E >() );
+
+	std::vector< typename InitialImage< E >::Relation > relations;
+	for( const typename Rtree::NodeT& refine : refinable )
+	    relations.push_back( initialImage.remove( refine ) );
+	auto refinedNodes = rtree.refine( refinable.begin(), refinable.end(), refinement );
+	for( uint i = 0; i < refinedNodes.size(); ++i )
+	    initialImage.add( relations[ i ], refinedNodes[ i ].begin(), refinedNodes[ i ].end() );
+    }
+    return std::make_pair( Ariadne::ValidatedKleenean( Ariadne::indeterminate ), CounterexampleT< E >() );
+}
+
+#endif
@@ -4,6 +4,11 @@
 #include "geometry/box.hpp"
 
 #include <random>
+#include <vector>
+#include <string>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
 
 /*
   Refinement classes represent a procedure for subdividing enclosures of one type into smaller enclosures of the same type.
@@ -31,12 +36,133 @@ struct LargestSideRefiner
     std::string name() const { return std::string( "largest_side_refiner" ); }
 };
 
+/*!
+  \return k intervals of equal width covering iv, neighbouring intervals share their exact boundary
+*/
+inline std::vector< Ariadne::ExactIntervalType > splitInterval( const Ariadne::ExactIntervalType& iv, const uint& k )
+{
+    std::vector< Ariadne::ExactIntervalType > parts;
+    parts.reserve( k );
+    Ariadne::Value< Ariadne::FloatDP > lower = iv.lower();
+    for( uint i = 1; i < k; ++i )
+    {
+	Ariadne::Value< Ariadne::FloatDP > upper = cast_exact( iv.lower() + ( static_cast< double >( i ) / k ) * iv.width() );
+	parts.push_back( Ariadne::ExactIntervalType( lower, upper ) );
+	lower = upper;
+    }
+    parts.push_back( Ariadne::ExactIntervalType( lower, iv.upper() ) );
+    return parts;
+}
+
+//! \return boxes of the grid with parts[ d ] as intervals along dimension d
+inline std::vector< Ariadne::ExactBoxType > gridBoxes( const Ariadne::ExactBoxType& b, const std::vector< std::vector< Ariadne::ExactIntervalType > >& parts )
+{
+    std::vector< Ariadne::ExactBoxType > grid = { b };
+    for( uint d = 0; d < parts.size(); ++d )
+    {
+	std::vector< Ariadne::ExactBoxType > split;
+	split.reserve( grid.size() * parts[ d ].size() );
+	for( auto& bx : grid )
+	{
+	    for( auto& iv : parts[ d ] )
+	    {
+		split.push_back( bx );
+		split.back()[ d ] = iv;
+	    }
+	}
+	grid.swap( split );
+    }
+    return grid;
+}
+
+/*!
+  \class refine into a grid of K parts of equal width along every dimension, i.e. K^d boxes in one refinement
+  replaces a sequence of bisections, so a state shrinks by a factor of K along each side in a single refinement
+*/
+template< uint K >
+struct GridRefiner
+{
+    static_assert( K > 1, "grid refinement needs at least two parts along each dimension" );
+
+    std::vector< Ariadne::ExactBoxType > operator ()( const Ariadne::ExactBoxType& b ) const
+    {
+	std::vector< std::vector< Ariadne::ExactIntervalType > > parts;
+	for( uint d = 0; d < b.dimension(); ++d )
+	    parts.push_back( splitInterval( b[ d ], K ) );
+	return gridBoxes( b, parts );
+    }
+
+    std::string name() const { return std::string( "grid_refiner_" ) + std::to_string( K ); }
+};
+
+/*!
+  \class refine into a grid with a number of parts of equal width given for each dimension at runtime
+  \note used to build initial abstractions at a given resolution
+*/
+class UniformGridRefiner
+{
+  public:
+    //! \param resolution number of parts for each dimension
+    explicit UniformGridRefiner( const std::vector< uint >& resolution ) : mResolution( resolution ) {}
+
+    std::vector< Ariadne::ExactBoxType > operator ()( const Ariadne::ExactBoxType& b ) const
+    {
+	if( mResolution.size() != b.dimension() )
+	    throw std::logic_error( "grid resolution needs one number of parts for each dimension" );
+	std::vector< std::vector< Ariadne::ExactIntervalType > > parts;
+	for( uint d = 0; d < b.dimension(); ++d )
+	    parts.push_back( splitInterval( b[ d ], std::max< uint >( mResolution[ d ], 1 ) ) );
+	return gridBoxes( b, parts );
+    }
+
+    std::string name() const { return std::string( "uniform_grid_refiner" ); }
+
+  private:
+    std::vector< uint > mResolution;
+};
+
+//! \class bisect along all dimensions, i.e. 2^d boxes in one refinement
+typedef GridRefiner< 2 > BisectAllRefiner;
+
+/*!
+  \class refine into K parts of equal width along each of the D widest dimensions, i.e. K^D boxes in one refinement
+  \note with D = 1 a k-ary version of LargestSideRefiner
+*/
+template< uint K, uint D = 1 >
+struct WidestSidesRefiner
+{
+    static_assert( K > 1 && D > 0, "refinement needs at least two parts along at least one dimension" );
+
+    std::vector< Ariadne::ExactBoxType > operator ()( const Ariadne::ExactBoxType& b ) const
+    {
+	// dimensions ordered by decreasing width, ties by index
+	std::vector< uint > dims( b.dimension() );
+	std::iota( dims.begin(), dims.end(), 0 );
+	std::stable_sort( dims.begin(), dims.end(), [&b] (const uint& i, const uint& j) {
+		return b[ i ].width().get_d() > b[ j ].width().get_d(); } );
+
+	std::vector< std::vector< Ariadne::ExactIntervalType > > parts( b.dimension() );
+	for( uint d = 0; d < b.dimension(); ++d )
+	    parts[ d ] = { b[ d ] };
+	for( uint i = 0; i < std::min< uint >( D, dims.size() ); ++i )
+	    parts[ dims[ i ] ] = splitInterval( b[ dims[ i ] ], K );
+	return gridBoxes( b, parts );
+    }
+
+    std::string name() const { return std::string( "widest_sides_refiner_" ) + std::to_string( K ) + "_" + std::to_string( D ); }
+};
+
 class RandomRefiner
 {
   public:
     RandomRefiner( const double& minFrac, const double& maxFrac )
+	: RandomRefiner( minFrac, maxFrac, std::random_device()() )
+    {}
+
+    //! \param seed of the generator, so runs with equal seeds split boxes alike
+    RandomRefiner( const double& minFrac, const double& maxFrac, const std::default_random_engine::result_type& seed )
 	: mFracDist( minFrac, maxFrac )
-	, mRandom( std::random_device()() )
+	, mRandom( seed )
     {}
 
     std::string name() const {return std::string( "random_position_refiner" ); }
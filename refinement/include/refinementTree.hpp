@@ -2,11 +2,20 @@
 #define REFINEMENT_TREE_HPP
 
 #include "adjacencyDiGraph.hpp"
+#include "indexDiGraph.hpp"
+#include "visitSet.hpp"
 #include "depthFirstSearch.hpp"
 #include "refinement.hpp"
 #include "treeValue.hpp"
 #include "graphValue.hpp"
+#include "graphSnapshot.hpp"
+#include "leafIndex.hpp"
 #include "objectPool.hpp"
+#include "phaseProfiler.hpp"
+#include "dynamicsTape.hpp"
+#include "affineImage.hpp"
+#include "effortSchedule.hpp"
+#include "memoryUsage.hpp"
 
 #include "geometry/box.hpp"
 #include "geometry/function_set.hpp"
@@ -19,6 +28,12 @@
 #include <algorithm>
 #include <limits>
 #include <memory>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <omp.h>
 
 template< typename E > class NodeEqual;
 template< typename E > class NodeHash;
@@ -32,12 +47,62 @@ class RefinementTree
 {
   public:
     typedef E EnclosureT;
-    // use shared_ptr because data structures require copy constructibility
-    // refinement tree: stores pointers to values that vary depending on whether they are stored in leafs or interior nodes
-
     // mapping graph: stores pointers to values that are either an "always-unsafe-node" or regular node storing a tree node
-    typedef graph::AdjacencyDiGraph< IGraphValue*, graph::VecMap, graph::InVec, graph::InVec > MappingT;
+    // vertices are index handles, so copies of nodes in paths, images and counterexamples are plain loads and stores
+    typedef graph::IndexDiGraph< IGraphValue*, graph::IndexMap, graph::HashVec, graph::HashVec > MappingT;
     typedef typename MappingT::VertexT NodeT;
+    typedef GraphSnapshot< MappingT, E > SnapshotT;
+    typedef LeafIndex< E, NodeT > LeafIndexT;
+    // set of nodes indexed by their ids, the outside node having its own slot
+    typedef graph::VisitSet< MappingT > VisitSetT;
+
+    /*!
+      \class range over the nodes adjacent to a node, iterating the edges stored in the graph in place
+      \param EdgeIterT iterator over out-edges or in-edges of the graph
+      \param OUT true if the range iterates targets of out-edges, false if it iterates sources of in-edges
+      \note invalidated by modifying the edges of the node
+    */
+    template< typename EdgeIterT, bool OUT >
+    class AdjacentRange
+    {
+      public:
+	class iterator
+	{
+	  public:
+	    typedef std::forward_iterator_tag iterator_category;
+	    typedef NodeT value_type;
+	    typedef std::ptrdiff_t difference_type;
+	    typedef const NodeT* pointer;
+	    typedef NodeT reference;
+
+	    iterator() = default;
+
+	    iterator( const MappingT& g, const EdgeIterT& iEdge ) : mpGraph( &g ), mEdge( iEdge ) {}
+
+	    NodeT operator *() const { return OUT ? graph::target( *mpGraph, *mEdge ) : graph::source( *mpGraph, *mEdge ); }
+
+	    iterator& operator ++() { ++mEdge; return *this; }
+	    iterator operator ++( int ) { iterator old( *this ); ++mEdge; return old; }
+
+	    bool operator ==( const iterator& other ) const { return mEdge == other.mEdge; }
+	    bool operator !=( const iterator& other ) const { return mEdge != other.mEdge; }
+	  private:
+	    const MappingT* mpGraph = nullptr;
+	    EdgeIterT mEdge;
+	};
+
+	AdjacentRange( const MappingT& g, const std::pair< EdgeIterT, EdgeIterT >& edges ) : mBegin( g, edges.first ), mEnd( g, edges.second ) {}
+
+	iterator begin() const { return mBegin; }
+	iterator end() const { return mEnd; }
+
+	bool empty() const { return mBegin == mEnd; }
+	size_t size() const { return std::distance( mBegin, mEnd ); }
+      private:
+	iterator mBegin, mEnd;
+    };
+    typedef AdjacentRange< typename MappingT::InIterT, false > PreimageRangeT;
+    typedef AdjacentRange< typename MappingT::OutIterT, true > PostimageRangeT;
 
     class NodeComparator
     {
@@ -47,17 +112,8 @@ class RefinementTree
 	bool operator ()( const typename RefinementTree< E >::NodeT& n1
 			  , const typename RefinementTree< E >::NodeT& n2 ) const
 	{
-	    auto otval1 = mRtree.get().nodeValue( n1 )
-		, otval2 = mRtree.get().nodeValue( n2 );
-	    // always unsafe node is always equal to always unsafe node
-	    if( !otval1 && !otval2 )
-		return false;
-	    if( !otval1 )
-		return false;
-	    if( !otval2 )
-		return true;
-
-	    return otval1.value().get().id() < otval2.value().get().id();
+	    // ids of inside nodes are index - 1, the always unsafe node with index 0 wraps to compare greater than all others
+	    return graph::value( mRtree.get().graph(), n1 )->index() - 1 < graph::value( mRtree.get().graph(), n2 )->index() - 1;
 	}
 
       private:
@@ -65,11 +121,11 @@ class RefinementTree
     };
 
     template< typename SpaceT >
-    static std::function< Ariadne::ValidatedLowerKleenean( const EnclosureT&, const SpaceT& ) > mDummyInsidePredicate = [] (auto& enc, auto& s) {
+    static constexpr auto mDummyInsidePredicate = [] (const EnclosureT& enc, const SpaceT& s) -> Ariadne::ValidatedLowerKleenean {
 	throw std::logic_error( "this predicate should have never been called" ); };
 
     template< typename SpaceT >
-    static std::function< Ariadne::ValidatedUpperKleenean( const EnclosureT&, const SpaceT& ) > mDummyOutsidePredicate = [] (auto& enc, auto& s) {
+    static constexpr auto mDummyOutsidePredicate = [] (const EnclosureT& enc, const SpaceT& s) -> Ariadne::ValidatedUpperKleenean {
 	throw std::logic_error( "this predicate should have never been called" ); };
 
     static Ariadne::ExactBoxType upper2ExactBox( const Ariadne::UpperBoxType& ub )
@@ -92,16 +148,27 @@ class RefinementTree
 		    )
 	: mSafeSet( safeSet )
 	, mDynamics( dynamics )
+	, mTape( dynamics )
 	, mEffort( effort )
+	, mSchedule( effort )
 	, mValuePool( poolChunkSize )
 	, mNodeIdCounter( 0 )
 	, mInitialEnclosure( upper2ExactBox( safeSet.bounding_box() ) )
+	, mImageEnclosure( ImageEnclosure::BOX )
+	, mSnapshotStale( true )
     {
+	if( safeSet.constraints().size() > 1 )
+	{
+	    for( size_t k = 0; k < std::min< size_t >( safeSet.constraints().size(), MAX_TRACKED_CONSTRAINTS ); ++k )
+		mConstraintSets.push_back( Ariadne::ConstraintSet( Ariadne::List< Ariadne::EffectiveConstraint >( { safeSet.constraints()[ k ] } ) ) );
+	}
+
 	// set up root
 	NodeT initialNode = addState( mInitialEnclosure );
+	mLeafIndex.reset( { nodeValue( initialNode ).value().get().id(), mInitialEnclosure, initialNode } );
 
 	// add outside node
-	auto iAddedOutside = graph::addVertex( mMapping, new OutsideGraphValue() );
+	auto iAddedOutside = graph::addVertex( mMapping, static_cast< IGraphValue* >( &mOutsideValue ) );
 	if( iAddedOutside == graph::vertices( mMapping ).second )
 	    throw std::logic_error( "always unsafe node added but iterator to end returned" );
 	mOutsideNode = *iAddedOutside;
@@ -113,8 +180,132 @@ class RefinementTree
 	if( possibly( isReachable( initialNode, mOutsideNode ) ) )
 	    addEdge( mMapping, initialNode, mOutsideNode );
 
-	std::vector< NodeT > initialSingle = {initialNode};
-	setTransitiveSafety( initialSingle.begin(), initialSingle.end() );
+	updateTransitiveSafety( { initialNode } );
+    }
+
+    /*!
+      \brief initial abstraction using a uniform grid over the bounding box of the safe set
+      all images of the grid are evaluated in batches, edges are found by the spatial index and transitive safety is determined once for the whole grid
+      \param resolution number of grid cells along each dimension
+    */
+    RefinementTree( const Ariadne::BoundedConstraintSet& safeSet
+		    , const Ariadne::EffectiveVectorFunction& dynamics
+		    , const Ariadne::Effort effort
+		    , const std::vector< uint >& resolution
+		    , const uint poolChunkSize = 250
+		    )
+	: RefinementTree( safeSet, dynamics, effort, poolChunkSize )
+    {
+	std::vector< NodeT > roots = insideLeaves();
+	UniformGridRefiner grid( resolution );
+	refine( roots.begin(), roots.end(), grid );
+    }
+
+    /*!
+      \brief warm starts from the partition of a snapshot written by save, possibly for different dynamics or safe set
+      the refinements of the snapshot are replayed, each generation in one batched refinement, so images, edges and safety
+      are determined for the given dynamics and safe set, the snapshot holds none of them, images are enclosed as by the tree saved
+      \param snapshot stream positioned at a snapshot, the root of its partition has to be the bounding box of safeSet
+    */
+    RefinementTree( const Ariadne::BoundedConstraintSet& safeSet
+		    , const Ariadne::EffectiveVectorFunction& dynamics
+		    , const Ariadne::Effort effort
+		    , std::istream& snapshot
+		    , const uint poolChunkSize = 250
+		    )
+	: RefinementTree( safeSet, dynamics, effort, poolChunkSize )
+    {
+	if( readRaw< uint64_t >( snapshot ) != SNAPSHOT_MAGIC )
+	    throw std::logic_error( "stream does not contain a snapshot of a refinement tree" );
+	const uint64_t dim = readRaw< uint64_t >( snapshot ), enclosure = readRaw< uint64_t >( snapshot ), noEntries = readRaw< uint64_t >( snapshot );
+	if( dim != mInitialEnclosure.dimension() )
+	    throw std::logic_error( "snapshot partitions a space of different dimension" );
+	if( enclosure > uint64_t( ImageEnclosure::AFFINE ) )
+	    throw std::logic_error( "snapshot encloses images by an unknown enclosure" );
+	// set before replaying, while the root is the only leaf
+	setImageEnclosure( ImageEnclosure( enclosure ) );
+
+	// entries as stored by the leaf index, the snapshot holds neither safety nor edges
+	std::vector< EnclosureT > boxes;
+	std::vector< std::pair< uint32_t, uint32_t > > childRanges;
+	boxes.reserve( noEntries );
+	childRanges.reserve( noEntries );
+	Ariadne::Array< Ariadne::ExactIntervalType > intervals( dim );
+	for( uint64_t e = 0; e < noEntries; ++e )
+	{
+	    for( uint64_t d = 0; d < dim; ++d )
+	    {
+		const double lower = readRaw< double >( snapshot ), upper = readRaw< double >( snapshot );
+		intervals[ d ] = Ariadne::ExactIntervalType( lower, upper );
+	    }
+	    boxes.push_back( EnclosureT( Ariadne::Vector( intervals ) ) );
+	    const uint32_t first = readRaw< uint32_t >( snapshot ), count = readRaw< uint32_t >( snapshot );
+	    childRanges.push_back( std::make_pair( first, count ) );
+	}
+	if( !snapshot )
+	    throw std::logic_error( "snapshot of refinement tree truncated" );
+	if( boxes.empty() || possibly( !( boxes.front() == mInitialEnclosure ) ) )
+	    throw std::logic_error( "snapshot partitions a different bounding box than the one of the safe set" );
+
+	std::vector< std::pair< uint32_t, NodeT > > generation;
+	const std::vector< NodeT > roots = insideLeaves();
+	if( childRanges.front().second != 0 )
+	    generation.push_back( std::make_pair( 0, roots.front() ) );
+	while( !generation.empty() )
+	{
+	    std::vector< NodeT > nodes;
+	    for( auto& entryNode : generation )
+		nodes.push_back( entryNode.second );
+
+	    // refinements are obtained in the order of the nodes given
+	    uint cNext = 0;
+	    auto replay = [&] (const EnclosureT& enc) {
+			      const uint32_t refinedEntry = generation[ cNext++ ].first;
+			      if( possibly( !( boxes[ refinedEntry ] == enc ) ) )
+				  throw std::logic_error( "replayed refinement of snapshot out of order" );
+			      const std::pair< uint32_t, uint32_t >& range = childRanges[ refinedEntry ];
+			      if( range.first + range.second > boxes.size() )
+				  throw std::logic_error( "snapshot refines to entries not stored" );
+			      return std::vector< EnclosureT >( boxes.begin() + range.first, boxes.begin() + range.first + range.second );
+			  };
+	    std::vector< std::vector< NodeT > > refined = refine( nodes.begin(), nodes.end(), replay );
+
+	    std::vector< std::pair< uint32_t, NodeT > > next;
+	    for( uint i = 0; i < generation.size(); ++i )
+	    {
+		const uint32_t first = childRanges[ generation[ i ].first ].first;
+		for( uint k = 0; k < refined[ i ].size(); ++k )
+		{
+		    if( childRanges[ first + k ].second != 0 )
+			next.push_back( std::make_pair( first + k, refined[ i ][ k ] ) );
+		}
+	    }
+	    generation.swap( next );
+	}
+    }
+
+    /*!
+      \brief writes a binary snapshot of the partition: the enclosure of images, the boxes of all refinements in the order of the leaf index and the range of their children
+      images, edges and safety are not written, loading replays the refinements and determines them for the dynamics and safe set given
+      \note numbers are written in the byte order of the machine
+    */
+    void save( std::ostream& os ) const
+    {
+	writeRaw< uint64_t >( os, SNAPSHOT_MAGIC );
+	writeRaw< uint64_t >( os, mInitialEnclosure.dimension() );
+	writeRaw< uint64_t >( os, uint64_t( mImageEnclosure ) );
+	writeRaw< uint64_t >( os, mLeafIndex.entryCount() );
+	for( typename LeafIndexT::EntryT e = 0; e < mLeafIndex.entryCount(); ++e )
+	{
+	    const EnclosureT& bx = mLeafIndex.box( e );
+	    for( uint d = 0; d < bx.dimension(); ++d )
+	    {
+		writeRaw< double >( os, bx[ d ].lower().get_d() );
+		writeRaw< double >( os, bx[ d ].upper().get_d() );
+	    }
+	    writeRaw< uint32_t >( os, mLeafIndex.firstChild( e ) );
+	    writeRaw< uint32_t >( os, mLeafIndex.childCount( e ) );
+	}
     }
 
     //! \return constraints determining the safe set
@@ -128,14 +319,134 @@ class RefinementTree
 	return mDynamics;
     }
 
+    //! \return dynamics lowered into a tape once, evaluating points and images faster than dynamics()
+    const DynamicsTape& compiledDynamics() const
+    {
+	return mTape;
+    }
+
     const Ariadne::Effort effort() const { return mEffort; }
 
+    //! \return schedule of the efforts at which predicates on the safe set are checked, escalating up to effort()
+    const EffortSchedule& effortSchedule() const { return mSchedule; }
+
+    //! \brief sets the schedule of efforts used for nodes added later, EffortSchedule::fixed( effort() ) checking at effort() only
+    void setEffortSchedule( const EffortSchedule& schedule ) { mSchedule = schedule; }
+
+    /*!
+      \return effort at which the safety of n was decided, or the maximum effort tried if it is not decided
+      checks on n and the safety of its refinements start at this effort, the outside node is at the maximum effort
+    */
+    uint effortLevel( const NodeT& n ) const
+    {
+	const IGraphValue* pval = graph::value( mMapping, n );
+	return pval->isInside() ? mEffortLevels[ pval->index() ] : mSchedule.maximum();
+    }
+
+    /*!
+      \return bits k set for constraints k of the safe set known to be satisfied on the whole of n, inherited by its refinements
+      satisfied constraints are only tracked for undecided nodes of safe sets with several constraints
+    */
+    uint64_t satisfiedConstraints( const NodeT& n ) const
+    {
+	const IGraphValue* pval = graph::value( mMapping, n );
+	return pval->isInside() ? mSatisfied[ pval->index() ] : 0;
+    }
+
+    //! \return enclosure of the images cached by the nodes, determining the edges between them
+    const ImageEnclosure& imageEnclosure() const { return mImageEnclosure; }
+
+    /*!
+      \brief sets the enclosure of the images cached by nodes, recomputing the images and out edges of all leaves and their transitive safety
+      mean value forms of images only reach leaves also reached by box images, so switching to them refines the abstraction without refining the partition
+    */
+    void setImageEnclosure( const ImageEnclosure& kind )
+    {
+	mImageEnclosure = kind;
+	mAffineImages.clear();
+	if( kind == ImageEnclosure::AFFINE )
+	    mAffineImages.resize( mImages.size() );
+
+	const std::vector< NodeT > leaves = insideLeaves();
+	const int noLeaves = leaves.size();
+	std::vector< std::vector< NodeT > >& posts = mRefineBuffers.mPosts;
+	RefineBuffers::clearRows( posts, noLeaves );
+#pragma omp parallel for schedule( dynamic )
+	for( int l = 0; l < noLeaves; ++l )
+	{
+	    const InsideGraphValue< E >& val = nodeValue( leaves[ l ] ).value().get();
+	    const size_t i = val.index();
+	    mImages[ i ] = mTape.image( val.getEnclosure() );
+	    if( kind == ImageEnclosure::AFFINE )
+	    {
+		mAffineImages[ i ] = mTape.affineImage( val.getEnclosure(), mImages[ i ] );
+		mImages[ i ] = mAffineImages[ i ].boundingBox();
+	    }
+	    appendReachableFrom( i, posts[ l ] );
+	}
+
+	std::vector< NodeT > outdated;
+	for( int l = 0; l < noLeaves; ++l )
+	{
+	    outdated.clear();
+	    for( const NodeT post : postimageRange( leaves[ l ] ) )
+		outdated.push_back( post );
+	    for( const NodeT& post : outdated )
+		graph::removeEdge( mMapping, leaves[ l ], post );
+	    for( const NodeT& post : posts[ l ] )
+		graph::addEdge( mMapping, leaves[ l ], post );
+	}
+	mSnapshotStale = true;
+	updateAllTransitiveSafety();
+    }
+
+    //! \return pool of values stored in the graph, e.g. to monitor memory
+    const ConcurrentObjectPoolRaw< InsideGraphValue< E > >& valuePool() const { return mValuePool; }
+
+    /*!
+      \return bytes allocated on the heap by the graph, values, node state and indices of the tree
+      \note storage of enclosures is estimated from the dimension of the initial enclosure, counterexamples are stored elsewhere
+    */
+    MemoryUsage memoryUsage() const
+    {
+	const size_t boxBytes = mInitialEnclosure.dimension() * sizeof( mInitialEnclosure[ 0 ] );
+	MemoryUsage usage;
+	usage.mVertices = mMapping.vertexBytes();
+	usage.mEdges = mMapping.edgeBytes();
+	usage.mValues = mValuePool.heapBytes() + mValuePool.liveObjects() * boxBytes
+	    + mTransMarks.capacity() + mSafety.capacity() + mVolumes.capacity() * sizeof( double ) + mEffortLevels.capacity() * sizeof( uint )
+	    + mSatisfied.capacity() * sizeof( uint64_t )
+	    + mImages.capacity() * sizeof( Ariadne::UpperBoxType ) + mAffineImages.capacity() * sizeof( AffineImage );
+	for( const Ariadne::UpperBoxType& img : mImages )
+	    usage.mValues += img.dimension() * sizeof( Ariadne::UpperIntervalType );
+	for( const AffineImage& img : mAffineImages )
+	    usage.mValues += img.heapBytes();
+	usage.mIndices = mLeafIndex.heapBytes() + mLeafIndex.entryCount() * boxBytes + mSnapshot.heapBytes() + mTape.heapBytes()
+	    + mRefineBuffers.heapBytes();
+	return usage;
+    }
+
+    //! \return empty set of nodes sized for all nodes currently in the graph
+    VisitSetT visitSet() const { return VisitSetT( mMapping, mNodeIdCounter + 1 ); }
+
     //! \return graph storing reachability between leaves
     const MappingT& graph() const
     {
 	return mMapping;
     }
 
+    //! \return compact snapshot of graph(), rebuilt if the graph changed since it was last taken
+    //! \note rebuilding is not thread safe, obtain the snapshot before starting parallel work on it
+    const SnapshotT& snapshot() const
+    {
+	if( mSnapshotStale )
+	{
+	    mSnapshot.assign( mMapping, mSafety );
+	    mSnapshotStale = false;
+	}
+	return mSnapshot;
+    }
+
     //! \return tree value stored at node v, storing the box and safety
     std::optional< std::reference_wrapper< const InsideGraphValue< EnclosureT > > > nodeValue( const NodeT& v ) const
     {
@@ -149,22 +460,33 @@ class RefinementTree
     //! \return true if n is certain to be safe, false if it is certain to be unsafe, indeterminate otherwise
     Ariadne::ValidatedKleenean isSafe( const NodeT& n ) const
     {
-	auto nval = nodeValue( n );
-	if( nval )
-	    return nval.value().get().isSafe();
-	else
-	    return Ariadne::ValidatedKleenean( false );
+	return isSafe( *graph::value( mMapping, n ) );
     }
 
+    //! \return safety of the node storing val
+    Ariadne::ValidatedKleenean isSafe( const IGraphValue& val ) const
+    {
+	return PackedSafety::safe( mSafety[ val.index() ] );
+    }
 
+    //! \return true if no unsafe state can be reached from n, false if one can be reached, indeterminate otherwise
     Ariadne::ValidatedKleenean isTransSafe( const NodeT& n ) const
     {
-	auto nval = nodeValue( n );
-	if( nval )
-	    return nval.value().get().isTransSafe();
-	return false;
+	return isTransSafe( *graph::value( mMapping, n ) );
+    }
+
+    //! \return transitive safety of the node storing val
+    Ariadne::ValidatedKleenean isTransSafe( const IGraphValue& val ) const
+    {
+	return PackedSafety::transSafe( mSafety[ val.index() ] );
     }
 
+    //! \return volumes of the leaves inside by their safety, maintained on refinement instead of scanning the leaves
+    const SafetyVolumes& safetyVolumes() const { return mSafetyVolumes; }
+
+    //! \return volumes of the leaves inside by their transitive safety, the safe volume is the volume proven safe
+    const SafetyVolumes& transSafetyVolumes() const { return mTransSafetyVolumes; }
+
     //! \return the always unsafe node used
     const NodeT& outside() const { return mOutsideNode; }
 
@@ -175,75 +497,138 @@ class RefinementTree
     template< typename EnclosureT2 >
     std::vector< NodeT > intersection( const EnclosureT2& from ) const
     {
-	std::vector< NodeT > inters;
-	auto vrange = graph::vertices( graph() );
-	std::copy_if( vrange.first, vrange.second, std::back_inserter( inters ),
-		      [this, &from] (auto& gn) {
-			  auto gnval = nodeValue( gn );
-			  if( gnval )
-			      return possibly( !Ariadne::intersection( from, gnval.value().get().getEnclosure() ).is_empty() );
-			  return possibly( !(Ariadne::intersection( from, initialEnclosure() ) == from) );
-		      } );
-
+	std::vector< NodeT > inters = mLeafIndex.leaves( [&from] (const EnclosureT& enc) {
+		return possibly( !Ariadne::intersection( from, enc ).is_empty() ); } );
+	if( possibly( !(Ariadne::intersection( from, initialEnclosure() ) == from) ) )
+	    inters.push_back( mOutsideNode );
 	return inters;
     }
 
     //! \brief generalization of other intersection overloads
-    //! \param pred function overapproximating whether enclosure and space intersect
-    std::vector< NodeT > intersection( const Ariadne::BoundedConstraintSet& s
-				       , const std::function< Ariadne::ValidatedUpperKleenean( const EnclosureT&, const Ariadne::BoundedConstraintSet& ) >& pred ) const
-    {
-	double largeM = 100 * initialEnclosure().radius().get_d();
-	
-	std::vector< NodeT > inters;
-	auto vrange = graph::vertices( graph() );
-	std::copy_if( vrange.first, vrange.second, std::back_inserter( inters )
-		      , [this, &s, &largeM] (auto& gn) {
-			    return possibly( overlapsConstraints( s, gn ) ); } );
+    //! \param pred function overapproximating whether enclosure and space intersect, a template parameter so lambdas are not type erased
+    template< typename PredT >
+    std::vector< NodeT > intersection( const Ariadne::BoundedConstraintSet& s, const PredT& pred ) const
+    {
+	std::vector< NodeT > inters = mLeafIndex.leaves( [this, &s] (const EnclosureT& enc) {
+		return possibly( !(s.separated( enc ).check( mEffort ) ) ); } );
+	if( possibly( overlapsConstraints( s, mOutsideNode ) ) )
+	    inters.push_back( mOutsideNode );
 	return inters;
     }
 
+    /*!
+      \return leaves possibly containing pt, followed by the outside node if pt is possibly outside the initial enclosure
+      the leaf index is descended along the split hierarchy, so points not on boundaries of boxes are located in O(depth)
+    */
+    std::vector< NodeT > containing( const Ariadne::ValidatedPoint& pt ) const
+    {
+	std::vector< NodeT > found = mLeafIndex.leaves( [&pt] (const EnclosureT& enc) { return possibly( enc.contains( pt ) ); } );
+	if( possibly( !mInitialEnclosure.contains( pt ) ) )
+	    found.push_back( mOutsideNode );
+	return found;
+    }
+
+    //! \return all leaves and the outside node possibly intersecting with image, i.e. possibly reached by a state mapped to image
+    std::vector< NodeT > reachableLeaves( const Ariadne::UpperBoxType& image ) const
+    {
+	std::vector< NodeT > reached;
+	appendReachableLeaves( image, reached );
+	return reached;
+    }
+
+    //! \return all leaves and the outside node possibly intersecting with the mean value form image
+    std::vector< NodeT > reachableLeaves( const AffineImage& image ) const
+    {
+	std::vector< NodeT > reached;
+	appendReachableLeaves( image, reached );
+	return reached;
+    }
+
+    //! \return range over all leaves in refinement tree mapping to to, iterating the in-edges of to in place
+    PreimageRangeT preimageRange( const NodeT& to ) const
+    {
+	return PreimageRangeT( mMapping, graph::inEdges( mMapping, to ) );
+    }
+
+    //! \return range over all leaves in refinement tree from maps to, iterating the out-edges of from in place
+    PostimageRangeT postimageRange( const NodeT& from ) const
+    {
+	return PostimageRangeT( mMapping, graph::outEdges( mMapping, from ) );
+    }
+
+    /*!
+      \brief calls visit( n ) for all leaves n mapping to to, without allocating
+      \param visit stops the iteration by returning false if it returns bool
+      \return false if visit stopped the iteration
+    */
+    template< typename VisitT >
+    bool visitPreimage( const NodeT& to, VisitT&& visit ) const
+    {
+	return visitAdjacent( preimageRange( to ), visit );
+    }
+
+    /*!
+      \brief calls visit( n ) for all leaves n reached from from, without allocating
+      \param visit stops the iteration by returning false if it returns bool
+      \return false if visit stopped the iteration
+    */
+    template< typename VisitT >
+    bool visitPostimage( const NodeT& from, VisitT&& visit ) const
+    {
+	return visitAdjacent( postimageRange( from ), visit );
+    }
+
     //! \return all leaves in refinement tree mapping to from
     std::vector< NodeT > preimage( const NodeT& to ) const
     {
-	std::vector< NodeT > preimg;
-	typename graph::DiGraphTraits< MappingT >::InRangeT ins = graph::inEdges( mMapping, to );
-
-	for( ; ins.first != ins.second; ++ins.first )
-	{
-	    const typename MappingT::EdgeT edge = *ins.first;
-	    auto edgeSource = graph::source( mMapping, edge );
-	    preimg.push_back( graph::source( mMapping, *ins.first ) );
-	}
-	return preimg;
+	const PreimageRangeT pres = preimageRange( to );
+	return std::vector< NodeT >( pres.begin(), pres.end() );
     }
 
     //! \return all leaves in refinement tree from maps to
     std::vector< NodeT > postimage( const NodeT& from ) const 
     {
-	std::vector< NodeT > postimg;
-	typename graph::DiGraphTraits< MappingT >::OutRangeT outs = graph::outEdges( mMapping, from );
-	for( ; outs.first != outs.second; ++outs.first )
-	    postimg.push_back( graph::target( mMapping, *outs.first ) );
-	return postimg;
+	const PostimageRangeT posts = postimageRange( from );
+	return std::vector< NodeT >( posts.begin(), posts.end() );
     }
 
     //! \return true if trg can be reached from src
     //! \note nothing can be reached from the outside node
-    Ariadne::ValidatedUpperKleenean isReachable( const NodeT& src, const NodeT& trg )
+    //! \note uses the image of src cached when it was added
+    Ariadne::ValidatedUpperKleenean isReachable( const NodeT& src, const NodeT& trg ) const
     {
-	auto optSrcVal = nodeValue( src );
-	if( optSrcVal )
-	    return isReachable( optSrcVal.value().get().getEnclosure(), trg );
-	else
+	const IGraphValue* pval = graph::value( mMapping, src );
+	if( !pval->isInside() )
 	    return false;
+	else if( mImageEnclosure == ImageEnclosure::AFFINE )
+	    return isImageReaching( mAffineImages[ pval->index() ], trg );
+	else
+	    return isImageReaching( mImages[ pval->index() ], trg );
     }
     
     //! \return true if there exists some point in src s.t. there exists a point in trg that can be reached
     //! \todo prepare for generalization of boxes
     Ariadne::ValidatedUpperKleenean isReachable( const EnclosureT& src, const NodeT& trg ) const
     {
-	Ariadne::UpperBoxType ubMapped =  Ariadne::image( src, mDynamics );
+	const Ariadne::UpperBoxType image = mTape.image( src );
+	if( mImageEnclosure == ImageEnclosure::AFFINE )
+	    return isImageReaching( mTape.affineImage( src, image ), trg );
+	return isImageReaching( image, trg );
+    }
+
+    /*!
+      \return images of the enclosures in [beginEnclosures, endEnclosures) under the dynamics, evaluated together by compiledDynamics()
+      \param beginEnclosures iterator dereferencing to EnclosureT
+    */
+    template< typename IterT >
+    std::vector< Ariadne::UpperBoxType > images( const IterT& beginEnclosures, const IterT& endEnclosures ) const
+    {
+	return mTape.batchImages( beginEnclosures, endEnclosures );
+    }
+
+    //! \return true if the image ubMapped of some enclosure intersects with trg
+    Ariadne::ValidatedUpperKleenean isImageReaching( const Ariadne::UpperBoxType& ubMapped, const NodeT& trg ) const
+    {
 	std::optional< std::reference_wrapper< const InsideGraphValue< EnclosureT > > > trgVal = nodeValue( trg );
 	if( trgVal )
 	{
@@ -256,11 +641,22 @@ class RefinementTree
 	    Ariadne::RealBox initialAbs( initialEnclosure() );
 	    Ariadne::BoundedConstraintSet insideInitialAbs( initialAbs );
 	    Ariadne::ExactBoxType mappedOverapprox = upper2ExactBox( ubMapped );
-	    Ariadne::ValidatedLowerKleenean imageContainedInside = insideInitialAbs.covers( mappedOverapprox, mEffort );
+	    Ariadne::ValidatedLowerKleenean imageContainedInside = mSchedule.decide( [&] (const Ariadne::Effort& e) {
+		    return insideInitialAbs.covers( mappedOverapprox, e ); } );
 	    return !imageContainedInside;
 	}
     }
 
+    //! \return true if the mean value form image of some enclosure intersects with trg
+    Ariadne::ValidatedUpperKleenean isImageReaching( const AffineImage& image, const NodeT& trg ) const
+    {
+	std::optional< std::reference_wrapper< const InsideGraphValue< EnclosureT > > > trgVal = nodeValue( trg );
+	if( trgVal )
+	    return image.intersects( trgVal.value().get().getEnclosure() );
+	// the initial enclosure is a box, so the form leaves it if and only if its bounding box does
+	return isImageReaching( image.boundingBox(), trg );
+    }
+
     //! \return true if n1 overlaps with n2
     Ariadne::ValidatedUpperKleenean overlaps( const NodeT& n1, const NodeT& n2 ) const
     {
@@ -291,11 +687,16 @@ class RefinementTree
     {
     	auto nval = nodeValue( n );
     	if( nval )
-    	    return !(constraintSet.separated( nval.value().get().getEnclosure() ).check( mEffort ) );
+	{
+	    uint work = mEffortLevels[ nval.value().get().index() ];
+	    return !mSchedule.decide( [&] (const Ariadne::Effort& e) {
+		    return constraintSet.separated( nval.value().get().getEnclosure() ).check( e ); }, work );
+	}
     	else
     	{
 	    // safe set determines initial enclosure
-	    return !( constraints().covers( upper2ExactBox( constraintSet.bounding_box() ) ).check( effort() ) );
+	    return !mSchedule.decide( [&] (const Ariadne::Effort& e) {
+		    return constraints().covers( upper2ExactBox( constraintSet.bounding_box() ) ).check( e ); } );
 	    
 	    // attempted generalized solution
 	    // EnclosureT initial = initialEnclosure();
@@ -322,12 +723,7 @@ class RefinementTree
     //! \return true nodes are equal based on their identifiers, false otherwise
     bool equal( const NodeT& n1, const NodeT& n2 ) const
     {
-	auto val1 = nodeValue( n1 ), val2 = nodeValue( n2 );
-	if( val1 && val2 )
-	    return val1.value().get() == val2.value().get();
-	else if( !val1 && !val2 )
-	    return true;
-	return false;
+	return graph::value( mMapping, n1 )->index() == graph::value( mMapping, n2 )->index();
     }
 
     /*! 
@@ -338,262 +734,731 @@ class RefinementTree
     template< typename R >
     std::vector< NodeT > refine( NodeT v, R& r ) // may not reference v, because modification of mMapping may cause reallocation of vertex container
     {
-	auto vval = nodeValue( v );
-	std::vector< NodeT > refinedStates;
-	if( !vval )
+	std::vector< NodeT > refinedStates = refineLeaf( v, r );
+	if( refinedStates.empty() )
 	    return refinedStates;
 
-	// make new tree values
-    	std::vector< EnclosureT > refinedEnclosures = r( vval.value().get().getEnclosure() );
-	refinedStates.reserve( refinedEnclosures.size() );
-	// map to outside node directly
-	for( auto& refEnc : refinedEnclosures )
-	    refinedStates.push_back( addState( refEnc ) );
-
-	refineEdges( v, refinedStates.begin(), refinedStates.end() );
-    	
-	// unlink v from the graph after its connectivity is no longer needed
+	// collect nodes whose transitive safety depends on v while still connected
+	std::vector< NodeT > cone = transSafetyCone( &v, &v + 1, refinedStates.begin(), refinedStates.end() );
 	removeNode( v );
-
-	// compute transitive safety AFTER unlinking parent node
-	setTransitiveSafety( refinedStates.begin(), refinedStates.end() );
-	// for( auto& refS : refinedStates )
-	// {
-	//     setTransitiveSafety( refS );
-	//     // auto refval = nodeValue( refS );
-	//     // std::cout << refval.value().get().getEnclosure() << " is tsafe " << refval.value().get().isTransSafe() << std::endl;
-	// }
+	updateTransitiveSafety( cone );
+	mSnapshotStale = true;
 	return refinedStates;
     }
 
-  private:
-
-    //! \return pointer to newly allocated leaf value ensuring that the safety flag is correctly initialized
-    const NodeT& addState( const EnclosureT& enc )
+    /*!
+      \brief refines all nodes in [beginNodes, endNodes) using r, determining transitive safety once for all new nodes
+      images, safety and edges of the new nodes are computed concurrently, the graph is only modified afterwards by a single thread
+      \param beginNodes iterator dereferencing to NodeT or a reference wrapper of it, nodes given more than once are refined once
+      \return refined nodes for each node given, empty for repetitions and nodes that cannot be refined
+    */
+    template< typename IterT, typename R >
+    std::vector< std::vector< NodeT > > refine( IterT beginNodes, const IterT& endNodes, R& r )
     {
-	Ariadne::ValidatedKleenean safety = definitely( constraints().covers( enc ).check( mEffort ) )
-	    ? Ariadne::ValidatedKleenean( true )
-	    : (definitely( constraints().separated( enc ).check( mEffort ) )
-	       ? Ariadne::ValidatedKleenean( false )
-	       : Ariadne::indeterminate);
-	InsideGraphValue< E >* pvalue = mValuePool.handOut();
-	pvalue->init( mNodeIdCounter++, enc, safety );
-	auto iadded = graph::addVertex( mMapping, static_cast< IGraphValue* >( pvalue ) );
-	return *iadded;
-    }
+	// copy nodes first, as references may be invalidated by the refinement
+	// buffers of the previous refinement are reused, so refinements of similar size do not allocate them anew
+	RefineBuffers& buffers = mRefineBuffers;
+	std::vector< NodeT >& nodes = buffers.mNodes;
+	std::vector< const IGraphValue* >& parentValues = buffers.mParentValues;
+	nodes.clear();
+	parentValues.clear();
+	for( ; beginNodes != endNodes; ++beginNodes )
+	    nodes.push_back( *beginNodes );
+	std::vector< std::vector< NodeT > > refinedStates( nodes.size() );
+
+	// refine enclosures sequentially, as refinements may keep state
+	std::vector< EnclosureT >& childEnclosures = buffers.mChildEnclosures;
+	std::vector< uint >& childOwner = buffers.mChildOwner;
+	childEnclosures.clear();
+	childOwner.clear();
+	for( uint i = 0; i < nodes.size(); ++i )
+	{
+	    const IGraphValue* pval = graph::value( mMapping, nodes[ i ] );
+	    if( !pval->isInside() || std::find( parentValues.begin(), parentValues.end(), pval ) != parentValues.end() )
+		continue;
+	    parentValues.push_back( pval );
+	    for( auto& refEnc : r( static_cast< const InsideGraphValue< E >& >( *pval ).getEnclosure() ) )
+	    {
+		childEnclosures.push_back( refEnc );
+		childOwner.push_back( i );
+	    }
+	}
+	std::sort( parentValues.begin(), parentValues.end() );
+
+	// images are evaluated in batches of children, batches concurrently
+	const int noChildren = childEnclosures.size();
+	const int noBatches = ( noChildren + IMAGE_BATCH - 1 ) / IMAGE_BATCH;
+	std::vector< Ariadne::UpperBoxType >& images = buffers.mImages;
+	images.assign( noChildren, Ariadne::UpperBoxType() );
+	std::vector< AffineImage >& affineImages = buffers.mAffineImages;
+	affineImages.assign( mImageEnclosure == ImageEnclosure::AFFINE ? noChildren : 0, AffineImage() );
+	// children start from the classification of their parent, only undecided constraints of undecided parents are checked
+	std::vector< Classification >& classes = buffers.mClasses;
+	classes.resize( noChildren );
+	std::vector< Ariadne::BoundedConstraintSet >& ownerConstraints = buffers.mOwnerConstraints;
+	std::vector< size_t >& remaining = buffers.mRemaining;
+	ownerConstraints.clear();
+	remaining.assign( nodes.size(), RefineBuffers::SAFE_SET );
+	for( int c = 0; c < noChildren; ++c )
+	{
+	    const uint i = childOwner[ c ];
+	    classes[ c ] = classification( nodes[ i ] );
+	    if( ( c == 0 || childOwner[ c - 1 ] != i ) && classes[ c ].mSatisfied != 0 )
+	    {
+		remaining[ i ] = ownerConstraints.size();
+		ownerConstraints.push_back( undecidedConstraints( classes[ c ].mSatisfied ) );
+	    }
+	}
+	// each thread evaluates its batches in scratch buffers of its own, kept for later refinements
+	std::vector< typename DynamicsTape::Scratch >& scratches = buffers.mTapeScratches;
+	if( scratches.size() < static_cast< size_t >( omp_get_max_threads() ) )
+	    scratches.resize( omp_get_max_threads() );
+#pragma omp parallel for schedule( dynamic )
+	for( int b = 0; b < noBatches; ++b )
+	{
+	    const int cBegin = b * IMAGE_BATCH, cEnd = std::min( noChildren, cBegin + IMAGE_BATCH );
+	    mTape.batchImages( childEnclosures.begin() + cBegin, childEnclosures.begin() + cEnd, images.begin() + cBegin
+			       , scratches[ omp_get_thread_num() ] );
+	    for( int c = cBegin; c < cEnd; ++c )
+	    {
+		if( !affineImages.empty() )
+		    affineImages[ c ] = mTape.affineImage( childEnclosures[ c ], images[ c ] );
+		const size_t r = remaining[ childOwner[ c ] ];
+		classes[ c ] = classify( childEnclosures[ c ], classes[ c ], r == RefineBuffers::SAFE_SET ? mSafeSet : ownerConstraints[ r ] );
+	    }
+	}
 
-    //! \note adapts edges of parent node after refinement
-    template< typename IterT >
-    void refineEdges( const NodeT& parent, const IterT& beginChildren, const IterT& endChildren )
-    {
-	// add edges
-	std::vector< NodeT > pres( preimage( parent ) );
-	auto iParentInPres = std::find_if( pres.begin(), pres.end()
-					   , std::bind( &RefinementTree< E >::equal, &*this, parent, std::placeholders::_1 ) );
-	if( iParentInPres != pres.end() )
-	    pres.erase( iParentInPres );
-	
-	std::vector< NodeT > posts( postimage( parent ) );
-	auto iParentInPosts = std::find_if( posts.begin(), posts.end()
-					    , std::bind( &RefinementTree< E >::equal, &*this, parent, std::placeholders::_1 ) );
-	if( iParentInPosts != posts.end() )
-	    posts.erase( iParentInPosts );
-
-	for( auto ichild = beginChildren; ichild != endChildren; ++ichild )
+	std::vector< NodeT >& children = buffers.mChildren;
+	children.clear();
+	for( int c = 0; c < noChildren; ++c )
 	{
-	    // connect parent's preimage minus self-loop
-	    for( auto& pre : pres )
+	    children.push_back( affineImages.empty() ? addState( childEnclosures[ c ], images[ c ], classes[ c ] )
+				: addState( childEnclosures[ c ], std::move( affineImages[ c ] ), classes[ c ] ) );
+	    refinedStates[ childOwner[ c ] ].push_back( children.back() );
+	}
+	for( uint i = 0; i < nodes.size(); ++i )
+	{
+	    if( refinedStates[ i ].empty() )
+		continue;
+	    std::vector< typename LeafIndexT::Leaf >& refinedLeaves = buffers.mRefinedLeaves;
+	    refinedLeaves.clear();
+	    for( auto& refS : refinedStates[ i ] )
 	    {
-		if( possibly( isReachable( pre, *ichild ) ) )
-		    graph::addEdge( mMapping, pre, *ichild );
+		const InsideGraphValue< E >& refVal = nodeValue( refS ).value().get();
+		refinedLeaves.push_back( { refVal.id(), refVal.getEnclosure(), refS } );
 	    }
-	    // connect parent's post image minus self-loop
-	    for( auto& post : posts )
+	    mLeafIndex.split( nodeValue( nodes[ i ] ).value().get().id(), refinedLeaves.begin(), refinedLeaves.end() );
+	}
+
+	// remaining leaves reaching a refined node may reach its refinement, the in edges of each parent are scanned once for all its children
+	{
+	    CEGAR_PROFILE_SCOPE( REFINE_EDGES );
+	    std::vector< std::vector< NodeT > >& parentPres = buffers.mParentPres;
+	    buffers.clearRows( parentPres, nodes.size() );
+	    for( uint i = 0; i < nodes.size(); ++i )
 	    {
-		if( possibly( isReachable( *ichild, post ) ) )
-		    graph::addEdge( mMapping, *ichild, post );
+		if( refinedStates[ i ].empty() )
+		    continue;
+		for( auto ins = graph::inEdges( mMapping, nodes[ i ] ); ins.first != ins.second; ++ins.first )
+		{
+		    const NodeT pre = graph::source( mMapping, *ins.first );
+		    if( !std::binary_search( parentValues.begin(), parentValues.end(), graph::value( mMapping, pre ) ) )
+			parentPres[ i ].push_back( pre );
+		}
 	    }
-	    // connect all children from-to and to-from
-	    for( auto iChildUp = ichild; iChildUp != endChildren; ++iChildUp )
+
+	    // edge candidates against the leaves after refinement: new nodes reach the leaves overlapping their image among the postimage of their parent
+	    std::vector< std::pair< const IGraphValue*, uint > >& owners = buffers.mParentOwners;
+	    owners.clear();
+	    for( uint i = 0; i < nodes.size(); ++i )
 	    {
-		if( possibly( isReachable( *ichild, *iChildUp ) ) )
-		    graph::addEdge( mMapping, *ichild, *iChildUp );
-		if( ichild != iChildUp && possibly( isReachable( *iChildUp, *ichild ) ) ) // don't make a 2nd self-loop
-		    graph::addEdge( mMapping, *iChildUp, *ichild );
+		if( !refinedStates[ i ].empty() )
+		    owners.push_back( std::make_pair( graph::value( mMapping, nodes[ i ] ), i ) );
 	    }
+	    std::sort( owners.begin(), owners.end() );
+	    auto refinementOf = [this, &owners, &refinedStates] (const NodeT& n) -> const std::vector< NodeT >* {
+				    const IGraphValue* pval = graph::value( mMapping, n );
+				    auto iowner = std::lower_bound( owners.begin(), owners.end(), std::make_pair( pval, uint( 0 ) ) );
+				    return iowner != owners.end() && iowner->first == pval ? &refinedStates[ iowner->second ] : nullptr; };
+	    std::vector< std::vector< NodeT > >& pres = buffers.mPres;
+	    buffers.clearRows( pres, noChildren );
+	    std::vector< std::vector< NodeT > >& posts = buffers.mPosts;
+	    buffers.clearRows( posts, noChildren );
+#pragma omp parallel for schedule( dynamic )
+	    for( int c = 0; c < noChildren; ++c )
+	    {
+		appendRefinedPostimage( nodes[ childOwner[ c ] ], children[ c ], refinementOf, posts[ c ] );
+		for( const NodeT& pre : parentPres[ childOwner[ c ] ] )
+		{
+		    if( possibly( isReachable( pre, children[ c ] ) ) )
+			pres[ c ].push_back( pre );
+		}
+	    }
+
+	    for( int c = 0; c < noChildren; ++c )
+	    {
+		for( auto& pre : pres[ c ] )
+		    graph::addEdge( mMapping, pre, children[ c ] );
+		for( auto& post : posts[ c ] )
+		    graph::addEdge( mMapping, children[ c ], post );
+	    }
+	}
+	std::vector< NodeT >& parents = buffers.mParents;
+	parents.clear();
+	for( uint i = 0; i < nodes.size(); ++i )
+	{
+	    if( !refinedStates[ i ].empty() )
+		parents.push_back( nodes[ i ] );
 	}
+	std::vector< NodeT > cone = transSafetyCone( parents.begin(), parents.end(), children.begin(), children.end() );
+	for( auto& parent : parents )
+	    removeNode( parent );
+	updateTransitiveSafety( cone );
+	mSnapshotStale = true;
+	return refinedStates;
     }
 
-    class FindUnsafe : public graph::BidirectionalDFTControl
+  private:
+    //! identifies snapshots written by save
+    static constexpr uint64_t SNAPSHOT_MAGIC = 0x43454741525433ull; // "CEGART3" in ascii, snapshots of the partition and the image enclosure
+
+    template< typename T >
+    static void writeRaw( std::ostream& os, const T& t )
     {
-      public:
-	FindUnsafe() : mFound( false ) {}
+	os.write( reinterpret_cast< const char* >( &t ), sizeof( T ) );
+    }
 
-	template< typename VisitSetT >
-	void visit( const MappingT& g, const NodeT& v, const VisitSetT& visited )
+    template< typename T >
+    static T readRaw( std::istream& is )
+    {
+	T t = T();
+	is.read( reinterpret_cast< char* >( &t ), sizeof( T ) );
+	return t;
+    }
+
+    //! \return all nodes except the outside node
+    std::vector< NodeT > insideLeaves() const
+    {
+	std::vector< NodeT > inside;
+	for( auto vs = graph::vertices( mMapping ); vs.first != vs.second; ++vs.first )
 	{
-	    const IGraphValue* pvval = graph::value( g, v );
-	    if( !pvval->isInside() || possibly( !static_cast< const InsideGraphValue< E >* >( pvval )->isSafe() ) )
-		mFound = true;
+	    if( graph::value( mMapping, *vs.first )->isInside() )
+		inside.push_back( *vs.first );
+	}
+	return inside;
+    }
+
+    template< typename RangeT, typename VisitT >
+    static bool visitAdjacent( const RangeT& adjacent, VisitT& visit )
+    {
+	for( const NodeT n : adjacent )
+	{
+	    if constexpr( std::is_same< decltype( visit( n ) ), bool >::value )
+	    {
+		if( !visit( n ) )
+		    return false;
+	    }
+	    else
+		visit( n );
 	}
+	return true;
+    }
 
-	template< typename VisitSetT >
-	bool terminate( const MappingT& g, const NodeT& v, const VisitSetT& visited ) {return mFound;}
+    //! number of constraints of the safe set tracked as satisfied, the bits of Classification::mSatisfied
+    static constexpr size_t MAX_TRACKED_CONSTRAINTS = 64;
 
-	template< typename VisitSetT >
-	bool isBacktrack( const MappingT& g, const NodeT& v, const VisitSetT& visited ) {return mFound;}
+    //! number of enclosures whose images are evaluated together when refining
+    static constexpr int IMAGE_BATCH = 32;
 
-	operator bool() {return mFound;}
-	    
-      private:
-	bool mFound;
+    //! \brief adds the refinement of leaf v according to r to the graph, without removing v or determining transitive safety of the refinement
+    template< typename R >
+    std::vector< NodeT > refineLeaf( NodeT v, R& r )
+    {
+	auto vval = nodeValue( v );
+	std::vector< NodeT > refinedStates;
+	if( !vval )
+	    return refinedStates;
+
+	// make new tree values
+    	std::vector< EnclosureT > refinedEnclosures = r( vval.value().get().getEnclosure() );
+	refinedStates.reserve( refinedEnclosures.size() );
+	std::vector< typename LeafIndexT::Leaf > refinedLeaves;
+	refinedLeaves.reserve( refinedEnclosures.size() );
+	std::vector< Ariadne::UpperBoxType > refinedImages = images( refinedEnclosures.begin(), refinedEnclosures.end() );
+	const Classification parent = classification( v );
+	const Ariadne::BoundedConstraintSet remaining = undecidedConstraints( parent.mSatisfied );
+	// map to outside node directly
+	for( uint i = 0; i < refinedEnclosures.size(); ++i )
+	{
+	    const EnclosureT& refEnc = refinedEnclosures[ i ];
+	    const Classification cls = classify( refEnc, parent, remaining );
+	    refinedStates.push_back( mImageEnclosure == ImageEnclosure::AFFINE
+				     ? addState( refEnc, mTape.affineImage( refEnc, refinedImages[ i ] ), cls )
+				     : addState( refEnc, refinedImages[ i ], cls ) );
+	    refinedLeaves.push_back( { nodeValue( refinedStates.back() ).value().get().id(), refEnc, refinedStates.back() } );
+	}
+	mLeafIndex.split( vval.value().get().id(), refinedLeaves.begin(), refinedLeaves.end() );
+
+	refineEdges( v, refinedStates );
+	return refinedStates;
+    }
+
+    //! \brief safety of a node and what was learnt deciding it, carried over to its refinements
+    struct Classification
+    {
+	Ariadne::ValidatedKleenean mSafety = Ariadne::indeterminate;
+	// effort that decided safety, or the maximum effort tried if undecided
+	uint mEffortLevel = 0;
+	// bit k is set if constraint k of the safe set is satisfied on the whole node
+	uint64_t mSatisfied = 0;
     };
 
-    class Resetter : public graph::BackwardDFTControl
+    /*!
+      \brief temporaries of batched refinements, kept with their capacity between refinements
+      \note the refinements returned, the storage of enclosures, images and constraint sets and the traversals of the leaf index
+      still allocate in each refinement
+    */
+    struct RefineBuffers
     {
-      public:
-	std::vector< NodeT > mReset;
-	
-	Resetter( const RefinementTree< E >& rtree )
-	    : mRtree( rtree )
-	{}
+	//! entry of mRemaining of nodes whose children are checked against the whole safe set
+	static constexpr size_t SAFE_SET = std::numeric_limits< size_t >::max();
 
-	template< typename VisitSetT >
-	bool isBacktrack( const MappingT& g, const NodeT& v, const VisitSetT& visited )
+	//! \brief empties the first n rows of rows, adding rows if there are fewer, rows beyond are kept for later refinements
+	static void clearRows( std::vector< std::vector< NodeT > >& rows, const size_t& n )
 	{
-	    return possibly( !mRtree.isSafe( v ) )      // local unsafety
-		||
-		possibly( mRtree.isTransSafe( v ) );     // either indeterminate (reset/not set) or true (-> nothing to reset)
+	    if( rows.size() < n )
+		rows.resize( n );
+	    for( size_t r = 0; r < n; ++r )
+		rows[ r ].clear();
 	}
 
-	template< typename VisitSetT >
-	void visit( const MappingT& g, const NodeT& v, const VisitSetT& visited )
+	//! \return bytes allocated on the heap, not counting the heap storage of enclosures and images
+	size_t heapBytes() const
 	{
-	    if( definitely( !mRtree.isTransSafe( v ) ) && definitely( mRtree.isSafe( v ) ) ) // trans unsafe and loc safe
-	    {
-		static_cast< InsideGraphValue< E > *>( graph::value( g, v ) )->resetTransSafe();
-		mReset.push_back( v );                    // does not re-insert nodes already reset
-	    }
+	    size_t bytes = ( mNodes.capacity() + mChildren.capacity() + mParents.capacity() ) * sizeof( NodeT )
+		+ mParentValues.capacity() * sizeof( const IGraphValue* ) + mChildEnclosures.capacity() * sizeof( EnclosureT )
+		+ mChildOwner.capacity() * sizeof( uint ) + mImages.capacity() * sizeof( Ariadne::UpperBoxType )
+		+ mClasses.capacity() * sizeof( Classification )
+		+ mAffineImages.capacity() * sizeof( AffineImage ) + mOwnerConstraints.capacity() * sizeof( Ariadne::BoundedConstraintSet )
+		+ mRemaining.capacity() * sizeof( size_t ) + mRefinedLeaves.capacity() * sizeof( typename LeafIndexT::Leaf )
+		+ mParentOwners.capacity() * sizeof( std::pair< const IGraphValue*, uint > )
+		+ ( mParentPres.capacity() + mPres.capacity() + mPosts.capacity() ) * sizeof( std::vector< NodeT > );
+	    for( const std::vector< NodeT >& row : mParentPres )
+		bytes += row.capacity() * sizeof( NodeT );
+	    for( const std::vector< NodeT >& row : mPres )
+		bytes += row.capacity() * sizeof( NodeT );
+	    for( const std::vector< NodeT >& row : mPosts )
+		bytes += row.capacity() * sizeof( NodeT );
+	    bytes += mTapeScratches.capacity() * sizeof( typename DynamicsTape::Scratch );
+	    for( const typename DynamicsTape::Scratch& scratch : mTapeScratches )
+		bytes += scratch.heapBytes();
+	    return bytes;
 	}
 
-      private:
-	const RefinementTree< E >& mRtree;
+	std::vector< NodeT > mNodes, mChildren, mParents;
+	std::vector< const IGraphValue* > mParentValues;
+	// refined nodes by their value, with their position among the nodes refined
+	std::vector< std::pair< const IGraphValue*, uint > > mParentOwners;
+	std::vector< EnclosureT > mChildEnclosures;
+	std::vector< uint > mChildOwner;
+	std::vector< Ariadne::UpperBoxType > mImages;
+	std::vector< Classification > mClasses;
+	std::vector< AffineImage > mAffineImages;
+	// undecided constraints of the parents, indexed by mRemaining for each node refined
+	std::vector< Ariadne::BoundedConstraintSet > mOwnerConstraints;
+	std::vector< size_t > mRemaining;
+	std::vector< typename LeafIndexT::Leaf > mRefinedLeaves;
+	std::vector< std::vector< NodeT > > mParentPres, mPres, mPosts;
+	std::vector< typename DynamicsTape::Scratch > mTapeScratches;  // by thread
     };
 
-    Ariadne::ValidatedKleenean determineTransitiveSafety( const NodeT& n ) const
+    //! \return classification stored for inside node n
+    Classification classification( const NodeT& n ) const
     {
-	if( possibly( !isSafe( n ) ) )
-	    return false;
+	const size_t i = graph::value( mMapping, n )->index();
+	return Classification{ PackedSafety::safe( mSafety[ i ] ), mEffortLevels[ i ], mSatisfied[ i ] };
+    }
 
-	bool reqIndet = false;
-	for( auto iout = outEdges( graph(), n ); iout.first != iout.second; ++iout.first )
+    //! \return safe set restricted to the constraints not set in satisfied, its domain is always kept
+    Ariadne::BoundedConstraintSet undecidedConstraints( const uint64_t& satisfied ) const
+    {
+	if( satisfied == 0 )
+	    return mSafeSet;
+	Ariadne::List< Ariadne::EffectiveConstraint > undecided;
+	for( size_t k = 0; k < mSafeSet.constraints().size(); ++k )
 	{
-	    const NodeT& t = target( graph(), *iout.first );
-	    
-	    Ariadne::ValidatedKleenean ttSafe = isTransSafe( t );
-	    if( definitely( !ttSafe ) || possibly( !isSafe( t ) ) )
-		return false;
-	    if( possibly( !ttSafe ) ) //indeterminate
-		reqIndet = true;
+	    if( k >= mConstraintSets.size() || !( ( satisfied >> k ) & 1 ) )
+		undecided.append( mSafeSet.constraints()[ k ] );
 	}
-	return reqIndet ? Ariadne::ValidatedKleenean( Ariadne::indeterminate ) : Ariadne::ValidatedKleenean( true );
+	return Ariadne::BoundedConstraintSet( mSafeSet.domain(), undecided );
     }
-    
-    /*
-      partitions reset nodes into those whose t-safety can be determined and those whose safety relies on indeterminate value
-      if first partition is empty, picks arbitrary node and sets it to true
-     */
-    template< typename IterT >
-    void fixResets( const IterT& resetBegin, const IterT& resetEnd )
+
+    /*!
+      \return classification of enc refining a node classified as parent
+      boxes in a box covered by or separated from the safe set are covered or separated alike, so only undecided parents are checked,
+      against remaining, the constraints not satisfied on the parent
+    */
+    Classification classify( const EnclosureT& enc, const Classification& parent, const Ariadne::BoundedConstraintSet& remaining ) const
     {
-	auto iShiftBegin = resetBegin;
-	bool set = true;
+	if( definitely( parent.mSafety ) || definitely( !parent.mSafety ) )
+	    return parent;
+	Classification cls = parent;
+	cls.mSafety = determineSafety( enc, remaining, cls.mEffortLevel );
+	if( !definitely( cls.mSafety ) && !definitely( !cls.mSafety ) )
+	{
+	    CEGAR_PROFILE_SCOPE( SAFETY );
+	    for( size_t k = 0; k < mConstraintSets.size(); ++k )
+	    {
+		if( !( ( cls.mSatisfied >> k ) & 1 ) && definitely( mConstraintSets[ k ].covers( enc ).check( Ariadne::Effort( cls.mEffortLevel ) ) ) )
+		    cls.mSatisfied |= uint64_t( 1 ) << k;
+	    }
+	}
+	return cls;
+    }
 
-	while( iShiftBegin != resetEnd && set )
+    /*!
+      \return safety of enc with respect to the safe set restricted to constraints
+      \param work effort to start at, set to the effort that decided safety or the maximum effort if undecided
+    */
+    Ariadne::ValidatedKleenean determineSafety( const EnclosureT& enc, const Ariadne::BoundedConstraintSet& constraints, uint& work ) const
+    {
+	CEGAR_PROFILE_SCOPE( SAFETY );
+	// both predicates are checked at each effort, so that unsafe boxes do not escalate the check of covering first
+	return mSchedule.decide( [&constraints, &enc] (const Ariadne::Effort& e) {
+		return definitely( constraints.covers( enc ).check( e ) )
+		    ? Ariadne::ValidatedKleenean( true )
+		    : (definitely( constraints.separated( enc ).check( e ) )
+		       ? Ariadne::ValidatedKleenean( false )
+		       : Ariadne::indeterminate); }, work );
+    }
+
+    //! \return node of a newly allocated leaf value of enc, with its image and safety initialized
+    const NodeT& addState( const EnclosureT& enc )
+    {
+	const Ariadne::UpperBoxType image = mTape.image( enc );
+	Classification root;
+	root.mEffortLevel = mSchedule.initial();
+	root = classify( enc, root, mSafeSet );
+	if( mImageEnclosure == ImageEnclosure::AFFINE )
+	    return addState( enc, mTape.affineImage( enc, image ), root );
+	return addState( enc, image, root );
+    }
+
+    //! \param image mean value form of the image of enc, its bounding box is cached as the box image of enc
+    const NodeT& addState( const EnclosureT& enc, AffineImage&& image, const Classification& cls )
+    {
+	const NodeT& added = addState( enc, image.boundingBox(), cls );
+	const size_t i = graph::value( mMapping, added )->index();
+	if( i >= mAffineImages.size() )
+	    mAffineImages.resize( mImages.size() );
+	mAffineImages[ i ] = std::move( image );
+	return added;
+    }
+
+    //! \return all leaves and the outside node reached from the inside node of value index i by its cached image
+    std::vector< NodeT > reachableFrom( const size_t& i ) const
+    {
+	std::vector< NodeT > reached;
+	appendReachableFrom( i, reached );
+	return reached;
+    }
+
+    //! \brief appends the leaves and the outside node reached from the inside node of value index i to reached, as reachableFrom
+    void appendReachableFrom( const size_t& i, std::vector< NodeT >& reached ) const
+    {
+	if( mImageEnclosure == ImageEnclosure::AFFINE )
+	    appendReachableLeaves( mAffineImages[ i ], reached );
+	else
+	    appendReachableLeaves( mImages[ i ], reached );
+    }
+
+    //! \brief appends the leaves and the outside node possibly intersecting with image to reached
+    void appendReachableLeaves( const Ariadne::UpperBoxType& image, std::vector< NodeT >& reached ) const
+    {
+	auto collect = [&reached] (const NodeT& n) { reached.push_back( n ); };
+	mLeafIndex.visitLeaves( [&image] (const EnclosureT& enc) { return possibly( !Ariadne::intersection( image, enc ).is_empty() ); }, collect );
+	if( possibly( isImageReaching( image, mOutsideNode ) ) )
+	    reached.push_back( mOutsideNode );
+    }
+
+    //! \brief appends the leaves and the outside node possibly intersecting with the mean value form image to reached
+    void appendReachableLeaves( const AffineImage& image, std::vector< NodeT >& reached ) const
+    {
+	auto collect = [&reached] (const NodeT& n) { reached.push_back( n ); };
+	mLeafIndex.visitLeaves( [&image] (const EnclosureT& enc) { return possibly( image.intersects( enc ) ); }, collect );
+	if( possibly( isImageReaching( image.boundingBox(), mOutsideNode ) ) )
+	    reached.push_back( mOutsideNode );
+    }
+
+    //! \param image image of enc under the dynamics
+    const NodeT& addState( const EnclosureT& enc, const Ariadne::UpperBoxType& image, const Classification& cls )
+    {
+	const Ariadne::ValidatedKleenean& safety = cls.mSafety;
+	InsideGraphValue< E >* pvalue = mValuePool.handOut();
+	pvalue->init( mNodeIdCounter++, enc );
+	const size_t i = pvalue->index();
+	if( i >= mSafety.size() )
 	{
-	    set = false; // repeat while sth is set
-	    for( auto ifix = iShiftBegin; ifix != resetEnd; ++ifix )
+	    // the outside index 0 keeps the default flags, it is unsafe and transitively unsafe
+	    mSafety.resize( std::max( i + 1, 2 * mSafety.size() ), PackedSafety::pack( false, false ) );
+	    mImages.resize( mSafety.size() );
+	    mVolumes.resize( mSafety.size(), 0 );
+	    mEffortLevels.resize( mSafety.size(), mSchedule.maximum() );
+	    mSatisfied.resize( mSafety.size(), 0 );
+	}
+	mSafety[ i ] = PackedSafety::pack( safety, Ariadne::indeterminate );
+	mImages[ i ] = image;
+	mVolumes[ i ] = enc.measure().get_d();
+	mEffortLevels[ i ] = cls.mEffortLevel;
+	mSatisfied[ i ] = cls.mSatisfied;
+	mSafetyVolumes.add( safety, mVolumes[ i ] );
+	mTransSafetyVolumes.add( Ariadne::indeterminate, mVolumes[ i ] );
+	auto iadded = graph::addVertex( mMapping, static_cast< IGraphValue* >( pvalue ) );
+	return *iadded;
+    }
+
+    //! \note adapts edges of parent node after refinement, call before removing the parent
+    void refineEdges( const NodeT& parent, const std::vector< NodeT >& children )
+    {
+	CEGAR_PROFILE_SCOPE( REFINE_EDGES );
+	auto refinementOf = [this, &parent, &children] (const NodeT& n) { return equal( n, parent ) ? &children : nullptr; };
+	std::vector< NodeT > posts;
+	// add edges, in-edges of the parent are not modified by adding edges to its children
+	for( const NodeT& child : children )
+	{
+	    // connect parent's preimage minus self-loop
+	    for( const NodeT pre : preimageRange( parent ) )
 	    {
-		InsideGraphValue< E > * const fixInside = static_cast< InsideGraphValue< E > *>( graph::value( mMapping, *ifix ) );
+		if( !equal( pre, parent ) && possibly( isReachable( pre, child ) ) )
+		    graph::addEdge( mMapping, pre, child );
+	    }
+	    // connect to the leaves reached among the parent's postimage, including siblings and self
+	    posts.clear();
+	    appendRefinedPostimage( parent, child, refinementOf, posts );
+	    for( const NodeT& post : posts )
+		graph::addEdge( mMapping, child, post );
+	}
+    }
 
-		Ariadne::ValidatedKleenean detTsafe = determineTransitiveSafety( *ifix );
-		if( definitely( detTsafe ) )
-		{
-		    fixInside->transSafe();
-		}
-		else if( definitely( !detTsafe ) )
+    /*!
+      \brief appends the nodes reached by the cached image of child among the postimage of its parent, nodes refined at the same time replaced by their refinement
+      restricting children to the transitions of their parent keeps refinement from adding transitions, which mean value forms
+      could add otherwise as they are not inclusion isotone, and is cheaper than querying the leaf index
+      \param refinementOf called as refinementOf( n ) for nodes n of the postimage, returns a pointer to the refinement of n if n is refined, nullptr otherwise
+    */
+    template< typename RefinementOfT >
+    void appendRefinedPostimage( const NodeT& parent, const NodeT& child, const RefinementOfT& refinementOf, std::vector< NodeT >& reached ) const
+    {
+	for( const NodeT post : postimageRange( parent ) )
+	{
+	    if( const std::vector< NodeT >* pRefined = refinementOf( post ) )
+	    {
+		for( const NodeT& refined : *pRefined )
 		{
-		    fixInside->transUnsafe();
+		    if( possibly( isReachable( child, refined ) ) )
+			reached.push_back( refined );
 		}
+	    }
+	    else if( possibly( isReachable( child, post ) ) )
+		reached.push_back( post );
+	}
+    }
 
-		if( definitely( detTsafe ) || definitely( !detTsafe ) )
-		{
-		    set = true;
-		    // move set elements away
-		    if( ifix != iShiftBegin ) // use std::swap here?
-		    {
-			NodeT tmp = *iShiftBegin;
-			*iShiftBegin = *ifix;
-			*ifix = tmp;
-		    }
-		    ++iShiftBegin;
-		}
+    enum TransMark : uint8_t { UNMARKED = 0, REFINED, IN_CONE, REACHES_UNSAFE };
+
+    //! \return mark of n used while updating transitive safety
+    uint8_t& transMark( const NodeT& n )
+    {
+	const size_t i = graph::value( mMapping, n )->index();
+	if( i >= mTransMarks.size() )
+	    mTransMarks.resize( std::max( i + 1, 2 * mTransMarks.size() ), UNMARKED );
+	return mTransMarks[ i ];
+    }
+
+    /*!
+      \brief collects nodes whose transitive safety may change by refining the parents, call before removing them
+      as refinement only removes transitions, only nodes reaching a parent through locally safe nodes whose transitive safety is not true are affected
+      \return new nodes and affected nodes, excluding the parents
+    */
+    template< typename ParentIterT, typename ChildIterT >
+    std::vector< NodeT > transSafetyCone( ParentIterT beginParents, const ParentIterT& endParents
+					  , const ChildIterT& beginChildren, const ChildIterT& endChildren )
+    {
+	CEGAR_PROFILE_SCOPE( TRANS_SAFETY );
+	std::vector< NodeT > cone( beginChildren, endChildren ), stack;
+	std::vector< NodeT > parents( beginParents, endParents );
+	for( const NodeT& p : parents )
+	    transMark( p ) = REFINED;
+	for( const NodeT& c : cone )
+	    transMark( c ) = IN_CONE;
+	for( const NodeT& p : parents )
+	{
+	    if( !definitely( isTransSafe( p ) ) )
+		stack.push_back( p );
+	}
+
+	while( !stack.empty() )
+	{
+	    const NodeT u = stack.back();
+	    stack.pop_back();
+	    for( auto ins = graph::inEdges( mMapping, u ); ins.first != ins.second; ++ins.first )
+	    {
+		const NodeT s = graph::source( mMapping, *ins.first );
+		uint8_t& mark = transMark( s );
+		if( mark != UNMARKED || possibly( !isSafe( s ) ) || definitely( isTransSafe( s ) ) )
+		    continue;
+		mark = IN_CONE;
+		cone.push_back( s );
+		stack.push_back( s );
 	    }
 	}
 
-	// if nothing maps to trans. unsafe, all indeterminates are trans. safe!
-	for( ; iShiftBegin != resetEnd && !set; ++iShiftBegin )
-	    static_cast< InsideGraphValue< E > * >( graph::value( mMapping, *iShiftBegin ) )->transSafe();
+	for( const NodeT& p : parents )
+	    transMark( p ) = UNMARKED;
+	for( const NodeT& n : cone )
+	    transMark( n ) = UNMARKED;
+	return cone;
     }
 
-    template< typename IterT >
-    void setTransitiveSafety( const IterT& iBegin, const IterT& iEnd )
+    /*!
+      \brief determines transitive safety of all nodes in cone, assuming transitive safety of all other nodes to be known
+      marks nodes reaching unsafe nodes by a backward worklist from locally unsafe nodes and nodes leaving the cone to transitively unsafe ones,
+      all other nodes in the cone are transitively safe
+    */
+    void updateTransitiveSafety( const std::vector< NodeT >& cone )
     {
-	Resetter resetter( *this );
-	
-	for( auto iset = iBegin; iset != iEnd; ++iset )
+	CEGAR_PROFILE_SCOPE( TRANS_SAFETY );
+	for( const NodeT& n : cone )
 	{
-	    IGraphValue* nval = graph::value( mMapping, *iset );
-	    if( nval->isInside() )
+	    transMark( n ) = IN_CONE;
+	    setTransSafe( n, Ariadne::indeterminate );
+	}
+
+	std::vector< NodeT > worklist;
+	auto reachesUnsafe = [this] (const NodeT& n) {
+	    transMark( n ) = REACHES_UNSAFE;
+	    setTransSafe( n, false );
+	};
+	for( const NodeT& n : cone )
+	{
+	    bool unsafe = possibly( !isSafe( n ) );
+	    for( auto outs = graph::outEdges( mMapping, n ); !unsafe && outs.first != outs.second; ++outs.first )
 	    {
-		InsideGraphValue< E > * const inval = static_cast< InsideGraphValue< E >* >( nval );
+		const NodeT t = graph::target( mMapping, *outs.first );
+		unsafe = transMark( t ) == UNMARKED && possibly( !isTransSafe( t ) );
+	    }
+	    if( unsafe )
+	    {
+		reachesUnsafe( n );
+		worklist.push_back( n );
+	    }
+	}
 
-		if( !definitely( inval->isTransSafe() ) && ! definitely( !inval->isTransSafe() ) ) // indeterminate
+	while( !worklist.empty() )
+	{
+	    const NodeT u = worklist.back();
+	    worklist.pop_back();
+	    for( auto ins = graph::inEdges( mMapping, u ); ins.first != ins.second; ++ins.first )
+	    {
+		const NodeT s = graph::source( mMapping, *ins.first );
+		if( transMark( s ) == IN_CONE )
 		{
-		    FindUnsafe isUnsafe;
-		    NodeEqual neq( *this );
-		    NodeHash nhash( *this );
-		    forwardDFT( graph(), *iset, isUnsafe, nhash, neq );
-
-		    if( isUnsafe )
-			inval->transUnsafe();
-		    else
-		    {
-			inval->transSafe();
-			backwardDFT( mMapping, *iset, resetter, nhash, neq );
-		    }
+		    reachesUnsafe( s );
+		    worklist.push_back( s );
 		}
 	    }
 	}
-	// require positions in fix resets, think how to circumnavigate this next
-	fixResets( resetter.mReset.begin(), resetter.mReset.end() ); // fix all resets after having set all refined nodes
+
+	for( const NodeT& n : cone )
+	{
+	    if( transMark( n ) == IN_CONE )
+		setTransSafe( n, true );
+	    transMark( n ) = UNMARKED;
+	}
+    }
+
+    /*!
+      \brief determines transitive safety of all leaves at once, by the strongly connected components of the snapshot
+      cheaper than updateTransitiveSafety on all leaves once edges of the whole abstraction changed
+      \note the snapshot is rebuilt, both before to condense the new edges and after as its flags become outdated
+    */
+    void updateAllTransitiveSafety()
+    {
+	CEGAR_PROFILE_SCOPE( TRANS_SAFETY );
+	const SnapshotT& snap = snapshot();
+	const std::vector< bool > safe = snap.transSafeComponents();
+	for( typename SnapshotT::IndexT i = 0; i < snap.size(); ++i )
+	{
+	    // edges changed arbitrarily, so leaves may turn from transitively safe to unsafe, reset as the cone update does
+	    if( graph::value( mMapping, snap.node( i ) )->isInside() )
+	    {
+		setTransSafe( snap.node( i ), Ariadne::indeterminate );
+		setTransSafe( snap.node( i ), safe[ snap.condensation().component( i ) ] );
+	    }
+	}
+	mSnapshotStale = true;
     }
 
+    //! \brief sets transitive safety of inside node n in its flags
+    void setTransSafe( const NodeT& n, const Ariadne::ValidatedKleenean& transSafe )
+    {
+	const size_t i = graph::value( mMapping, n )->index();
+	uint8_t& flags = mSafety[ i ];
+	if( definitely( !transSafe ) && definitely( PackedSafety::transSafe( flags ) ) )
+	    throw std::logic_error( "attempt to set node unsafe, even though node is already set safe" );
+	mTransSafetyVolumes.add( PackedSafety::transSafe( flags ), -mVolumes[ i ] );
+	mTransSafetyVolumes.add( transSafe, mVolumes[ i ] );
+	flags = PackedSafety::withTransSafe( flags, transSafe );
+    }
+
+    //! \note copies of n become stale, their slot in the graph and their value handed back to the pool may be reused by nodes added later
     void removeNode( const NodeT& n)
     {
-	// IGraphValue* pval = graph::value( mMapping, n );
+	IGraphValue* pval = graph::value( mMapping, n );
 	graph::removeVertex( mMapping, n );
-	// mValuePool.handBack( static_cast< InsideGraphValue< E > * >( pval ) );
+	if( pval->isInside() )
+	{
+	    InsideGraphValue< E > * const pinval = static_cast< InsideGraphValue< E > * >( pval );
+	    const uint8_t& flags = mSafety[ pinval->index() ];
+	    mSafetyVolumes.add( PackedSafety::safe( flags ), -mVolumes[ pinval->index() ] );
+	    mTransSafetyVolumes.add( PackedSafety::transSafe( flags ), -mVolumes[ pinval->index() ] );
+	    mImages[ pinval->index() ] = Ariadne::UpperBoxType();
+	    if( pinval->index() < mAffineImages.size() )
+		mAffineImages[ pinval->index() ] = AffineImage();
+	    mValuePool.handBack( pinval );
+	}
     }
     
     Ariadne::BoundedConstraintSet mSafeSet;
     Ariadne::EffectiveVectorFunction mDynamics;
+    DynamicsTape mTape;
     Ariadne::Effort mEffort;
-    ObjectPoolRaw< InsideGraphValue< E > > mValuePool;
+    EffortSchedule mSchedule;
+    ConcurrentObjectPoolRaw< InsideGraphValue< E > > mValuePool;
     unsigned long mNodeIdCounter;
+    OutsideGraphValue mOutsideValue;
     MappingT mMapping;
     E mInitialEnclosure;
+    ImageEnclosure mImageEnclosure;
     NodeT mOutsideNode;
+    LeafIndexT mLeafIndex;
+    std::vector< uint8_t > mTransMarks;
+    RefineBuffers mRefineBuffers;
+    // state of nodes indexed by value index, kept apart from the values so that scans over flags do not load enclosures
+    std::vector< uint8_t > mSafety;
+    std::vector< Ariadne::UpperBoxType > mImages;
+    // mean value forms of images indexed alike, empty unless images are enclosed by them
+    std::vector< AffineImage > mAffineImages;
+    std::vector< double > mVolumes;
+    std::vector< uint > mEffortLevels;
+    std::vector< uint64_t > mSatisfied;
+    // each constraint of the safe set on its own, to record constraints satisfied by undecided nodes, empty for a single constraint
+    std::vector< Ariadne::ConstraintSet > mConstraintSets;
+    // volumes of leaves by safety and by transitive safety, updated with the flags
+    SafetyVolumes mSafetyVolumes;
+    SafetyVolumes mTransSafetyVolumes;
+    mutable SnapshotT mSnapshot;
+    mutable bool mSnapshotStale;
 };
 
 //! \todo is not default constructible
@@ -605,12 +1470,7 @@ class NodeEqual
 
     bool operator ()( const typename RefinementTree< E >::NodeT& n1, const typename RefinementTree< E >::NodeT& n2 ) const
     {
-	auto nval1 = mRtree.nodeValue( n1 ), nval2 = mRtree.nodeValue( n2 );
-	if( !nval1 && !nval2 )
-	    return true;
-	else if( !nval1 || !nval2 )
-	    return false;
-	return nval1.value().get() == nval2.value().get();
+	return graph::value( mRtree.graph(), n1 )->index() == graph::value( mRtree.graph(), n2 )->index();
     }
 
   private:
@@ -626,10 +1486,7 @@ class NodeHash
 
     size_t operator ()( const typename RefinementTree< E >::NodeT& n ) const
     {
-	auto nval = mRtree.nodeValue( n );
-	if( !nval )
-	    return 0;
-	return nval.value().get().id();
+	return graph::value( mRtree.graph(), n )->index();
     }
   private:
     const RefinementTree< E >& mRtree;
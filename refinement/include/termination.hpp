@@ -1,7 +1,13 @@
 #ifndef TERMINATION_HPP
 #define TERMINATION_HPP
 
+#include "memoryUsage.hpp"
+
+#include <algorithm>
 #include <chrono>
+#include <deque>
+#include <tuple>
+#include <utility>
 
 /*! 
   \brief termination should support
@@ -64,5 +70,139 @@ class LimitedIterations
     uint mCount;
 };
 
+//! \brief terminate once the resident memory of the process exceeds a budget
+class MemoryBudget
+{
+  public:
+    //! \param checkEvery number of calls between reads of the resident memory, reading it costs a system call
+    MemoryBudget( const size_t& bytes, const uint& checkEvery = 1 )
+	: mBytes( bytes )
+	, mCheckEvery( std::max( checkEvery, 1u ) )
+	, mCount( 0 )
+	, mExceeded( false )
+    {}
+
+    template< typename Rtree >
+    void start( const Rtree& rtree )
+    {
+	mCount = 0;
+	mExceeded = false;
+    }
+
+    template< typename Rtree >
+    bool operator ()( const Rtree& rtree )
+    {
+	if( !mExceeded && mCount++ % mCheckEvery == 0 )
+	    mExceeded = residentBytes() > mBytes;
+	return mExceeded;
+    }
+
+  private:
+    const size_t mBytes;
+    const uint mCheckEvery;
+    uint mCount;
+    bool mExceeded;
+};
+
+/*!
+  \brief terminate once the fraction of volume proven safe, i.e. transitively safe, grew by less than minGain over the last window calls
+  the volumes are maintained by the refinement tree, so each call takes constant time
+*/
+class SafeVolumePlateau
+{
+  public:
+    SafeVolumePlateau( const uint& window, const double& minGain )
+	: mWindow( window )
+	, mMinGain( minGain )
+    {}
+
+    template< typename Rtree >
+    void start( const Rtree& rtree )
+    {
+	mFractions.clear();
+	mFractions.push_back( safeFraction( rtree ) );
+    }
+
+    template< typename Rtree >
+    bool operator ()( const Rtree& rtree )
+    {
+	mFractions.push_back( safeFraction( rtree ) );
+	if( mFractions.size() <= mWindow )
+	    return false;
+	if( mFractions.size() > mWindow + 1 )
+	    mFractions.pop_front();
+	return mFractions.back() - mFractions.front() < mMinGain;
+    }
+
+  private:
+    template< typename Rtree >
+    static double safeFraction( const Rtree& rtree )
+    {
+	const double total = rtree.safetyVolumes().total();
+	return total > 0 ? rtree.transSafetyVolumes().mSafe / total : 0;
+    }
+
+    const uint mWindow;
+    const double mMinGain;
+    std::deque< double > mFractions;
+};
+
+/*!
+  \brief terminate if any of the given terminations does
+  all terminations are called each time, so counting terminations advance regardless of the others
+*/
+template< typename ... TermTs >
+class AnyOf
+{
+  public:
+    AnyOf( const TermTs& ... terms ) : mTerms( terms ... ) {}
+
+    template< typename Rtree >
+    void start( const Rtree& rtree )
+    {
+	std::apply( [&rtree] (auto& ... term) { ( term.start( rtree ), ... ); }, mTerms );
+    }
+
+    template< typename Rtree >
+    bool operator ()( const Rtree& rtree )
+    {
+	return std::apply( [&rtree] (auto& ... term) { bool any = false; ( ( any = term( rtree ) || any ), ... ); return any; }, mTerms );
+    }
+
+  private:
+    std::tuple< TermTs ... > mTerms;
+};
+
+/*!
+  \brief terminate once all of the given terminations do
+  all terminations are called each time, so counting terminations advance regardless of the others
+*/
+template< typename ... TermTs >
+class AllOf
+{
+  public:
+    AllOf( const TermTs& ... terms ) : mTerms( terms ... ) {}
+
+    template< typename Rtree >
+    void start( const Rtree& rtree )
+    {
+	std::apply( [&rtree] (auto& ... term) { ( term.start( rtree ), ... ); }, mTerms );
+    }
+
+    template< typename Rtree >
+    bool operator ()( const Rtree& rtree )
+    {
+	return std::apply( [&rtree] (auto& ... term) { bool all = true; ( ( all = term( rtree ) && all ), ... ); return all; }, mTerms );
+    }
+
+  private:
+    std::tuple< TermTs ... > mTerms;
+};
+
+template< typename ... TermTs >
+AnyOf< TermTs ... > anyOf( const TermTs& ... terms ) { return AnyOf< TermTs ... >( terms ... ); }
+
+template< typename ... TermTs >
+AllOf< TermTs ... > allOf( const TermTs& ... terms ) { return AllOf< TermTs ... >( terms ... ); }
 
 #endif
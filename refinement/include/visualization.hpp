@@ -2,9 +2,21 @@
 #define VISUALIZATION_HPP
 
 #include "refinementTree.hpp"
+#include "mappedGraph.hpp"
+#include "cegarObserver.hpp"
 
 #include "output/graphics.hpp"
 
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+
+#include <omp.h>
+
 struct ZeroState
 {
     template< typename Rtree, typename IterT >
@@ -29,50 +41,408 @@ struct ZeroCex
     }
 };
 
+//! classes of leaves distinguished by visualizations, by reachability from the initial set and safety
+enum class StateClass : uint8_t { UNREACHED, INITIAL, SAFE, UNSAFE, UNDECIDED };
+
 template< typename Rtree, typename InisetT >
-Ariadne::Colour stateColor( const Rtree& rtree, const InisetT& initialSet, const InsideGraphValue< typename Rtree::EnclosureT >& gv, bool reachable )
+StateClass stateClass( const Rtree& rtree, const InisetT& initialSet, const InsideGraphValue< typename Rtree::EnclosureT >& gv, bool reachable )
 {
     if( reachable )
     {
-	if( definitely( gv.isSafe() ) )
+	if( definitely( rtree.isSafe( gv ) ) )
 	{
 	    if( possibly( !initialSet.separated( gv.getEnclosure() ) ) )
-		return Ariadne::cyan;
+		return StateClass::INITIAL;
 	    else
-		return Ariadne::green;
+		return StateClass::SAFE;
+	}
+	else if( definitely( !rtree.isSafe( gv ) ) )
+	    return StateClass::UNSAFE;
+	else
+	    return StateClass::UNDECIDED;
+    }
+    return StateClass::UNREACHED;
+}
+
+//! \return colour of leaves of class c in figures
+inline Ariadne::Colour classColor( const StateClass& c )
+{
+    switch( c )
+    {
+      case StateClass::INITIAL: return Ariadne::cyan;
+      case StateClass::SAFE: return Ariadne::green;
+      case StateClass::UNSAFE: return Ariadne::red;
+      case StateClass::UNDECIDED: return Ariadne::Colour( 1, 0.7, 0 );
+      default: return Ariadne::white;
+    }
+}
+
+template< typename Rtree, typename InisetT >
+Ariadne::Colour stateColor( const Rtree& rtree, const InisetT& initialSet, const InsideGraphValue< typename Rtree::EnclosureT >& gv, bool reachable )
+{
+    return classColor( stateClass( rtree, initialSet, gv, reachable ) );
+}
+
+/*!
+  \return for each index of the snapshot of rtree whether a counterexample search from [beginInitial, endInitial) reaches it
+  nodes are expanded as by findCounterexample, without collecting counterexamples
+  \note the result refers to the current snapshot, it can be reused by visualizations of the tree until it is refined
+*/
+template< typename E, typename IterT >
+std::vector< bool > reachedNodes( const RefinementTree< E >& rtree, IterT beginInitial, const IterT& endInitial )
+{
+    typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+    typedef typename SnapshotT::IndexT IndexT;
+
+    const SnapshotT& snap = rtree.snapshot();
+    std::vector< bool > reached( snap.size(), false );
+    std::vector< IndexT > stack;
+    for( ; beginInitial != endInitial; ++beginInitial )
+    {
+	const IndexT i = snap.index( graph::value( rtree.graph(), *beginInitial ) );
+	if( !reached[ i ] )
+	{
+	    reached[ i ] = true;
+	    stack.push_back( i );
+	}
+    }
+    while( !stack.empty() )
+    {
+	const IndexT u = stack.back();
+	stack.pop_back();
+	if( possibly( !snap.isSafe( u ) ) || definitely( snap.isTransSafe( u ) ) )
+	    continue;
+	for( auto outs = graph::outEdges( snap.graph(), u ); outs.first != outs.second; ++outs.first )
+	{
+	    const IndexT t = graph::target( snap.graph(), *outs.first );
+	    if( !reached[ t ] )
+	    {
+		reached[ t ] = true;
+		stack.push_back( t );
+	    }
+	}
+    }
+    return reached;
+}
+
+/*!
+  \class keeps the reachability of the abstraction cegar finished with, so visualizations of the final tree need no search of their own
+  the initial nodes of the last search are kept, reachability is determined once when cegar finishes, from the initial abstraction
+  of the last search if the tree was not refined since and from the initial set otherwise
+  \note reached() refers to the snapshot of the final tree, see reachedNodes
+*/
+template< typename E >
+class KeepReached : public CegarObserver
+{
+  public:
+    typedef RefinementTree< E > Rtree;
+
+    KeepReached( const Ariadne::BoundedConstraintSet& initialSet, const Ariadne::Effort& effort )
+	: mInitialSet( initialSet )
+	, mEffort( effort )
+    {}
+
+    template< typename IterT >
+    void searchCounterexample( const Rtree& rtree, IterT iBegin, const IterT& iEnd )
+    {
+	mInitialNodes.assign( iBegin, iEnd );
+	mRefined = false;
+    }
+
+    template< typename IterT >
+    void refined( const Rtree& rtree, const IterT& iBegin, const IterT& iEnd )
+    {
+	mRefined = true;
+    }
+
+    void finished( const Rtree& rtree, const Ariadne::ValidatedKleenean& safe )
+    {
+	if( mRefined )
+	{
+	    const Ariadne::Effort effort = mEffort;
+	    mInitialNodes = rtree.intersection( mInitialSet, [&effort] (const typename Rtree::EnclosureT& enc, const Ariadne::BoundedConstraintSet& cset) {
+		    return !( cset.separated( enc ).check( effort ) ); } );
+	}
+	mReached = reachedNodes( rtree, mInitialNodes.begin(), mInitialNodes.end() );
+	mInitialNodes.clear();
+    }
+
+    //! \return reachability by snapshot index of the tree cegar finished with, empty before it finished
+    const std::vector< bool >& reached() const { return mReached; }
+
+  private:
+    Ariadne::BoundedConstraintSet mInitialSet;
+    Ariadne::Effort mEffort;
+    std::vector< typename Rtree::NodeT > mInitialNodes;
+    bool mRefined = false;
+    std::vector< bool > mReached;
+};
+
+//! relative part of a level of detail cell its leaves may leave uncovered due to rounding and still be merged
+constexpr double LOD_AREA_TOLERANCE = 1e-9;
+
+/*!
+  \return boxes of the leaves of rtree with their class, classified concurrently
+  \param reached reachability by snapshot index, see reachedNodes
+  \param lodCells cells along each of the first two dimensions of a level of detail grid over the initial enclosure, 0 for no grid,
+  in two dimensional trees the leaves inside a cell are merged into the cell if they are of one class and cover it
+*/
+template< typename E, typename InisetT >
+std::vector< std::pair< E, StateClass > > classifiedLeaves( const RefinementTree< E >& rtree, const InisetT& initialSet
+							    , const std::vector< bool >& reached, const uint& lodCells = 0 )
+{
+    typedef typename RefinementTree< E >::SnapshotT SnapshotT;
+    const SnapshotT& snap = rtree.snapshot();
+    const int noNodes = snap.size();
+    std::vector< std::optional< std::pair< E, StateClass > > > leaves( noNodes );
+#pragma omp parallel for schedule( dynamic, 256 )
+    for( int i = 0; i < noNodes; ++i )
+    {
+	auto vval = rtree.nodeValue( snap.node( i ) );
+	if( vval )
+	    leaves[ i ] = std::make_pair( vval.value().get().getEnclosure(), stateClass( rtree, initialSet, vval.value().get(), reached[ i ] ) );
+    }
+
+    std::vector< std::pair< E, StateClass > > classified;
+    const E& domain = rtree.initialEnclosure();
+    if( lodCells == 0 || domain.dimension() != 2 )
+    {
+	for( auto& leaf : leaves )
+	{
+	    if( leaf )
+		classified.push_back( std::move( leaf.value() ) );
+	}
+	return classified;
+    }
+
+    // leaves fitting into one cell are binned, cells covered by leaves of one class are drawn as a single box
+    double lower[ 2 ], width[ 2 ];
+    for( size_t d = 0; d < 2; ++d )
+    {
+	lower[ d ] = domain[ d ].lower().get_d();
+	width[ d ] = ( domain[ d ].upper().get_d() - lower[ d ] ) / lodCells;
+    }
+    struct Cell
+    {
+	std::vector< size_t > mLeaves;
+	double mArea = 0;
+	bool mUniform = true;
+    };
+    std::vector< Cell > cells( lodCells * lodCells );
+    for( size_t i = 0; i < leaves.size(); ++i )
+    {
+	if( !leaves[ i ] )
+	    continue;
+	const E& bx = leaves[ i ]->first;
+	size_t cell[ 2 ];
+	bool inCell = true;
+	for( size_t d = 0; d < 2 && inCell; ++d )
+	{
+	    const double lo = ( bx[ d ].lower().get_d() - lower[ d ] ) / width[ d ], hi = ( bx[ d ].upper().get_d() - lower[ d ] ) / width[ d ];
+	    cell[ d ] = std::min< size_t >( lodCells - 1, std::max( 0.0, std::floor( lo ) ) );
+	    inCell = hi <= cell[ d ] + 1;
+	}
+	if( !inCell )
+	{
+	    classified.push_back( std::move( leaves[ i ].value() ) );
+	    continue;
+	}
+	Cell& c = cells[ cell[ 0 ] * lodCells + cell[ 1 ] ];
+	c.mUniform = c.mUniform && ( c.mLeaves.empty() || leaves[ c.mLeaves.front() ]->second == leaves[ i ]->second );
+	c.mArea += ( bx[ 0 ].upper().get_d() - bx[ 0 ].lower().get_d() ) * ( bx[ 1 ].upper().get_d() - bx[ 1 ].lower().get_d() );
+	c.mLeaves.push_back( i );
+    }
+
+    // leaves are disjoint, so leaves within a cell cover it if their areas sum up to the area of the cell
+    const double cellArea = width[ 0 ] * width[ 1 ];
+    Ariadne::Array< Ariadne::ExactIntervalType > intervals( 2 );
+    for( size_t c = 0; c < cells.size(); ++c )
+    {
+	const Cell& cell = cells[ c ];
+	if( cell.mLeaves.size() > 1 && cell.mUniform && cell.mArea >= ( 1 - LOD_AREA_TOLERANCE ) * cellArea )
+	{
+	    const size_t cx = c / lodCells, cy = c % lodCells;
+	    intervals[ 0 ] = Ariadne::ExactIntervalType( lower[ 0 ] + cx * width[ 0 ], lower[ 0 ] + ( cx + 1 ) * width[ 0 ] );
+	    intervals[ 1 ] = Ariadne::ExactIntervalType( lower[ 1 ] + cy * width[ 1 ], lower[ 1 ] + ( cy + 1 ) * width[ 1 ] );
+	    classified.push_back( std::make_pair( E( Ariadne::Vector( intervals ) ), leaves[ cell.mLeaves.front() ]->second ) );
 	}
-	else if( definitely( !gv.isSafe() ) )
-	    return Ariadne::red;
 	else
-	    return Ariadne::Colour( 1, 0.7, 0 );
+	{
+	    for( const size_t& i : cell.mLeaves )
+		classified.push_back( std::move( leaves[ i ].value() ) );
+	}
+    }
+    return classified;
+}
+
+/*!
+  \brief figure of the leaves of rtree coloured by stateColor, reusing the reachability of an earlier search
+  \param reached reachability by snapshot index, see reachedNodes and KeepReached
+  \param lodCells level of detail grid merging small leaves, see classifiedLeaves
+*/
+template< typename E, typename InisetT >
+Ariadne::Figure visualize( const RefinementTree< E >& rtree, const InisetT& initialSet, const std::vector< bool >& reached, const uint& lodCells = 0 )
+{
+    Ariadne::Figure fig( rtree.initialEnclosure(), Ariadne::PlanarProjectionMap( 2,0,1 ) );
+    for( const std::pair< E, StateClass >& leaf : classifiedLeaves( rtree, initialSet, reached, lodCells ) )
+    {
+	fig.set_fill_colour( classColor( leaf.second ) );
+	fig.draw( leaf.first );
     }
-    return Ariadne::white;
+    return fig;
 }
 
+//! \brief figure of the leaves of rtree coloured by stateColor, reachability is determined from the image of initialSet
 template< typename E, typename InisetT >
 Ariadne::Figure visualize( const RefinementTree< E >& rtree, const InisetT& initialSet, const Ariadne::Effort& effort )
 {
-    auto ncomp = typename RefinementTree< E >::NodeComparator( rtree );
-    VisitMap< typename RefinementTree< E >::EnclosureT > reachMap( ncomp );
-    ZeroState stateH; ZeroCex cexH;
-    CounterexampleStore< typename RefinementTree< E >::EnclosureT, ZeroState, ZeroCex > cstore( stateH, cexH );
-    std::function< Ariadne::ValidatedUpperKleenean( const typename RefinementTree< E >::EnclosureT&, const Ariadne::BoundedConstraintSet& ) > interPred =
-	[&effort] (auto& enc, auto& cset) {return !(cset.separated( enc ).check( effort ) ); };
+    auto interPred = [&effort] (const typename RefinementTree< E >::EnclosureT& enc, const Ariadne::BoundedConstraintSet& cset) {
+	return !(cset.separated( enc ).check( effort ) ); };
     auto initialAbs = rtree.intersection( initialSet, interPred );
-    findCounterexample( rtree, initialAbs.begin(), initialAbs.end(), cstore );
+    return visualize( rtree, initialSet, reachedNodes( rtree, initialAbs.begin(), initialAbs.end() ) );
+}
 
-    Ariadne::Figure fig( rtree.initialEnclosure(), Ariadne::PlanarProjectionMap( 2,0,1 ) );
-    for( auto vs = graph::vertices( rtree.graph() ); vs.first != vs.second; ++vs.first )
+/*!
+  \class rgb image of the first two dimensions of the leaves of a refinement tree, painted tile by tile concurrently
+  a pixel takes the colour of the leaf containing its centre, rows are stored from the top, i.e. the upper bound of the second dimension
+*/
+class Raster
+{
+  public:
+    /*!
+      \param bounds lower and upper bounds of the first two dimensions covered
+      \param tileSize width and height of the tiles in pixels painted concurrently
+    */
+    Raster( const uint& width, const uint& height, const std::array< double, 4 >& bounds, const uint& tileSize = 64 )
+	: mWidth( width ), mHeight( height ), mTileSize( std::max< uint >( tileSize, 1 ) ), mBounds( bounds )
+	, mPixels( 3 * size_t( width ) * height, 255 )
+    {}
+
+    uint width() const { return mWidth; }
+
+    uint height() const { return mHeight; }
+
+    //! \return colour of pixel ( x, y ) of row y from the top, as red, green and blue bytes
+    std::array< uint8_t, 3 > pixel( const uint& x, const uint& y ) const
     {
-	auto vval = rtree.nodeValue( *vs.first );
-	if( vval )
+	const size_t p = 3 * ( size_t( y ) * mWidth + x );
+	return { mPixels[ p ], mPixels[ p + 1 ], mPixels[ p + 2 ] };
+    }
+
+    //! \return pixel ( x, y ) with x increasing along the first and y decreasing along the second dimension containing ( px, py )
+    std::pair< uint, uint > pixelOf( const double& px, const double& py ) const
+    {
+	const double fx = ( px - mBounds[ 0 ] ) / ( mBounds[ 1 ] - mBounds[ 0 ] ) * mWidth, fy = ( mBounds[ 3 ] - py ) / ( mBounds[ 3 ] - mBounds[ 2 ] ) * mHeight;
+	return std::make_pair( std::min< uint >( mWidth - 1, std::max( 0.0, std::floor( fx ) ) ), std::min< uint >( mHeight - 1, std::max( 0.0, std::floor( fy ) ) ) );
+    }
+
+    //! \brief paints boxes with their class, boxes are binned by tile and tiles are painted concurrently
+    template< typename E >
+    void paint( const std::vector< std::pair< E, StateClass > >& boxes )
+    {
+	const uint tilesX = ( mWidth + mTileSize - 1 ) / mTileSize, tilesY = ( mHeight + mTileSize - 1 ) / mTileSize;
+	// pixel ranges [x0, x1) x [y0, y1) whose centres lie in each box
+	std::vector< std::array< int, 4 > > ranges( boxes.size() );
+	std::vector< std::vector< size_t > > tiles( size_t( tilesX ) * tilesY );
+	for( size_t b = 0; b < boxes.size(); ++b )
+	{
+	    const E& bx = boxes[ b ].first;
+	    std::array< int, 4 >& r = ranges[ b ];
+	    r[ 0 ] = centreBegin( ( bx[ 0 ].lower().get_d() - mBounds[ 0 ] ) / ( mBounds[ 1 ] - mBounds[ 0 ] ) * mWidth, mWidth );
+	    r[ 1 ] = centreBegin( ( bx[ 0 ].upper().get_d() - mBounds[ 0 ] ) / ( mBounds[ 1 ] - mBounds[ 0 ] ) * mWidth, mWidth );
+	    r[ 2 ] = centreBegin( ( mBounds[ 3 ] - bx[ 1 ].upper().get_d() ) / ( mBounds[ 3 ] - mBounds[ 2 ] ) * mHeight, mHeight );
+	    r[ 3 ] = centreBegin( ( mBounds[ 3 ] - bx[ 1 ].lower().get_d() ) / ( mBounds[ 3 ] - mBounds[ 2 ] ) * mHeight, mHeight );
+	    if( r[ 0 ] >= r[ 1 ] || r[ 2 ] >= r[ 3 ] )
+		continue;
+	    for( int ty = r[ 2 ] / mTileSize; ty <= ( r[ 3 ] - 1 ) / int( mTileSize ); ++ty )
+		for( int tx = r[ 0 ] / mTileSize; tx <= ( r[ 1 ] - 1 ) / int( mTileSize ); ++tx )
+		    tiles[ size_t( ty ) * tilesX + tx ].push_back( b );
+	}
+
+	const int noTiles = tiles.size();
+#pragma omp parallel for schedule( dynamic )
+	for( int t = 0; t < noTiles; ++t )
+	{
+	    const int tx0 = ( t % tilesX ) * mTileSize, ty0 = ( t / tilesX ) * mTileSize;
+	    const int tx1 = std::min< int >( tx0 + mTileSize, mWidth ), ty1 = std::min< int >( ty0 + mTileSize, mHeight );
+	    for( const size_t& b : tiles[ t ] )
+	    {
+		const std::array< uint8_t, 3 > rgb = classRgb( boxes[ b ].second );
+		const std::array< int, 4 >& r = ranges[ b ];
+		for( int y = std::max( r[ 2 ], ty0 ); y < std::min( r[ 3 ], ty1 ); ++y )
+		    for( int x = std::max( r[ 0 ], tx0 ); x < std::min( r[ 1 ], tx1 ); ++x )
+			std::copy( rgb.begin(), rgb.end(), mPixels.begin() + 3 * ( size_t( y ) * mWidth + x ) );
+	    }
+	}
+    }
+
+    //! \brief writes the raster as binary portable pixmap
+    void write( std::ostream& os ) const
+    {
+	os << "P6\n" << mWidth << " " << mHeight << "\n255\n";
+	os.write( reinterpret_cast< const char* >( mPixels.data() ), mPixels.size() );
+    }
+
+    //! \return colour of class c as red, green and blue bytes, matching classColor
+    static std::array< uint8_t, 3 > classRgb( const StateClass& c )
+    {
+	switch( c )
 	{
-	    auto tv = vval.value().get();
-	    // auto imapEntry = reachMap.find( *vs.first );
-	    // fig.set_fill_colour( stateColor( rtree, initialSet, tv, imapEntry != reachMap.end() && imapEntry->second ) );
-	    fig.draw( tv.getEnclosure() );
+	  case StateClass::INITIAL: return { 0, 255, 255 };
+	  case StateClass::SAFE: return { 0, 255, 0 };
+	  case StateClass::UNSAFE: return { 255, 0, 0 };
+	  case StateClass::UNDECIDED: return { 255, 179, 0 };
+	  default: return { 255, 255, 255 };
 	}
     }
+
+  private:
+    //! \return first pixel whose centre is at least at the fractional pixel coordinate f, clamped to [0, n]
+    static int centreBegin( const double& f, const uint& n )
+    {
+	return std::min< double >( n, std::max( 0.0, std::ceil( f - 0.5 ) ) );
+    }
+
+    uint mWidth, mHeight, mTileSize;
+    std::array< double, 4 > mBounds;
+    std::vector< uint8_t > mPixels;
+};
+
+/*!
+  \brief rasterizes the leaves of rtree over its initial enclosure, reusing the reachability of an earlier search
+  \param reached reachability by snapshot index, see reachedNodes and KeepReached
+  \param lodCells level of detail grid merging small leaves before painting, see classifiedLeaves
+*/
+template< typename E, typename InisetT >
+Raster rasterize( const RefinementTree< E >& rtree, const InisetT& initialSet, const std::vector< bool >& reached
+		  , const uint& width, const uint& height, const uint& lodCells = 0, const uint& tileSize = 64 )
+{
+    const E& domain = rtree.initialEnclosure();
+    Raster raster( width, height, { domain[ 0 ].lower().get_d(), domain[ 0 ].upper().get_d(), domain[ 1 ].lower().get_d(), domain[ 1 ].upper().get_d() }
+		   , tileSize );
+    raster.paint( classifiedLeaves( rtree, initialSet, reached, lodCells ) );
+    return raster;
+}
+
+//! \return figure of the boxes of all inside vertices of a mapped graph, read directly from the mapping
+inline Ariadne::Figure visualize( const MappedGraph& g )
+{
+    auto toBox = [&g] (auto boundsOfDimension) {
+		     Ariadne::Array< Ariadne::ExactIntervalType > intervals( g.dimension() );
+		     for( size_t d = 0; d < g.dimension(); ++d )
+		     {
+			 const std::pair< double, double > b = boundsOfDimension( d );
+			 intervals[ d ] = Ariadne::ExactIntervalType( b.first, b.second );
+		     }
+		     return Ariadne::ExactBoxType( Ariadne::Vector( intervals ) );
+		 };
+
+    Ariadne::Figure fig( toBox( [&g] (const size_t& d) { return g.bounds( d ); } ), Ariadne::PlanarProjectionMap( 2,0,1 ) );
+    for( MappedGraph::VertexT v = 0; v < g.size(); ++v )
+    {
+	if( g.isInside( v ) )
+	    fig.draw( toBox( [&g, v] (const size_t& d) { return g.bounds( v, d ); } ) );
+    }
     return fig;
 }
 
@@ -3,7 +3,11 @@
 
 #include "testGroupInterface.hpp"
 #include "cegar.hpp"
+#include "parallelCegar.hpp"
+#include "guidedSearch.hpp"
+#include "visualization.hpp"
 #include "guide.hpp"
+#include "certificate.hpp"
 
 #include "expression/space.hpp"
 #include "expression/expression.hpp"
@@ -11,6 +15,8 @@
 // #include "function/function_set.hpp"
 
 #include <random>
+#include <deque>
+#include <set>
 
 struct CegarTest : public ITestGroup
 {
@@ -34,11 +40,11 @@ struct CegarTest : public ITestGroup
     	    return E( E::zero( 0 ) );
     }
     
-    template< typename E, typename R >
-    static typename RefinementTree< E >::NodeT refineRandomLeaf( RefinementTree< E >& rt, const R& refiner )
+    //! \return random node of rt other than the outside node
+    template< typename E >
+    static typename RefinementTree< E >::NodeT randomLeaf( const RefinementTree< E >& rt )
     {
 	auto vrange = graph::vertices( rt.graph() );
-	// need to store n otherwise graph part will be removed from memory (will be removed from graph)
 	typename RefinementTree< E >::NodeT n;
 	do
 	{
@@ -47,7 +53,14 @@ struct CegarTest : public ITestGroup
 	    std::advance( irefine, jump );
 	    n = *irefine;
 	} while( rt.equal( rt.outside(), n ) );
-							
+	return n;
+    }
+
+    template< typename E, typename R >
+    static typename RefinementTree< E >::NodeT refineRandomLeaf( RefinementTree< E >& rt, const R& refiner )
+    {
+	// need to store n otherwise graph part will be removed from memory (will be removed from graph)
+	typename RefinementTree< E >::NodeT n = randomLeaf( rt );
 	rt.refine( n, refiner );
 	return n;
     }
@@ -139,6 +152,31 @@ struct CegarTest : public ITestGroup
 	return new RefinementTree< BoxType >( safeSet, henon, e );
     }
 
+    /*!
+      \return refinement tree for the henon map with a = 1.4, b = 0.3 on a disc shaped safe set inside [-2,2]^2
+      states on the boundary of the disc contain safe and unsafe points, so many possibly unsafe leaves are reached along many paths
+    */
+    static ExactRefinementTree* discHenonMap()
+    {
+	Ariadne::EffectiveScalarFunction cx = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 0 )
+	    , cy = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 1 );
+	Ariadne::RealConstant radius = constant( "r", 3.0 );
+	Ariadne::BoundedConstraintSet safeSet( { {-2, 2}, {-2, 2} }, { cx*cx + cy*cy <= radius } );
+
+	Ariadne::RealVariable x( "x" ), y( "y" );
+	Ariadne::RealConstant a( "a", Ariadne::Real( 1.4 ) ), b( "b", Ariadne::Real( 0.3 ) );
+	Ariadne::EffectiveVectorFunction henon = Ariadne::make_function( {x, y}, {1 - a*x*x + y, b*x} );
+
+	return new ExactRefinementTree( safeSet, henon, Ariadne::Effort( 10 ) );
+    }
+
+    //! \brief resets pRtree to the henon map on [-3,3]^2 and pInitialSet to [0,0.5]^2, the fixture of the tests running cegar with observers
+    static void resetHenonRun( std::unique_ptr< ExactRefinementTree >& pRtree, std::unique_ptr< Ariadne::BoundedConstraintSet >& pInitialSet )
+    {
+	pRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 3, 3, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+	pInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, 0.5}, {0, 0.5} } ) );
+    }
+
     // find a counterexample in an obviously unsafe system
     class FindCounterexampleTest : public ITest
     {
@@ -163,6 +201,143 @@ struct CegarTest : public ITestGroup
 	STATEFUL_TEST( FindNoCounterexampleTest );
     };
 
+    // incremental search reaches the same possibly unsafe nodes as a search from scratch, also after searches terminated early
+    class IncrementalSearchTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	mutable IncrementalSearch< typename ExactRefinementTree::EnclosureT > mSearch;
+	STATEFUL_TEST( IncrementalSearchTest );
+    };
+
+    // searches reusing buffers find the counterexamples of searches with buffers of their own, repeated searches do not grow the buffers
+    class SearchBuffersTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	mutable SearchBuffers< typename ExactRefinementTree::EnclosureT > mBuffers;
+	STATEFUL_TEST( SearchBuffersTest );
+    };
+
+    // best first search reaches the unsafe nodes of bfs without a beam and finds valid counterexamples with one
+    class GuidedSearchTest : public ITest
+    {
+	static constexpr size_t mBeamWidth = 4;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	STATEFUL_TEST( GuidedSearchTest );
+    };
+
+    //! \class scores all states alike and counts how often it is called, so the states a search scores are known
+    //! \note declares no score dependence, so the store scores each state of each counterexample found
+    struct CountingStateValue
+    {
+	CountingStateValue() : mpCalls( std::make_shared< size_t >( 0 ) ) {}
+
+	template< typename Rtree, typename IterT >
+	double operator ()( const Rtree& rtree, const IterT& cexBegin, const IterT& cexEnd, const IterT& istate ) const
+	{
+	    ++*mpCalls;
+	    return 1;
+	}
+
+	template< typename Rtree >
+	double maxScore( const Rtree& rtree ) const { return 1; }
+
+	std::shared_ptr< size_t > mpCalls;
+    };
+
+    // bounded stores terminate searches once full of counterexamples reaching the bound the heuristics declare, after the first level reaching unsafe nodes
+    class BoundedSearchTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	GreatestState mCexH;
+	STATEFUL_TEST( BoundedSearchTest );
+    };
+
+    // reach map follows the expansion of the search, rasters paint leaves in their class colour and merging leaves preserves the area drawn
+    class VisualizationTest : public ITest
+    {
+	static constexpr uint mRasterSize = 96, mTileSize = 16, mLodCells = 4;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( VisualizationTest );
+    };
+
+    //! \class scores states by the index of their value, so scores of counterexamples are known
+    //! \note depends on the state only, so the store caches its scores
+    struct IndexStateValue
+    {
+	static constexpr ScoreDependence scoreDependence = ScoreDependence::STATE;
+
+	template< typename Rtree, typename IterT >
+	double operator ()( const Rtree& rtree, const IterT& cexBegin, const IterT& cexEnd, const IterT& istate ) const
+	{
+	    return graph::value( rtree.graph(), *istate )->index();
+	}
+    };
+
+    // counterexample store hands out counterexamples by decreasing score and none containing invalidated nodes, bounded stores the highest scoring ones
+    class CounterexampleStoreTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	IndexStateValue mStateH;
+	SumStates mCexH;
+	STATEFUL_TEST( CounterexampleStoreTest );
+    };
+
+    //! \class counting state value declaring dependence D, so the store caches its scores
+    template< ScoreDependence D >
+    struct CountingDependentValue : public CountingStateValue
+    {
+	static constexpr ScoreDependence scoreDependence = D;
+    };
+
+    // scores are cached across searches and dropped for refined nodes, counterexamples through their refinements are scored afresh
+    class ScoreCacheTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	mutable LargestSideRefiner mRefiner;
+	GreatestState mCexH;
+
+	//! \return true if the store of heuristic SH scores each state, or state and successor, once and drops the scores of a refined node
+	template< typename SH >
+	bool checkCache() const;
+
+	STATEFUL_TEST( ScoreCacheTest );
+    };
+
+    // maximum entropy locator samples inside states and picks reproducibly for a fixed seed
+    class MaximumEntropyTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( MaximumEntropyTest );
+    };
+
+    // concretization tests the centre, grid cell centres and corners of a state and finds every unsafe trajectory of the centre
+    class ConcretizationTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitial;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( ConcretizationTest );
+    };
+
     // no explicit test for isSpurious as it is hard to construct cases where a counterexample is definitely deemed spurious
 
     struct PrintInitialSet : public CegarObserver
@@ -334,6 +509,243 @@ struct CegarTest : public ITestGroup
 	STATELESS_TEST( VerifyCounterexamples );
     };
 
+    //! \class tests that successive states in counterexamples are reachable when refining whole counterexamples at once
+    class VerifyBatchCounterexamples : public ITest
+    {
+	static const uint mMaxNodesFactor = 10;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	CompleteCounterexample mLocator;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	LimitedIterations mTerm;
+	std::exponential_distribution<> mInitialBoxLengthDist = std::exponential_distribution<>( 25 )
+	    , mSafeBoxLengthDist = std::exponential_distribution<>( 0.01 );
+
+	STATELESS_TEST( VerifyBatchCounterexamples );
+    };
+
+    //! \class tests that the drivers decide alike and return valid counterexamples searching incrementally and from scratch
+    class SearchStrategyTest : public ITest
+    {
+	static const uint mMaxNodesFactor = 10;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	double mSafeWidth, mSafeHeight;
+	LargestSideRefiner mRefinement;
+	CompleteCounterexample mLocator;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	LimitedIterations mTerm;
+	std::exponential_distribution<> mInitialBoxLengthDist = std::exponential_distribution<>( 25 )
+	    , mSafeBoxLengthDist = std::exponential_distribution<>( 0.01 );
+
+	STATELESS_TEST( SearchStrategyTest );
+    };
+
+    //! \class verifies counterexamples once they are checked, i.e. after refinements for earlier counterexamples of the same batch
+    //! counterexamples used must not contain nodes refined since they were obtained and get their hooks in order, one of each per counterexample
+    struct CheckedCounterexampleVerifier : public CounterexampleVerifier
+    {
+	template< typename IterT >
+	void processCounterexample( const ExactRefinementTree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd )
+	{
+	    if( !mOpen.empty() )
+		mUnpaired = true;
+	    mOpen = indices( rtree, iCounterexBegin, iCounterexEnd );
+	    mChecking = false;
+	}
+
+	template< typename IterT >
+	void checkSpurious( const ExactRefinementTree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd )
+	{
+	    if( mChecking || mOpen != indices( rtree, iCounterexBegin, iCounterexEnd ) )
+		mUnpaired = true;
+	    mChecking = true;
+	}
+
+	void startRefinement( const ExactRefinementTree& rtree, const typename ExactRefinementTree::NodeT& toRefine )
+	{
+	    mRefined.insert( graph::value( rtree.graph(), toRefine )->index() );
+	}
+
+	template< typename IterT >
+	void spurious( const ExactRefinementTree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd, const Ariadne::ValidatedUpperKleenean& spurious )
+	{
+	    const std::vector< size_t > current = indices( rtree, iCounterexBegin, iCounterexEnd );
+	    if( !mChecking || mOpen != current )
+		mUnpaired = true;
+	    mOpen.clear();
+	    mChecking = false;
+	    if( !mBadCounterexample.empty() )
+		return;
+	    if( std::any_of( current.begin(), current.end(), [this] (const size_t& i) { return mRefined.count( i ) != 0; } ) )
+		mBadCounterexample = std::vector< typename ExactRefinementTree::NodeT >( iCounterexBegin, iCounterexEnd );
+	    else
+		CounterexampleVerifier::processCounterexample( rtree, iCounterexBegin, iCounterexEnd );
+	}
+
+	template< typename IterT >
+	static std::vector< size_t > indices( const ExactRefinementTree& rtree, IterT iCounterexBegin, const IterT& iCounterexEnd )
+	{
+	    std::vector< size_t > is;
+	    for( ; iCounterexBegin != iCounterexEnd; ++iCounterexBegin )
+		is.push_back( graph::value( rtree.graph(), *iCounterexBegin )->index() );
+	    return is;
+	}
+
+	std::vector< size_t > mOpen;  // counterexample whose hooks began, empty once spurious closed them
+	bool mChecking = false, mUnpaired = false;
+	std::set< size_t > mRefined;
+    };
+
+    //! \class tests that counterexamples checked concurrently are dropped once refinements for earlier ones invalidate them
+    class VerifyConcurrentChecks : public ITest
+    {
+	static const uint mMaxNodesFactor = 10;
+	static constexpr uint mCheckBatch = 8;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	LimitedIterations mTerm;
+	std::exponential_distribution<> mInitialBoxLengthDist = std::exponential_distribution<>( 4 );
+
+	STATELESS_TEST( VerifyConcurrentChecks );
+    };
+
+    //! \class tests that components of the initial image expand disjoint regions and that the parallel driver agrees with cegar
+    class ParallelCegarTest : public ITest
+    {
+	static const uint mMaxNodesFactor = 10;
+	std::unique_ptr< ExactRefinementTree > mpRtree, mpParallelRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	LimitedIterations mTerm;
+	std::exponential_distribution<> mInitialBoxLengthDist = std::exponential_distribution<>( 4 )
+	    , mSafeBoxLengthDist = std::exponential_distribution<>( 0.5 );
+
+	STATELESS_TEST( ParallelCegarTest );
+    };
+
+    //! \class tests that phases recorded during the loop are attributed to the iteration they were recorded in
+    class PhaseProfileTest : public ITest
+    {
+      public:
+	//! \class records a search of known latency in each iteration, independent of whether the library is instrumented
+	struct SearchRecorder : public CegarObserver
+	{
+	    static constexpr uint64_t LATENCY = 1000;
+	    uint mIterations = 0;
+
+	    void startIteration( const ExactRefinementTree& rtree ) { ++mIterations; }
+
+	    template< typename IterT >
+	    void searchCounterexample( const ExactRefinementTree& rtree, IterT iAbstractionsBegin, const IterT& iAbstractionsEnd )
+	    {
+		PhaseProfiler::instance().record( Phase::SEARCH, LATENCY );
+	    }
+	};
+
+      private:
+	static const uint mMaxNodesFactor = 5;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	LimitedIterations mTerm;
+
+	STATELESS_TEST( PhaseProfileTest );
+    };
+
+    //! \class tests that the iteration log writes one consistent record per iteration
+    class IterationLogTest : public ITest
+    {
+      private:
+	static const uint mMaxNodesFactor = 5;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	uint mTerm;
+
+	STATELESS_TEST( IterationLogTest );
+    };
+
+    //! \class tests that memory is sampled in each iteration, including the counterexample store watched
+    class MemoryObserverTest : public ITest
+    {
+      private:
+	static const uint mMaxNodesFactor = 5;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	uint mTerm;
+
+	STATELESS_TEST( MemoryObserverTest );
+    };
+
+    //! \class tests memory budget, safe volume plateau and their combinations
+    class TerminationTest : public ITest
+    {
+      private:
+	static const uint mMaxNodesFactor = 5;
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	uint mTerm;
+
+	STATELESS_TEST( TerminationTest );
+    };
+
+    //! \class counts the calls of some hooks and inherits the others
+    struct HookCounter : public CegarObserver
+    {
+	uint mStarts = 0, mRefinements = 0, mRefined = 0;
+
+	void startIteration( const ExactRefinementTree& rtree ) { ++mStarts; }
+
+	template< typename Rtree >
+	void startRefinement( const Rtree& rtree, const typename Rtree::NodeT& toRefine ) { ++mRefinements; }
+
+	template< typename Rtree, typename IterT >
+	void refined( const Rtree& rtree, IterT iRefinedBegin, const IterT& iRefinedEnd ) { ++mRefined; }
+    };
+
+    // hooks an observer defines are called, hooks it inherits from CegarObserver are skipped at compile time
+    class ObserverPruningTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	STATELESS_TEST( ObserverPruningTest );
+    };
+
+    //! \class tests that certificates of safe trees verify after a round trip and fail for other dynamics or safe sets
+    class CertificateTest : public ITest
+    {
+      private:
+	static const uint mMaxNodesFactor = 5;
+	std::unique_ptr< Ariadne::BoundedConstraintSet > mpInitialSet;
+	LargestSideRefiner mRefinement;
+	RandomStateValue mStateH;
+	GreatestState mCexH;
+	uint mTerm;
+
+	STATELESS_TEST( CertificateTest );
+    };
+
     // test that counterexample with single broken link is detected
     class LoopTest : public ITest
     {
@@ -2,6 +2,11 @@
 #include "testMacros.hpp"
 
 #include <limits>
+#include <set>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <algorithm>
 
 #ifndef DEBUG
 #define DEBUG false
@@ -105,138 +110,1364 @@ bool CegarTest::FindNoCounterexampleTest::check() const
     return true;
 }
 
+CegarTest::TEST_CTOR( IncrementalSearchTest, "incremental search finds the same unsafe nodes as full search" )
+
+void CegarTest::IncrementalSearchTest::init()
+{
+    // disc shaped safe set, so leaves on its boundary are possibly unsafe and reached along many paths
+    mpRtree.reset( discHenonMap() );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+    mSearch.clear();
+}
+
+void CegarTest::IncrementalSearchTest::iterate()
+{
+    // searches terminated by a store holding a single counterexample leave exploration to repair after refinement
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState >
+	boundedStore( mStateH, mCexH, 1, -std::numeric_limits< double >::infinity() );
+    mSearch.find( *mpRtree, initialNodes.begin(), initialNodes.end(), boundedStore );
+
+    typename ExactRefinementTree::NodeT n = randomLeaf( *mpRtree );
+    mSearch.invalidate( *mpRtree, n );
+    mpRtree->refine( n, mRefiner );
+}
+
+bool CegarTest::IncrementalSearchTest::check() const
+{
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+
+    typedef CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > StoreT;
+    StoreT incrementalStore( mStateH, mCexH ), fullStore( mStateH, mCexH );
+    mSearch.find( *mpRtree, initialNodes.begin(), initialNodes.end(), incrementalStore );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), fullStore );
+
+    auto unsafeEnds = [this] (StoreT& store) {
+	std::set< size_t > ends;
+	while( store.hasCounterexample() )
+	    ends.insert( graph::value( mpRtree->graph(), store.obtain().first.back() )->index() );
+	return ends;
+    };
+    std::set< size_t > incrementalEnds = unsafeEnds( incrementalStore ), fullEnds = unsafeEnds( fullStore );
+    if( incrementalEnds != fullEnds )
+    {
+	std::cout << "incremental search reached " << incrementalEnds.size() << " unsafe nodes, full search " << fullEnds.size() << std::endl;
+	return false;
+    }
+
+    // a search from scratch terminated by the first counterexample reaches no further unsafe node
+    IncrementalSearch< typename ExactRefinementTree::EnclosureT > terminated;
+    StoreT boundedStore( mStateH, mCexH, 1, -std::numeric_limits< double >::infinity() );
+    terminated.find( *mpRtree, initialNodes.begin(), initialNodes.end(), boundedStore );
+    size_t noReached = 0;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	if( fullEnds.count( graph::value( mpRtree->graph(), *vs.first )->index() ) && terminated.isReached( *mpRtree, *vs.first ) )
+	    ++noReached;
+    }
+    if( noReached != std::min< size_t >( fullEnds.size(), 1 ) )
+    {
+	std::cout << "search terminated by the first counterexample reached " << noReached << " of " << fullEnds.size() << " unsafe nodes" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( SearchBuffersTest, "searches reusing buffers find the same counterexamples" )
+
+void CegarTest::SearchBuffersTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+    mBuffers = SearchBuffers< typename ExactRefinementTree::EnclosureT >();
+}
+
+void CegarTest::SearchBuffersTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::SearchBuffersTest::check() const
+{
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+
+    typedef CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > StoreT;
+    StoreT reusedStore( mStateH, mCexH ), freshStore( mStateH, mCexH ), repeatedStore( mStateH, mCexH );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), reusedStore, mBuffers );
+    const size_t bytes = mBuffers.heapBytes();
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), repeatedStore, mBuffers );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), freshStore );
+    if( mBuffers.heapBytes() != bytes )
+    {
+	std::cout << "repeated search grew buffers from " << bytes << " to " << mBuffers.heapBytes() << " bytes" << std::endl;
+	return false;
+    }
+
+    auto unsafeEnds = [this] (StoreT& store) {
+	std::set< std::pair< size_t, size_t > > ends;
+	while( store.hasCounterexample() )
+	{
+	    auto cex = store.obtain().first;
+	    ends.insert( std::make_pair( graph::value( mpRtree->graph(), cex.back() )->index(), cex.size() ) );
+	}
+	return ends;
+    };
+    const std::set< std::pair< size_t, size_t > > freshEnds = unsafeEnds( freshStore );
+    if( unsafeEnds( reusedStore ) != freshEnds || unsafeEnds( repeatedStore ) != freshEnds )
+    {
+	std::cout << "search reusing buffers reached other unsafe nodes than search with buffers of its own" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( GuidedSearchTest, "best first search finds the counterexamples of bfs" )
+
+void CegarTest::GuidedSearchTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+}
+
+void CegarTest::GuidedSearchTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::GuidedSearchTest::check() const
+{
+    typedef typename ExactRefinementTree::SnapshotT SnapshotT;
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+
+    typedef CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > StoreT;
+    StoreT guidedStore( mStateH, mCexH ), beamStore( mStateH, mCexH ), bfsStore( mStateH, mCexH );
+    guidedCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), guidedStore, mStateH, mCexH );
+    guidedCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), beamStore, mStateH, mCexH, mBeamWidth );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), bfsStore );
+
+    auto unsafeEnds = [this] (StoreT& store) {
+	std::set< size_t > ends;
+	while( store.hasCounterexample() )
+	    ends.insert( graph::value( mpRtree->graph(), store.obtain().first.back() )->index() );
+	return ends;
+    };
+    if( unsafeEnds( guidedStore ) != unsafeEnds( bfsStore ) )
+    {
+	std::cout << "best first search reached other unsafe nodes than bfs" << std::endl;
+	return false;
+    }
+
+    // counterexamples of the beam start in the initial image, follow edges through safe nodes and end in a possibly unsafe node
+    const SnapshotT& snap = mpRtree->snapshot();
+    while( beamStore.hasCounterexample() )
+    {
+	auto cex = beamStore.obtain().first;
+	bool valid = std::any_of( initialNodes.begin(), initialNodes.end(), [&] (auto& n) { return mpRtree->equal( n, cex.front() ); } )
+	    && possibly( !mpRtree->isSafe( cex.back() ) );
+	for( size_t i = 0; valid && i + 1 < cex.size(); ++i )
+	{
+	    const typename SnapshotT::IndexT src = snap.index( graph::value( mpRtree->graph(), cex[ i ] ) )
+		, trg = snap.index( graph::value( mpRtree->graph(), cex[ i + 1 ] ) );
+	    valid = definitely( mpRtree->isSafe( cex[ i ] ) ) && graph::findEdgeTo( snap.graph(), src, trg ) != graph::outEdges( snap.graph(), src ).second;
+	}
+	if( !valid )
+	{
+	    std::cout << "beam search found invalid counterexample ";
+	    printCounterexample( *mpRtree, cex.begin(), cex.end() );
+	    return false;
+	}
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( BoundedSearchTest, "bounded stores stop searches once they reach the declared score bound" )
+
+void CegarTest::BoundedSearchTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+}
+
+void CegarTest::BoundedSearchTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::BoundedSearchTest::check() const
+{
+    typedef typename ExactRefinementTree::EnclosureT EncT;
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+
+    // the full search scores every state of every counterexample, which are as long as the depth of their unsafe node
+    CountingStateValue fullH, boundedH;
+    CounterexampleStore< EncT, CountingStateValue, GreatestState > full( fullH, mCexH ), bounded( boundedH, mCexH, 1 );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), full );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), bounded );
+    if( *fullH.mpCalls == 0 )
+	return true;
+    std::vector< size_t > lengths;
+    while( full.hasCounterexample() )
+	lengths.push_back( full.obtain().first.size() );
+    if( std::accumulate( lengths.begin(), lengths.end(), size_t( 0 ) ) != *fullH.mpCalls )
+    {
+	std::cout << "full search scored " << *fullH.mpCalls << " states for counterexamples of total length "
+		  << std::accumulate( lengths.begin(), lengths.end(), size_t( 0 ) ) << std::endl;
+	return false;
+    }
+
+    // all counterexamples score the bound 1, so the bounded search stops after the shallowest level reaching unsafe nodes
+    const size_t shortest = *std::min_element( lengths.begin(), lengths.end() );
+    const size_t expectedCalls = shortest * std::count( lengths.begin(), lengths.end(), shortest );
+    if( bounded.scoreBound() != 1 || !bounded.terminateSearch() || *boundedH.mpCalls != expectedCalls )
+    {
+	std::cout << "bounded search with bound " << bounded.scoreBound() << " scored " << *boundedH.mpCalls << " states instead of "
+		  << expectedCalls << ", the full search " << *fullH.mpCalls << std::endl;
+	return false;
+    }
+
+    // state volume bounds scores by the largest leaf, sums of states declare no bound and never stop early
+    CounterexampleStore< EncT, StateVolume, GreatestState > byVolume( StateVolume(), mCexH, 1 );
+    CounterexampleStore< EncT, CountingStateValue, SumStates > summed( CountingStateValue(), SumStates(), 1 );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), byVolume );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), summed );
+    double largest = 0;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	auto nval = mpRtree->nodeValue( *vs.first );
+	if( nval )
+	    largest = std::max( largest, nval.value().get().getEnclosure().measure().get_d() );
+    }
+    if( byVolume.scoreBound() != largest || summed.scoreBound() != std::numeric_limits< double >::infinity() )
+    {
+	std::cout << "volume bound " << byVolume.scoreBound() << " instead of " << largest << ", sum bound " << summed.scoreBound() << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( VisualizationTest, "visualization colours leaves by their class" )
+
+void CegarTest::VisualizationTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+}
+
+void CegarTest::VisualizationTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::VisualizationTest::check() const
+{
+    typedef typename ExactRefinementTree::EnclosureT EnclosureT;
+    typedef typename ExactRefinementTree::SnapshotT SnapshotT;
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+    const std::vector< bool > reached = reachedNodes( *mpRtree, initialNodes.begin(), initialNodes.end() );
+
+    // nodes are reached from the initial image through nodes the search expands
+    const SnapshotT& snap = mpRtree->snapshot();
+    std::vector< bool > expected( snap.size(), false );
+    for( auto& n : initialNodes )
+	expected[ snap.index( graph::value( mpRtree->graph(), n ) ) ] = true;
+    for( size_t i = 0; i < snap.size(); ++i )
+    {
+	if( !reached[ i ] || !definitely( snap.isSafe( i ) ) || definitely( snap.isTransSafe( i ) ) )
+	    continue;
+	for( auto outs = graph::outEdges( snap.graph(), i ); outs.first != outs.second; ++outs.first )
+	    expected[ graph::target( snap.graph(), *outs.first ) ] = true;
+    }
+    if( expected != reached )
+    {
+	std::cout << "reach map differs from the nodes the search expands into" << std::endl;
+	return false;
+    }
+
+    // the centre pixel of leaves spanning several pixels takes their class colour
+    const std::vector< std::pair< EnclosureT, StateClass > > leaves = classifiedLeaves( *mpRtree, *mpInitial, reached );
+    const Raster raster = rasterize( *mpRtree, *mpInitial, reached, mRasterSize, mRasterSize, 0, mTileSize );
+    auto area = [] (const EnclosureT& bx) {
+	return ( bx[ 0 ].upper().get_d() - bx[ 0 ].lower().get_d() ) * ( bx[ 1 ].upper().get_d() - bx[ 1 ].lower().get_d() ); };
+    const EnclosureT& domain = mpRtree->initialEnclosure();
+    const double pixelArea = area( domain ) / ( mRasterSize * mRasterSize );
+    for( const std::pair< EnclosureT, StateClass >& leaf : leaves )
+    {
+	if( area( leaf.first ) < 16 * pixelArea )
+	    continue;
+	auto lower = raster.pixelOf( leaf.first[ 0 ].lower().get_d(), leaf.first[ 1 ].upper().get_d() )
+	    , upper = raster.pixelOf( leaf.first[ 0 ].upper().get_d(), leaf.first[ 1 ].lower().get_d() );
+	if( upper.first < lower.first + 2 || upper.second < lower.second + 2 )
+	    continue;
+	const std::pair< uint, uint > centre = raster.pixelOf( 0.5 * ( leaf.first[ 0 ].lower().get_d() + leaf.first[ 0 ].upper().get_d() )
+								, 0.5 * ( leaf.first[ 1 ].lower().get_d() + leaf.first[ 1 ].upper().get_d() ) );
+	if( raster.pixel( centre.first, centre.second ) != Raster::classRgb( leaf.second ) )
+	{
+	    std::cout << "pixel " << centre.first << ", " << centre.second << " not coloured as the leaf containing it " << leaf.first << std::endl;
+	    return false;
+	}
+    }
+
+    // merged cells cover exactly the leaves they replace
+    const std::vector< std::pair< EnclosureT, StateClass > > merged = classifiedLeaves( *mpRtree, *mpInitial, reached, mLodCells );
+    double leafArea = 0, mergedArea = 0;
+    for( auto& leaf : leaves )
+	leafArea += area( leaf.first );
+    for( auto& leaf : merged )
+	mergedArea += area( leaf.first );
+    if( merged.size() > leaves.size() || std::abs( leafArea - mergedArea ) > 1e-6 * area( domain ) )
+    {
+	std::cout << "merging " << leaves.size() << " leaves of area " << leafArea << " resulted in " << merged.size() << " boxes of area " << mergedArea << std::endl;
+	return false;
+    }
+
+    // reachability kept by an observer of cegar is the one of the final tree, for runs ending refined and runs ending after a search
+    for( const uint iterations : { 3u, 1000u } )
+    {
+	std::unique_ptr< ExactRefinementTree > pRtree( henonMap< EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+	LargestSideRefiner refiner;
+	RandomStateValue stateH;
+	GreatestState cexH;
+	LimitedIterations termination( iterations );
+	KeepReached< EnclosureT > keeper( *mpInitial, Ariadne::Effort( 10 ) );
+	cegar( *pRtree, *mpInitial, Ariadne::Effort( 10 ), refiner, stateH, cexH, termination, keeper );
+	auto finalInitial = pRtree->intersection( *mpInitial, mIntersectConstraints );
+	if( keeper.reached() != reachedNodes( *pRtree, finalInitial.begin(), finalInitial.end() ) )
+	{
+	    std::cout << "reachability kept after " << iterations << " iterations differs from the one of the final tree" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( CounterexampleStoreTest, "counterexample store hands out valid counterexamples by score" )
+
+void CegarTest::CounterexampleStoreTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+}
+
+void CegarTest::CounterexampleStoreTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::CounterexampleStoreTest::check() const
+{
+    typedef std::vector< size_t > IndexPathT;
+    std::vector< typename ExactRefinementTree::NodeT > nodes;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+	nodes.push_back( *vs.first );
+    auto index = [this] (const typename ExactRefinementTree::NodeT& n) { return graph::value( mpRtree->graph(), n )->index(); };
+    std::uniform_int_distribution<> nodeDist( 0, nodes.size() - 1 ), lengthDist( 1, 6 );
+
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, IndexStateValue, SumStates > store( mStateH, mCexH );
+    // the second round reuses the store after it ran empty
+    for( uint round = 0; round < 2; ++round )
+    {
+	std::vector< typename ExactRefinementTree::NodeT > invalid;
+	std::set< size_t > invalidIndices;
+	for( uint i = 0; i < 3; ++i )
+	{
+	    invalid.push_back( nodes[ nodeDist( mRandom ) ] );
+	    invalidIndices.insert( index( invalid.back() ) );
+	}
+
+	// random paths, the store does not require them to be paths of the graph
+	std::multiset< IndexPathT > expected;
+	for( uint c = 0; c < 4 * nodes.size(); ++c )
+	{
+	    CounterexampleT< typename ExactRefinementTree::EnclosureT > cex;
+	    IndexPathT path;
+	    for( int l = lengthDist( mRandom ); l > 0; --l )
+	    {
+		cex.push_back( nodes[ nodeDist( mRandom ) ] );
+		path.push_back( index( cex.back() ) );
+	    }
+	    store.found( *mpRtree, cex.begin(), cex.end() );
+	    if( std::none_of( path.begin(), path.end(), [&invalidIndices] (const size_t& i) { return invalidIndices.count( i ) != 0; } ) )
+		expected.insert( path );
+	}
+	for( auto& n : invalid )
+	    store.invalidate( *mpRtree, n );
+
+	if( store.size() != expected.size() )
+	{
+	    std::cout << "store holds " << store.size() << " counterexamples after invalidation, expected " << expected.size() << std::endl;
+	    return false;
+	}
+	double lastScore = std::numeric_limits< double >::max();
+	while( store.hasCounterexample() )
+	{
+	    IndexPathT path;
+	    for( auto& n : store.obtain().first )
+		path.push_back( index( n ) );
+	    const double score = std::accumulate( path.begin(), path.end(), 0.0 );
+	    auto iexpected = expected.find( path );
+	    if( iexpected == expected.end() || score > lastScore )
+	    {
+		std::cout << "obtained " << ( iexpected == expected.end() ? "unexpected" : "higher scoring" ) << " counterexample of score " << score << std::endl;
+		return false;
+	    }
+	    expected.erase( iexpected );
+	    lastScore = score;
+	}
+	if( !expected.empty() )
+	    return false;
+    }
+
+    // a bounded store keeps the highest scores, scores are non-negative so a full store needs no more with bound 0
+    const size_t capacity = 5;
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, IndexStateValue, SumStates > bounded( mStateH, mCexH, capacity, 0 );
+    std::vector< double > scores;
+    for( uint c = 0; c < 4 * nodes.size(); ++c )
+    {
+	if( bounded.terminateSearch() != ( c >= capacity ) )
+	{
+	    std::cout << "bounded store " << ( c >= capacity ? "does not terminate" : "terminates" ) << " holding " << bounded.size() << std::endl;
+	    return false;
+	}
+	CounterexampleT< typename ExactRefinementTree::EnclosureT > cex;
+	for( int l = lengthDist( mRandom ); l > 0; --l )
+	    cex.push_back( nodes[ nodeDist( mRandom ) ] );
+	bounded.found( *mpRtree, cex.begin(), cex.end() );
+	scores.push_back( std::accumulate( cex.begin(), cex.end(), 0.0, [&index] (const double& sum, auto& n) { return sum + index( n ); } ) );
+    }
+    std::sort( scores.begin(), scores.end(), std::greater< double >() );
+    scores.resize( std::min( scores.size(), capacity ) );
+    std::vector< double > obtained;
+    while( bounded.hasCounterexample() )
+    {
+	auto cex = bounded.obtain().first;
+	obtained.push_back( std::accumulate( cex.begin(), cex.end(), 0.0, [&index] (const double& sum, auto& n) { return sum + index( n ); } ) );
+    }
+    if( obtained != scores )
+    {
+	std::cout << "bounded store returned " << obtained.size() << " counterexamples, not the " << scores.size() << " highest scoring" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( ScoreCacheTest, "cached scores are reused and dropped for refined nodes" )
+
+void CegarTest::ScoreCacheTest::init()
+{
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( 2, 2, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-0.5, 0.5}, {-0.5, 0.5} } ) ) );
+}
+
+void CegarTest::ScoreCacheTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+template< typename SH >
+bool CegarTest::ScoreCacheTest::checkCache() const
+{
+    typedef typename ExactRefinementTree::NodeT NodeT;
+    // states are keyed by index, or by index of state and successor, the last state having none
+    auto keys = [this] (const std::vector< NodeT >& cex) {
+	std::set< std::pair< size_t, size_t > > ks;
+	for( size_t s = 0; s < cex.size(); ++s )
+	{
+	    const size_t i = graph::value( mpRtree->graph(), cex[ s ] )->index();
+	    if( SH::scoreDependence == ScoreDependence::STATE )
+		ks.insert( std::make_pair( i, 0 ) );
+	    else
+		ks.insert( std::make_pair( i, s + 1 < cex.size() ? graph::value( mpRtree->graph(), cex[ s + 1 ] )->index()
+					   : std::numeric_limits< size_t >::max() ) );
+	}
+	return ks;
+    };
+
+    SH stateH;
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, SH, GreatestState > store( stateH, mCexH );
+    auto initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), store );
+    std::set< std::pair< size_t, size_t > > scored;
+    std::vector< std::pair< std::vector< NodeT >, NodeT > > found;
+    while( store.hasCounterexample() )
+    {
+	found.push_back( store.obtain() );
+	const std::set< std::pair< size_t, size_t > > ks = keys( found.back().first );
+	scored.insert( ks.begin(), ks.end() );
+    }
+    if( *stateH.mpCalls != scored.size() )
+    {
+	std::cout << "scored " << *stateH.mpCalls << " times for " << scored.size() << " distinct states" << std::endl;
+	return false;
+    }
+
+    // searching again hits the cache only
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), store );
+    if( *stateH.mpCalls != scored.size() )
+    {
+	std::cout << "repeated search scored " << *stateH.mpCalls - scored.size() << " states again" << std::endl;
+	return false;
+    }
+    store.clear();
+
+    auto irefine = std::find_if( found.begin(), found.end(), [this] (auto& cex) { return mpRtree->nodeValue( cex.second ).has_value(); } );
+    if( irefine == found.end() )
+	return true;
+    const NodeT refine = irefine->second;
+    const size_t refinedIndex = graph::value( mpRtree->graph(), refine )->index();
+    if( store.cachedScores( refinedIndex ) == 0 )
+    {
+	std::cout << "no score cached for state " << refinedIndex << " of a counterexample" << std::endl;
+	return false;
+    }
+    store.invalidate( *mpRtree, refine );
+    if( store.cachedScores( refinedIndex ) != 0 )
+    {
+	std::cout << store.cachedScores( refinedIndex ) << " scores still cached for invalidated state " << refinedIndex << std::endl;
+	return false;
+    }
+    mpRtree->refine( refine, mRefiner );
+    initialNodes = mpRtree->intersection( *mpInitial, mIntersectConstraints );
+
+    // only states, or states and successors, not scored before are scored, e.g. predecessors of the refinement
+    const size_t callsBefore = *stateH.mpCalls;
+    findCounterexample( *mpRtree, initialNodes.begin(), initialNodes.end(), store );
+    std::set< std::pair< size_t, size_t > > fresh;
+    while( store.hasCounterexample() )
+    {
+	for( const std::pair< size_t, size_t >& k : keys( store.obtain().first ) )
+	{
+	    if( !scored.count( k ) )
+		fresh.insert( k );
+	}
+    }
+    if( *stateH.mpCalls - callsBefore != fresh.size() )
+    {
+	std::cout << "scored " << *stateH.mpCalls - callsBefore << " states after refinement instead of " << fresh.size() << std::endl;
+	return false;
+    }
+    return true;
+}
+
+bool CegarTest::ScoreCacheTest::check() const
+{
+    return checkCache< CountingDependentValue< ScoreDependence::STATE > >()
+	&& checkCache< CountingDependentValue< ScoreDependence::SUCCESSOR > >();
+}
+
+CegarTest::TEST_CTOR( MaximumEntropyTest, "maximum entropy samples inside states and picks reproducibly" )
+
+void CegarTest::MaximumEntropyTest::init()
+{
+    // disc shaped safe set, so states on its boundary contain safe and unsafe points
+    mpRtree.reset( discHenonMap() );
+}
+
+void CegarTest::MaximumEntropyTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::MaximumEntropyTest::check() const
+{
+    typedef MaximumEntropy< 16 > LocatorT;
+    const uint64_t seed = std::uniform_int_distribution< uint64_t >()( mRandom );
+    const CounterRandom random( seed );
+
+    std::vector< typename ExactRefinementTree::NodeT > leaves;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	leaves.push_back( *vs.first );
+	auto nval = mpRtree->nodeValue( *vs.first );
+	if( !nval )
+	    continue;
+	const Ariadne::ExactBoxType& bx = nval.value().get().getEnclosure();
+	const uint64_t stream = nval.value().get().id();
+	std::vector< double > pts = LocatorT::samplePoints( bx, random, stream );
+	if( pts != LocatorT::samplePoints( bx, random, stream ) )
+	{
+	    std::cout << "samples of stream " << stream << " differ when drawn again" << std::endl;
+	    return false;
+	}
+	for( uint cCoord = 0; cCoord < pts.size(); ++cCoord )
+	{
+	    const uint d = cCoord % bx.dimension();
+	    if( pts[ cCoord ] < bx[ d ].lower().get_d() || pts[ cCoord ] > bx[ d ].upper().get_d() )
+	    {
+		std::cout << "sample coordinate " << pts[ cCoord ] << " outside of " << bx << std::endl;
+		return false;
+	    }
+	}
+    }
+
+    LocatorT locator1( seed ), locator2( seed );
+    auto pick1 = locator1( *mpRtree, leaves.begin(), leaves.end() ), pick2 = locator2( *mpRtree, leaves.begin(), leaves.end() );
+    if( pick1.size() != 1 || pick2.size() != 1 || !mpRtree->equal( pick1.front().get(), pick2.front().get() ) )
+    {
+	std::cout << "locators seeded equally picked different states" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::TEST_CTOR( ConcretizationTest, "concretization tests grid and corner points and all unsafe centres" )
+
+void CegarTest::ConcretizationTest::init()
+{
+    mpRtree.reset( discHenonMap() );
+    mpInitial.reset( new Ariadne::BoundedConstraintSet( { {-1, 1}, {-1, 1} } ) );
+}
+
+void CegarTest::ConcretizationTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool CegarTest::ConcretizationTest::check() const
+{
+    const Ariadne::Effort effort( 10 );
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	auto nval = mpRtree->nodeValue( *vs.first );
+	if( !nval )
+	    continue;
+	const Ariadne::ExactBoxType& bx = nval.value().get().getEnclosure();
+	for( uint divisions = 0; divisions <= 3; ++divisions )
+	{
+	    auto pts = concretizationPoints( bx, divisions );
+	    // without divisions only the centre is tested
+	    const size_t expected = divisions == 0 ? 1 : 1 + divisions * divisions - divisions % 2 + 4;
+	    if( pts.size() != expected )
+	    {
+		std::cout << pts.size() << " concretization points for " << divisions << " divisions, expected " << expected << std::endl;
+		return false;
+	    }
+	    auto iOut = std::find_if( pts.begin(), pts.end(), [&bx] (auto& pt) { return !possibly( bx.contains( pt ) ); } );
+	    if( iOut != pts.end() )
+	    {
+		std::cout << "concretization point " << *iOut << " outside of " << bx << std::endl;
+		return false;
+	    }
+	}
+
+	// the centre is one of the points tested
+	const CounterexampleT< typename ExactRefinementTree::EnclosureT > cex = { *vs.first };
+	if( definitely( !safeTrajectory( *mpRtree, *vs.first, bx.centre(), *mpInitial, effort ) )
+	    && possibly( isCounterexampleSafe( *mpRtree, cex, *mpInitial, effort, 3 ) ) )
+	{
+	    std::cout << "unsafe trajectory of centre of " << bx << " not found by concretization" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
 CegarTest::InitialAbstraction::InitialAbstraction( uint size, uint repetitions )
     : ITest( "initial abstractions are complete and only complete", size, repetitions )
     , mTerm( size * mMaxNodesFactor )
 {}
 
-void CegarTest::InitialAbstraction::iterate()
+void CegarTest::InitialAbstraction::iterate()
+{
+    double wid = mInitialBoxLengthDist( mRandom )
+	, hig = mInitialBoxLengthDist( mRandom )
+	, delta = mDeltaDist( mRandom );
+
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( wid + delta, hig + delta
+									 , 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+
+    Ariadne::EffectiveScalarFunction cx = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 0 )
+	    , cy = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 1 );
+    Ariadne::RealConstant w = constant( "w", wid )
+	, h = constant( "h", hig )
+	, zero = constant( "zero", 0.0 );
+    
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wid}, {0, hig} },
+							   { zero <= cx <= w, zero <= cy <= h } ) );
+}
+
+bool CegarTest::InitialAbstraction::check() const
+{
+    Ariadne::Effort effort( 10 );
+    CheckInitialSet checkObs( *mpRtree, Ariadne::ConstraintSet( mpInitialSet->constraints() ), effort );
+    KeepInitialSet< ExactRefinementTree > keeper;
+
+    cegar( *mpRtree, *mpInitialSet, effort, mRefinement, mStateH, mCexH, mTerm, checkObs, keeper );
+    if( checkObs.mpIssue )
+    {
+	std::cout << "found " << *checkObs.mpIssue << " in initial set, even though it is not in " << *mpInitialSet << std::endl;
+	return false;
+    }
+    
+    // verify that all final leaf nodes inside the initial set are contained
+    ExactRefinementTree::NodeComparator ncomp( *mpRtree );
+    for( auto leafRange = mpRtree->graph().vertices(); leafRange.first != leafRange.second; ++leafRange.first )
+    {
+	if( definitely( mpRtree->overlapsConstraints( *mpInitialSet, *leafRange.first ) ) )
+	{
+	    // nodes kept from the last search may have been refined since, their handles must not be read
+	    auto ifound = std::find_if( keeper.mNodes.begin(), keeper.mNodes.end()
+					, [&] (const typename ExactRefinementTree::NodeT& kept) {
+					      return mpRtree->graph().contains( kept ) && ncomp( *leafRange.first, kept ); } );
+	    if( ifound == keeper.mNodes.end() )
+	    {
+		std::cout << "node in initial set ";
+		printNode( *mpRtree, *leafRange.first );
+		std::cout << " is not contained in the initial set of the last iteration " << std::endl;
+		return false;
+	    }
+	}
+    }
+    
+    return true;
+}
+
+CegarTest::VerifySafety::VerifySafety( uint size, uint repetitions )
+    : ITest( "verify safe by construction system", size, repetitions )
+    , mTerm( size * mMaxNodesFactor )
+{}
+
+void CegarTest::VerifySafety::iterate()
+{
+    double wid = mInitialBoxLengthDist( mRandom )
+	, hig = mInitialBoxLengthDist( mRandom )
+	, delta = mDeltaDist( mRandom )
+	, boundary = std::max( wid + delta, hig + delta )
+	, attraction = mAttractionDist( mRandom );
+
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-wid, wid}, {-hig, hig} } ) ) );
+
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::RealConstant a( "a", Ariadne::Real( attraction ) );
+    Ariadne::EffectiveVectorFunction insideMap = Ariadne::make_function( {x, y}, {a*x, a*y} );
+
+    // figure out how to use bounds on safe region to do this
+    Ariadne::RealBox initialAbs = { {-boundary, boundary}, {-boundary, boundary} };
+
+    mpRtree.reset( new ExactRefinementTree( Ariadne::BoundedConstraintSet( initialAbs ), insideMap, Ariadne::Effort( 10 ) ) );
+}
+
+bool CegarTest::VerifySafety::check() const
+{
+    auto cegarResult = cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm
+			      // , iniPrint, cexPrint
+			      );
+    if( !definitely( cegarResult.first ) )
+    {
+	std::cout << "could not verify safety of system safe by construction, safety " << cegarResult.first
+		  << " with " << graph::size( mpRtree->graph() ) << " nodes "
+		  << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::VerifyCounterexamples::VerifyCounterexamples( uint size, uint reps )
+    : ITest( "verify consecutive nodes in counterexample are reachable", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::VerifyCounterexamples::iterate()
+{
+    D( std::cout << "verify counterexamples iteration" << std::endl; );
+    double wi = mInitialBoxLengthDist( mRandom )
+	, hi = mInitialBoxLengthDist( mRandom )
+	, ws = mSafeBoxLengthDist( mRandom )
+	, hs = mSafeBoxLengthDist( mRandom );
+    
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( ws, hs, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wi}, {0, hi} } ) );
+}
+
+bool CegarTest::VerifyCounterexamples::check() const
+{
+    CounterexampleVerifier verifier;
+    cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm, verifier );
+
+    if( !verifier.mBadCounterexample.empty() )
+    {
+	std::cout << "found counterexample with bad link " << std::endl;
+	printCounterexample( *mpRtree, verifier.mBadCounterexample.begin(), verifier.mBadCounterexample.end() );
+	std::cout << "bad link being ";
+	printNode( *mpRtree, *(verifier.mBadLink - 1) );
+	std::cout << " -> ";
+	printNode( *mpRtree, *verifier.mBadLink );
+	std::cout << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::VerifyBatchCounterexamples::VerifyBatchCounterexamples( uint size, uint reps )
+    : ITest( "verify consecutive nodes in counterexample are reachable with batch refinement", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::VerifyBatchCounterexamples::iterate()
+{
+    double wi = mInitialBoxLengthDist( mRandom )
+	, hi = mInitialBoxLengthDist( mRandom )
+	, ws = mSafeBoxLengthDist( mRandom )
+	, hs = mSafeBoxLengthDist( mRandom );
+    
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( ws, hs, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wi}, {0, hi} } ) );
+}
+
+bool CegarTest::VerifyBatchCounterexamples::check() const
+{
+    CounterexampleVerifier verifier;
+    batchCegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mLocator, mStateH, mCexH, mTerm, verifier );
+
+    if( !verifier.mBadCounterexample.empty() )
+    {
+	std::cout << "found counterexample with bad link " << std::endl;
+	printCounterexample( *mpRtree, verifier.mBadCounterexample.begin(), verifier.mBadCounterexample.end() );
+	return false;
+    }
+    return true;
+}
+
+CegarTest::SearchStrategyTest::SearchStrategyTest( uint size, uint reps )
+    : ITest( "drivers searching incrementally and from scratch decide alike", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::SearchStrategyTest::iterate()
+{
+    const double wi = mInitialBoxLengthDist( mRandom ), hi = mInitialBoxLengthDist( mRandom );
+    mSafeWidth = mSafeBoxLengthDist( mRandom );
+    mSafeHeight = mSafeBoxLengthDist( mRandom );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wi}, {0, hi} } ) );
+}
+
+bool CegarTest::SearchStrategyTest::check() const
+{
+    // each driver runs on trees of its own, one per strategy
+    typedef std::pair< Ariadne::ValidatedKleenean, CounterexampleT< typename ExactRefinementTree::EnclosureT > > ResultT;
+    const std::vector< std::string > drivers = { "cegar", "boundedCegar", "batchCegar" };
+    std::vector< std::vector< ResultT > > results( drivers.size() );
+    for( const SearchStrategy strategy : { SearchStrategy::INCREMENTAL, SearchStrategy::FULL } )
+    {
+	CegarOptions options;
+	options.mSearch = strategy;
+	for( uint d = 0; d < drivers.size(); ++d )
+	{
+	    std::unique_ptr< ExactRefinementTree > pRtree( henonMap< typename ExactRefinementTree::EnclosureT >( mSafeWidth, mSafeHeight, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+	    CounterexampleVerifier verifier;
+	    if( d == 0 )
+		results[ d ].push_back( cegar( *pRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm, options, verifier ) );
+	    else if( d == 1 )
+		results[ d ].push_back( boundedCegar( *pRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, 4, mTerm, options, verifier ) );
+	    else
+		results[ d ].push_back( batchCegar( *pRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mLocator, mStateH, mCexH, mTerm, options, verifier ) );
+	    if( !verifier.mBadCounterexample.empty() )
+	    {
+		std::cout << drivers[ d ] << ( strategy == SearchStrategy::FULL ? " searching from scratch" : " searching incrementally" )
+			  << " found counterexample with bad link" << std::endl;
+		return false;
+	    }
+	}
+    }
+    for( uint d = 0; d < drivers.size(); ++d )
+    {
+	const ResultT& incremental = results[ d ].front(), & full = results[ d ].back();
+	if( ( definitely( incremental.first ) && definitely( !full.first ) ) || ( definitely( !incremental.first ) && definitely( full.first ) ) )
+	{
+	    std::cout << drivers[ d ] << " decided " << incremental.first << " searching incrementally but " << full.first << " from scratch" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+CegarTest::VerifyConcurrentChecks::VerifyConcurrentChecks( uint size, uint reps )
+    : ITest( "verify counterexamples checked concurrently are valid when used", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::VerifyConcurrentChecks::iterate()
 {
-    double wid = mInitialBoxLengthDist( mRandom )
-	, hig = mInitialBoxLengthDist( mRandom )
-	, delta = mDeltaDist( mRandom );
+    // disc shaped safe set, so many possibly unsafe leaves are reached and batches hold several counterexamples
+    double wi = mInitialBoxLengthDist( mRandom )
+	, hi = mInitialBoxLengthDist( mRandom );
+    mpRtree.reset( discHenonMap() );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wi}, {0, hi} } ) );
+}
 
-    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( wid + delta, hig + delta
-									 , 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+bool CegarTest::VerifyConcurrentChecks::check() const
+{
+    CheckedCounterexampleVerifier verifier;
+    CegarOptions options;
+    options.mCheckBatch = mCheckBatch;
+    cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm, options, verifier );
 
-    Ariadne::EffectiveScalarFunction cx = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 0 )
-	    , cy = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 1 );
-    Ariadne::RealConstant w = constant( "w", wid )
-	, h = constant( "h", hig )
-	, zero = constant( "zero", 0.0 );
-    
-    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wid}, {0, hig} },
-							   { zero <= cx <= w, zero <= cy <= h } ) );
+    if( verifier.mUnpaired || !verifier.mOpen.empty() )
+    {
+	std::cout << "hooks of a checked counterexample are not paired" << std::endl;
+	return false;
+    }
+    if( !verifier.mBadCounterexample.empty() )
+    {
+	std::cout << "used counterexample with bad link " << std::endl;
+	printCounterexample( *mpRtree, verifier.mBadCounterexample.begin(), verifier.mBadCounterexample.end() );
+	return false;
+    }
+    return true;
 }
 
-bool CegarTest::InitialAbstraction::check() const
+CegarTest::ParallelCegarTest::ParallelCegarTest( uint size, uint reps )
+    : ITest( "parallel cegar searches disjoint components and agrees with cegar", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::ParallelCegarTest::iterate()
 {
-    Ariadne::Effort effort( 10 );
-    CheckInitialSet checkObs( *mpRtree, Ariadne::ConstraintSet( mpInitialSet->constraints() ), effort );
-    KeepInitialSet< ExactRefinementTree > keeper;
+    // initial set straddling the origin, so refined trees have several initial nodes
+    double wi = mInitialBoxLengthDist( mRandom )
+	, hi = mInitialBoxLengthDist( mRandom )
+	, ws = 1 + mSafeBoxLengthDist( mRandom )
+	, hs = 1 + mSafeBoxLengthDist( mRandom );
 
-    cegar( *mpRtree, *mpInitialSet, effort, mRefinement, mStateH, mCexH, mTerm, checkObs, keeper );
-    if( checkObs.mpIssue )
+    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( ws, hs, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpParallelRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( ws, hs, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {-wi, wi}, {-hi, hi} } ) );
+    for( uint i = 0; i < mTestSize; ++i )
+	refineRandomLeaf( *mpParallelRtree, mRefinement );
+}
+
+bool CegarTest::ParallelCegarTest::check() const
+{
+    typedef typename ExactRefinementTree::SnapshotT SnapshotT;
+    typedef typename SnapshotT::IndexT IndexT;
+
+    // every initial node is in exactly one component and no region expanded is shared by components
+    InitialImage< typename ExactRefinementTree::EnclosureT > initialImage( *mpParallelRtree, *mpInitialSet, Ariadne::Effort( 10 ) );
+    auto components = searchComponents( *mpParallelRtree, initialImage.begin(), initialImage.end() );
+    const SnapshotT& snap = mpParallelRtree->snapshot();
+    std::vector< size_t > owner( snap.size(), components.size() );
+    size_t noInitial = 0;
+    for( size_t c = 0; c < components.size(); ++c )
     {
-	std::cout << "found " << *checkObs.mpIssue << " in initial set, even though it is not in " << *mpInitialSet << std::endl;
+	noInitial += components[ c ].size();
+	std::vector< IndexT > frontier;
+	for( auto& n : components[ c ] )
+	    frontier.push_back( snap.index( graph::value( mpParallelRtree->graph(), n ) ) );
+	while( !frontier.empty() )
+	{
+	    const IndexT i = frontier.back();
+	    frontier.pop_back();
+	    if( !definitely( snap.isSafe( i ) ) || definitely( snap.isTransSafe( i ) ) || owner[ i ] == c )
+		continue;
+	    if( owner[ i ] != components.size() )
+	    {
+		std::cout << "components " << owner[ i ] << " and " << c << " both expand node " << i << std::endl;
+		return false;
+	    }
+	    owner[ i ] = c;
+	    for( auto outs = graph::outEdges( snap.graph(), i ); outs.first != outs.second; ++outs.first )
+		frontier.push_back( graph::target( snap.graph(), *outs.first ) );
+	}
+    }
+    if( noInitial != initialImage.size() )
+    {
+	std::cout << "components hold " << noInitial << " of " << initialImage.size() << " initial nodes" << std::endl;
 	return false;
     }
-    
-    // verify that all final leaf nodes inside the initial set are contained
-    ExactRefinementTree::NodeComparator ncomp( *mpRtree );
-    for( auto leafRange = mpRtree->graph().vertices(); leafRange.first != leafRange.second; ++leafRange.first )
+
+    auto result = cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm );
+    auto parallelResult = parallelCegar( *mpParallelRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm );
+    if( ( definitely( result.first ) && definitely( !parallelResult.first ) ) || ( definitely( !result.first ) && definitely( parallelResult.first ) ) )
     {
-	if( definitely( mpRtree->overlapsConstraints( *mpInitialSet, *leafRange.first ) ) )
+	std::cout << "cegar decided " << result.first << " but parallel cegar decided " << parallelResult.first << std::endl;
+	return false;
+    }
+    if( definitely( !parallelResult.first ) )
+    {
+	CounterexampleVerifier verifier;
+	verifier.processCounterexample( *mpParallelRtree, parallelResult.second.begin(), parallelResult.second.end() );
+	if( !verifier.mBadCounterexample.empty() )
 	{
-	    auto ifound = std::find_if( keeper.mNodes.begin(), keeper.mNodes.end()
-					, std::bind( &ExactRefinementTree::NodeComparator::operator()
-						     , &ncomp, *leafRange.first, std::placeholders::_1 ) );
-	    if( ifound == keeper.mNodes.end() )
+	    std::cout << "parallel cegar returned counterexample with bad link " << std::endl;
+	    printCounterexample( *mpParallelRtree, verifier.mBadCounterexample.begin(), verifier.mBadCounterexample.end() );
+	    return false;
+	}
+    }
+    return true;
+}
+
+CegarTest::PhaseProfileTest::PhaseProfileTest( uint size, uint reps )
+    : ITest( "phase profile is collected per iteration", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::PhaseProfileTest::iterate()
+{
+    resetHenonRun( mpRtree, mpInitialSet );
+}
+
+bool CegarTest::PhaseProfileTest::check() const
+{
+    SearchRecorder recorder;
+    PhaseProfileObserver profile;
+    LimitedIterations term( mTerm );
+    cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, term, recorder, profile );
+
+    if( profile.iterations().size() != recorder.mIterations )
+    {
+	std::cout << "profiled " << profile.iterations().size() << " of " << recorder.mIterations << " iterations" << std::endl;
+	return false;
+    }
+    const size_t search = static_cast< size_t >( Phase::SEARCH )
+	, latencyBucket = PhaseStats::bucket( SearchRecorder::LATENCY );
+    for( const PhaseProfileT& it : profile.iterations() )
+    {
+	if( it[ search ].mCalls < 1 || it[ search ].mHistogram[ latencyBucket ] < 1 || it[ search ].mNanoseconds < SearchRecorder::LATENCY )
+	{
+	    std::cout << "search recorded in iteration missing from its profile" << std::endl;
+	    return false;
+	}
+	for( const PhaseStats& stats : it )
+	{
+	    if( std::accumulate( stats.mHistogram.begin(), stats.mHistogram.end(), uint64_t( 0 ) ) != stats.mCalls )
 	    {
-		std::cout << "node in initial set ";
-		printNode( *mpRtree, *leafRange.first );
-		std::cout << " is not contained in the initial set of the last iteration " << std::endl;
+		std::cout << "histogram does not count all " << stats.mCalls << " calls" << std::endl;
 		return false;
 	    }
 	}
     }
-    
+    return profile.total()[ search ].mCalls >= recorder.mIterations;
+}
+
+CegarTest::IterationLogTest::IterationLogTest( uint size, uint reps )
+    : ITest( "iteration log streams one record per iteration", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
+
+void CegarTest::IterationLogTest::iterate()
+{
+    resetHenonRun( mpRtree, mpInitialSet );
+}
+
+bool CegarTest::IterationLogTest::check() const
+{
+    std::stringstream ss;
+    IterationCounter iterations;
+    CounterexampleLengthAverage cexLength;
+    LimitedIterations term( mTerm );
+    {
+	IterationLog log( ss );
+	cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, term, iterations, cexLength, log );
+    }
+
+    std::string line;
+    std::getline( ss, line );
+    if( line != IterationLog::header() )
+    {
+	std::cout << "log does not start with header but " << line << std::endl;
+	return false;
+    }
+    std::vector< IterationRecord > records;
+    while( std::getline( ss, line ) )
+    {
+	std::replace( line.begin(), line.end(), ',', ' ' );
+	std::istringstream fields( line );
+	IterationRecord r;
+	fields >> r.mIteration >> r.mNodes >> r.mEdges >> r.mFrontier >> r.mCounterexamples >> r.mSearchNs >> r.mCheckNs >> r.mRefineNs >> r.mOtherNs;
+	if( !fields )
+	{
+	    std::cout << "malformed record " << line << std::endl;
+	    return false;
+	}
+	records.push_back( r );
+    }
+
+    if( records.size() != iterations.iterations() )
+    {
+	std::cout << "logged " << records.size() << " of " << iterations.iterations() << " iterations" << std::endl;
+	return false;
+    }
+    uint64_t counterexamples = 0;
+    for( uint i = 0; i < records.size(); ++i )
+    {
+	if( records[ i ].mIteration != i || records[ i ].mFrontier == 0 || records[ i ].mEdges == 0
+	    || ( i > 0 && records[ i ].mNodes < records[ i - 1 ].mNodes ) || records[ i ].mNodes > graph::size( mpRtree->graph() ) )
+	{
+	    std::cout << "inconsistent record of iteration " << i << std::endl;
+	    return false;
+	}
+	counterexamples += records[ i ].mCounterexamples;
+    }
+    if( counterexamples != cexLength.counterexamples() )
+    {
+	std::cout << "logged " << counterexamples << " of " << cexLength.counterexamples() << " counterexamples" << std::endl;
+	return false;
+    }
     return true;
 }
 
-CegarTest::VerifySafety::VerifySafety( uint size, uint repetitions )
-    : ITest( "verify safe by construction system", size, repetitions )
-    , mTerm( size * mMaxNodesFactor )
+CegarTest::MemoryObserverTest::MemoryObserverTest( uint size, uint reps )
+    : ITest( "memory is sampled in each iteration", size, reps )
+    , mTerm( mMaxNodesFactor * size )
 {}
 
-void CegarTest::VerifySafety::iterate()
+void CegarTest::MemoryObserverTest::iterate()
 {
-    double wid = mInitialBoxLengthDist( mRandom )
-	, hig = mInitialBoxLengthDist( mRandom )
-	, delta = mDeltaDist( mRandom )
-	, boundary = std::max( wid + delta, hig + delta )
-	, attraction = mAttractionDist( mRandom );
+    resetHenonRun( mpRtree, mpInitialSet );
+}
 
-    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( Ariadne::RealBox( { {-wid, wid}, {-hig, hig} } ) ) );
+bool CegarTest::MemoryObserverTest::check() const
+{
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > counters( mStateH, mCexH );
+    auto pick = [] (const ExactRefinementTree& rtree, auto& counterexample) {
+	return NodeRefVec< ExactRefinementTree >( { std::ref( counterexample.second ) } ); };
+    LargestSideRefiner refinement( mRefinement );
+    LimitedIterations term( mTerm );
+    IterationCounter iterations;
+    MemoryObserver memory;
+    memory.watch( counters );
+    IncrementalSearch< typename ExactRefinementTree::EnclosureT > search;
+    cegarLoop( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), refinement, pick, counters, search, 1, 0, term, iterations, memory );
 
-    Ariadne::RealVariable x( "x" ), y( "y" );
-    Ariadne::RealConstant a( "a", Ariadne::Real( attraction ) );
-    Ariadne::EffectiveVectorFunction insideMap = Ariadne::make_function( {x, y}, {a*x, a*y} );
+    const std::vector< MemoryObserver::Sample >& samples = memory.samples();
+    if( samples.size() != iterations.iterations() + 1 )
+    {
+	std::cout << "sampled " << samples.size() << " times in " << iterations.iterations() << " iterations" << std::endl;
+	return false;
+    }
+    for( uint i = 0; i < samples.size(); ++i )
+    {
+	if( samples[ i ].bytesPerNode() <= 0 || samples[ i ].bytesPerEdge() <= 0 || ( i > 0 && samples[ i ].mNodes < samples[ i - 1 ].mNodes ) )
+	{
+	    std::cout << "inconsistent sample " << i << " of " << samples[ i ].mNodes << " nodes" << std::endl;
+	    return false;
+	}
+    }
+    const MemoryObserver::Sample& last = samples.back();
+    if( last.mNodes != graph::size( mpRtree->graph() ) || last.mUsage.mVertices != mpRtree->memoryUsage().mVertices )
+    {
+	std::cout << "last sample does not describe final tree" << std::endl;
+	return false;
+    }
+    // the loop only continues after finding counterexamples
+    if( iterations.iterations() > 1 && last.mUsage.mCounterexamples == 0 )
+    {
+	std::cout << "counterexamples of watched store not sampled" << std::endl;
+	return false;
+    }
+    return true;
+}
 
-    // figure out how to use bounds on safe region to do this
-    Ariadne::RealBox initialAbs = { {-boundary, boundary}, {-boundary, boundary} };
+CegarTest::TerminationTest::TerminationTest( uint size, uint reps )
+    : ITest( "terminations by memory, safe volume and combinations", size, reps )
+    , mTerm( mMaxNodesFactor * size )
+{}
 
-    mpRtree.reset( new ExactRefinementTree( Ariadne::BoundedConstraintSet( initialAbs ), insideMap, Ariadne::Effort( 10 ) ) );
+void CegarTest::TerminationTest::iterate()
+{
+    resetHenonRun( mpRtree, mpInitialSet );
 }
 
-bool CegarTest::VerifySafety::check() const
+//! \return number of calls until term terminates, at most maxCalls + 1
+template< typename TermT, typename Rtree >
+static uint callsToTerminate( TermT term, const Rtree& rtree, const uint& maxCalls )
 {
-    auto cegarResult = cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm
-			      // , iniPrint, cexPrint
-			      );
-    if( !definitely( cegarResult.first ) )
+    term.start( rtree );
+    uint calls = 1;
+    for( ; calls <= maxCalls && !term( rtree ); ++calls )
+	;
+    return calls;
+}
+
+bool CegarTest::TerminationTest::check() const
+{
+    const uint window = 3, maxCalls = 3 * window;
+    const uint memory = callsToTerminate( MemoryBudget( 0 ), *mpRtree, maxCalls )
+	, unlimitedMemory = callsToTerminate( MemoryBudget( std::numeric_limits< size_t >::max(), 2 ), *mpRtree, maxCalls )
+	, plateau = callsToTerminate( SafeVolumePlateau( window, 0.5 ), *mpRtree, maxCalls )
+	, progress = callsToTerminate( SafeVolumePlateau( window, -1 ), *mpRtree, maxCalls )
+	, any = callsToTerminate( anyOf( LimitedIterations( window ), LimitedIterations( 2 * window ) ), *mpRtree, maxCalls )
+	, all = callsToTerminate( allOf( LimitedIterations( window ), LimitedIterations( 2 * window ) ), *mpRtree, maxCalls );
+    // the tree does not change between calls, so the safe volume makes no progress
+    if( memory != 1 || unlimitedMemory != maxCalls + 1 || plateau != window || progress != maxCalls + 1
+	|| any != window + 1 || all != 2 * window + 1 )
     {
-	std::cout << "could not verify safety of system safe by construction, safety " << cegarResult.first
-		  << " with " << graph::size( mpRtree->graph() ) << " nodes "
-		  << std::endl;
+	std::cout << "terminated after " << memory << " and " << unlimitedMemory << " calls by memory, " << plateau << " and " << progress
+		  << " by safe volume, " << any << " by any of and " << all << " by all of" << std::endl;
 	return false;
     }
+
+    // in the loop, the safe volume only grows as refinement only removes transitions
+    struct SafeVolumeRecorder : public CegarObserver
+    {
+	std::vector< double > mSafe;
+
+	void startIteration( const ExactRefinementTree& rtree ) { mSafe.push_back( rtree.transSafetyVolumes().mSafe ); }
+    } recorder;
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > counters( mStateH, mCexH );
+    auto pick = [] (const ExactRefinementTree& rtree, auto& counterexample) {
+	return NodeRefVec< ExactRefinementTree >( { std::ref( counterexample.second ) } ); };
+    LargestSideRefiner refinement( mRefinement );
+    auto term = anyOf( LimitedIterations( mTerm ), SafeVolumePlateau( mTerm, -1 ), MemoryBudget( std::numeric_limits< size_t >::max() ) );
+    IncrementalSearch< typename ExactRefinementTree::EnclosureT > search;
+    cegarLoop( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), refinement, pick, counters, search, 1, 0, term, recorder );
+    for( uint i = 1; i < recorder.mSafe.size(); ++i )
+    {
+	if( recorder.mSafe[ i ] < recorder.mSafe[ i - 1 ] )
+	{
+	    std::cout << "safe volume decreased from " << recorder.mSafe[ i - 1 ] << " to " << recorder.mSafe[ i ] << " in iteration " << i << std::endl;
+	    return false;
+	}
+    }
     return true;
 }
 
-CegarTest::VerifyCounterexamples::VerifyCounterexamples( uint size, uint reps )
-    : ITest( "verify consecutive nodes in counterexample are reachable", size, reps )
+CegarTest::TEST_CTOR( ObserverPruningTest, "observer hooks not defined are skipped and defined ones are called" )
+
+void CegarTest::ObserverPruningTest::iterate()
+{
+    resetHenonRun( mpRtree, mpInitialSet );
+}
+
+bool CegarTest::ObserverPruningTest::check() const
+{
+    HookCounter hooks;
+    CegarObserver empty;
+    IterationCounter searches;
+    if( isObserved< decltype( empty.startIteration( *mpRtree ) ) > || isObserved< decltype( hooks.finished( *mpRtree, Ariadne::ValidatedKleenean( true ) ) ) >
+	|| !isObserved< decltype( hooks.startIteration( *mpRtree ) ) > || !isObserved< decltype( hooks.startRefinement( *mpRtree, mpRtree->outside() ) ) > )
+    {
+	std::cout << "hooks inherited from the blueprint are not told apart from defined ones" << std::endl;
+	return false;
+    }
+
+    CounterexampleStore< typename ExactRefinementTree::EnclosureT, RandomStateValue, GreatestState > counters( mStateH, mCexH );
+    auto pick = [] (const ExactRefinementTree& rtree, auto& counterexample) {
+	return NodeRefVec< ExactRefinementTree >( { std::ref( counterexample.second ) } ); };
+    LargestSideRefiner refinement( mRefinement );
+    LimitedIterations term( mTestSize );
+    IncrementalSearch< typename ExactRefinementTree::EnclosureT > search;
+    cegarLoop( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), refinement, pick, counters, search, 1, 0, term, empty, hooks, searches );
+    if( hooks.mStarts == 0 || hooks.mStarts != searches.iterations() || hooks.mRefinements != hooks.mRefined )
+    {
+	std::cout << hooks.mStarts << " iterations started, " << searches.iterations() << " searches, " << hooks.mRefinements
+		  << " refinements started and " << hooks.mRefined << " nodes refined" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+CegarTest::CertificateTest::CertificateTest( uint size, uint reps )
+    : ITest( "certificates of safety verify only for their system", size, reps )
     , mTerm( mMaxNodesFactor * size )
 {}
 
-void CegarTest::VerifyCounterexamples::iterate()
+void CegarTest::CertificateTest::iterate()
 {
-    D( std::cout << "verify counterexamples iteration" << std::endl; );
-    double wi = mInitialBoxLengthDist( mRandom )
-	, hi = mInitialBoxLengthDist( mRandom )
-	, ws = mSafeBoxLengthDist( mRandom )
-	, hs = mSafeBoxLengthDist( mRandom );
-    
-    mpRtree.reset( henonMap< typename ExactRefinementTree::EnclosureT >( ws, hs, 1.4, 0.3, Ariadne::Effort( 10 ) ) );
-    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, wi}, {0, hi} } ) );
+    mpInitialSet.reset( new Ariadne::BoundedConstraintSet( { {0, 0.5}, {0, 0.5} } ) );
 }
 
-bool CegarTest::VerifyCounterexamples::check() const
+bool CegarTest::CertificateTest::check() const
 {
-    CounterexampleVerifier verifier;
-    cegar( *mpRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, mTerm, verifier );
+    // contraction of the safe set into itself, the tree is built here as compacting frees it
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    const Ariadne::EffectiveVectorFunction dynamics = Ariadne::make_function( {x, y}, {0.5 * x + 0.25, 0.5 * y} );
+    const Ariadne::BoundedConstraintSet safeSet( { {-1, 1}, {-1, 1} } );
+    std::unique_ptr< ExactRefinementTree > pRtree( new ExactRefinementTree( safeSet, dynamics, Ariadne::Effort( 10 ) ) );
+    for( uint i = 0; i < mTestSize; ++i )
+	refineRandomLeaf( *pRtree, mRefinement );
+    const size_t noLeaves = graph::size( pRtree->graph() ) - 1;
+    auto result = cegar( *pRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, LimitedIterations( mTerm ) );
+    if( !definitely( result.first ) )
+    {
+	std::cout << "contraction not proven safe" << std::endl;
+	return false;
+    }
 
-    if( !verifier.mBadCounterexample.empty() )
+    std::stringstream ss;
+    SafetyCertificate::compact( pRtree, *mpInitialSet ).save( ss );
+    const SafetyCertificate certificate( ss );
+    if( pRtree || certificate.size() != noLeaves || certificate.invariantSize() == 0 || certificate.invariantSize() > certificate.size() )
     {
-	std::cout << "found counterexample with bad link " << std::endl;
-	printCounterexample( *mpRtree, verifier.mBadCounterexample.begin(), verifier.mBadCounterexample.end() );
-	std::cout << "bad link being ";
-	printNode( *mpRtree, *(verifier.mBadLink - 1) );
-	std::cout << " -> ";
-	printNode( *mpRtree, *verifier.mBadLink );
-	std::cout << std::endl;
+	std::cout << "certificate of " << certificate.invariantSize() << " of " << certificate.size() << " boxes for " << noLeaves << " leaves"
+		  << ( pRtree ? ", tree not freed" : "" ) << std::endl;
+	return false;
+    }
+    for( size_t i = 1; i < certificate.size(); ++i )
+    {
+	if( certificate.box( i )[ 0 ].lower().get_d() < certificate.box( i - 1 )[ 0 ].lower().get_d() )
+	{
+	    std::cout << "boxes of certificate not sorted" << std::endl;
+	    return false;
+	}
+    }
+    const SafetyCertificate::Check check = certificate.verify( dynamics, safeSet, *mpInitialSet, Ariadne::Effort( 10 ) );
+    if( !check.mVerified || !check.mDigestMatches )
+    {
+	std::cout << "certificate not verified at box " << check.mFailedBox << ": " << check.mReason << std::endl;
+	return false;
+    }
+
+    // proofs by mean value forms are verified by mean value forms
+    std::unique_ptr< ExactRefinementTree > pAffineRtree( new ExactRefinementTree( safeSet, dynamics, Ariadne::Effort( 10 ) ) );
+    pAffineRtree->setImageEnclosure( ImageEnclosure::AFFINE );
+    if( definitely( cegar( *pAffineRtree, *mpInitialSet, Ariadne::Effort( 10 ), mRefinement, mStateH, mCexH, LimitedIterations( mTerm ) ).first ) )
+    {
+	std::stringstream affineSs;
+	SafetyCertificate::compact( pAffineRtree, *mpInitialSet ).save( affineSs );
+	const SafetyCertificate affineCertificate( affineSs );
+	const SafetyCertificate::Check affineCheck = affineCertificate.verify( dynamics, safeSet, *mpInitialSet, Ariadne::Effort( 10 ) );
+	if( affineCertificate.imageEnclosure() != ImageEnclosure::AFFINE || !affineCheck.mVerified || !affineCheck.mDigestMatches )
+	{
+	    std::cout << "certificate of mean value forms not verified by them: " << affineCheck.mReason << std::endl;
+	    return false;
+	}
+    }
+
+    Ariadne::EffectiveVectorFunction expansion = Ariadne::make_function( {x, y}, {3 * x, 3 * y} );
+    const Ariadne::BoundedConstraintSet smallSafeSet( { {-0.1, 0.1}, {-0.1, 0.1} } );
+    if( certificate.verify( expansion, safeSet, *mpInitialSet, Ariadne::Effort( 10 ) ).mVerified
+	|| certificate.verify( dynamics, smallSafeSet, *mpInitialSet, Ariadne::Effort( 10 ) ).mVerified )
+    {
+	std::cout << "certificate verified for other dynamics or safe set" << std::endl;
+	return false;
+    }
+
+    // shrinking a box by an ulp leaves a gap too thin for the volume to tell, the tiling does
+    std::string gapped = ss.str();
+    const size_t boxesAt = 5 * sizeof( uint64_t ) + 2 * certificate.dimension() * sizeof( double );
+    bool shrunk = false;
+    for( size_t i = 0; i < certificate.size() && !shrunk; ++i )
+    {
+	for( size_t d = 0; d < certificate.dimension() && !shrunk; ++d )
+	{
+	    const double upper = certificate.box( i )[ d ].upper().get_d();
+	    if( upper == safeSet.bounding_box()[ d ].upper().get_d() )
+		continue;
+	    const double shrinked = std::nextafter( upper, -std::numeric_limits< double >::infinity() );
+	    const size_t at = boxesAt + ( 2 * ( i * certificate.dimension() + d ) + 1 ) * sizeof( double );
+	    std::copy( reinterpret_cast< const char* >( &shrinked ), reinterpret_cast< const char* >( &shrinked ) + sizeof( double ), gapped.begin() + at );
+	    shrunk = true;
+	}
+    }
+    if( shrunk )
+    {
+	std::stringstream gs( gapped );
+	const SafetyCertificate::Check gappedCheck = SafetyCertificate( gs ).verify( dynamics, safeSet, *mpInitialSet, Ariadne::Effort( 10 ) );
+	if( gappedCheck.mVerified || gappedCheck.mReason != "boxes do not tile the bounding box" )
+	{
+	    std::cout << "certificate with a gap " << ( gappedCheck.mVerified ? "verified" : "rejected as " + gappedCheck.mReason ) << std::endl;
+	    return false;
+	}
+    }
+
+    std::stringstream truncated( ss.str().substr( 0, ss.str().size() / 2 ) );
+    try
+    {
+	SafetyCertificate broken( truncated );
+	std::cout << "truncated certificate read" << std::endl;
 	return false;
     }
+    catch( std::logic_error& e )
+    {}
     return true;
 }
 
@@ -322,8 +1553,27 @@ void CegarTest::init()
 	, pStateless( new StatelessRunner() );
     addTest( new FindCounterexampleTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new FindNoCounterexampleTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new IncrementalSearchTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new SearchBuffersTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new GuidedSearchTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new BoundedSearchTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new VisualizationTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new CounterexampleStoreTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new ScoreCacheTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new MaximumEntropyTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new ConcretizationTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new InitialAbstraction( mTestSize, 0.1 * mRepetitions ), pStateless );
     // addTest( new VerifySafety( mTestSize, 0.1 * mRepetitions ), pStateless );
     addTest( new VerifyCounterexamples( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new VerifyBatchCounterexamples( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new SearchStrategyTest( 0.1 * mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new VerifyConcurrentChecks( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new ParallelCegarTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new PhaseProfileTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new IterationLogTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new MemoryObserverTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new TerminationTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new ObserverPruningTest( mTestSize, 0.05 * mRepetitions ), pStateless );
+    addTest( new CertificateTest( 0.5 * mTestSize, 0.05 * mRepetitions ), pStateless );
     // addTest( new LoopTest( mTestSize, 0.05 * mRepetitions ), pStateless );
 }
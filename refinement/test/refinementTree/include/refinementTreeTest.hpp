@@ -3,6 +3,7 @@
 
 #include "testGroupInterface.hpp"
 #include "cegar.hpp"
+#include "mappedGraph.hpp"
 
 #include "expression/space.hpp"
 #include "expression/expression.hpp"
@@ -98,6 +99,16 @@ struct RefinementTreeTest : public ITestGroup
 	return new RefinementTree< BoxT >( Ariadne::BoundedConstraintSet( Ariadne::RealBox( safeBox ) ), f, e );
     }
 
+    //! \return refinement tree for a contracting rotation by 45 degrees, shifted and slightly bent so that some states leave the safe set
+    template< typename BoxT >
+    static RefinementTree< BoxT >* rotationMap( const BoxT safeBox, const Ariadne::Effort& e )
+    {
+	Ariadne::RealVariable x( "x" ), y( "y" );
+	Ariadne::RealConstant c( "c", Ariadne::Real( 0.5 ) ), d( "d", Ariadne::Real( 0.2 ) ), s( "s", Ariadne::Real( 0.4 ) );
+	Ariadne::EffectiveVectorFunction f = Ariadne::make_function( {x, y}, {c*x - c*y + d*y*y + s, c*x + c*y} );
+	return new RefinementTree< BoxT >( Ariadne::BoundedConstraintSet( Ariadne::RealBox( safeBox ) ), f, e );
+    }
+
     //! \return refinement tree for henon map with strictly positive initial and safe sets (i.e. left hand bottom corner is origin
     template< typename BoxType >
     static RefinementTree< BoxType >* henonMap( const BoxType& safeBox
@@ -116,6 +127,12 @@ struct RefinementTreeTest : public ITestGroup
 	return new RefinementTree< BoxType >( safeSet, henon, e );
     }
 
+    //! \return true if k1 and k2 are both true, both false or both indeterminate
+    static bool sameKleenean( const Ariadne::ValidatedKleenean& k1, const Ariadne::ValidatedKleenean& k2 )
+    {
+	return definitely( k1 ) == definitely( k2 ) && definitely( !k1 ) == definitely( !k2 );
+    }
+
     template< typename E >
     static void printNodeValue( const std::optional< std::reference_wrapper< const InsideGraphValue< E > > >& otn )
     {
@@ -160,6 +177,14 @@ struct RefinementTreeTest : public ITestGroup
 	
     };
 
+    // test whether values of refined nodes are recycled, i.e. only values of leaves are live
+    class ValueRecyclingTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( ValueRecyclingTest );
+    };
+
     // test preimage after some expansions: 
     class PreimageTest : public ITest
     {
@@ -197,6 +222,141 @@ struct RefinementTreeTest : public ITestGroup
     };
     
 
+    // test that refining several leaves at once removes all of them and sets transitive safety correctly
+    class BatchRefinementTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::vector< size_t > mRefinedIds;
+	LargestSideRefiner mRefiner;
+
+	bool reachUnsafe( const typename ExactRefinementTree::NodeT& n, NodeSet& visited ) const;
+
+	STATEFUL_TEST( BatchRefinementTest );
+    };
+
+    // dynamics lowered into a tape evaluate points and images of states consistently with the function
+    class DynamicsTapeTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( DynamicsTapeTest );
+    };
+
+    // refiners splitting into many boxes cover the box refined, refining with them keeps exactly the edges reachable
+    class MultiWayRefinementTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	GridRefiner< 3 > mGridRefiner;
+	BisectAllRefiner mBisectRefiner;
+	WidestSidesRefiner< 4 > mWidestRefiner;
+	Ariadne::ExactBoxType mRefined;
+	std::vector< Ariadne::ExactBoxType > mRefinement;
+	STATEFUL_TEST( MultiWayRefinementTest );
+    };
+
+    // initial grid abstraction has one leaf per cell, exactly the edges reachable and correct transitive safety
+    class InitialGridTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	std::vector< uint > mResolution;
+
+	bool reachUnsafe( const typename ExactRefinementTree::NodeT& n, NodeSet& visited ) const;
+
+	STATELESS_TEST( InitialGridTest );
+    };
+
+    // snapshots hold the partition only, replaying it restores edges and safety for the same dynamics and keeps the partition for other dynamics
+    class SnapshotTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( SnapshotTest );
+    };
+
+    // transitive safety determined over the condensation of the snapshot matches transitive safety maintained by refinements
+    class CondensedSafetyTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( CondensedSafetyTest );
+    };
+
+    // ranges and visitors of pre- and postimages enumerate the same nodes as the vectors returned
+    class AdjacentRangeTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( AdjacentRangeTest );
+    };
+
+    // mapped graph file stores the boxes, edges and safety of the snapshot, searches over it find counterexamples like the tree
+    class MappedGraphTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( MappedGraphTest );
+    };
+
+    // memory reported covers at least the vertices, edges and values stored
+    class MemoryUsageTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( MemoryUsageTest );
+    };
+
+    // volumes by safety maintained by the tree equal the sums over all leaves
+    class SafetyVolumesTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( SafetyVolumesTest );
+    };
+
+    // points are located in the same leaves by the leaf index as by scanning all leaves
+    class ContainingTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	STATEFUL_TEST( ContainingTest );
+    };
+
+    // mean value form images keep the edges of all transitions sampled, and fewer edges than box images of the same partition
+    class AffineImageTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree, mpBoxRtree;
+	LargestSideRefiner mRefiner;
+	uint mIterations;
+	STATEFUL_TEST( AffineImageTest );
+    };
+
+    // refinements with mean value form images of a nonlinear map only keep transitions of their parents
+    class RefinedEdgesTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	// children refined in the last iteration with the values of the nodes their parent reached, refined nodes replaced by their refinement
+	std::vector< std::pair< std::vector< ExactRefinementTree::NodeT >, std::vector< const IGraphValue* > > > mRefined;
+	STATEFUL_TEST( RefinedEdgesTest );
+    };
+
+    // escalating efforts stop at the first effort deciding a check, and leaves record the effort that decided their safety
+    class EffortScheduleTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	uint mDecidingWork;
+	STATELESS_TEST( EffortScheduleTest );
+    };
+
+    // safety inherited from parents and checked against undecided constraints only equals safety checked against the whole safe set
+    class ConstraintInheritanceTest : public ITest
+    {
+	std::unique_ptr< ExactRefinementTree > mpRtree;
+	LargestSideRefiner mRefiner;
+	uint mIterations;
+	STATEFUL_TEST( ConstraintInheritanceTest );
+    };
+
     // move away to cegar test
     // //positve test for finding counterexamples
     // class PositiveCounterexampleTest : public ITest
@@ -11,6 +11,12 @@
 #include <algorithm>
 #include <stack>
 #include <cmath>
+#include <sstream>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
 
 #ifndef DEBUG
 #define DEBUG false
@@ -253,6 +259,37 @@ bool RefinementTreeTest::RefinedNodesRemovalTest::check() const
     return true;
 }
 
+RefinementTreeTest::TEST_CTOR( ValueRecyclingTest, "values of refined nodes are recycled" );
+
+void RefinementTreeTest::ValueRecyclingTest::init()
+{
+    Ariadne::ExactBoxType safeBox( { {0,10}, {0,9} } );
+    mpRtree.reset( staticMap( safeBox, Ariadne::Effort( 10 ) ) );
+    iterate();
+}
+
+void RefinementTreeTest::ValueRecyclingTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::ValueRecyclingTest::check() const
+{
+    const auto& pool = mpRtree->valuePool();
+    if( pool.liveObjects() != graph::size( mpRtree->graph() ) - 1 ) // outside value is not pooled
+    {
+	std::cout << pool.liveObjects() << " values live, but " << graph::size( mpRtree->graph() ) - 1 << " leaves in graph" << std::endl;
+	return false;
+    }
+    // chunks double, so capacity stays below twice the peak plus the default chunk size, refinement needs one more value at once
+    if( pool.capacity() >= 2 * ( pool.liveObjects() + 1 ) + 250 )
+    {
+	std::cout << pool.capacity() << " values allocated in " << pool.chunks() << " chunks for " << pool.liveObjects() << " live values" << std::endl;
+	return false;
+    }
+    return true;
+}
+
 RefinementTreeTest::TEST_CTOR( PreimageTest, "preimage is complete and only complete" );
 
 void RefinementTreeTest::PreimageTest::init()
@@ -449,38 +486,1069 @@ bool RefinementTreeTest::TransitiveSafetyTest::check() const
 	Ariadne::ValidatedKleenean tsafe = mpRtree->isTransSafe( *in.first );
 	if( !definitely( tsafe ) && !definitely( !tsafe ) )
 	{
-	    print( std::cout, mpRtree->graph(), GraphValuePrinter< Ariadne::ExactBoxType >::makeFun( true, false, true, true ) );
-	    std::cout << mpRtree->nodeValue( *in.first ).value().get() << " is indeterminate " << std::endl;
+	    print( std::cout, mpRtree->graph(), GraphValuePrinter< Ariadne::ExactBoxType >::makeFun( *mpRtree, true, false, true, true ) );
+	    std::cout << mpRtree->nodeValue( *in.first ).value().get() << " (" << mpRtree->isSafe( *in.first ) << ", " << tsafe << ") is indeterminate " << std::endl;
 	    return false;
 	}
 	NodeSet ns( *mpRtree );
 	bool reachesUnsafe = reachUnsafe( *in.first, ns );
 	if( reachesUnsafe != definitely( !tsafe ) )
 	{
-	    print( std::cout, mpRtree->graph(), GraphValuePrinter< Ariadne::ExactBoxType >::makeFun( true, false, true, true ) );
+	    print( std::cout, mpRtree->graph(), GraphValuePrinter< Ariadne::ExactBoxType >::makeFun( *mpRtree, true, false, true, true ) );
 	    
-	    std::cout << "ERROR at " << mpRtree->nodeValue( *in.first ).value().get() << std::endl;
+	    std::cout << "ERROR at " << mpRtree->nodeValue( *in.first ).value().get() << " (" << mpRtree->isSafe( *in.first ) << ", " << tsafe << ")" << std::endl;
+	    std::cout << "find reachable unsafe node " << reachesUnsafe << " but tsafety " << tsafe << std::endl;
+	    return false;
+	}
+    }
+
+    const typename ExactRefinementTree::SnapshotT& snap = mpRtree->snapshot();
+    for( size_t i = 0; i < snap.size(); ++i )
+    {
+	if( !sameKleenean( snap.isSafe( i ), mpRtree->isSafe( snap.node( i ) ) )
+	    || !sameKleenean( snap.isTransSafe( i ), mpRtree->isTransSafe( snap.node( i ) ) ) )
+	{
+	    std::cout << "snapshot flags differ from tree at index " << i << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( BatchRefinementTest, "batch refinement correct" )
+
+bool RefinementTreeTest::BatchRefinementTest::reachUnsafe( const typename ExactRefinementTree::NodeT& n, NodeSet& visited ) const
+{
+    if( possibly( !mpRtree->isSafe( n ) ) )
+	return true;
+
+    visited.insert( n );
+
+    for( auto& ns : mpRtree->postimage( n ) )
+    {
+	if( visited.find( ns ) == visited.end() && reachUnsafe( ns, visited ) )
+	    return true;
+    }
+
+    return false;
+}
+
+void RefinementTreeTest::BatchRefinementTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+    mRefinedIds.clear();
+}
+
+void RefinementTreeTest::BatchRefinementTest::iterate()
+{
+    // pick a few leaves, possibly repeating some
+    auto vrange = graph::vertices( mpRtree->graph() );
+    std::vector< typename ExactRefinementTree::NodeT > batch;
+    uint batchSize = std::uniform_int_distribution<>( 1, 4 )( mRandom );
+    for( uint i = 0; i < batchSize; ++i )
+    {
+	auto ipick = vrange.first;
+	std::advance( ipick, std::uniform_int_distribution<>( 0, std::distance( vrange.first, vrange.second ) - 1 )( mRandom ) );
+	batch.push_back( *ipick );
+    }
+
+    mRefinedIds.clear();
+    for( auto& n : batch )
+    {
+	auto nval = mpRtree->nodeValue( n );
+	if( nval )
+	    mRefinedIds.push_back( nval.value().get().id() );
+    }
+    mpRtree->refine( batch.begin(), batch.end(), mRefiner );
+}
+
+bool RefinementTreeTest::BatchRefinementTest::check() const
+{
+    for( auto in = graph::vertices( mpRtree->graph() ); in.first != in.second; ++in.first )
+    {
+	auto nval = mpRtree->nodeValue( *in.first );
+	if( nval && std::find( mRefinedIds.begin(), mRefinedIds.end(), nval.value().get().id() ) != mRefinedIds.end() )
+	{
+	    std::cout << nval.value().get() << " was refined but is still in graph" << std::endl;
+	    return false;
+	}
+
+	Ariadne::ValidatedKleenean tsafe = mpRtree->isTransSafe( *in.first );
+	NodeSet ns( *mpRtree );
+	bool reachesUnsafe = reachUnsafe( *in.first, ns );
+	if( reachesUnsafe != definitely( !tsafe ) )
+	{
 	    std::cout << "find reachable unsafe node " << reachesUnsafe << " but tsafety " << tsafe << std::endl;
 	    return false;
 	}
+
+	// edges computed concurrently are complete and only complete
+	auto postimg = mpRtree->postimage( *in.first );
+	for( auto iu = graph::vertices( mpRtree->graph() ); iu.first != iu.second; ++iu.first )
+	{
+	    bool isPost = std::any_of( postimg.begin(), postimg.end()
+				       , std::bind( &ExactRefinementTree::equal, &*mpRtree, *iu.first, std::placeholders::_1 ) );
+	    if( isPost != possibly( mpRtree->isReachable( *in.first, *iu.first ) ) )
+	    {
+		printNodeValue( mpRtree->nodeValue( *iu.first ) );
+		std::cout << ( isPost ? "is" : "is not" ) << " in postimage of ";
+		printNodeValue( mpRtree->nodeValue( *in.first ) );
+		std::cout << std::endl;
+		return false;
+	    }
+	}
     }
     return true;
 }
 
 RefinementTreeTest::GROUP_CTOR( RefinementTreeTest, "refinement tree" );
 
+RefinementTreeTest::TEST_CTOR( DynamicsTapeTest, "dynamics tape consistent with function and batched images" )
+
+void RefinementTreeTest::DynamicsTapeTest::init()
+{
+    // tinkerbell map, products of a coordinate with itself are squares in the tape
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::RealConstant a( "a", Ariadne::Real( 0.9 ) ), b( "b", Ariadne::Real( -0.6 ) ), c( "c", Ariadne::Real( 2.0 ) ), d( "d", Ariadne::Real( 0.5 ) );
+    Ariadne::EffectiveVectorFunction tinkerbell = Ariadne::make_function( {x, y}, {x*x - y*y + a*x + b*y, 2*x*y + c*x + d*y} );
+    Ariadne::BoundedConstraintSet safeSet( Ariadne::RealBox( { {-1.5, 1.5}, {-1.5, 1.5} } ) );
+    mpRtree.reset( new ExactRefinementTree( safeSet, tinkerbell, Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::DynamicsTapeTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::DynamicsTapeTest::check() const
+{
+    const DynamicsTape& tape = mpRtree->compiledDynamics();
+    if( !tape.isCompiled() )
+    {
+	std::cout << "polynomial dynamics not lowered into a tape" << std::endl;
+	return false;
+    }
+
+    // images evaluated in one batch are those evaluated one by one
+    std::vector< Ariadne::ExactBoxType > leaves;
+    for( auto in = graph::vertices( mpRtree->graph() ); in.first != in.second; ++in.first )
+    {
+	auto nval = mpRtree->nodeValue( *in.first );
+	if( nval )
+	    leaves.push_back( nval.value().get().getEnclosure() );
+    }
+    const std::vector< Ariadne::UpperBoxType > batch = mpRtree->images( leaves.begin(), leaves.end() );
+    for( uint i = 0; i < leaves.size(); ++i )
+    {
+	const Ariadne::UpperBoxType single = tape.image( leaves[ i ] );
+	for( uint d = 0; d < single.dimension(); ++d )
+	{
+	    if( batch[ i ][ d ].lower().get_d() != single[ d ].lower().get_d() || batch[ i ][ d ].upper().get_d() != single[ d ].upper().get_d() )
+	    {
+		std::cout << "batched image " << batch[ i ] << " of " << leaves[ i ] << " differs from " << single << std::endl;
+		return false;
+	    }
+	}
+    }
+    // batches evaluated in reused scratch buffers match, repeating a batch does not grow the buffers
+    DynamicsTape::Scratch scratch;
+    std::vector< Ariadne::UpperBoxType > reused( leaves.size() );
+    tape.batchImages( leaves.begin(), leaves.end(), reused.begin(), scratch );
+    const size_t scratchBytes = scratch.heapBytes();
+    tape.batchImages( leaves.begin(), leaves.end(), reused.begin(), scratch );
+    for( uint i = 0; i < leaves.size(); ++i )
+    {
+	for( uint d = 0; d < reused[ i ].dimension(); ++d )
+	{
+	    if( reused[ i ][ d ].lower().get_d() != batch[ i ][ d ].lower().get_d() || reused[ i ][ d ].upper().get_d() != batch[ i ][ d ].upper().get_d() )
+	    {
+		std::cout << "image " << reused[ i ] << " of " << leaves[ i ] << " evaluated in reused buffers differs from " << batch[ i ] << std::endl;
+		return false;
+	    }
+	}
+    }
+    if( scratch.heapBytes() != scratchBytes )
+    {
+	std::cout << "repeating a batch grew the scratch buffers from " << scratchBytes << " to " << scratch.heapBytes() << " bytes" << std::endl;
+	return false;
+    }
+
+    for( auto in = graph::vertices( mpRtree->graph() ); in.first != in.second; ++in.first )
+    {
+	auto nval = mpRtree->nodeValue( *in.first );
+	if( !nval )
+	    continue;
+	const Ariadne::ExactBoxType& enc = nval.value().get().getEnclosure();
+	const Ariadne::UpperBoxType img = tape.image( enc );
+	const Ariadne::ValidatedPoint centre = enc.centre();
+	const Ariadne::ValidatedPoint mapped = tape.evaluate( centre ), expected = mpRtree->dynamics().evaluate( centre );
+	if( !possibly( img.contains( expected ) ) || !possibly( img.contains( mapped ) ) )
+	{
+	    std::cout << "image " << img << " of " << enc << " misses mapped centre " << mapped << " or " << expected << std::endl;
+	    return false;
+	}
+	for( uint d = 0; d < mapped.dimension(); ++d )
+	{
+	    if( definitely( mapped[ d ] < expected[ d ] ) || definitely( mapped[ d ] > expected[ d ] ) )
+	    {
+		std::cout << "tape maps centre of " << enc << " to " << mapped << ", function to " << expected << std::endl;
+		return false;
+	    }
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( MultiWayRefinementTest, "multi way refiners cover box and keep edges exact" )
+
+void RefinementTreeTest::MultiWayRefinementTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::MultiWayRefinementTest::iterate()
+{
+    auto vrange = graph::vertices( mpRtree->graph() );
+    typename ExactRefinementTree::NodeT n;
+    do
+    {
+	auto ipick = vrange.first;
+	std::advance( ipick, std::uniform_int_distribution<>( 0, std::distance( vrange.first, vrange.second ) - 1 )( mRandom ) );
+	n = *ipick;
+    } while( mpRtree->equal( mpRtree->outside(), n ) );
+
+    mRefined = mpRtree->nodeValue( n ).value().get().getEnclosure();
+    std::vector< typename ExactRefinementTree::NodeT > batch = { n };
+    std::vector< std::vector< typename ExactRefinementTree::NodeT > > refined;
+    switch( std::uniform_int_distribution<>( 0, 2 )( mRandom ) )
+    {
+      case 0: refined = mpRtree->refine( batch.begin(), batch.end(), mGridRefiner ); break;
+      case 1: refined = mpRtree->refine( batch.begin(), batch.end(), mBisectRefiner ); break;
+      default: refined = mpRtree->refine( batch.begin(), batch.end(), mWidestRefiner ); break;
+    }
+    mRefinement.clear();
+    for( auto& r : refined.front() )
+	mRefinement.push_back( mpRtree->nodeValue( r ).value().get().getEnclosure() );
+}
+
+bool RefinementTreeTest::MultiWayRefinementTest::check() const
+{
+    // boxes of the refinement are contained in the box refined and sum up to its volume
+    double volume = 0;
+    for( auto& bx : mRefinement )
+    {
+	if( !definitely( Ariadne::intersection( mRefined, bx ) == bx ) )
+	{
+	    std::cout << bx << " of refinement not contained in " << mRefined << std::endl;
+	    return false;
+	}
+	volume += bx.measure().get_d();
+    }
+    if( std::abs( volume - mRefined.measure().get_d() ) > 1e-9 * mRefined.measure().get_d() )
+    {
+	std::cout << "refinement of " << mRefined << " into " << mRefinement.size() << " boxes covers volume " << volume << std::endl;
+	return false;
+    }
+
+    auto vrange = graph::vertices( mpRtree->graph() );
+    for( auto iv = vrange.first; iv != vrange.second; ++iv )
+    {
+	auto postimg = mpRtree->postimage( *iv );
+	for( auto iu = vrange.first; iu != vrange.second; ++iu )
+	{
+	    const bool isEdge = std::any_of( postimg.begin(), postimg.end(), [&] (auto& n) { return mpRtree->equal( *iu, n ); } );
+	    if( possibly( mpRtree->isReachable( *iv, *iu ) ) != isEdge )
+	    {
+		printNodeValue( mpRtree->nodeValue( *iv ) );
+		std::cout << ( isEdge ? "has edge to unreachable " : "misses edge to reachable " );
+		printNodeValue( mpRtree->nodeValue( *iu ) );
+		std::cout << std::endl;
+		return false;
+	    }
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( InitialGridTest, "initial grid abstraction complete with correct edges and safety" )
+
+bool RefinementTreeTest::InitialGridTest::reachUnsafe( const typename ExactRefinementTree::NodeT& n, NodeSet& visited ) const
+{
+    if( possibly( !mpRtree->isSafe( n ) ) )
+	return true;
+
+    visited.insert( n );
+
+    for( auto& ns : mpRtree->postimage( n ) )
+    {
+	if( visited.find( ns ) == visited.end() && reachUnsafe( ns, visited ) )
+	    return true;
+    }
+
+    return false;
+}
+
+void RefinementTreeTest::InitialGridTest::iterate()
+{
+    std::uniform_int_distribution<> cellDist( 1, 8 );
+    mResolution = { uint( cellDist( mRandom ) ), uint( cellDist( mRandom ) ) };
+
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::EffectiveVectorFunction f = Ariadne::make_function( {x, y}, {x * x, y * y} );
+    Ariadne::BoundedConstraintSet safeSet( Ariadne::RealBox( { {-1.5, 1.5}, {-1, 1} } ) );
+    mpRtree.reset( new ExactRefinementTree( safeSet, f, Ariadne::Effort( 10 ), mResolution ) );
+}
+
+bool RefinementTreeTest::InitialGridTest::check() const
+{
+    auto vrange = graph::vertices( mpRtree->graph() );
+    const uint noLeaves = std::count_if( vrange.first, vrange.second, [this] (auto& n) { return bool( mpRtree->nodeValue( n ) ); } );
+    if( noLeaves != mResolution[ 0 ] * mResolution[ 1 ] )
+    {
+	std::cout << noLeaves << " leaves in initial grid of " << mResolution[ 0 ] << "x" << mResolution[ 1 ] << " cells" << std::endl;
+	return false;
+    }
+
+    for( auto iv = vrange.first; iv != vrange.second; ++iv )
+    {
+	auto postimg = mpRtree->postimage( *iv );
+	for( auto iu = vrange.first; iu != vrange.second; ++iu )
+	{
+	    const bool isEdge = std::any_of( postimg.begin(), postimg.end(), [&] (auto& n) { return mpRtree->equal( *iu, n ); } );
+	    if( possibly( mpRtree->isReachable( *iv, *iu ) ) != isEdge )
+	    {
+		printNodeValue( mpRtree->nodeValue( *iv ) );
+		std::cout << ( isEdge ? "has edge to unreachable " : "misses edge to reachable " );
+		printNodeValue( mpRtree->nodeValue( *iu ) );
+		std::cout << std::endl;
+		return false;
+	    }
+	}
+
+	NodeSet ns( *mpRtree );
+	const Ariadne::ValidatedKleenean tsafe = mpRtree->isTransSafe( *iv );
+	if( reachUnsafe( *iv, ns ) != definitely( !tsafe ) )
+	{
+	    printNodeValue( mpRtree->nodeValue( *iv ) );
+	    std::cout << "has transitive safety " << tsafe << " in initial grid" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( SnapshotTest, "snapshots restore partition, edges and safety" )
+
+void RefinementTreeTest::SnapshotTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::SnapshotTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::SnapshotTest::check() const
+{
+    typedef std::vector< double > KeyT;
+    // leaves are identified by their box across trees, the outside node by the empty key
+    auto key = [] (const ExactRefinementTree& rtree, const typename ExactRefinementTree::NodeT& n) {
+		   KeyT k;
+		   auto nval = rtree.nodeValue( n );
+		   if( nval )
+		       for( uint d = 0; d < nval.value().get().getEnclosure().dimension(); ++d )
+		       {
+			   k.push_back( nval.value().get().getEnclosure()[ d ].lower().get_d() );
+			   k.push_back( nval.value().get().getEnclosure()[ d ].upper().get_d() );
+		       }
+		   return k;
+	       };
+    // postimage and safety flags of each leaf
+    auto describe = [&key] (const ExactRefinementTree& rtree) {
+			std::map< KeyT, std::pair< std::set< KeyT >, std::pair< bool, bool > > > leaves;
+			for( auto vs = graph::vertices( rtree.graph() ); vs.first != vs.second; ++vs.first )
+			{
+			    auto& l = leaves[ key( rtree, *vs.first ) ];
+			    for( auto& post : rtree.postimage( *vs.first ) )
+				l.first.insert( key( rtree, post ) );
+			    l.second = std::make_pair( definitely( rtree.isSafe( *vs.first ) ), definitely( !rtree.isTransSafe( *vs.first ) ) );
+			}
+			return leaves;
+		    };
+
+    std::stringstream snapshot;
+    mpRtree->save( snapshot );
+    const std::string bytes = snapshot.str();
+
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::EffectiveVectorFunction f = Ariadne::make_function( {x, y}, {x * x, y * y} );
+    Ariadne::BoundedConstraintSet safeSet( Ariadne::RealBox( { {-1.5, 1.5}, {-1, 1} } ) );
+    ExactRefinementTree loaded( safeSet, f, Ariadne::Effort( 10 ), snapshot );
+    if( describe( loaded ) != describe( *mpRtree ) )
+    {
+	std::cout << "tree loaded for the same dynamics differs from tree saved" << std::endl;
+	return false;
+    }
+
+    // other dynamics keep the partition
+    std::stringstream again( bytes );
+    Ariadne::EffectiveVectorFunction g = Ariadne::make_function( {x, y}, {y, x * x} );
+    ExactRefinementTree reloaded( safeSet, g, Ariadne::Effort( 10 ), again );
+    auto original = describe( *mpRtree ), other = describe( reloaded );
+    if( original.size() != other.size()
+	|| !std::equal( original.begin(), original.end(), other.begin(), [] (auto& l1, auto& l2) { return l1.first == l2.first; } ) )
+    {
+	std::cout << "tree loaded for other dynamics does not keep the partition" << std::endl;
+	return false;
+    }
+
+    // the enclosure of images is restored, so edges are determined as by the tree saved
+    std::stringstream boxSnapshot( bytes ), affineSnapshot;
+    ExactRefinementTree affine( safeSet, f, Ariadne::Effort( 10 ), boxSnapshot );
+    affine.setImageEnclosure( ImageEnclosure::AFFINE );
+    affine.save( affineSnapshot );
+    ExactRefinementTree affineLoaded( safeSet, f, Ariadne::Effort( 10 ), affineSnapshot );
+    if( affineLoaded.imageEnclosure() != ImageEnclosure::AFFINE || describe( affineLoaded ) != describe( affine ) )
+    {
+	std::cout << "tree loaded from a snapshot of mean value forms differs from tree saved" << std::endl;
+	return false;
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( CondensedSafetyTest, "condensed transitive safety matches maintained transitive safety" )
+
+void RefinementTreeTest::CondensedSafetyTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::CondensedSafetyTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::CondensedSafetyTest::check() const
+{
+    typedef typename ExactRefinementTree::SnapshotT SnapshotT;
+    const SnapshotT& snap = mpRtree->snapshot();
+    const std::vector< bool > safe = snap.transSafeComponents();
+    for( typename SnapshotT::IndexT i = 0; i < snap.size(); ++i )
+    {
+	if( !mpRtree->nodeValue( snap.node( i ) ) )
+	    continue;
+	if( definitely( snap.isTransSafe( i ) ) != safe[ snap.condensation().component( i ) ] )
+	{
+	    std::cout << "node " << i << " transitively safe " << snap.isTransSafe( i ) << " but its component " << safe[ snap.condensation().component( i ) ] << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( AdjacentRangeTest, "adjacent ranges and visitors match pre- and postimages" )
+
+void RefinementTreeTest::AdjacentRangeTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::AdjacentRangeTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::AdjacentRangeTest::check() const
+{
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	const ExactRefinementTree::NodeT& v = *vs.first;
+	const std::vector< ExactRefinementTree::NodeT > posts = mpRtree->postimage( v ), pres = mpRtree->preimage( v );
+	const ExactRefinementTree::PostimageRangeT postRange = mpRtree->postimageRange( v );
+	const ExactRefinementTree::PreimageRangeT preRange = mpRtree->preimageRange( v );
+
+	std::vector< ExactRefinementTree::NodeT > postVisited, preVisited;
+	mpRtree->visitPostimage( v, [&postVisited] (const ExactRefinementTree::NodeT& n) { postVisited.push_back( n ); } );
+	mpRtree->visitPreimage( v, [&preVisited] (const ExactRefinementTree::NodeT& n) { preVisited.push_back( n ); } );
+	if( postRange.size() != posts.size() || !std::equal( postRange.begin(), postRange.end(), posts.begin() ) || postVisited != posts
+	    || preRange.size() != pres.size() || !std::equal( preRange.begin(), preRange.end(), pres.begin() ) || preVisited != pres )
+	{
+	    std::cout << "adjacent range of ";
+	    printNodeValue( mpRtree->nodeValue( v ) );
+	    std::cout << " differs from pre- or postimage" << std::endl;
+	    return false;
+	}
+
+	// visitors returning false stop after the first node
+	uint noVisited = 0;
+	const bool completed = mpRtree->visitPostimage( v, [&noVisited] (const ExactRefinementTree::NodeT& n) { ++noVisited; return false; } );
+	if( completed != posts.empty() || noVisited != std::min< size_t >( 1, posts.size() ) )
+	{
+	    std::cout << "visitor of postimage of size " << posts.size() << " visited " << noVisited << " nodes after being stopped" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( MappedGraphTest, "mapped graph matches snapshot and finds counterexamples" )
+
+void RefinementTreeTest::MappedGraphTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::MappedGraphTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::MappedGraphTest::check() const
+{
+    const std::string path = "mappedGraphTest.bin";
+    MappedGraph::write( *mpRtree, path );
+    std::string bytes;
+    {
+	std::ifstream is( path, std::ios::binary );
+	bytes.assign( std::istreambuf_iterator< char >( is ), std::istreambuf_iterator< char >() );
+    }
+    MappedGraph mapped( path );
+    std::remove( path.c_str() ); // mapping stays valid
+
+    // headers with sections beyond the file or overlapping the next one are rejected
+    const std::string corruptPath = "mappedGraphTestCorrupt.bin";
+    const size_t targetsOffsetAt = 7 * sizeof( uint64_t ), vertexCountAt = 2 * sizeof( uint64_t );
+    for( const size_t& at : { targetsOffsetAt, vertexCountAt } )
+    {
+	std::string corrupt = bytes;
+	uint64_t value;
+	std::copy( corrupt.begin() + at, corrupt.begin() + at + sizeof( value ), reinterpret_cast< char* >( &value ) );
+	value += at == targetsOffsetAt ? bytes.size() : 1;
+	std::copy( reinterpret_cast< const char* >( &value ), reinterpret_cast< const char* >( &value ) + sizeof( value ), corrupt.begin() + at );
+	std::ofstream( corruptPath, std::ios::binary | std::ios::trunc ) << corrupt;
+	bool thrown = false;
+	try { MappedGraph rejected( corruptPath ); }
+	catch( const std::logic_error& ) { thrown = true; }
+	std::remove( corruptPath.c_str() );
+	if( !thrown )
+	{
+	    std::cout << "mapped graph with corrupt header field at byte " << at << " opened" << std::endl;
+	    return false;
+	}
+    }
+
+    // edges to vertices beyond the graph are rejected
+    if( mapped.edgeCount() > 0 )
+    {
+	std::string corrupt = bytes;
+	uint64_t targetsOffset;
+	std::copy( bytes.begin() + targetsOffsetAt, bytes.begin() + targetsOffsetAt + sizeof( targetsOffset ), reinterpret_cast< char* >( &targetsOffset ) );
+	const MappedGraph::VertexT beyond = mapped.size();
+	std::copy( reinterpret_cast< const char* >( &beyond ), reinterpret_cast< const char* >( &beyond ) + sizeof( beyond ), corrupt.begin() + targetsOffset );
+	std::ofstream( corruptPath, std::ios::binary | std::ios::trunc ) << corrupt;
+	bool thrown = false;
+	try { MappedGraph rejected( corruptPath ); }
+	catch( const std::logic_error& ) { thrown = true; }
+	std::remove( corruptPath.c_str() );
+	if( !thrown )
+	{
+	    std::cout << "mapped graph with edge to vertex " << beyond << " of " << mapped.size() << " opened" << std::endl;
+	    return false;
+	}
+    }
+
+    const auto& snap = mpRtree->snapshot();
+    if( mapped.size() != snap.size() || mapped.edgeCount() != snap.graph().edgeCount() )
+    {
+	std::cout << "mapped graph has " << mapped.size() << " vertices and " << mapped.edgeCount() << " edges, snapshot "
+		  << snap.size() << " and " << snap.graph().edgeCount() << std::endl;
+	return false;
+    }
+    for( MappedGraph::VertexT v = 0; v < mapped.size(); ++v )
+    {
+	auto vval = mpRtree->nodeValue( snap.node( v ) );
+	auto succs = mapped.successors( v );
+	auto outs = snap.graph().outEdges( v );
+	if( bool( vval ) != mapped.isInside( v ) || !sameKleenean( mapped.isSafe( v ), snap.isSafe( v ) )
+	    || !sameKleenean( mapped.isTransSafe( v ), snap.isTransSafe( v ) )
+	    || succs.second - succs.first != outs.second - outs.first
+	    || !std::equal( succs.first, succs.second, outs.first, [&snap] (auto t, auto e) { return t == snap.graph().target( e ); } ) )
+	{
+	    std::cout << "vertex " << v << " of mapped graph differs from snapshot" << std::endl;
+	    return false;
+	}
+	if( vval )
+	{
+	    const Ariadne::ExactBoxType& bx = vval.value().get().getEnclosure();
+	    for( uint d = 0; d < bx.dimension(); ++d )
+	    {
+		if( mapped.bounds( v, d ).first != bx[ d ].lower().get_d() || mapped.bounds( v, d ).second != bx[ d ].upper().get_d() )
+		{
+		    std::cout << "mapped box of vertex " << v << " differs from " << bx << std::endl;
+		    return false;
+		}
+	    }
+	}
+    }
+
+    // a counterexample exists exactly if some initial vertex reaches an unsafe one
+    const std::vector< MappedGraph::VertexT > initial = mapped.overlapping( { -0.5, -0.5 }, { 0.5, 0.5 } );
+    const std::vector< MappedGraph::VertexT > cex = findMappedCounterexample( mapped, initial.begin(), initial.end() );
+    const bool reachesUnsafe = std::any_of( initial.begin(), initial.end(), [&mapped] (auto v) { return definitely( !mapped.isTransSafe( v ) ); } );
+    if( cex.empty() == reachesUnsafe )
+    {
+	std::cout << "counterexample of length " << cex.size() << " found in mapped graph, but initial set " << ( reachesUnsafe ? "reaches" : "does not reach" ) << " unsafe vertices" << std::endl;
+	return false;
+    }
+    for( uint i = 0; i + 1 < cex.size(); ++i )
+    {
+	auto succs = mapped.successors( cex[ i ] );
+	if( !std::binary_search( succs.first, succs.second, cex[ i + 1 ] ) )
+	{
+	    std::cout << "counterexample of mapped graph follows missing edge" << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( MemoryUsageTest, "memory usage covers vertices, edges and values" )
+
+void RefinementTreeTest::MemoryUsageTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::MemoryUsageTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::MemoryUsageTest::check() const
+{
+    const MemoryUsage usage = mpRtree->memoryUsage();
+    const size_t noNodes = graph::size( mpRtree->graph() ), noEdges = mpRtree->graph().edgeCount();
+    // each edge is stored as in and out edge
+    if( usage.mVertices < noNodes * sizeof( ExactRefinementTree::NodeT ) || usage.mEdges < 2 * noEdges * sizeof( ExactRefinementTree::MappingT::EdgeT )
+	|| usage.mValues < mpRtree->valuePool().liveObjects() * sizeof( InsideGraphValue< ExactRefinementTree::EnclosureT > )
+	|| usage.mIndices == 0 || usage.mCounterexamples != 0 )
+    {
+	std::cout << "memory usage of " << noNodes << " nodes and " << noEdges << " edges too small: vertices " << usage.mVertices
+		  << ", edges " << usage.mEdges << ", values " << usage.mValues << ", indices " << usage.mIndices << std::endl;
+	return false;
+    }
+    return usage.total() == usage.mVertices + usage.mEdges + usage.mValues + usage.mIndices;
+}
+
+RefinementTreeTest::TEST_CTOR( SafetyVolumesTest, "volumes by safety match sums over the leaves" )
+
+void RefinementTreeTest::SafetyVolumesTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::SafetyVolumesTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::SafetyVolumesTest::check() const
+{
+    SafetyVolumes scanned, transScanned;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	auto nval = mpRtree->nodeValue( *vs.first );
+	if( !nval )
+	    continue;
+	const double volume = nval.value().get().getEnclosure().measure().get_d();
+	scanned.add( mpRtree->isSafe( *vs.first ), volume );
+	transScanned.add( mpRtree->isTransSafe( *vs.first ), volume );
+    }
+    const double initial = mpRtree->initialEnclosure().measure().get_d(), tolerance = 1e-9 * initial;
+    auto close = [&tolerance] (const SafetyVolumes& v1, const SafetyVolumes& v2) {
+		     return std::abs( v1.mSafe - v2.mSafe ) <= tolerance && std::abs( v1.mUnsafe - v2.mUnsafe ) <= tolerance
+			 && std::abs( v1.mIndeterminate - v2.mIndeterminate ) <= tolerance; };
+    const SafetyVolumes& kept = mpRtree->safetyVolumes(), & transKept = mpRtree->transSafetyVolumes();
+    if( !close( kept, scanned ) || !close( transKept, transScanned ) || std::abs( kept.total() - initial ) > tolerance )
+    {
+	std::cout << "volumes kept safe " << kept.mSafe << ", unsafe " << kept.mUnsafe << ", indeterminate " << kept.mIndeterminate
+		  << " and transitively safe " << transKept.mSafe << " but leaves sum to " << scanned.mSafe << ", " << scanned.mUnsafe
+		  << ", " << scanned.mIndeterminate << " and " << transScanned.mSafe << " of " << initial << std::endl;
+	return false;
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( ContainingTest, "leaves containing points are located through the leaf index" )
+
+void RefinementTreeTest::ContainingTest::init()
+{
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+}
+
+void RefinementTreeTest::ContainingTest::iterate()
+{
+    refineRandomLeaf( *mpRtree, mRefiner );
+}
+
+bool RefinementTreeTest::ContainingTest::check() const
+{
+    // points partly outside the initial enclosure, points on boundaries of boxes are contained in several leaves
+    std::uniform_real_distribution< double > xDist( -2, 2 ), yDist( -1.5, 1.5 );
+    for( uint p = 0; p < 10; ++p )
+    {
+	const double x = xDist( mRandom ), y = yDist( mRandom );
+	const Ariadne::ValidatedPoint pt = Ariadne::ExactBoxType( { {x, x}, {y, y} } ).centre();
+	std::vector< size_t > located, scanned;
+	for( const ExactRefinementTree::NodeT& n : mpRtree->containing( pt ) )
+	    located.push_back( graph::value( mpRtree->graph(), n )->index() );
+	for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+	{
+	    auto nval = mpRtree->nodeValue( *vs.first );
+	    if( nval ? possibly( nval.value().get().getEnclosure().contains( pt ) ) : possibly( !mpRtree->initialEnclosure().contains( pt ) ) )
+		scanned.push_back( graph::value( mpRtree->graph(), *vs.first )->index() );
+	}
+	std::sort( located.begin(), located.end() );
+	std::sort( scanned.begin(), scanned.end() );
+	if( located != scanned || located.empty() )
+	{
+	    std::cout << "located " << located.size() << " but scanned " << scanned.size() << " nodes containing " << pt << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( AffineImageTest, "mean value form images keep sampled transitions and remove edges of box images" )
+
+void RefinementTreeTest::AffineImageTest::init()
+{
+    const Ariadne::ExactBoxType safeBox( { {-1, 1}, {-1, 1} } );
+    mpRtree.reset( rotationMap( safeBox, Ariadne::Effort( 10 ) ) );
+    mpBoxRtree.reset( rotationMap( safeBox, Ariadne::Effort( 10 ) ) );
+    UniformGridRefiner grid( { 4, 4 } );
+    for( ExactRefinementTree* pRtree : { mpRtree.get(), mpBoxRtree.get() } )
+    {
+	std::vector< ExactRefinementTree::NodeT > roots = { pRtree->containing( safeBox.centre() ).front() };
+	pRtree->refine( roots.begin(), roots.end(), grid );
+    }
+    // the partition refined with box images is switched to the form afterwards
+    mpRtree->setImageEnclosure( ImageEnclosure::AFFINE );
+    mIterations = 0;
+}
+
+void RefinementTreeTest::AffineImageTest::iterate()
+{
+    // the same leaves are refined in both trees, alternating single and batched refinement
+    std::uniform_real_distribution< double > dist( -1, 1 );
+    const double x = dist( mRandom ), y = dist( mRandom );
+    const Ariadne::ValidatedPoint pt = Ariadne::ExactBoxType( { {x, x}, {y, y} } ).centre();
+    for( ExactRefinementTree* pRtree : { mpRtree.get(), mpBoxRtree.get() } )
+    {
+	std::vector< ExactRefinementTree::NodeT > leaves = pRtree->containing( pt );
+	if( mIterations % 2 == 0 )
+	    pRtree->refine( leaves.front(), mRefiner );
+	else
+	    pRtree->refine( leaves.begin(), leaves.end(), mRefiner );
+    }
+    ++mIterations;
+}
+
+bool RefinementTreeTest::AffineImageTest::check() const
+{
+    auto edgeCount = [] (const ExactRefinementTree& rtree) {
+			 size_t noEdges = 0;
+			 for( auto vs = graph::vertices( rtree.graph() ); vs.first != vs.second; ++vs.first )
+			     noEdges += rtree.postimageRange( *vs.first ).size();
+			 return noEdges; };
+    const size_t affineEdges = edgeCount( *mpRtree ), boxEdges = edgeCount( *mpBoxRtree );
+    if( graph::size( mpRtree->graph() ) != graph::size( mpBoxRtree->graph() ) || affineEdges >= boxEdges )
+    {
+	std::cout << "form images reach " << affineEdges << " edges between " << graph::size( mpRtree->graph() ) << " nodes but box images "
+		  << boxEdges << " edges between " << graph::size( mpBoxRtree->graph() ) << " nodes" << std::endl;
+	return false;
+    }
+    if( mpRtree->transSafetyVolumes().mSafe < mpBoxRtree->transSafetyVolumes().mSafe - 1e-9 )
+    {
+	std::cout << "form images prove volume " << mpRtree->transSafetyVolumes().mSafe << " safe but box images "
+		  << mpBoxRtree->transSafetyVolumes().mSafe << std::endl;
+	return false;
+    }
+
+    std::uniform_real_distribution< double > dist( -1, 1 );
+    for( uint p = 0; p < 20; ++p )
+    {
+	const double x = dist( mRandom ), y = dist( mRandom );
+	const Ariadne::ValidatedPoint pt = Ariadne::ExactBoxType( { {x, x}, {y, y} } ).centre();
+	const Ariadne::ValidatedPoint mapped = mpRtree->compiledDynamics().evaluate( pt );
+	const std::vector< ExactRefinementTree::NodeT > trgs = mpRtree->containing( mapped );
+	for( const ExactRefinementTree::NodeT& src : mpRtree->containing( pt ) )
+	{
+	    const std::vector< ExactRefinementTree::NodeT > posts = mpRtree->postimage( src );
+	    for( const ExactRefinementTree::NodeT& trg : trgs )
+	    {
+		if( std::find_if( posts.begin(), posts.end(), [&] (const ExactRefinementTree::NodeT& n) { return mpRtree->equal( n, trg ); } ) == posts.end() )
+		{
+		    std::cout << "transition from " << pt << " to " << mapped << " has no edge" << std::endl;
+		    return false;
+		}
+	    }
+	}
+    }
+
+    // refinement with forms keeps transitive safety maintained incrementally in line with the edges
+    typedef typename ExactRefinementTree::SnapshotT SnapshotT;
+    const SnapshotT& snap = mpRtree->snapshot();
+    const std::vector< bool > safe = snap.transSafeComponents();
+    for( typename SnapshotT::IndexT i = 0; i < snap.size(); ++i )
+    {
+	if( mpRtree->nodeValue( snap.node( i ) ) && definitely( snap.isTransSafe( i ) ) != safe[ snap.condensation().component( i ) ] )
+	{
+	    std::cout << "node " << i << " transitively safe " << snap.isTransSafe( i ) << " with form images but its component "
+		      << safe[ snap.condensation().component( i ) ] << std::endl;
+	    return false;
+	}
+    }
+
+    // switching back to box images recovers the edges and transitive safety of the tree refined with box images
+    mpRtree->setImageEnclosure( ImageEnclosure::BOX );
+    const size_t switchedEdges = edgeCount( *mpRtree );
+    const double switchedSafe = mpRtree->transSafetyVolumes().mSafe;
+    mpRtree->setImageEnclosure( ImageEnclosure::AFFINE );
+    if( switchedEdges != boxEdges || std::abs( switchedSafe - mpBoxRtree->transSafetyVolumes().mSafe ) > 1e-9 )
+    {
+	std::cout << "switched to box images " << switchedEdges << " edges and safe volume " << switchedSafe << " instead of "
+		  << boxEdges << " and " << mpBoxRtree->transSafetyVolumes().mSafe << std::endl;
+	return false;
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( RefinedEdgesTest, "refinements with mean value form images only keep transitions of their parents" )
+
+void RefinementTreeTest::RefinedEdgesTest::init()
+{
+    mpRtree.reset( henonMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), 1.4, 0.3, Ariadne::Effort( 10 ) ) );
+    mpRtree->setImageEnclosure( ImageEnclosure::AFFINE );
+}
+
+void RefinementTreeTest::RefinedEdgesTest::iterate()
+{
+    // refine the leaves containing two random points together, they may reach each other
+    std::uniform_real_distribution< double > xDist( -1.5, 1.5 ), yDist( -1, 1 );
+    std::vector< ExactRefinementTree::NodeT > parents;
+    for( uint p = 0; p < 2; ++p )
+    {
+	const double x = xDist( mRandom ), y = yDist( mRandom );
+	const std::vector< ExactRefinementTree::NodeT > leaves = mpRtree->containing( Ariadne::ExactBoxType( { {x, x}, {y, y} } ).centre() );
+	parents.push_back( leaves.front() );
+    }
+    std::vector< std::vector< const IGraphValue* > > parentPosts;
+    for( const ExactRefinementTree::NodeT& parent : parents )
+    {
+	parentPosts.push_back( {} );
+	for( const ExactRefinementTree::NodeT& post : mpRtree->postimage( parent ) )
+	    parentPosts.back().push_back( graph::value( mpRtree->graph(), post ) );
+    }
+    std::vector< const IGraphValue* > parentValues;
+    for( const ExactRefinementTree::NodeT& parent : parents )
+	parentValues.push_back( graph::value( mpRtree->graph(), parent ) );
+
+    const std::vector< std::vector< ExactRefinementTree::NodeT > > refined = mpRtree->refine( parents.begin(), parents.end(), mRefiner );
+    mRefined.clear();
+    for( uint i = 0; i < parents.size(); ++i )
+    {
+	if( refined[ i ].empty() )
+	    continue;
+	std::vector< const IGraphValue* > allowed;
+	for( const IGraphValue* pPost : parentPosts[ i ] )
+	{
+	    const uint j = std::find( parentValues.begin(), parentValues.end(), pPost ) - parentValues.begin();
+	    if( j == parents.size() )
+		allowed.push_back( pPost );
+	    else
+	    {
+		for( const ExactRefinementTree::NodeT& child : refined[ j ] )
+		    allowed.push_back( graph::value( mpRtree->graph(), child ) );
+	    }
+	}
+	mRefined.push_back( std::make_pair( refined[ i ], allowed ) );
+    }
+}
+
+bool RefinementTreeTest::RefinedEdgesTest::check() const
+{
+    for( const auto& refined : mRefined )
+    {
+	for( const ExactRefinementTree::NodeT& child : refined.first )
+	{
+	    for( const ExactRefinementTree::NodeT& post : mpRtree->postimage( child ) )
+	    {
+		if( std::find( refined.second.begin(), refined.second.end(), graph::value( mpRtree->graph(), post ) ) == refined.second.end() )
+		{
+		    std::cout << "refined node " << graph::value( mpRtree->graph(), child )->index() << " reaches " << graph::value( mpRtree->graph(), post )->index()
+			      << " which its parent did not reach" << std::endl;
+		    return false;
+		}
+	    }
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( EffortScheduleTest, "escalating efforts stop at the first deciding effort and are recorded by leaves" )
+
+void RefinementTreeTest::EffortScheduleTest::iterate()
+{
+    mDecidingWork = std::uniform_int_distribution< uint >( 1, 12 )( mRandom );
+    mpRtree.reset( squareMap( Ariadne::ExactBoxType( { {-1.5, 1.5}, {-1, 1} } ), Ariadne::Effort( 10 ) ) );
+    LargestSideRefiner refiner;
+    for( uint r = 0; r < 20; ++r )
+	refineRandomLeaf( *mpRtree, refiner );
+}
+
+bool RefinementTreeTest::EffortScheduleTest::check() const
+{
+    // check deciding from mDecidingWork on, efforts tried are 1, 2, 4, 8 and 10
+    const EffortSchedule schedule( Ariadne::Effort( 10 ) );
+    std::vector< uint > tried;
+    auto check = [this, &tried] (const Ariadne::Effort& e) {
+		     tried.push_back( e.work() );
+		     return uint( e.work() ) >= mDecidingWork ? Ariadne::ValidatedKleenean( false ) : Ariadne::ValidatedKleenean( Ariadne::indeterminate ); };
+    uint work = 0;
+    const Ariadne::ValidatedKleenean result = schedule.decide( check, work );
+    std::vector< uint > expected;
+    for( uint w = 1; expected.empty() || ( expected.back() < mDecidingWork && expected.back() < 10 ); w = std::min( 10u, 2 * w ) )
+	expected.push_back( w );
+    if( tried != expected || work != expected.back() || definitely( !result ) != ( mDecidingWork <= 10 ) )
+    {
+	std::cout << "check deciding at effort " << mDecidingWork << " tried " << tried.size() << " efforts up to " << tried.back()
+		  << " and stopped at " << work << " with " << result << std::endl;
+	return false;
+    }
+    // starting at the effort recorded tries it first, fixed schedules try the maximum only
+    tried.clear();
+    work = 4;
+    schedule.decide( check, work );
+    const uint second = tried.front();
+    tried.clear();
+    EffortSchedule::fixed( Ariadne::Effort( 10 ) ).decide( check );
+    if( second != 4 || tried != std::vector< uint >( { 10 } ) )
+    {
+	std::cout << "started at effort " << second << " instead of 4 and fixed schedule tried " << tried.size() << " efforts" << std::endl;
+	return false;
+    }
+
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	const uint level = mpRtree->effortLevel( *vs.first );
+	const bool decided = definitely( mpRtree->isSafe( *vs.first ) ) || definitely( !mpRtree->isSafe( *vs.first ) );
+	if( level < mpRtree->effortSchedule().initial() || level > mpRtree->effortSchedule().maximum()
+	    || ( mpRtree->nodeValue( *vs.first ) && !decided && level != mpRtree->effortSchedule().maximum() ) )
+	{
+	    printNodeValue( mpRtree->nodeValue( *vs.first ) );
+	    std::cout << "of safety " << mpRtree->isSafe( *vs.first ) << " recorded at effort " << level << std::endl;
+	    return false;
+	}
+    }
+    return true;
+}
+
+RefinementTreeTest::TEST_CTOR( ConstraintInheritanceTest, "safety inherited through refinements equals safety checked on the whole safe set" )
+
+void RefinementTreeTest::ConstraintInheritanceTest::init()
+{
+    // disc cut by two half planes, so leaves satisfy some of the constraints while others are undecided
+    Ariadne::EffectiveScalarFunction cx = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 0 )
+	, cy = Ariadne::EffectiveScalarFunction::coordinate( Ariadne::EuclideanDomain( 2 ), 1 );
+    Ariadne::RealConstant r( "r", Ariadne::Real( 3.0 ) ), s( "s", Ariadne::Real( 1.5 ) ), t( "t", Ariadne::Real( 1.2 ) );
+    Ariadne::BoundedConstraintSet safeSet( { {-2, 2}, {-2, 2} }, { cx*cx + cy*cy <= r, cx - cy <= s, cy <= t } );
+    Ariadne::RealVariable x( "x" ), y( "y" );
+    Ariadne::EffectiveVectorFunction f = Ariadne::make_function( {x, y}, {x * x, y * y} );
+    mpRtree.reset( new ExactRefinementTree( safeSet, f, Ariadne::Effort( 10 ) ) );
+    mIterations = 0;
+}
+
+void RefinementTreeTest::ConstraintInheritanceTest::iterate()
+{
+    // alternate single refinements and batches of random leaves
+    if( mIterations++ % 2 == 0 )
+    {
+	refineRandomLeaf( *mpRtree, mRefiner );
+	return;
+    }
+    std::vector< ExactRefinementTree::NodeT > leaves;
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	if( mpRtree->nodeValue( *vs.first ) )
+	    leaves.push_back( *vs.first );
+    }
+    std::shuffle( leaves.begin(), leaves.end(), mRandom );
+    leaves.resize( std::min< size_t >( leaves.size(), 4 ) );
+    mpRtree->refine( leaves.begin(), leaves.end(), mRefiner );
+}
+
+bool RefinementTreeTest::ConstraintInheritanceTest::check() const
+{
+    const Ariadne::BoundedConstraintSet& safeSet = mpRtree->constraints();
+    const Ariadne::Effort effort = mpRtree->effort();
+    for( auto vs = graph::vertices( mpRtree->graph() ); vs.first != vs.second; ++vs.first )
+    {
+	auto nval = mpRtree->nodeValue( *vs.first );
+	if( !nval )
+	    continue;
+	const Ariadne::ExactBoxType& enc = nval.value().get().getEnclosure();
+	const Ariadne::ValidatedKleenean direct = definitely( safeSet.covers( enc ).check( effort ) ) ? Ariadne::ValidatedKleenean( true )
+	    : ( definitely( safeSet.separated( enc ).check( effort ) ) ? Ariadne::ValidatedKleenean( false ) : Ariadne::indeterminate );
+	if( !sameKleenean( direct, mpRtree->isSafe( *vs.first ) ) )
+	{
+	    std::cout << enc << " classified " << mpRtree->isSafe( *vs.first ) << " but is " << direct << std::endl;
+	    return false;
+	}
+	const uint64_t satisfied = mpRtree->satisfiedConstraints( *vs.first );
+	for( size_t k = 0; k < safeSet.constraints().size(); ++k )
+	{
+	    Ariadne::ConstraintSet single( Ariadne::List< Ariadne::EffectiveConstraint >( { safeSet.constraints()[ k ] } ) );
+	    if( ( ( satisfied >> k ) & 1 ) && !definitely( single.covers( enc ).check( effort ) ) )
+	    {
+		std::cout << enc << " records constraint " << k << " as satisfied but it is not" << std::endl;
+		return false;
+	    }
+	}
+    }
+    return true;
+}
+
 void RefinementTreeTest::init()
 {
     std::shared_ptr< InterleaveRandomRunner > pRinterleave( new InterleaveRandomRunner() );
     std::shared_ptr< ContinuousRandomRunner > pRcontinuous( new ContinuousRandomRunner() );
     std::shared_ptr< OnlyOnceRunner > pOnce( new OnlyOnceRunner() );
+    std::shared_ptr< StatelessRunner > pStateless( new StatelessRunner() );
 
     addTest( new SizeTest( 1 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new IntersectionTest( 1 * mTestSize, 0.1 * mRepetitions ), pRcontinuous );
     addTest( new CSetIntersectionTest( 1*mTestSize, 0.1 * mRepetitions ), pRcontinuous );
     addTest( new RefinedNodesRemovalTest( 1 * mTestSize, 0.1 * mRepetitions ), pRcontinuous );
+    addTest( new ValueRecyclingTest( 1 * mTestSize, 0.1 * mRepetitions ), pRcontinuous );
     addTest( new PreimageTest( 1 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new PostimageTest( 1 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new AlwaysUnsafeTest( 1 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
     addTest( new TransitiveSafetyTest( 1*mTestSize, mRepetitions ), pRinterleave );
+    addTest( new BatchRefinementTest( 1*mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new DynamicsTapeTest( 1*mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new MultiWayRefinementTest( 0.2 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new InitialGridTest( 0.1 * mTestSize, 0.1 * mRepetitions ), pStateless );
+    addTest( new SnapshotTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new CondensedSafetyTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new AdjacentRangeTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new MappedGraphTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new MemoryUsageTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new SafetyVolumesTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new ContainingTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new AffineImageTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new RefinedEdgesTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
+    addTest( new EffortScheduleTest( 0.2 * mTestSize, 0.1 * mRepetitions ), pStateless );
+    addTest( new ConstraintInheritanceTest( 0.5 * mTestSize, 0.1 * mRepetitions ), pRinterleave );
 }
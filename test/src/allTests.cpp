@@ -6,6 +6,7 @@ void AllTests::init()
 {
     std::shared_ptr< OnlyOnceRunner > poor( new OnlyOnceRunner() );
     addTest( new LinkedFixedBranchTreeTest( mTestSize, mRepetitions ), poor );
+    addTest( new IndexedFixedBranchTreeTest( mTestSize, mRepetitions ), poor );
     addTest( new AdjacencyDiGraphTest( mTestSize, mRepetitions ), poor );
     addTest( new RefinementTreeTest( mTestSize, mRepetitions ), poor );
     addTest( new CegarTest( mTestSize, mRepetitions ), poor );
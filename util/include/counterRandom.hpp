@@ -0,0 +1,42 @@
+#ifndef COUNTER_RANDOM_HPP
+#define COUNTER_RANDOM_HPP
+
+#include <cstdint>
+
+/*!
+  \class counter based random numbers: the number drawn for a stream and counter is a hash of both and the seed
+  draws do not modify any state, so threads can draw from disjoint streams of the same generator without synchronization
+  and a stream is reproduced by drawing the same counters again
+  \note mixes with the finalizer of splitmix64
+*/
+class CounterRandom
+{
+  public:
+    explicit CounterRandom( const uint64_t& seed ) : mSeed( mix( seed ) ) {}
+
+    //! \return 64 random bits for counter of stream
+    uint64_t bits( const uint64_t& stream, const uint64_t& counter ) const
+    {
+	return mix( mix( mSeed ^ mix( stream ) ) + counter );
+    }
+
+    //! \return random number uniformly distributed in [0, 1) for counter of stream
+    double uniform( const uint64_t& stream, const uint64_t& counter ) const
+    {
+	// upper 53 bits fill the mantissa exactly
+	return ( bits( stream, counter ) >> 11 ) * ( 1.0 / ( uint64_t( 1 ) << 53 ) );
+    }
+
+  private:
+    static uint64_t mix( uint64_t z )
+    {
+	z += 0x9e3779b97f4a7c15ull;
+	z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+	z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+	return z ^ ( z >> 31 );
+    }
+
+    uint64_t mSeed;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <fstream>
+
+#include <unistd.h>
+
+/*!
+  \class bytes allocated on the heap by the parts of an abstraction
+  containers are counted by their capacity, nodes of hash indices and control blocks of shared pointers by their usual layout
+*/
+struct MemoryUsage
+{
+    // vertex containers and slots of the graph
+    size_t mVertices = 0;
+    // in and out edge containers
+    size_t mEdges = 0;
+    // pooled graph values, their enclosures and state kept per node
+    size_t mValues = 0;
+    // leaf index, graph snapshot and compiled dynamics
+    size_t mIndices = 0;
+    size_t mCounterexamples = 0;
+
+    size_t total() const { return mVertices + mEdges + mValues + mIndices + mCounterexamples; }
+
+    MemoryUsage& operator +=( const MemoryUsage& other )
+    {
+	mVertices += other.mVertices;
+	mEdges += other.mEdges;
+	mValues += other.mValues;
+	mIndices += other.mIndices;
+	mCounterexamples += other.mCounterexamples;
+	return *this;
+    }
+};
+
+//! \return resident set size of the process in bytes as reported by /proc/self/statm, 0 if it cannot be read
+inline size_t residentBytes()
+{
+    std::ifstream statm( "/proc/self/statm" );
+    size_t pages = 0, residentPages = 0;
+    if( !( statm >> pages >> residentPages ) )
+	return 0;
+    return residentPages * static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+}
+
+#endif
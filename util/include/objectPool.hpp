@@ -3,6 +3,10 @@
 
 #include <stack>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <stdexcept>
 
 template< typename T > class ObjectPool;
 
@@ -20,6 +24,7 @@ class ObjectPoolRaw
 	: mSize( chunkSize )
 	, mNewSize( chunkSize )
 	, mPosUnused( 0 )
+	, mLive( 0 )
 	, mChunks()
 	, mUsedObjects()
     {
@@ -46,6 +51,7 @@ class ObjectPoolRaw
     //! \return pool pointer owning object of type T initialized to undef value
     T* handOut()
     {
+	++mLive;
 	if( mUsedObjects.empty() )
 	{
 	    if( mPosUnused >= mSize )
@@ -64,8 +70,21 @@ class ObjectPoolRaw
     template< typename TT >
     void handBack( TT* pptr )
     {
+	--mLive;
 	mUsedObjects.push( static_cast< T* >( pptr ) );
     }
+
+    //! \return number of objects handed out and not handed back yet
+    size_t liveObjects() const { return mLive; }
+
+    //! \return number of objects that can be handed out without allocating, recycled and never handed out
+    size_t freeObjects() const { return mUsedObjects.size() + mSize - mPosUnused; }
+
+    //! \return number of chunks allocated
+    size_t chunks() const { return mChunks.size(); }
+
+    //! \return bytes allocated on the heap for chunks and the stack of recycled objects
+    size_t heapBytes() const { return mChunks.size() * ( mNewSize * sizeof( T ) + sizeof( T* ) ) + mUsedObjects.size() * sizeof( T* ); }
     
   private:
     void allocateNewChunk()
@@ -76,9 +95,168 @@ class ObjectPoolRaw
     }
 
     uint mSize, mNewSize, mPosUnused;
+    size_t mLive;
     std::stack< T* > mChunks, mUsedObjects;
 };
 
+/*!
+  \class thread safe variant of ObjectPoolRaw
+  free objects are linked through their slots and popped or pushed by a single compare and swap on a tagged head (Treiber stack),
+  so handing out and back does not allocate. Chunks grow geometrically and are only allocated under a lock when the free list is empty.
+  \param T type of object to manage. Requires T to be default constructible
+ */
+template< typename T >
+class ConcurrentObjectPoolRaw
+{
+  public:
+
+    //!\param chunkSize number of objects to allocate in the first chunk, each further chunk doubles the capacity
+    ConcurrentObjectPoolRaw( size_t chunkSize )
+	: mChunkSize( std::max< size_t >( chunkSize, 1 ) )
+	, mHead( NO_SLOT )
+	, mLive( 0 )
+	, mNoChunks( 0 )
+    {
+	for( auto& c : mChunks )
+	    c.store( nullptr, std::memory_order_relaxed );
+    }
+
+    // \note pool requires have longer lifetime than pointers
+    ~ConcurrentObjectPoolRaw()
+    {
+	for( uint32_t k = 0; k < mNoChunks.load(); ++k )
+	    delete [] mChunks[ k ].load();
+    }
+
+    ConcurrentObjectPoolRaw( const ConcurrentObjectPoolRaw& ) = delete;
+    ConcurrentObjectPoolRaw& operator =( const ConcurrentObjectPoolRaw& ) = delete;
+
+    //! \return pointer to object of type T that may have been used before
+    T* handOut()
+    {
+	mLive.fetch_add( 1, std::memory_order_relaxed );
+	uint64_t head = mHead.load( std::memory_order_acquire );
+	while( true )
+	{
+	    const uint32_t index = head & INDEX_MASK;
+	    if( index == NO_SLOT )
+	    {
+		if( T* pGrown = grow() )
+		    return pGrown;
+		head = mHead.load( std::memory_order_acquire );
+		continue;
+	    }
+	    Slot& s = slot( index );
+	    const uint64_t next = nextTag( head ) | s.mNext.load( std::memory_order_relaxed );
+	    if( mHead.compare_exchange_weak( head, next, std::memory_order_acquire, std::memory_order_acquire ) )
+		return &s.mObject;
+	}
+    }
+
+    //! \brief hands pptr back to pool allowing it to be handed out again
+    template< typename TT >
+    void handBack( TT* pptr )
+    {
+	const uint32_t index = indexOf( static_cast< T* >( pptr ) );
+	push( index, index );
+	mLive.fetch_sub( 1, std::memory_order_relaxed );
+    }
+
+    //! \return number of objects handed out and not handed back yet
+    size_t liveObjects() const { return mLive.load( std::memory_order_relaxed ); }
+
+    //! \return number of objects that can be handed out without allocating
+    size_t freeObjects() const { return capacity() - liveObjects(); }
+
+    //! \return number of chunks allocated
+    size_t chunks() const { return mNoChunks.load( std::memory_order_acquire ); }
+
+    //! \return number of objects allocated in all chunks
+    size_t capacity() const { return firstIndex( chunks() ); }
+
+    //! \return bytes allocated on the heap for chunks
+    size_t heapBytes() const { return capacity() * sizeof( Slot ); }
+
+  private:
+    struct Slot
+    {
+	T mObject;
+	std::atomic< uint32_t > mNext;
+    };
+
+    static const uint32_t NO_SLOT = 0xffffffff;
+    static const uint64_t INDEX_MASK = 0xffffffff;
+    static const uint32_t MAX_CHUNKS = 32;
+
+    static uint64_t nextTag( const uint64_t& head ) { return ( ( head >> 32 ) + 1 ) << 32; }
+
+    //! \return index of first slot in chunk k
+    size_t firstIndex( const size_t& k ) const { return mChunkSize * ( ( size_t( 1 ) << k ) - 1 ); }
+
+    Slot& slot( const uint32_t& index )
+    {
+	uint32_t k = 0;
+	while( index >= firstIndex( k + 1 ) )
+	    ++k;
+	return mChunks[ k ].load( std::memory_order_acquire )[ index - firstIndex( k ) ];
+    }
+
+    uint32_t indexOf( const T* pobj ) const
+    {
+	const char* p = reinterpret_cast< const char* >( pobj );
+	for( uint32_t k = 0; k < mNoChunks.load( std::memory_order_acquire ); ++k )
+	{
+	    const Slot* pChunk = mChunks[ k ].load( std::memory_order_acquire );
+	    const size_t chunkSize = firstIndex( k + 1 ) - firstIndex( k );
+	    const char* pFirst = reinterpret_cast< const char* >( &pChunk[ 0 ].mObject );
+	    if( p >= pFirst && p < pFirst + chunkSize * sizeof( Slot ) )
+		return firstIndex( k ) + ( p - pFirst ) / sizeof( Slot );
+	}
+	throw std::logic_error( "object handed back was not handed out by this pool" );
+    }
+
+    //! \brief pushes the slots first, ..., last linked in ascending order
+    void push( const uint32_t& first, const uint32_t& last )
+    {
+	uint64_t head = mHead.load( std::memory_order_relaxed );
+	do
+	{
+	    slot( last ).mNext.store( head & INDEX_MASK, std::memory_order_relaxed );
+	}
+	while( !mHead.compare_exchange_weak( head, nextTag( head ) | first, std::memory_order_release, std::memory_order_relaxed ) );
+    }
+
+    //! \return object of newly allocated chunk, nullptr if another thread refilled the free list
+    T* grow()
+    {
+	std::lock_guard< std::mutex > lock( mGrowMutex );
+	if( ( mHead.load( std::memory_order_acquire ) & INDEX_MASK ) != NO_SLOT )
+	    return nullptr;
+
+	const uint32_t k = mNoChunks.load( std::memory_order_relaxed );
+	if( k >= MAX_CHUNKS || firstIndex( k + 1 ) >= NO_SLOT )
+	    throw std::runtime_error( "object pool exhausted" );
+	const size_t begin = firstIndex( k ), size = firstIndex( k + 1 ) - begin;
+	Slot* pChunk = new Slot[ size ]();
+	for( size_t i = 0; i + 1 < size; ++i )
+	    pChunk[ i ].mNext.store( begin + i + 1, std::memory_order_relaxed );
+	mChunks[ k ].store( pChunk, std::memory_order_release );
+	mNoChunks.store( k + 1, std::memory_order_release );
+
+	// keep first object, make remaining ones available
+	if( size > 1 )
+	    push( begin + 1, begin + size - 1 );
+	return &pChunk[ 0 ].mObject;
+    }
+
+    const size_t mChunkSize;
+    std::atomic< uint64_t > mHead;
+    std::atomic< size_t > mLive;
+    std::atomic< uint32_t > mNoChunks;
+    std::atomic< Slot* > mChunks[ MAX_CHUNKS ];
+    std::mutex mGrowMutex;
+};
+
 /*!
   \brief smart pointer with shared semantics akin to std::shared_ptr< T >.  Instead of deallocating memory when the last reference goes out of scope, the memory is returned to the home pool.  The use count is continuously adapted on construction, copy construction, move construction, copy assignment, move assignment and deletion.
  */
@@ -0,0 +1,198 @@
+#ifndef PHASE_PROFILER_HPP
+#define PHASE_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <ostream>
+#include <string>
+#include <cstdint>
+
+/*!
+  phases of the cegar loop timed by the profiler
+  \note append new phases before COUNT and name them in phaseName
+*/
+enum class Phase : uint8_t { IMAGE, SAFETY, REFINE_EDGES, TRANS_SAFETY, INVALIDATE, SEARCH, CHECK, COUNT };
+
+constexpr size_t NO_PHASES = static_cast< size_t >( Phase::COUNT );
+
+inline const char* phaseName( const Phase& p )
+{
+    static const char* names[ NO_PHASES ] = { "image", "safety", "refineEdges", "transSafety", "invalidate", "search", "check" };
+    return names[ static_cast< size_t >( p ) ];
+}
+
+/*!
+  \class calls and latencies of a phase, latencies are binned into powers of two of nanoseconds
+  bucket b counts calls taking [2^b, 2^(b+1)) ns, bucket 0 also counts calls shorter than 1 ns
+*/
+struct PhaseStats
+{
+    static constexpr size_t NO_BUCKETS = 48;
+
+    uint64_t mCalls = 0;
+    uint64_t mNanoseconds = 0;
+    std::array< uint64_t, NO_BUCKETS > mHistogram = {};
+
+    static size_t bucket( uint64_t ns )
+    {
+	size_t b = 0;
+	for( ; ns > 1 && b + 1 < NO_BUCKETS; ns >>= 1 )
+	    ++b;
+	return b;
+    }
+
+    PhaseStats& operator +=( const PhaseStats& other )
+    {
+	mCalls += other.mCalls;
+	mNanoseconds += other.mNanoseconds;
+	for( size_t b = 0; b < NO_BUCKETS; ++b )
+	    mHistogram[ b ] += other.mHistogram[ b ];
+	return *this;
+    }
+
+    PhaseStats& operator -=( const PhaseStats& other )
+    {
+	mCalls -= other.mCalls;
+	mNanoseconds -= other.mNanoseconds;
+	for( size_t b = 0; b < NO_BUCKETS; ++b )
+	    mHistogram[ b ] -= other.mHistogram[ b ];
+	return *this;
+    }
+};
+
+typedef std::array< PhaseStats, NO_PHASES > PhaseProfileT;
+
+/*!
+  \class process wide profiler aggregating phases per thread
+  each thread records into counters of its own, written only by that thread, so recording needs no synchronization
+  collect sums the counters of all threads that recorded so far
+  \note counters of threads are kept until the end of the process, as threads of the openmp pool are reused
+*/
+class PhaseProfiler
+{
+  public:
+    static PhaseProfiler& instance()
+    {
+	static PhaseProfiler profiler;
+	return profiler;
+    }
+
+    //! \brief records a call of p taking ns nanoseconds to the counters of the calling thread
+    void record( const Phase& p, const uint64_t& ns )
+    {
+	ThreadCounters& counters = local();
+	Counter* c = counters.mCounters[ static_cast< size_t >( p ) ];
+	bump( c[ CALLS ], 1 );
+	bump( c[ NANOSECONDS ], ns );
+	bump( c[ FIRST_BUCKET + PhaseStats::bucket( ns ) ], 1 );
+    }
+
+    //! \return sum of the counters of all threads
+    PhaseProfileT collect() const
+    {
+	PhaseProfileT profile;
+	std::lock_guard< std::mutex > lock( mMutex );
+	for( const std::unique_ptr< ThreadCounters >& pCounters : mThreads )
+	{
+	    for( size_t p = 0; p < NO_PHASES; ++p )
+	    {
+		const Counter* c = pCounters->mCounters[ p ];
+		PhaseStats& stats = profile[ p ];
+		stats.mCalls += c[ CALLS ].load( std::memory_order_relaxed );
+		stats.mNanoseconds += c[ NANOSECONDS ].load( std::memory_order_relaxed );
+		for( size_t b = 0; b < PhaseStats::NO_BUCKETS; ++b )
+		    stats.mHistogram[ b ] += c[ FIRST_BUCKET + b ].load( std::memory_order_relaxed );
+	    }
+	}
+	return profile;
+    }
+
+  private:
+    typedef std::atomic< uint64_t > Counter;
+
+    enum : size_t { CALLS = 0, NANOSECONDS, FIRST_BUCKET, NO_COUNTERS = FIRST_BUCKET + PhaseStats::NO_BUCKETS };
+
+    // aligned to cache lines, so threads recording do not share lines
+    struct alignas( 64 ) ThreadCounters
+    {
+	Counter mCounters[ NO_PHASES ][ NO_COUNTERS ];
+    };
+
+    PhaseProfiler() = default;
+
+    // single writer, so a relaxed load and store suffice and compile to plain moves
+    static void bump( Counter& c, const uint64_t& add ) { c.store( c.load( std::memory_order_relaxed ) + add, std::memory_order_relaxed ); }
+
+    ThreadCounters& local()
+    {
+	thread_local ThreadCounters* pLocal = nullptr;
+	if( !pLocal )
+	{
+	    std::unique_ptr< ThreadCounters > pNew( new ThreadCounters() );
+	    for( auto& phaseCounters : pNew->mCounters )
+		for( Counter& c : phaseCounters )
+		    c.store( 0, std::memory_order_relaxed );
+	    pLocal = pNew.get();
+	    std::lock_guard< std::mutex > lock( mMutex );
+	    mThreads.push_back( std::move( pNew ) );
+	}
+	return *pLocal;
+    }
+
+    mutable std::mutex mMutex;
+    std::vector< std::unique_ptr< ThreadCounters > > mThreads;
+};
+
+//! \class records the time from construction to destruction as one call of a phase
+class PhaseTimer
+{
+  public:
+    typedef std::chrono::steady_clock ClockT;
+
+    explicit PhaseTimer( const Phase& p ) : mPhase( p ), mStart( ClockT::now() ) {}
+
+    PhaseTimer( const PhaseTimer& ) = delete;
+    PhaseTimer& operator =( const PhaseTimer& ) = delete;
+
+    ~PhaseTimer()
+    {
+	PhaseProfiler::instance().record( mPhase, std::chrono::duration_cast< std::chrono::nanoseconds >( ClockT::now() - mStart ).count() );
+    }
+
+  private:
+    Phase mPhase;
+    ClockT::time_point mStart;
+};
+
+//! \brief writes profile as csv lines of phase, calls, nanoseconds and histogram buckets, prefixed by prefix
+template< typename CharT, typename Traits >
+std::basic_ostream< CharT, Traits >& writeProfile( std::basic_ostream< CharT, Traits >& os, const PhaseProfileT& profile, const std::string& prefix = "" )
+{
+    for( size_t p = 0; p < NO_PHASES; ++p )
+    {
+	const PhaseStats& stats = profile[ p ];
+	os << prefix << phaseName( static_cast< Phase >( p ) ) << "," << stats.mCalls << "," << stats.mNanoseconds;
+	for( const uint64_t& count : stats.mHistogram )
+	    os << "," << count;
+	os << std::endl;
+    }
+    return os;
+}
+
+/*!
+  instrumentation of hot functions, compiled in only if CEGAR_PROFILE is defined, e.g. by adding -DCEGAR_PROFILE to OPTFLAGS
+  CEGAR_PROFILE_SCOPE( p ) times the enclosing scope as a call of Phase::p
+*/
+#define CEGAR_PROFILE_CONCAT_IMPL( a, b ) a##b
+#define CEGAR_PROFILE_CONCAT( a, b ) CEGAR_PROFILE_CONCAT_IMPL( a, b )
+#ifdef CEGAR_PROFILE
+#define CEGAR_PROFILE_SCOPE( p ) PhaseTimer CEGAR_PROFILE_CONCAT( cegarPhaseTimer, __LINE__ )( Phase::p )
+#else
+#define CEGAR_PROFILE_SCOPE( p ) ((void) 0)
+#endif
+
+#endif